@@ -66,6 +66,9 @@
 /* support MP3 */
 #cmakedefine HAVE_MP3
 
+/* use the LAME library for MP3 encoding */
+#cmakedefine HAVE_LAME
+
 /* does libogg have the function ogg_stream_flush_fill ? (>= v1.3.0) */
 #cmakedefine HAVE_OGG_STREAM_FLUSH_FILL
 
@@ -32,6 +32,7 @@
 #include <KSharedConfig>
 
 #include "libkwave/ClipBoard.h"
+#include "libkwave/FloatArray.h"
 #include "libkwave/LabelList.h"
 #include "libkwave/Logger.h"
 #include "libkwave/Parser.h"
@@ -59,6 +60,7 @@ Kwave::App::App(int &argc, char **argv)
     m_gui_type(Kwave::App::GUI_TAB)
 {
     qRegisterMetaType<Kwave::SampleArray>("Kwave::SampleArray");
+    qRegisterMetaType<Kwave::FloatArray>("Kwave::FloatArray");
     qRegisterMetaType<Kwave::LabelList>("Kwave::LabelList");
     qRegisterMetaType<sample_index_t>("sample_index_t");
     qRegisterMetaType<Kwave::MetaDataList>("Kwave::MetaDataList");
@@ -0,0 +1,436 @@
+/***************************************************************************
+       BatchContext.cpp  -  headless context for batch processing
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <new>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QLatin1Char>
+#include <QList>
+#include <QLocale>
+#include <QMap>
+#include <QMutableListIterator>
+#include <QProcess>
+#include <QTextStream>
+#include <QThread>
+#include <QUrl>
+
+#include "libkwave/Logger.h"
+#include "libkwave/MessageBox.h"
+#include "libkwave/Parser.h"
+#include "libkwave/PluginManager.h"
+#include "libkwave/SignalManager.h"
+#include "libkwave/String.h"
+#include "libkwave/Utils.h"
+
+#include "BatchContext.h"
+
+/**
+ * useful macro for command parsing
+ */
+#define CASE_COMMAND(x) } else if (parser.command() == _(x)) {
+
+//***************************************************************************
+Kwave::BatchContext::BatchContext()
+    :QObject(), Kwave::CommandHandler(),
+     m_signal_manager(Q_NULLPTR),
+     m_plugin_manager(Q_NULLPTR),
+     m_file()
+{
+}
+
+//***************************************************************************
+Kwave::BatchContext::~BatchContext()
+{
+    closeSignal();
+
+    if (m_plugin_manager) delete m_plugin_manager;
+    m_plugin_manager = Q_NULLPTR;
+
+    if (m_signal_manager) delete m_signal_manager;
+    m_signal_manager = Q_NULLPTR;
+}
+
+//***************************************************************************
+bool Kwave::BatchContext::init()
+{
+    m_signal_manager = new(std::nothrow) Kwave::SignalManager(Q_NULLPTR);
+    Q_ASSERT(m_signal_manager);
+    if (!m_signal_manager) return false;
+
+    m_plugin_manager = new(std::nothrow)
+	Kwave::PluginManager(Q_NULLPTR, *m_signal_manager);
+    Q_ASSERT(m_plugin_manager);
+    if (!m_plugin_manager) return false;
+
+    // commands from plugins are executed in this context
+    connect(m_plugin_manager, SIGNAL(sigCommand(QString)),
+            this,             SLOT(executeCommand(QString)));
+
+    m_plugin_manager->setActive();
+    m_plugin_manager->searchPluginModules();
+    if (!m_plugin_manager->loadAllPlugins()) {
+	qWarning("Kwave has not been properly installed. No plugins found!");
+	return false;
+    }
+
+    return true;
+}
+
+//***************************************************************************
+int Kwave::BatchContext::executeCommand(const QString &line)
+{
+    Q_ASSERT(m_signal_manager);
+    Q_ASSERT(m_plugin_manager);
+    if (!m_signal_manager || !m_plugin_manager) return -ENOMEM;
+
+    QString command = line.trimmed();
+    if (!command.length()) return 0; // empty line -> nothing to do
+    if (command.startsWith(_("#")))
+	return 0; // only a comment
+
+    // there is no macro recorder in batch mode
+    if (command.startsWith(_("nomacro:")))
+	command = command.mid(QString(_("nomacro:")).length());
+
+    // a list of commands, separated by ";"
+    Kwave::Parser parse_list(command);
+    if (parse_list.hasMultipleCommands()) {
+	foreach (const QString &it, parse_list.commandList()) {
+	    int result = executeCommand(it);
+	    if (result) return result;
+	    m_plugin_manager->sync();
+	}
+	return 0;
+    }
+
+    command = expandVariables(command);
+    Kwave::Parser parser(command);
+    const QString cmd = parser.command();
+
+    // commands for menus, windows, the view or playback have no
+    // meaning without a GUI
+    if ((cmd == _("menu")) || (cmd == _("about_kde")) ||
+        (cmd == _("help")) || cmd.startsWith(_("playback")) ||
+        cmd.startsWith(_("view:")) ||
+        cmd.startsWith(_("window:")))
+	return 0;
+
+    Kwave::Logger::log(this, Kwave::Logger::Info, _("CMD: ") + command);
+
+    int result = 0;
+    if (false) {
+    CASE_COMMAND("close")
+	closeSignal();
+    CASE_COMMAND("delayed")
+	// no need to wait for a GUI, execute it immediately
+	if (parser.count() != 2) return -EINVAL;
+	parser.firstParam();
+	result = executeCommand(parser.nextParam());
+    CASE_COMMAND("goto")
+	m_signal_manager->selectRange(parser.toSampleIndex(), 0);
+    CASE_COMMAND("label:add")
+	sample_index_t pos = parser.toSampleIndex();
+	if (parser.isDone()) return -EINVAL; // would need a dialog
+	m_signal_manager->addLabel(pos, parser.nextParam());
+    CASE_COMMAND("loadbatch")
+	QFile file(QUrl::fromUserInput(parser.nextParam()).toLocalFile());
+	if (!file.open(QIODevice::ReadOnly)) return -EIO;
+	QStringList lines;
+	QTextStream stream(&file);
+	while (!stream.atEnd()) lines.append(stream.readLine());
+	file.close();
+	result = runCommands(lines);
+    CASE_COMMAND("newsignal")
+	sample_index_t samples = parser.toSampleIndex();
+	double         rate    = parser.toDouble();
+	unsigned int   bits    = parser.toUInt();
+	unsigned int   tracks  = parser.toUInt();
+	closeSignal();
+	m_signal_manager->newSignal(samples, rate, bits, tracks);
+    CASE_COMMAND("open")
+	result = openFile(parser.nextParam());
+    CASE_COMMAND("plugin")
+	QString name(parser.firstParam());
+	QStringList params(parser.remainingParams());
+	if (params.isEmpty()) {
+	    qWarning("plugin '%s' needs parameters in batch mode", DBG(name));
+	    return -EINVAL;
+	}
+	result = m_plugin_manager->executePlugin(name, &params);
+    CASE_COMMAND("plugin:execute")
+	QString name(parser.firstParam());
+	QStringList params(parser.remainingParams());
+	result = m_plugin_manager->executePlugin(name, &params);
+    CASE_COMMAND("plugin:setup")
+	qWarning("'%s' needs a GUI, not possible in batch mode", DBG(cmd));
+	return -ENOSYS;
+    CASE_COMMAND("quit")
+	result = 0; // handled in runCommands()
+    CASE_COMMAND("revert")
+	result = openFile(m_signal_manager->signalName());
+    CASE_COMMAND("save")
+	result = m_signal_manager->save(
+	    QUrl(m_signal_manager->signalName()), false);
+    CASE_COMMAND("saveas")
+	const QString name = parser.nextParam();
+	if (!name.length()) return -EINVAL; // would need a dialog
+	result = m_signal_manager->save(QUrl::fromUserInput(name), false);
+    CASE_COMMAND("saveselect")
+	const QString name = parser.nextParam();
+	if (!name.length()) return -EINVAL; // would need a dialog
+	result = m_signal_manager->save(QUrl::fromUserInput(name), true);
+    CASE_COMMAND("selectnone")
+	m_signal_manager->selectRange(
+	    m_signal_manager->selection().offset(), 0);
+    CASE_COMMAND("selectvisible")
+	// everything is visible
+	m_signal_manager->selectRange(0, m_signal_manager->length());
+    CASE_COMMAND("sync")
+	m_plugin_manager->sync();
+    } else {
+	// pass the command to the signal manager
+	result = m_signal_manager->executeCommand(command);
+	if (result == -ENOSYS)
+	    qWarning("unknown command '%s'", DBG(cmd));
+    }
+
+    return result;
+}
+
+//***************************************************************************
+int Kwave::BatchContext::runScript(const QStringList &script,
+                                   const QString &file)
+{
+    QElapsedTimer total;
+    total.start();
+
+    int result = 0;
+    m_file = file;
+    if (file.length()) {
+	QElapsedTimer timer;
+	timer.start();
+	result = openFile(file);
+	printTiming(_("open(") + file + _(")"), timer.nsecsElapsed(), result);
+    }
+
+    if (!result) result = runCommands(script);
+
+    closeSignal();
+    printTiming(_("(total)"), total.nsecsElapsed(), result);
+    m_file = QString();
+
+    return result;
+}
+
+//***************************************************************************
+int Kwave::BatchContext::runCommands(const QStringList &lines)
+{
+    // find all labels, the first one of a name wins
+    QMap<QString, int> labels;
+    for (int index = 0; index < lines.count(); ++index) {
+	const QString line = lines.at(index).simplified();
+	if (line.startsWith(_("#")) || !line.endsWith(QLatin1Char(':')))
+	    continue;
+	const QString name = line.left(line.length() - 1).simplified();
+	if (!labels.contains(name)) labels[name] = index;
+    }
+
+    int result = 0;
+    for (int index = 0; (index < lines.count()) && !result; ++index) {
+	const QString line = lines.at(index).simplified();
+	if (!line.length()) continue;                   // skip empty lines
+	if (line.startsWith(_("#"))) continue;          // skip comments
+	if (line.endsWith(QLatin1Char(':'))) continue;  // skip labels
+
+	// the "GOTO" command
+	const QStringList words = line.split(QLatin1Char(' '));
+	if (words.at(0) == _("GOTO")) {
+	    const QString label = (words.count() > 1) ?
+		words.at(1).simplified() : QString();
+	    if (!labels.contains(label)) {
+		qWarning("label '%s' not found", DBG(label));
+		result = -ENOENT;
+		break;
+	    }
+	    index = labels[label];
+	    continue;
+	}
+
+	Kwave::Parser parser(line);
+	if (parser.command() == _("quit")) break;
+	if (parser.command() == _("msgbox")) {
+	    // nobody to ask, take it as "yes"
+	    qDebug("msgbox: %s", DBG(parser.firstParam()));
+	    continue;
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+	result = executeCommand(line);
+
+	// a plugin runs in the background, include it in the time
+	m_plugin_manager->sync();
+	printTiming(line, timer.nsecsElapsed(), result);
+    }
+
+    return result;
+}
+
+//***************************************************************************
+int Kwave::BatchContext::openFile(const QString &name)
+{
+    if (!name.length()) return -EINVAL; // would need a dialog
+    closeSignal();
+    return m_signal_manager->loadFile(QUrl::fromUserInput(name));
+}
+
+//***************************************************************************
+void Kwave::BatchContext::closeSignal()
+{
+    // close all plugins that still might use the current signal
+    if (m_plugin_manager) {
+	m_plugin_manager->stopAllPlugins();
+	m_plugin_manager->signalClosed();
+    }
+
+    if (m_signal_manager) m_signal_manager->close();
+}
+
+//***************************************************************************
+QString Kwave::BatchContext::expandVariables(const QString &command) const
+{
+    if (!command.contains(_("${"))) return command;
+
+    QString result = command;
+    const QFileInfo fi(m_file);
+    result.replace(_("${FILE}"),     fi.absoluteFilePath());
+    result.replace(_("${DIR}"),      fi.absolutePath());
+    result.replace(_("${BASENAME}"), fi.completeBaseName());
+    result.replace(_("${LANG}"),
+                   QLocale().name().split(QLatin1Char('_')).at(0));
+    return result;
+}
+
+//***************************************************************************
+void Kwave::BatchContext::printTiming(const QString &command, qint64 ns,
+                                      int result) const
+{
+    const QString file = (m_file.length()) ? m_file : _("-");
+    printf("%s\t%.3f\t%d\t%s\n", UTF8(file),
+           static_cast<double>(ns) / 1E6, result, UTF8(command));
+    fflush(stdout);
+}
+
+//***************************************************************************
+int Kwave::BatchContext::runBatch(const QString &script_file,
+                                  const QStringList &files,
+                                  unsigned int jobs)
+{
+    // read the script once for all files
+    QFile file(script_file);
+    if (!file.open(QIODevice::ReadOnly)) {
+	qWarning("unable to open script '%s'", DBG(script_file));
+	return EXIT_FAILURE;
+    }
+    QStringList script;
+    QTextStream stream(&file);
+    while (!stream.atEnd()) script.append(stream.readLine());
+    file.close();
+
+    // there is nobody who could answer a message box
+    Kwave::MessageBox::setInteractive(false);
+
+    if (!jobs) jobs = qMax(QThread::idealThreadCount(), 1);
+    if ((jobs > 1) && (files.count() > 1))
+	return runParallel(script_file, files, jobs);
+
+    Kwave::BatchContext context;
+    if (!context.init()) return EXIT_FAILURE;
+
+    int failed = 0;
+    if (files.isEmpty()) {
+	if (context.runScript(script, QString())) failed++;
+    } else {
+	foreach (const QString &name, files)
+	    if (context.runScript(script, name)) failed++;
+    }
+
+    return (failed) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+//***************************************************************************
+int Kwave::BatchContext::runParallel(const QString &script_file,
+                                     const QStringList &files,
+                                     unsigned int jobs)
+{
+    QStringList       pending(files);
+    QList<QProcess *> running;
+    int               failed = 0;
+
+    while (!pending.isEmpty() || !running.isEmpty()) {
+	// start one worker process per file, up to the number of jobs
+	while (!pending.isEmpty() && (running.count() < Kwave::toInt(jobs))) {
+	    const QString name = pending.takeFirst();
+	    QProcess *worker = new(std::nothrow) QProcess();
+	    Q_ASSERT(worker);
+	    if (!worker) {
+		failed++;
+		continue;
+	    }
+
+	    // the workers write their timing directly to our stdout
+	    worker->setProcessChannelMode(QProcess::ForwardedChannels);
+	    worker->start(QCoreApplication::applicationFilePath(),
+	        QStringList() << _("--batch") << script_file <<
+	                         _("--jobs")  << _("1") << name);
+	    if (!worker->waitForStarted()) {
+		qWarning("unable to start a worker for '%s'", DBG(name));
+		delete worker;
+		failed++;
+		continue;
+	    }
+	    running.append(worker);
+	}
+
+	// collect the workers that have finished
+	QMutableListIterator<QProcess *> it(running);
+	while (it.hasNext()) {
+	    QProcess *worker = it.next();
+	    if (!worker->waitForFinished(10) &&
+	        (worker->state() != QProcess::NotRunning))
+		continue;
+	    if ((worker->exitStatus() != QProcess::NormalExit) ||
+	        worker->exitCode())
+		failed++;
+	    delete worker;
+	    it.remove();
+	}
+    }
+
+    return (failed) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+//***************************************************************************
+//***************************************************************************
@@ -0,0 +1,158 @@
+/***************************************************************************
+         BatchContext.h  -  headless context for batch processing
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef KWAVE_BATCH_CONTEXT_H
+#define KWAVE_BATCH_CONTEXT_H
+
+#include "config.h"
+
+#include <QtGlobal>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+#include "libkwave/CommandHandler.h"
+
+namespace Kwave
+{
+
+    class PluginManager;
+    class SignalManager;
+
+    /**
+     * Headless counterpart of a FileContext: a signal manager and a
+     * plugin manager without any toplevel or main widget. Executes the
+     * same text commands and macro scripts as a FileContext, except for
+     * the commands that only make sense with a GUI, and prints the time
+     * needed for each command to stdout.
+     *
+     * Every line of the timing output has four tab separated columns:
+     * name of the processed file, time in milliseconds, result code and
+     * the command.
+     */
+    class BatchContext: public QObject, public Kwave::CommandHandler
+    {
+	Q_OBJECT
+    public:
+
+	/** Constructor */
+	BatchContext();
+
+	/** Destructor */
+	virtual ~BatchContext() Q_DECL_OVERRIDE;
+
+	/**
+	 * Creates the signal manager and the plugin manager
+	 * and loads all plugins
+	 * @return true if successful
+	 */
+	bool init();
+
+	/**
+	 * Opens a file, executes a script on it and closes it again,
+	 * without saving
+	 * @param script list of lines of the script
+	 * @param file name of the file to process, or an empty string
+	 *             for running the script without a file
+	 * @return zero if succeeded or the result of the failed command
+	 */
+	int runScript(const QStringList &script, const QString &file);
+
+	/**
+	 * Processes a list of files with a script. If more than one job
+	 * is allowed, each file is processed by a separate worker process
+	 * with its own context, the worker processes are started from the
+	 * same executable with "--jobs 1".
+	 * @param script_file name of the script file
+	 * @param files list of files to process, might be empty
+	 * @param jobs maximum number of parallel jobs, or zero for
+	 *             one job per CPU
+	 * @return EXIT_SUCCESS or EXIT_FAILURE if one of the jobs failed
+	 */
+	static int runBatch(const QString &script_file,
+	                    const QStringList &files, unsigned int jobs);
+
+	/** returns the signal manager, only valid after init() */
+	inline Kwave::SignalManager *signalManager() const {
+	    return m_signal_manager;
+	}
+
+    public slots:
+
+	/**
+	 * Executes a Kwave text command
+	 * @param command a text command
+	 * @return zero if succeeded or negative error code if failed
+	 */
+	virtual int executeCommand(const QString &command) Q_DECL_OVERRIDE;
+
+    private:
+
+	/**
+	 * Executes a list of commands, including labels and "GOTO"
+	 * @param lines list of lines of a script
+	 * @return zero if succeeded or the result of the failed command
+	 */
+	int runCommands(const QStringList &lines);
+
+	/**
+	 * Loads a file, after closing the current one without saving
+	 * @param name name or URL of the file
+	 * @return zero if succeeded or error code
+	 */
+	int openFile(const QString &name);
+
+	/** closes the current signal, without saving */
+	void closeSignal();
+
+	/**
+	 * expands the variables ${FILE}, ${DIR}, ${BASENAME} and ${LANG}
+	 * @param command a text command
+	 * @return the command with all known variables replaced
+	 */
+	QString expandVariables(const QString &command) const;
+
+	/**
+	 * Prints one line of timing output
+	 * @param command the text command
+	 * @param ns the time needed by the command [nanoseconds]
+	 * @param result the result of the command
+	 */
+	void printTiming(const QString &command, qint64 ns, int result) const;
+
+	/** processes files in parallel, with worker processes */
+	static int runParallel(const QString &script_file,
+	                       const QStringList &files, unsigned int jobs);
+
+    private:
+
+	/** the signal manager, without parent widget */
+	Kwave::SignalManager *m_signal_manager;
+
+	/** the plugin manager, without parent widget */
+	Kwave::PluginManager *m_plugin_manager;
+
+	/** name of the file that is currently processed */
+	QString m_file;
+
+    };
+}
+
+#endif /* KWAVE_BATCH_CONTEXT_H */
+
+//***************************************************************************
+//***************************************************************************
@@ -0,0 +1,761 @@
+/***************************************************************************
+          Benchmark.cpp  -  benchmarks of the core data paths
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <new>
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QStandardPaths>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QUrl>
+#include <QVariant>
+#include <QVector>
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include "libkwave/ByteOrder.h"
+#include "libkwave/InsertMode.h"
+#include "libkwave/MessageBox.h"
+#include "libkwave/MixerEngine.h"
+#include "libkwave/MultiTrackReader.h"
+#include "libkwave/PluginManager.h"
+#include "libkwave/ReaderMode.h"
+#include "libkwave/SampleConversion.h"
+#include "libkwave/SampleEncoderLinear.h"
+#include "libkwave/SampleFormat.h"
+#include "libkwave/SamplePool.h"
+#include "libkwave/SampleReader.h"
+#include "libkwave/SignalManager.h"
+#include "libkwave/String.h"
+#include "libkwave/Track.h"
+#include "libkwave/Utils.h"
+#include "libkwave/Writer.h"
+#include "libkwave/memcpy.h"
+#include "libkwave/modules/NoiseEngine.h"
+#include "libkwave/modules/RateConverter.h"
+#include "libkwave/modules/Resampler.h"
+#include "plugins/codec_mp3/MP3EncoderSettings.h"
+
+#include "Benchmark.h"
+
+/** number of samples processed per iteration and track */
+#define BENCHMARK_LENGTH (4 * 1024 * 1024)
+
+/** size of one block of samples */
+#define BENCHMARK_BLOCK (64 * 1024)
+
+/** number of edit operations per iteration */
+#define BENCHMARK_EDITS 256
+
+/** number of samples per edit operation */
+#define BENCHMARK_EDIT_LENGTH 4096
+
+/** number of samples per pixel for the min/max benchmark */
+#define BENCHMARK_MINMAX_RANGE 1024
+
+/** sample rate of the test signals */
+#define BENCHMARK_RATE 44100
+
+/** minimum time of all iterations of one benchmark [ns] */
+#define BENCHMARK_MIN_TIME (Q_INT64_C(500) * 1000 * 1000)
+
+/** minimum number of iterations of one benchmark */
+#define BENCHMARK_MIN_ITERATIONS 3
+
+/** maximum number of iterations of one benchmark */
+#define BENCHMARK_MAX_ITERATIONS 1000
+
+/** formats for the SampleEncoderLinear benchmarks */
+static const struct {
+    Kwave::SampleFormat::Format m_format;
+    unsigned int                m_bits;
+    Kwave::byte_order_t         m_endian;
+} g_encoder_formats[] = {
+    { Kwave::SampleFormat::Unsigned,  8, Kwave::LittleEndian },
+    { Kwave::SampleFormat::Signed,   16, Kwave::LittleEndian },
+    { Kwave::SampleFormat::Signed,   16, Kwave::BigEndian    },
+    { Kwave::SampleFormat::Signed,   24, Kwave::LittleEndian },
+    { Kwave::SampleFormat::Signed,   32, Kwave::LittleEndian }
+};
+
+/** commands for the filter benchmarks */
+static const char *g_filter_commands[] = {
+    "plugin:execute(lowpass,1000)",
+    "plugin:execute(notch_filter,1000,100)",
+    "plugin:execute(band_pass,1000,100)"
+};
+
+/** file extensions for the codec benchmarks */
+static const char *g_codec_extensions[] = {
+    "wav",
+    "flac"
+};
+
+//***************************************************************************
+Kwave::Benchmark::Benchmark()
+    :m_context(), m_results(), m_noise(BENCHMARK_BLOCK),
+     m_edit(BENCHMARK_EDIT_LENGTH)
+{
+    // the input data: white noise, reproducible by seed
+    Kwave::NoiseEngine noise(0, 0, Kwave::NoiseEngine::White);
+    QVector<float> buffer(BENCHMARK_BLOCK);
+    noise.generate(buffer.data(), BENCHMARK_BLOCK);
+    Kwave::floats2samples(buffer.constData(), m_noise.data(),
+                          BENCHMARK_BLOCK);
+    MEMCPY(m_edit.data(), m_noise.constData(),
+           BENCHMARK_EDIT_LENGTH * sizeof(sample_t));
+}
+
+//***************************************************************************
+Kwave::Benchmark::~Benchmark()
+{
+}
+
+//***************************************************************************
+int Kwave::Benchmark::runBenchmarks(const QString &output,
+                                    const QStringList &filter)
+{
+    static const Case cases[] = {
+	{ "track/append",           &Kwave::Benchmark::trackAppend,    0 },
+	{ "track/insert",           &Kwave::Benchmark::trackInsert,    0 },
+	{ "track/delete",           &Kwave::Benchmark::trackDelete,    0 },
+	{ "track/overwrite",        &Kwave::Benchmark::trackOverwrite, 0 },
+	{ "track/overwrite_full",   &Kwave::Benchmark::trackOverwrite, 1 },
+	{ "track/overwrite_full_delete_append",
+	  &Kwave::Benchmark::trackOverwrite, 2 },
+	{ "sample_reader/read",     &Kwave::Benchmark::readerRead,     0 },
+	{ "sample_reader/minmax",   &Kwave::Benchmark::readerMinMax,   0 },
+	{ "writer/flush",           &Kwave::Benchmark::writerFlush,    0 },
+	{ "multi_track_reader/2",   &Kwave::Benchmark::multiTrackRead, 2 },
+	{ "multi_track_reader/16",  &Kwave::Benchmark::multiTrackRead, 16 },
+	{ "multi_track_reader/64",  &Kwave::Benchmark::multiTrackRead, 64 },
+	{ "encoder_linear/u8",      &Kwave::Benchmark::encoderLinear,  0 },
+	{ "encoder_linear/s16le",   &Kwave::Benchmark::encoderLinear,  1 },
+	{ "encoder_linear/s16be",   &Kwave::Benchmark::encoderLinear,  2 },
+	{ "encoder_linear/s24le",   &Kwave::Benchmark::encoderLinear,  3 },
+	{ "encoder_linear/s32le",   &Kwave::Benchmark::encoderLinear,  4 },
+	{ "rate_converter/linear",  &Kwave::Benchmark::rateConverter,
+	  Kwave::Resampler::Linear },
+	{ "rate_converter/medium",  &Kwave::Benchmark::rateConverter,
+	  Kwave::Resampler::Medium },
+	{ "rate_converter/best",    &Kwave::Benchmark::rateConverter,
+	  Kwave::Resampler::Best },
+	{ "rate_converter/polyphase", &Kwave::Benchmark::rateConverter,
+	  Kwave::Resampler::Polyphase },
+	{ "channel_mixer/1to2",     &Kwave::Benchmark::channelMixer,   12 },
+	{ "channel_mixer/2to2",     &Kwave::Benchmark::channelMixer,   22 },
+	{ "channel_mixer/2to1",     &Kwave::Benchmark::channelMixer,   21 },
+	{ "channel_mixer/6to2",     &Kwave::Benchmark::channelMixer,   62 },
+	{ "playback/2to2",          &Kwave::Benchmark::playback,       2 },
+	{ "playback/6to2",          &Kwave::Benchmark::playback,       6 },
+	{ "filter/lowpass",         &Kwave::Benchmark::filter,         0 },
+	{ "filter/notch_filter",    &Kwave::Benchmark::filter,         1 },
+	{ "filter/band_pass",       &Kwave::Benchmark::filter,         2 },
+	{ "codec/wav",              &Kwave::Benchmark::codecRoundTrip, 0 },
+	{ "codec/flac",             &Kwave::Benchmark::codecRoundTrip, 1 },
+	{ "encoder/mp3_lame",       &Kwave::Benchmark::encoderMP3,     1 },
+	{ "encoder/mp3_process",    &Kwave::Benchmark::encoderMP3,     0 },
+	{ "startup/plugins_cold",   &Kwave::Benchmark::pluginStartup,  0 },
+	{ "startup/plugins_warm",   &Kwave::Benchmark::pluginStartup,  1 }
+    };
+
+    // there is nobody who could answer a message box
+    Kwave::MessageBox::setInteractive(false);
+
+    Kwave::Benchmark benchmark;
+    if (!benchmark.m_context.init()) return EXIT_FAILURE;
+
+    int failed = 0;
+    for (unsigned int i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+	const QString name = _(cases[i].m_name);
+	bool selected = filter.isEmpty();
+	foreach (const QString &prefix, filter)
+	    if (name.startsWith(prefix)) selected = true;
+	if (!selected) continue;
+
+	if (!benchmark.run(cases[i])) failed++;
+    }
+
+    QJsonObject root;
+    root[_("context")]    = context();
+    root[_("benchmarks")] = benchmark.m_results;
+    const QByteArray json = QJsonDocument(root).toJson();
+
+    QFile file(output);
+    bool ok = (output == _("-")) ?
+	file.open(stdout, QIODevice::WriteOnly) :
+	file.open(QIODevice::WriteOnly);
+    if (!ok || (file.write(json) != json.size())) {
+	qWarning("unable to write the results to '%s'", DBG(output));
+	return EXIT_FAILURE;
+    }
+    file.close();
+
+    return (failed) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+//***************************************************************************
+bool Kwave::Benchmark::run(const Case &c)
+{
+    QVector<qint64> times;
+    qint64          total = 0;
+    quint64         items = 0;
+
+    const Kwave::SamplePool::Statistics pool_before =
+	Kwave::SamplePool::statistics();
+
+    while ((times.count() < BENCHMARK_MIN_ITERATIONS) ||
+           ((total < BENCHMARK_MIN_TIME) &&
+            (times.count() < BENCHMARK_MAX_ITERATIONS)))
+    {
+	items = 0;
+	qint64 ns = (this->*(c.m_function))(c.m_param, items);
+	if (ns < 0) {
+	    qWarning("benchmark '%s' failed: %s", c.m_name,
+	             strerror(Kwave::toInt(-ns)));
+	    QJsonObject result;
+	    result[_("name")]           = _(c.m_name);
+	    result[_("error_occurred")] = true;
+	    result[_("error_message")]  = _(strerror(Kwave::toInt(-ns)));
+	    m_results.append(result);
+	    return false;
+	}
+	times.append(ns);
+	total += ns;
+    }
+
+    // allocations of sample arrays, including the setup of each run
+    const Kwave::SamplePool::Statistics pool_after =
+	Kwave::SamplePool::statistics();
+    const double seconds = static_cast<double>(total) / 1E9;
+    const double allocs  = static_cast<double>(
+	pool_after.m_allocations - pool_before.m_allocations);
+    const double reused  = static_cast<double>(
+	pool_after.m_reused - pool_before.m_reused);
+
+    std::sort(times.begin(), times.end());
+    const int    iterations = times.count();
+    const double mean       = static_cast<double>(total) / iterations;
+    const double median     = static_cast<double>(times[iterations / 2]);
+    const double rate       = (mean > 0) ?
+	(static_cast<double>(items) * 1E9 / mean) : 0.0;
+
+    QJsonObject result;
+    result[_("name")]             = _(c.m_name);
+    result[_("iterations")]       = iterations;
+    result[_("real_time")]        = mean;
+    result[_("median_time")]      = median;
+    result[_("min_time")]         = static_cast<double>(times.first());
+    result[_("time_unit")]        = _("ns");
+    result[_("items_per_second")] = rate;
+    result[_("allocations_per_second")] = (seconds > 0) ?
+	(allocs / seconds) : 0.0;
+    result[_("reused_per_second")] = (seconds > 0) ?
+	(reused / seconds) : 0.0;
+    m_results.append(result);
+
+    qDebug("%-28s %6d x %12.3f ms, %10.3f Msamples/s, %10.0f allocs/s",
+           c.m_name, iterations, mean / 1E6, rate / 1E6,
+           (seconds > 0) ? (allocs / seconds) : 0.0);
+    return true;
+}
+
+//***************************************************************************
+QJsonObject Kwave::Benchmark::context()
+{
+    QJsonObject context;
+    context[_("date")] =
+	QDateTime::currentDateTime().toString(Qt::ISODate);
+    context[_("host_name")]     = QSysInfo::machineHostName();
+    context[_("cpu")]           = QSysInfo::currentCpuArchitecture();
+    context[_("num_cpus")]      = QThread::idealThreadCount();
+    context[_("kwave_version")] = _(KWAVE_VERSION);
+    context[_("sample_bits")]   = SAMPLE_BITS;
+    return context;
+}
+
+//***************************************************************************
+bool Kwave::Benchmark::fill(Kwave::Writer *writer, sample_index_t length)
+{
+    Q_ASSERT(writer);
+    if (!writer) return false;
+
+    while (length >= BENCHMARK_BLOCK) {
+	*writer << m_noise;
+	length -= BENCHMARK_BLOCK;
+    }
+    for (unsigned int i = 0; i < length; ++i)
+	*writer << m_noise[i];
+
+    return writer->flush();
+}
+
+//***************************************************************************
+bool Kwave::Benchmark::newSignal(unsigned int tracks)
+{
+    Kwave::SignalManager *signal_manager = m_context.signalManager();
+    Q_ASSERT(signal_manager);
+    if (!signal_manager) return false;
+
+    const sample_index_t length = BENCHMARK_LENGTH;
+    signal_manager->newSignal(length, BENCHMARK_RATE, 16, tracks);
+    if (signal_manager->tracks() != tracks) return false;
+
+    for (unsigned int track = 0; track < tracks; ++track) {
+	Kwave::Writer *writer = signal_manager->openWriter(
+	    Kwave::Overwrite, track, 0, length - 1);
+	bool ok = fill(writer, length);
+	delete writer;
+	if (!ok) return false;
+    }
+    return true;
+}
+
+//***************************************************************************
+qint64 Kwave::Benchmark::trackAppend(int param, quint64 &items)
+{
+    Q_UNUSED(param)
+    Kwave::Track track;
+    Kwave::Writer *writer = track.openWriter(Kwave::Append);
+    if (!writer) return -ENOMEM;
+
+    QElapsedTimer timer;
+    timer.start();
+    bool ok = fill(writer, BENCHMARK_LENGTH);
+    delete writer;
+    qint64 ns = timer.nsecsElapsed();
+
+    if (!ok || (track.length() != BENCHMARK_LENGTH)) return -EIO;
+    items = BENCHMARK_LENGTH;
+    return ns;
+}
+
+//***************************************************************************
+qint64 Kwave::Benchmark::trackInsert(int param, quint64 &items)
+{
+    Q_UNUSED(param)
+    Kwave::Track track;
+    Kwave::Writer *writer = track.openWriter(Kwave::Append);
+    if (!fill(writer, BENCHMARK_LENGTH)) return -EIO;
+    delete writer;
+
+    QElapsedTimer timer;
+    timer.start();
+    for (unsigned int i = 0; i < BENCHMARK_EDITS; ++i) {
+	const sample_index_t pos = (i * Q_UINT64_C(2654435761)) %
+	    track.length();
+	writer = track.openWriter(Kwave::Insert, pos,
+	                          pos + BENCHMARK_EDIT_LENGTH - 1);
+	if (!writer) return -ENOMEM;
+	*writer << m_edit;
+	bool ok = writer->flush();
+	delete writer;
+	if (!ok) return -EIO;
+    }
+    qint64 ns = timer.nsecsElapsed();
+
+    items = BENCHMARK_EDITS * BENCHMARK_EDIT_LENGTH;
+    return ns;
+}
+
+//***************************************************************************
+qint64 Kwave::Benchmark::trackDelete(int param, quint64 &items)
+{
+    Q_UNUSED(param)
+    Kwave::Track track;
+    Kwave::Writer *writer = track.openWriter(Kwave::Append);
+    if (!fill(writer, BENCHMARK_LENGTH)) return -EIO;
+    delete writer;
+
+    QElapsedTimer timer;
+    timer.start();
+    for (unsigned int i = 0; i < BENCHMARK_EDITS; ++i) {
+	const sample_index_t pos = (i * Q_UINT64_C(2654435761)) %
+	    (track.length() - BENCHMARK_EDIT_LENGTH);
+	track.deleteRange(pos, BENCHMARK_EDIT_LENGTH);
+    }
+    qint64 ns = timer.nsecsElapsed();
+
+    if (track.length() != BENCHMARK_LENGTH -
+        (BENCHMARK_EDITS * BENCHMARK_EDIT_LENGTH))
+	return -EIO;
+    items = BENCHMARK_EDITS * BENCHMARK_EDIT_LENGTH;
+    return ns;
+}
+
+//***************************************************************************
+qint64 Kwave::Benchmark::trackOverwrite(int param, quint64 &items)
+{
+    Kwave::Track track;
+    Kwave::Writer *writer = track.openWriter(Kwave::Append);
+    if (!fill(writer, BENCHMARK_LENGTH)) return -EIO;
+    delete writer;
+
+    QElapsedTimer timer;
+    timer.start();
+    if (param == 2) {
+	// the same, the way it was done before overwriting in place:
+	// each block is deleted, leaving a gap, which the writer then
+	// fills by appending to the stripe before it
+	for (sample_index_t pos = 0; pos < BENCHMARK_LENGTH;
+	     pos += BENCHMARK_BLOCK)
+	{
+	    track.deleteRange(pos, BENCHMARK_BLOCK, true);
+	    writer = track.openWriter(Kwave::Overwrite, pos,
+	                              pos + BENCHMARK_BLOCK - 1);
+	    if (!writer) return -ENOMEM;
+	    *writer << m_noise;
+	    bool ok = writer->flush();
+	    delete writer;
+	    if (!ok) return -EIO;
+	}
+	qint64 ns = timer.nsecsElapsed();
+
+	if (track.length() != BENCHMARK_LENGTH) return -EIO;
+	items = BENCHMARK_LENGTH;
+	return ns;
+    }
+    if (param) {
+	// whole track block by block, like a filter
+	writer = track.openWriter(Kwave::Overwrite, 0, BENCHMARK_LENGTH - 1);
+	if (!fill(writer, BENCHMARK_LENGTH)) return -EIO;
+	delete writer;
+	qint64 ns = timer.nsecsElapsed();
+
+	if (track.length() != BENCHMARK_LENGTH) return -EIO;
+	items = BENCHMARK_LENGTH;
+	return ns;
+    }
+
+    for (unsigned int i = 0; i < BENCHMARK_EDITS; ++i) {
+	const sample_index_t pos = (i * Q_UINT64_C(2654435761)) %
+	    (track.length() - BENCHMARK_EDIT_LENGTH);
+	writer = track.openWriter(Kwave::Overwrite, pos,
+	                          pos + BENCHMARK_EDIT_LENGTH - 1);
+	if (!writer) return -ENOMEM;
+	*writer << m_edit;
+	bool ok = writer->flush();
+	delete writer;
+	if (!ok) return -EIO;
+    }
+    qint64 ns = timer.nsecsElapsed();
+
+    if (track.length() != BENCHMARK_LENGTH) return -EIO;
+    items = BENCHMARK_EDITS * BENCHMARK_EDIT_LENGTH;
+    return ns;
+}
+
+//***************************************************************************
+qint64 Kwave::Benchmark::readerRead(int param, quint64 &items)
+{
+    Q_UNUSED(param)
+    Kwave::Track track;
+    Kwave::Writer *writer = track.openWriter(Kwave::Append);
+    if (!fill(writer, BENCHMARK_LENGTH)) return -EIO;
+    delete writer;
+
+    Kwave::SampleArray buffer(BENCHMARK_BLOCK);
+    QElapsedTimer timer;
+    timer.start();
+    Kwave::SampleReader *reader = track.openReader(
+	Kwave::SinglePassForward, 0, BENCHMARK_LENGTH - 1);
+    if (!reader) return -ENOMEM;
+    while (!reader->eof())
+	items += reader->read(buffer, 0, BENCHMARK_BLOCK);
+    delete reader;
+    qint64 ns = timer.nsecsElapsed();
+
+    return (items == BENCHMARK_LENGTH) ? ns : -EIO;
+}
+
+//***************************************************************************
+qint64 Kwave::Benchmark::readerMinMax(int param, quint64 &items)
+{
+    Q_UNUSED(param)
+    Kwave::Track track;
+    Kwave::Writer *writer = track.openWriter(Kwave::Append);
+    if (!fill(writer, BENCHMARK_LENGTH)) return -EIO;
+    delete writer;
+
+    sample_t min = 0;
+    sample_t max = 0;
+    QElapsedTimer timer;
+    timer.start();
+    Kwave::SampleReader *reader = track.openReader(
+	Kwave::SinglePassForward, 0, BENCHMARK_LENGTH - 1);
+    if (!reader) return -ENOMEM;
+    for (sample_index_t pos = 0; pos < BENCHMARK_LENGTH;
+         pos += BENCHMARK_MINMAX_RANGE)
+	reader->minMax(pos, pos + BENCHMARK_MINMAX_RANGE - 1, min, max);
+    delete reader;
+    qint64 ns = timer.nsecsElapsed();
+
+    if (min >= max) return -EIO;
+    items = BENCHMARK_LENGTH;
+    return ns;
+}
+
+//***************************************************************************
+qint64 Kwave::Benchmark::writerFlush(int param, quint64 &items)
+{
+    Q_UNUSED(param)
+    Kwave::Track track;
+    Kwave::Writer *writer = track.openWriter(Kwave::Append);
+    if (!writer) return -ENOMEM;
+
+    QElapsedTimer timer;
+    timer.start();
+    for (unsigned int i = 0; i < BENCHMARK_LENGTH; ++i)
+	*writer << m_noise[i % BENCHMARK_BLOCK];
+    bool ok = writer->flush();
+    delete writer;
+    qint64 ns = timer.nsecsElapsed();
+
+    if (!ok || (track.length() != BENCHMARK_LENGTH)) return -EIO;
+    items = BENCHMARK_LENGTH;
+    return ns;
+}
+
+//***************************************************************************
+qint64 Kwave::Benchmark::multiTrackRead(int param, quint64 &items)
+{
+    const unsigned int tracks = Kwave::toUint(param);
+    Kwave::SignalManager *signal_manager = m_context.signalManager();
+    if (!newSignal(tracks)) return -ENOMEM;
+
+    Kwave::SampleArray buffer(BENCHMARK_BLOCK);
+    QElapsedTimer timer;
+    timer.start();
+    Kwave::MultiTrackReader reader(Kwave::SinglePassForward,
+	*signal_manager, signal_manager->allTracks(),
+	0, BENCHMARK_LENGTH - 1);
+    if (reader.tracks() != tracks) return -ENOMEM;
+    while (!reader.eof()) {
+	for (unsigned int track = 0; track < tracks; ++track)
+	    items += reader[track]->read(buffer, 0, BENCHMARK_BLOCK);
+    }
+    qint64 ns = timer.nsecsElapsed();
+
+    signal_manager->close();
+    return (items == quint64(BENCHMARK_LENGTH) * tracks) ? ns : -EIO;
+}
+
+//***************************************************************************
+qint64 Kwave::Benchmark::encoderLinear(int param, quint64 &items)
+{
+    Kwave::SampleEncoderLinear encoder(
+	g_encoder_formats[param].m_format,
+	g_encoder_formats[param].m_bits,
+	g_encoder_formats[param].m_endian);
+    QByteArray raw(BENCHMARK_BLOCK * encoder.rawBytesPerSample(), 0);
+
+    QElapsedTimer timer;
+    timer.start();
+    for (items = 0; items < BENCHMARK_LENGTH; items += BENCHMARK_BLOCK)
+	encoder.encode(m_noise, BENCHMARK_BLOCK, raw);
+    return timer.nsecsElapsed();
+}
+
+//***************************************************************************
+qint64 Kwave::Benchmark::rateConverter(int param, quint64 &items)
+{
+    Kwave::RateConverter converter;
+    converter.setQuality(QVariant(param));
+    converter.setRatio(QVariant(48000.0 / 44100.0));
+
+    QElapsedTimer timer;
+    timer.start();
+    for (items = 0; items < BENCHMARK_LENGTH; items += BENCHMARK_BLOCK)
+	converter.input(m_noise);
+    return timer.nsecsElapsed();
+}
+
+//***************************************************************************
+qint64 Kwave::Benchmark::channelMixer(int param, quint64 &items)
+{
+    const unsigned int inputs  = Kwave::toUint(param / 10);
+    const unsigned int outputs = Kwave::toUint(param % 10);
+    Kwave::MixerEngine mixer(inputs, outputs);
+
+    QVector<Kwave::SampleArray> out(outputs);
+    QVector<const sample_t *>   in_ptr(inputs);
+    QVector<sample_t *>         out_ptr(outputs);
+    for (unsigned int i = 0; i < inputs; ++i)
+	in_ptr[i] = m_noise.constData();
+    for (unsigned int i = 0; i < outputs; ++i) {
+	if (!out[i].resize(BENCHMARK_BLOCK)) return -ENOMEM;
+	out_ptr[i] = out[i].data();
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    for (items = 0; items < BENCHMARK_LENGTH; items += BENCHMARK_BLOCK)
+	mixer.mix(in_ptr.constData(), out_ptr.constData(), BENCHMARK_BLOCK);
+    return timer.nsecsElapsed();
+}
+
+//***************************************************************************
+qint64 Kwave::Benchmark::playback(int param, quint64 &items)
+{
+    const unsigned int tracks   = Kwave::toUint(param);
+    const unsigned int channels = 2;
+    Kwave::SignalManager *signal_manager = m_context.signalManager();
+    if (!newSignal(tracks)) return -ENOMEM;
+
+    Kwave::MixerEngine mixer(tracks, channels);
+    Kwave::SampleArray in_samples(tracks);
+    Kwave::SampleArray out_samples(channels);
+
+    // the same as the PlaybackController does, without a device
+    QElapsedTimer timer;
+    timer.start();
+    Kwave::MultiTrackReader input(Kwave::FullSnapshot,
+	*signal_manager, signal_manager->allTracks(),
+	0, BENCHMARK_LENGTH - 1);
+    if (input.tracks() != tracks) return -ENOMEM;
+    for (items = 0; items < BENCHMARK_LENGTH; ++items) {
+	for (unsigned int track = 0; track < tracks; ++track)
+	    *(input[track]) >> in_samples[track];
+	mixer.mixFrame(in_samples.constData(), out_samples.data());
+    }
+    qint64 ns = timer.nsecsElapsed();
+
+    signal_manager->close();
+    return ns;
+}
+
+//***************************************************************************
+qint64 Kwave::Benchmark::filter(int param, quint64 &items)
+{
+    const unsigned int tracks = 2;
+    if (!newSignal(tracks)) return -ENOMEM;
+    m_context.executeCommand(_("selectall()"));
+
+    QElapsedTimer timer;
+    timer.start();
+    int result = m_context.executeCommand(_(g_filter_commands[param]));
+    m_context.executeCommand(_("sync()"));
+    qint64 ns = timer.nsecsElapsed();
+
+    m_context.executeCommand(_("close()"));
+    if (result < 0) return result;
+    if (result) return -EIO;
+    items = quint64(BENCHMARK_LENGTH) * tracks;
+    return ns;
+}
+
+//***************************************************************************
+qint64 Kwave::Benchmark::codecRoundTrip(int param, quint64 &items)
+{
+    const unsigned int tracks = 2;
+    Kwave::SignalManager *signal_manager = m_context.signalManager();
+    QTemporaryDir dir;
+    if (!dir.isValid()) return -EIO;
+    const QUrl url = QUrl::fromLocalFile(dir.path() + _("/benchmark.") +
+	_(g_codec_extensions[param]));
+    if (!newSignal(tracks)) return -ENOMEM;
+
+    QElapsedTimer timer;
+    timer.start();
+    int result = signal_manager->save(url, false);
+    signal_manager->close();
+    if (!result) result = signal_manager->loadFile(url);
+    qint64 ns = timer.nsecsElapsed();
+
+    bool ok = (signal_manager->length() == BENCHMARK_LENGTH) &&
+              (signal_manager->tracks() == tracks);
+    m_context.executeCommand(_("close()"));
+    if (result) return (result < 0) ? result : -EIO;
+    if (!ok) return -EIO;
+    items = quint64(BENCHMARK_LENGTH) * tracks;
+    return ns;
+}
+
+//***************************************************************************
+qint64 Kwave::Benchmark::encoderMP3(int param, quint64 &items)
+{
+    const unsigned int tracks = 2;
+    Kwave::SignalManager *signal_manager = m_context.signalManager();
+    QTemporaryDir dir;
+    if (!dir.isValid()) return -EIO;
+    const QUrl url = QUrl::fromLocalFile(dir.path() + _("/benchmark.mp3"));
+    if (!newSignal(tracks)) return -ENOMEM;
+
+    // hidden option of the MP3 encoder: LAME library or external program,
+    // only changed in memory, without the flag "Persistent" it never gets
+    // written to the config file of the user
+    const KConfigBase::WriteConfigFlags transient =
+	KConfigBase::WriteConfigFlags();
+    KConfigGroup cfg =
+	KSharedConfig::openConfig()->group(MP3_ENCODER_CONFIG_GROUP);
+    const bool use_library = cfg.readEntry(MP3_ENCODER_USE_LIBRARY, true);
+    cfg.writeEntry(MP3_ENCODER_USE_LIBRARY, (param != 0), transient);
+
+    QElapsedTimer timer;
+    timer.start();
+    int result = signal_manager->save(url, false);
+    qint64 ns = timer.nsecsElapsed();
+
+    cfg.writeEntry(MP3_ENCODER_USE_LIBRARY, use_library, transient);
+    m_context.executeCommand(_("close()"));
+    if (result) return (result < 0) ? result : -EIO;
+    items = quint64(BENCHMARK_LENGTH) * tracks;
+    return ns;
+}
+
+//***************************************************************************
+qint64 Kwave::Benchmark::pluginStartup(int param, quint64 &items)
+{
+    Kwave::SignalManager *signal_manager = m_context.signalManager();
+    Q_ASSERT(signal_manager);
+    if (!signal_manager) return -EINVAL;
+
+    // without the manifest all plugins are loaded once, like on the
+    // first start or after an update
+    if (!param) QFile::remove(QStandardPaths::writableLocation(
+	QStandardPaths::CacheLocation) + _("/plugin-manifest"));
+
+    Kwave::PluginManager *manager = new(std::nothrow)
+	Kwave::PluginManager(Q_NULLPTR, *signal_manager);
+    if (!manager) return -ENOMEM;
+    manager->searchPluginModules();
+
+    QElapsedTimer timer;
+    timer.start();
+    bool ok = manager->loadAllPlugins();
+    qint64 ns = timer.nsecsElapsed();
+
+    items = manager->pluginInfoList().count();
+    delete manager;
+    return (ok) ? ns : -EIO;
+}
+
+//***************************************************************************
+//***************************************************************************
@@ -0,0 +1,196 @@
+/***************************************************************************
+            Benchmark.h  -  benchmarks of the core data paths
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef KWAVE_BENCHMARK_H
+#define KWAVE_BENCHMARK_H
+
+#include "config.h"
+
+#include <QtGlobal>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+
+#include "libkwave/Sample.h"
+#include "libkwave/SampleArray.h"
+
+#include "BatchContext.h"
+
+namespace Kwave
+{
+
+    class Writer;
+
+    /**
+     * Runs a set of benchmarks on the core data paths of libkwave and
+     * the codec and filter plugins, within a headless Kwave::BatchContext.
+     *
+     * Each benchmark is repeated until a minimum time has passed, the
+     * results are written as JSON, in the same format as produced by
+     * "Google Benchmark", so that the usual tools for comparing runs can
+     * be used for finding regressions.
+     */
+    class Benchmark
+    {
+    public:
+
+	/** Constructor */
+	Benchmark();
+
+	/** Destructor */
+	virtual ~Benchmark();
+
+	/**
+	 * Runs all benchmarks and writes the results to a file
+	 * @param output name of the JSON file, "-" for stdout
+	 * @param filter list of prefixes of names of benchmarks to run,
+	 *               or empty for running all of them
+	 * @return EXIT_SUCCESS or EXIT_FAILURE if a benchmark failed
+	 */
+	static int runBenchmarks(const QString &output,
+	                         const QStringList &filter);
+
+    private:
+
+	/**
+	 * One iteration of a benchmark. Only the part of the work that
+	 * should be measured is timed, preparation is excluded.
+	 * @param param parameter of the benchmark, meaning depends on it
+	 * @param items receives the number of samples that have been
+	 *              processed
+	 * @return time of the iteration [ns] or negative error code
+	 */
+	typedef qint64 (Kwave::Benchmark::*Function)(int param,
+	                                              quint64 &items);
+
+	/** description of one benchmark */
+	typedef struct {
+	    const char *m_name;     /**< name, used for filtering     */
+	    Function    m_function; /**< function for one iteration   */
+	    int         m_param;    /**< parameter of the function    */
+	} Case;
+
+	/**
+	 * Runs one benchmark and appends the result
+	 * @param c the benchmark
+	 * @return true if succeeded
+	 */
+	bool run(const Case &c);
+
+	/** returns an object with information about the system */
+	static QJsonObject context();
+
+	/**
+	 * Writes noise into a writer and flushes it
+	 * @param writer a Writer for a track
+	 * @param length number of samples to write
+	 * @return true if succeeded
+	 */
+	bool fill(Kwave::Writer *writer, sample_index_t length);
+
+	/**
+	 * Creates a new signal with noise in the batch context
+	 * @param tracks number of tracks
+	 * @return true if succeeded
+	 */
+	bool newSignal(unsigned int tracks);
+
+	/** appends samples to an empty track */
+	qint64 trackAppend(int param, quint64 &items);
+
+	/** inserts blocks of samples into a track */
+	qint64 trackInsert(int param, quint64 &items);
+
+	/** deletes ranges of samples from a track */
+	qint64 trackDelete(int param, quint64 &items);
+
+	/**
+	 * overwrites ranges of samples within a track
+	 * @param param 0 for random short ranges, 1 for the whole track,
+	 *              2 for the whole track with delete and append per
+	 *              block (the path used before overwriting in place)
+	 */
+	qint64 trackOverwrite(int param, quint64 &items);
+
+	/** reads a track block by block with SampleReader::read() */
+	qint64 readerRead(int param, quint64 &items);
+
+	/** SampleReader::minMax() of short ranges, as for the overview */
+	qint64 readerMinMax(int param, quint64 &items);
+
+	/** writes single samples through the buffer of a Writer */
+	qint64 writerFlush(int param, quint64 &items);
+
+	/** reads param tracks through a MultiTrackReader */
+	qint64 multiTrackRead(int param, quint64 &items);
+
+	/** SampleEncoderLinear, param = index of the format */
+	qint64 encoderLinear(int param, quint64 &items);
+
+	/** RateConverter, param = Kwave::Resampler::Quality */
+	qint64 rateConverter(int param, quint64 &items);
+
+	/** mixer of ChannelMixer, param = inputs * 10 + outputs */
+	qint64 channelMixer(int param, quint64 &items);
+
+	/**
+	 * reading and mixing frame by frame like the playback, without
+	 * a device, param = number of tracks, mixed to two channels
+	 */
+	qint64 playback(int param, quint64 &items);
+
+	/** filter plugin, param = index of the filter */
+	qint64 filter(int param, quint64 &items);
+
+	/** round trip through a codec, param = index of the codec */
+	qint64 codecRoundTrip(int param, quint64 &items);
+
+	/**
+	 * saving as MP3, param = 1 with the LAME library in-process,
+	 * 0 through the external program
+	 */
+	qint64 encoderMP3(int param, quint64 &items);
+
+	/**
+	 * loadAllPlugins() of a new plugin manager, as on the start of
+	 * a new window. The items are the plugin modules.
+	 * @param param 0 without the plugin manifest (cold), 1 with it (warm)
+	 */
+	qint64 pluginStartup(int param, quint64 &items);
+
+    private:
+
+	/** headless context with the signal manager and all plugins */
+	Kwave::BatchContext m_context;
+
+	/** list of results */
+	QJsonArray m_results;
+
+	/** one block of white noise, used as input data */
+	Kwave::SampleArray m_noise;
+
+	/** a short block of noise, for inserting and overwriting */
+	Kwave::SampleArray m_edit;
+
+    };
+}
+
+#endif /* KWAVE_BENCHMARK_H */
+
+//***************************************************************************
+//***************************************************************************
@@ -452,27 +452,7 @@ int Kwave::MainWidget::executeCommand(const QString &command)
 		m_offset + (visible_samples / 2));
 	setOffset((ofs > (visible_samples / 2)) ?
 	          (ofs - (visible_samples / 2)) : 0);
-    // -- selection --
-    CASE_COMMAND("selectall")
-	signal_manager->selectRange(0, signal_manager->length());
-    CASE_COMMAND("selectnext")
-	if (signal_manager->selection().length())
-	    signal_manager->selectRange(signal_manager->selection().last() + 1,
-	                signal_manager->selection().length());
-	else
-	    signal_manager->selectRange(signal_manager->length() - 1, 0);
-    CASE_COMMAND("selectprev")
-	sample_index_t ofs = signal_manager->selection().first();
-	sample_index_t len = signal_manager->selection().length();
-	if (!len) len = 1;
-	if (len > ofs) len = ofs;
-	signal_manager->selectRange(ofs - len, len);
-    CASE_COMMAND("selecttoleft")
-	signal_manager->selectRange(0, signal_manager->selection().last() + 1);
-    CASE_COMMAND("selecttoright")
-	signal_manager->selectRange(signal_manager->selection().first(),
-	    signal_manager->length() - signal_manager->selection().first()
-	);
+    // -- selection, depending on the view --
     CASE_COMMAND("selectvisible")
 	signal_manager->selectRange(m_offset, visibleSamples());
     CASE_COMMAND("selectnone")
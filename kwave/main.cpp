@@ -18,6 +18,7 @@
 #include "config.h"
 
 #include <errno.h>
+#include <string.h>
 
 #include <QApplication>
 #include <QCommandLineParser>
@@ -30,9 +31,12 @@
 #include <KLocalizedString>
 #include <kxmlgui_version.h>
 
+#include "libkwave/Profiler.h"
 #include "libkwave/String.h"
 
 #include "App.h"
+#include "BatchContext.h"
+#include "Benchmark.h"
 #include "Splash.h"
 
 /**
@@ -146,6 +150,35 @@ static void addDataStrings(KAboutData &aboutdata)
 	QString());
 }
 
+/**
+ * Profiles the whole session if the environment variable KWAVE_TRACE
+ * contains a file name, and writes a Chrome trace into that file when
+ * leaving main()
+ */
+class SessionTrace
+{
+public:
+    /** Constructor, enables the profiler if requested */
+    SessionTrace()
+	:m_filename(qEnvironmentVariable("KWAVE_TRACE"))
+    {
+	if (m_filename.length()) Kwave::Profiler::setEnabled(true);
+    }
+
+    /** Destructor, writes the trace */
+    virtual ~SessionTrace()
+    {
+	if (!m_filename.length()) return;
+	Kwave::Profiler::setEnabled(false);
+	if (!Kwave::Profiler::writeChromeTrace(m_filename))
+	    qWarning("unable to write trace to '%s'", DBG(m_filename));
+    }
+
+private:
+    /** name of the trace file, or empty */
+    QString m_filename;
+};
+
 #ifdef WITH_OPTIMIZED_MEMCPY
 /* forward declaration to libkwave/memcpy.c */
 extern "C" void probe_fast_memcpy(void);
@@ -156,8 +189,21 @@ int main(int argc, char **argv)
 {
     int retval = 0;
 
+    // batch and benchmark mode run without any window, use the
+    // "offscreen" platform unless a platform has been selected explicitly
+    for (int i = 1; i < argc; ++i) {
+	if (!strcmp(argv[i], "--batch") || !strncmp(argv[i], "--batch=", 8) ||
+	    !strcmp(argv[i], "--benchmark") ||
+	    !strncmp(argv[i], "--benchmark=", 12)) {
+	    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+	    break;
+	}
+    }
+
     // create the application instance first
     Kwave::App app(argc, argv);
+    SessionTrace trace;
 
     // initialize the crash handler (only if KCrash >= 5.15 is available)
 #if KCrash_VERSION >= ((5 << 16) | (15 << 8) | (0))
@@ -188,6 +234,29 @@ int main(int argc, char **argv)
 	      "Select a GUI type: SDI, MDI or TAB mode."),
 	i18nc("placeholder of command line parameter", "sdi|mdi|tab")
     ));
+    cmdline.addOption(QCommandLineOption(
+	_("batch"),
+	i18nc("description of command line parameter",
+	      "Run the Kwave macro file <script> on each of the given "\
+	      "files, without GUI, and print the time of each command."),
+	i18nc("placeholder of command line parameter", "script")
+    ));
+    cmdline.addOption(QCommandLineOption(
+	_("jobs"),
+	i18nc("description of command line parameter",
+	      "Number of files processed in parallel in batch mode, "\
+	      "default is one per CPU."),
+	i18nc("placeholder of command line parameter", "count")
+    ));
+    cmdline.addOption(QCommandLineOption(
+	_("benchmark"),
+	i18nc("description of command line parameter",
+	      "Run the benchmarks of the core functions, without GUI, and "\
+	      "write the results to a JSON file <file>, or to stdout if "\
+	      "<file> is \"-\". The files argument can be used for "\
+	      "selecting benchmarks by the start of their names."),
+	i18nc("placeholder of command line parameter", "file")
+    ));
     cmdline.addPositionalArgument(
 	_("files"),
 	i18nc("description of command line parameter",
@@ -230,15 +299,30 @@ int main(int argc, char **argv)
     about.setupCommandLine(&cmdline);
     about.processCommandLine(&cmdline);
 
-    /* let Kwave be a "unique" application, only one instance */
-    KDBusService service(KDBusService::Unique);
-
      /* check for an optimized version of memcpy() */
 #ifdef WITH_OPTIMIZED_MEMCPY
     probe_fast_memcpy();
     qDebug("\n");
 #endif /* WITH_OPTIMIZED_MEMCPY */
 
+    /* batch mode: no windows, no splash screen, no DBus service */
+    if (cmdline.isSet(_("batch"))) {
+	unsigned int jobs = 0;
+	if (cmdline.isSet(_("jobs")))
+	    jobs = cmdline.value(_("jobs")).toUInt();
+	return Kwave::BatchContext::runBatch(cmdline.value(_("batch")),
+	    cmdline.positionalArguments(), jobs);
+    }
+
+    /* benchmark mode, also without windows */
+    if (cmdline.isSet(_("benchmark"))) {
+	return Kwave::Benchmark::runBenchmarks(cmdline.value(_("benchmark")),
+	    cmdline.positionalArguments());
+    }
+
+    /* let Kwave be a "unique" application, only one instance */
+    KDBusService service(KDBusService::Unique);
+
     // check whether to start up without splash screen or in iconic mode
     // which implicitly also disables the splash screen
     Kwave::Splash splash(_("pics/kwave-splash.png"));
@@ -23,6 +23,7 @@
 
 #include <QApplication>
 #include <QDialog>
+#include <QMetaObject>
 #include <QStringList>
 
 #include <KLocalizedString>
@@ -37,6 +38,28 @@
 
 #include "libgui/FilterPlugin.h"
 
+//***************************************************************************
+/**
+ * Checks whether the first track of a stream object provides a given
+ * signal or slot
+ * @param obj the stream object
+ * @param port name of the signal or slot, as from SIGNAL() or SLOT()
+ * @return true if the signal or slot exists
+ */
+static bool hasPort(Kwave::StreamObject &obj, const char *port)
+{
+    Kwave::StreamObject *track = obj.port(port, 0);
+    if (!track || !port || !port[0]) return false;
+
+    // the first character is the code added by the SIGNAL()/SLOT() macro
+    const QMetaObject *meta = track->metaObject();
+    const QByteArray signature = QMetaObject::normalizedSignature(port + 1);
+    const int index = (port[0] == ('0' + QSIGNAL_CODE)) ?
+	meta->indexOfSignal(signature.constData()) :
+	meta->indexOfSlot(signature.constData());
+    return (index >= 0);
+}
+
 //***************************************************************************
 Kwave::FilterPlugin::FilterPlugin(QObject *parent, const QVariantList &args)
     :Kwave::Plugin(parent, args),
@@ -152,11 +175,22 @@ void Kwave::FilterPlugin::run(QStringList params)
     // force initial update of the filter settings
     updateFilter(filter, true);
 
-    // connect them
-    Kwave::connect(source,  SIGNAL(output(Kwave::SampleArray)),
-                   *filter, SLOT(input(Kwave::SampleArray)));
-    Kwave::connect(*filter, SIGNAL(output(Kwave::SampleArray)),
-                   *m_sink, SLOT(input(Kwave::SampleArray)));
+    // connect them, in float representation if filter and sink support
+    // it, which avoids clipping and conversion within the filter
+    if (hasPort(*filter, SLOT(input(Kwave::FloatArray))) &&
+	hasPort(*filter, SIGNAL(output(Kwave::FloatArray))) &&
+	hasPort(*m_sink, SLOT(input(Kwave::FloatArray))))
+    {
+	Kwave::connect(source,  SIGNAL(output(Kwave::FloatArray)),
+	               *filter, SLOT(input(Kwave::FloatArray)));
+	Kwave::connect(*filter, SIGNAL(output(Kwave::FloatArray)),
+	               *m_sink, SLOT(input(Kwave::FloatArray)));
+    } else {
+	Kwave::connect(source,  SIGNAL(output(Kwave::SampleArray)),
+	               *filter, SLOT(input(Kwave::SampleArray)));
+	Kwave::connect(*filter, SIGNAL(output(Kwave::SampleArray)),
+	               *m_sink, SLOT(input(Kwave::SampleArray)));
+    }
 
     // transport the samples
     while (!shouldStop() && (!source.done() || m_listen)) {
@@ -409,8 +409,9 @@ void Kwave::TrackView::paintEvent(QPaintEvent *)
 
 	int last_marker = -1;
 	const sample_index_t last_visible = lastVisible();
-	foreach (const Kwave::Label &label,
-	         Kwave::LabelList(m_signal_manager->metaData()))
+	foreach (const Kwave::Label &label, Kwave::LabelList(
+	         m_signal_manager->metaData().selectByRange(
+	             m_offset, last_visible)))
 	{
 	    sample_index_t pos = label.pos();
 	    if (pos < m_offset)     continue; // outside left
@@ -0,0 +1,112 @@
+/***************************************************************************
+       ChangeJournal.cpp  -  collects and merges changes of a track
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "config.h"
+
+#include <QMutexLocker>
+
+#include "libkwave/ChangeJournal.h"
+
+//***************************************************************************
+Kwave::ChangeJournal::ChangeJournal()
+    :m_lock(), m_changes()
+{
+}
+
+//***************************************************************************
+Kwave::ChangeJournal::~ChangeJournal()
+{
+}
+
+//***************************************************************************
+bool Kwave::ChangeJournal::record(Kind kind, sample_index_t offset,
+                                  sample_index_t length)
+{
+    QMutexLocker lock(&m_lock);
+
+    if (!m_changes.isEmpty()) {
+	Change &last = m_changes.last();
+	const sample_index_t last_end = last.m_offset + last.m_length;
+
+	switch (kind) {
+	    case Inserted:
+		// appended directly after the last inserted block
+		if ((last.m_kind == Inserted) && (offset == last_end)) {
+		    last.m_length += length;
+		    return false;
+		}
+		break;
+	    case Deleted:
+		// deleted directly after the last deleted block
+		if ((last.m_kind == Deleted) && (offset == last.m_offset)) {
+		    last.m_length += length;
+		    return false;
+		}
+		break;
+	    case Modified:
+		// within freshly inserted samples -> nothing new
+		if ((last.m_kind == Inserted) && (offset >= last.m_offset) &&
+		    (offset + length <= last_end))
+		    return false;
+
+		// overlapping or touching the last modified range
+		if ((last.m_kind == Modified) && (offset <= last_end) &&
+		    (offset + length >= last.m_offset))
+		{
+		    const sample_index_t end =
+			qMax(last_end, offset + length);
+		    last.m_offset = qMin(last.m_offset, offset);
+		    last.m_length = end - last.m_offset;
+		    return false;
+		}
+		break;
+	}
+    }
+
+    Change change;
+    change.m_kind   = kind;
+    change.m_offset = offset;
+    change.m_length = length;
+    m_changes.append(change);
+    return (m_changes.count() == 1);
+}
+
+//***************************************************************************
+QList<Kwave::ChangeJournal::Change> Kwave::ChangeJournal::pending() const
+{
+    QMutexLocker lock(&m_lock);
+    return m_changes;
+}
+
+//***************************************************************************
+QList<Kwave::ChangeJournal::Change> Kwave::ChangeJournal::take()
+{
+    QMutexLocker lock(&m_lock);
+    QList<Change> changes = m_changes;
+    m_changes.clear();
+    return changes;
+}
+
+//***************************************************************************
+bool Kwave::ChangeJournal::isEmpty() const
+{
+    QMutexLocker lock(&m_lock);
+    return m_changes.isEmpty();
+}
+
+//***************************************************************************
+//***************************************************************************
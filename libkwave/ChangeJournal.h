@@ -0,0 +1,96 @@
+/***************************************************************************
+         ChangeJournal.h  -  collects and merges changes of a track
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef CHANGE_JOURNAL_H
+#define CHANGE_JOURNAL_H
+
+#include "config.h"
+
+#include <QtGlobal>
+#include <QList>
+#include <QMutex>
+
+#include "libkwave/Sample.h"
+
+namespace Kwave
+{
+
+    /**
+     * Thread safe list of pending changes of a track (inserted, deleted
+     * or modified ranges of samples), which have not been delivered to
+     * the views and caches yet. A new change is merged with the last
+     * one where this does not change the result for the receivers, for
+     * example consecutive blocks appended by a writer or neighbour
+     * blocks overwritten by a filter.
+     */
+    class Q_DECL_EXPORT ChangeJournal
+    {
+    public:
+
+	/** kind of a change */
+	typedef enum {
+	    Inserted, /**< samples have been inserted */
+	    Deleted,  /**< samples have been deleted  */
+	    Modified  /**< samples have been modified */
+	} Kind;
+
+	/** one entry in the journal */
+	typedef struct {
+	    Kind           m_kind;   /**< kind of the change          */
+	    sample_index_t m_offset; /**< index of the first sample   */
+	    sample_index_t m_length; /**< number of samples           */
+	} Change;
+
+	/** Constructor */
+	ChangeJournal();
+
+	/** Destructor */
+	virtual ~ChangeJournal();
+
+	/**
+	 * Appends a change to the journal, or merges it with the last one
+	 * @param kind the kind of the change
+	 * @param offset index of the first sample
+	 * @param length number of samples
+	 * @return true if the journal was empty before
+	 */
+	bool record(Kind kind, sample_index_t offset, sample_index_t length);
+
+	/** returns a copy of all pending changes, in chronological order */
+	QList<Kwave::ChangeJournal::Change> pending() const;
+
+	/** removes and returns all pending changes */
+	QList<Kwave::ChangeJournal::Change> take();
+
+	/** returns true if there are no pending changes */
+	bool isEmpty() const;
+
+    private:
+
+	/** lock for the list of changes */
+	mutable QMutex m_lock;
+
+	/** list of pending changes */
+	QList<Kwave::ChangeJournal::Change> m_changes;
+
+    };
+}
+
+#endif /* CHANGE_JOURNAL_H */
+
+//***************************************************************************
+//***************************************************************************
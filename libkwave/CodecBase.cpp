@@ -86,6 +86,12 @@ void Kwave::CodecBase::addMimeType(const char *name,
     m_supported_mime_types.append(type);
 }
 
+/***************************************************************************/
+void Kwave::CodecBase::addMimeType(const Kwave::CodecBase::MimeType &type)
+{
+    m_supported_mime_types.append(type);
+}
+
 /***************************************************************************/
 void Kwave::CodecBase::addCompression(Kwave::Compression::Type compression)
 {
@@ -80,6 +80,13 @@ namespace Kwave
 	                         const QString &description,
 	                         const char *patterns);
 
+	/**
+	 * Adds a mime type to the internal list of supported mime types
+	 * as it is, without looking it up in the system.
+	 * @param type the mime type, with name, description and patterns
+	 */
+	virtual void addMimeType(const Kwave::CodecBase::MimeType &type);
+
 	/**
 	 * Adds a new compression type to the internal list of supported
 	 * compression types.
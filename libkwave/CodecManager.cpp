@@ -17,21 +17,29 @@
 
 #include "config.h"
 
+#include <new>
+
+#include <QCoreApplication>
 #include <QLatin1Char>
 #include <QMimeData>
+#include <QMutexLocker>
 #include <QRegExp>
 #include <QMimeDatabase>
 #include <QMimeType>
+#include <QThread>
 
 #include "libkwave/CodecManager.h"
+#include "libkwave/CodecProxy.h"
 #include "libkwave/Decoder.h"
 #include "libkwave/Encoder.h"
+#include "libkwave/PluginManager.h"
 #include "libkwave/String.h"
 
 //***************************************************************************
 /* static initializers */
 QList<Kwave::Encoder *> Kwave::CodecManager::m_encoders;
 QList<Kwave::Decoder *> Kwave::CodecManager::m_decoders;
+QMutex Kwave::CodecManager::m_lock(QMutex::Recursive);
 
 //***************************************************************************
 //***************************************************************************
@@ -49,6 +57,8 @@ Kwave::CodecManager::~CodecManager()
 //***************************************************************************
 void Kwave::CodecManager::registerEncoder(Kwave::Encoder &encoder)
 {
+    QMutexLocker lock(&m_lock);
+
     if (m_encoders.contains(&encoder)) return; /* already known */
     m_encoders.append(&encoder);
 }
@@ -56,6 +66,8 @@ void Kwave::CodecManager::registerEncoder(Kwave::Encoder &encoder)
 //***************************************************************************
 void Kwave::CodecManager::unregisterEncoder(Kwave::Encoder *encoder)
 {
+    QMutexLocker lock(&m_lock);
+
     if (!m_encoders.contains(encoder)) return; /* unknown */
     m_encoders.removeAll(encoder);
 }
@@ -63,6 +75,8 @@ void Kwave::CodecManager::unregisterEncoder(Kwave::Encoder *encoder)
 //***************************************************************************
 void Kwave::CodecManager::registerDecoder(Kwave::Decoder &decoder)
 {
+    QMutexLocker lock(&m_lock);
+
     if (m_decoders.contains(&decoder)) return; /* already known */
     m_decoders.append(&decoder);
 }
@@ -70,13 +84,106 @@ void Kwave::CodecManager::registerDecoder(Kwave::Decoder &decoder)
 //***************************************************************************
 void Kwave::CodecManager::unregisterDecoder(Kwave::Decoder *decoder)
 {
+    QMutexLocker lock(&m_lock);
+
     if (!m_decoders.contains(decoder)) return; /* unknown */
     m_decoders.removeAll(decoder);
 }
 
+//***************************************************************************
+void Kwave::CodecManager::registerCodecModule(
+    const QString &module,
+    const QList<Kwave::CodecBase::MimeType> &encoding,
+    const QList<Kwave::CodecBase::MimeType> &decoding)
+{
+    QMutexLocker lock(&m_lock);
+
+    // register only once, the proxies are shared by all windows
+    foreach (Kwave::Encoder *e, m_encoders) {
+	Kwave::EncoderProxy *proxy = dynamic_cast<Kwave::EncoderProxy *>(e);
+	if (proxy && (proxy->module() == module)) return;
+    }
+    foreach (Kwave::Decoder *d, m_decoders) {
+	Kwave::DecoderProxy *proxy = dynamic_cast<Kwave::DecoderProxy *>(d);
+	if (proxy && (proxy->module() == module)) return;
+    }
+
+    if (!encoding.isEmpty()) {
+	Kwave::Encoder *proxy =
+	    new(std::nothrow) Kwave::EncoderProxy(module, encoding);
+	if (proxy) registerEncoder(*proxy);
+    }
+    if (!decoding.isEmpty()) {
+	Kwave::Decoder *proxy =
+	    new(std::nothrow) Kwave::DecoderProxy(module, decoding);
+	if (proxy) registerDecoder(*proxy);
+    }
+}
+
+//***************************************************************************
+void Kwave::CodecManager::unregisterCodecModule(const QString &module)
+{
+    QMutexLocker lock(&m_lock);
+
+    foreach (Kwave::Encoder *e, m_encoders) {
+	Kwave::EncoderProxy *proxy = dynamic_cast<Kwave::EncoderProxy *>(e);
+	if (!proxy || (proxy->module() != module)) continue;
+	unregisterEncoder(proxy);
+	delete proxy;
+    }
+    foreach (Kwave::Decoder *d, m_decoders) {
+	Kwave::DecoderProxy *proxy = dynamic_cast<Kwave::DecoderProxy *>(d);
+	if (!proxy || (proxy->module() != module)) continue;
+	unregisterDecoder(proxy);
+	delete proxy;
+    }
+}
+
+//***************************************************************************
+void Kwave::CodecManager::unregisterCodecModules()
+{
+    QMutexLocker lock(&m_lock);
+
+    QStringList modules;
+    foreach (Kwave::Encoder *e, m_encoders) {
+	Kwave::EncoderProxy *proxy = dynamic_cast<Kwave::EncoderProxy *>(e);
+	if (proxy && !modules.contains(proxy->module()))
+	    modules.append(proxy->module());
+    }
+    foreach (Kwave::Decoder *d, m_decoders) {
+	Kwave::DecoderProxy *proxy = dynamic_cast<Kwave::DecoderProxy *>(d);
+	if (proxy && !modules.contains(proxy->module()))
+	    modules.append(proxy->module());
+    }
+    foreach (const QString &module, modules)
+	unregisterCodecModule(module);
+}
+
+//***************************************************************************
+bool Kwave::CodecManager::loadCodecModule(const QString &module)
+{
+    // plugins can only be loaded in the GUI thread. Waiting for it here
+    // could dead-lock if the GUI thread waits for this worker, so it is
+    // up to the caller to request the codec in the GUI thread first.
+    if (QThread::currentThread() != qApp->thread()) {
+	qWarning("CodecManager: codec module '%s' not loaded, "
+	         "only possible in the GUI thread", DBG(module));
+	return false;
+    }
+
+    if (Kwave::PluginManager::loadCodecModule(module)) return true;
+
+    // do not try again, a module that does not load will not get better
+    qWarning("CodecManager: loading codec module '%s' failed", DBG(module));
+    unregisterCodecModule(module);
+    return false;
+}
+
 //***************************************************************************
 bool Kwave::CodecManager::canDecode(const QString &mimetype_name)
 {
+    QMutexLocker lock(&m_lock);
+
     foreach (Kwave::Decoder *d, m_decoders)
 	if (d && d->supports(mimetype_name)) return true;
     return false;
@@ -85,6 +192,8 @@ bool Kwave::CodecManager::canDecode(const QString &mimetype_name)
 //***************************************************************************
 QString Kwave::CodecManager::mimeTypeOf(const QUrl &url)
 {
+    QMutexLocker lock(&m_lock);
+
     const QString default_mime_type = QMimeType().name();
 
     foreach (Kwave::Decoder *d, m_decoders) {
@@ -105,6 +214,8 @@ QString Kwave::CodecManager::mimeTypeOf(const QUrl &url)
 //***************************************************************************
 QStringList Kwave::CodecManager::encodingMimeTypes()
 {
+    QMutexLocker lock(&m_lock);
+
     QStringList list;
     foreach (Kwave::Encoder *e, m_encoders) {
 	if (!e) continue;
@@ -120,22 +231,52 @@ QStringList Kwave::CodecManager::encodingMimeTypes()
 //***************************************************************************
 Kwave::Decoder *Kwave::CodecManager::decoder(const QString &mimetype_name)
 {
-    foreach (Kwave::Decoder *d, m_decoders)
-	if (d && d->supports(mimetype_name)) return d->instance();
+    QMutexLocker lock(&m_lock);
+
+    QString module;
+    foreach (Kwave::Decoder *d, m_decoders) {
+	if (!d || !d->supports(mimetype_name)) continue;
+	Kwave::DecoderProxy *proxy = dynamic_cast<Kwave::DecoderProxy *>(d);
+	if (!proxy) return d->instance();
+	if (module.isEmpty()) module = proxy->module();
+    }
+
+    // only known from the manifest -> load the module and try again
+    if (module.isEmpty() || !loadCodecModule(module)) return Q_NULLPTR;
+    foreach (Kwave::Decoder *d, m_decoders) {
+	if (!d || !d->supports(mimetype_name)) continue;
+	if (!dynamic_cast<Kwave::DecoderProxy *>(d)) return d->instance();
+    }
     return Q_NULLPTR;
 }
 
 //***************************************************************************
 Kwave::Encoder *Kwave::CodecManager::encoder(const QString &mimetype_name)
 {
-    foreach (Kwave::Encoder *e, m_encoders)
-	if (e && e->supports(mimetype_name)) return e->instance();
+    QMutexLocker lock(&m_lock);
+
+    QString module;
+    foreach (Kwave::Encoder *e, m_encoders) {
+	if (!e || !e->supports(mimetype_name)) continue;
+	Kwave::EncoderProxy *proxy = dynamic_cast<Kwave::EncoderProxy *>(e);
+	if (!proxy) return e->instance();
+	if (module.isEmpty()) module = proxy->module();
+    }
+
+    // only known from the manifest -> load the module and try again
+    if (module.isEmpty() || !loadCodecModule(module)) return Q_NULLPTR;
+    foreach (Kwave::Encoder *e, m_encoders) {
+	if (!e || !e->supports(mimetype_name)) continue;
+	if (!dynamic_cast<Kwave::EncoderProxy *>(e)) return e->instance();
+    }
     return Q_NULLPTR;
 }
 
 //***************************************************************************
 QString Kwave::CodecManager::encodingFilter()
 {
+    QMutexLocker lock(&m_lock);
+
     QStringList list;
     foreach (Kwave::Encoder *e, m_encoders) {
 	// loop over all mime types that the encoder supports
@@ -170,6 +311,8 @@ QString Kwave::CodecManager::encodingFilter()
 //***************************************************************************
 QString Kwave::CodecManager::decodingFilter()
 {
+    QMutexLocker lock(&m_lock);
+
     QStringList list;
     QStringList all_extensions;
 
@@ -22,10 +22,13 @@
 
 #include <QtGlobal>
 #include <QList>
+#include <QMutex>
 #include <QObject>
 #include <QString>
 #include <QStringList>
 
+#include "libkwave/CodecBase.h"
+
 namespace Kwave
 {
 
@@ -69,6 +72,30 @@ namespace Kwave
 	 */
 	static void unregisterDecoder(Kwave::Decoder *decoder);
 
+	/**
+	 * Registers the mime types of a codec module without loading it.
+	 * The module is represented by proxies until the first encoder or
+	 * decoder of it is requested, then it gets loaded through the
+	 * plugin manager.
+	 * @param module name of the plugin module
+	 * @param encoding list of mime types the module can encode
+	 * @param decoding list of mime types the module can decode
+	 */
+	static void registerCodecModule(
+	    const QString &module,
+	    const QList<Kwave::CodecBase::MimeType> &encoding,
+	    const QList<Kwave::CodecBase::MimeType> &decoding);
+
+	/**
+	 * Un-registers a codec module previously registered with
+	 * registerCodecModule and deletes it's proxies.
+	 * @param module name of the plugin module
+	 */
+	static void unregisterCodecModule(const QString &module);
+
+	/** Un-registers all codec modules, see unregisterCodecModule */
+	static void unregisterCodecModules();
+
 	/**
 	 * Returns true if a decoder for the given mime type is known.
 	 * @param mimetype_name name of the mime type
@@ -117,12 +144,33 @@ namespace Kwave
 	/** Returns a list of supported mime types for encoding */
 	static QStringList encodingMimeTypes();
 
+    private:
+
+	/**
+	 * Loads a codec module that was registered with registerCodecModule
+	 * through the plugin manager. If loading fails, the module is
+	 * un-registered. Only possible in the GUI thread, worker threads
+	 * only get encoders or decoders of modules that are already loaded.
+	 * @note must be called with m_lock held
+	 * @param module name of the plugin module
+	 * @return true if the module has been loaded
+	 */
+	static bool loadCodecModule(const QString &module);
+
     private:
 	/** list of all encoders */
 	static QList<Kwave::Encoder *> m_encoders;
 
 	/** list of decoders */
 	static QList<Kwave::Decoder *> m_decoders;
+
+	/**
+	 * protects m_encoders and m_decoders, which are modified when a
+	 * codec module is loaded on demand while worker threads might look
+	 * up an encoder or decoder (recursive, loading a module registers
+	 * it's codecs)
+	 */
+	static QMutex m_lock;
     };
 }
 
@@ -78,6 +78,16 @@ namespace Kwave
          */
 	virtual QList<Kwave::Encoder *> createEncoder() = 0;
 
+	/** Returns the list of registered encoders, valid after load() */
+	inline const QList<Kwave::Encoder *> &encoders() const {
+	    return m_codec.m_encoder;
+	}
+
+	/** Returns the list of registered decoders, valid after load() */
+	inline const QList<Kwave::Decoder *> &decoders() const {
+	    return m_codec.m_decoder;
+	}
+
     protected:
 
         /**
@@ -0,0 +1,94 @@
+/*************************************************************************
+       CodecProxy.cpp  -  placeholders for codecs of unloaded modules
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "config.h"
+
+#include "libkwave/CodecProxy.h"
+
+/***************************************************************************/
+Kwave::EncoderProxy::EncoderProxy(
+    const QString &module,
+    const QList<Kwave::CodecBase::MimeType> &mime_types)
+    :Kwave::Encoder(), m_module(module)
+{
+    foreach (const Kwave::CodecBase::MimeType &type, mime_types)
+	addMimeType(type);
+}
+
+/***************************************************************************/
+Kwave::EncoderProxy::~EncoderProxy()
+{
+}
+
+/***************************************************************************/
+Kwave::Encoder *Kwave::EncoderProxy::instance()
+{
+    return Q_NULLPTR;
+}
+
+/***************************************************************************/
+bool Kwave::EncoderProxy::encode(QWidget */* widget */,
+                                 Kwave::MultiTrackReader &/* src */,
+                                 QIODevice &/* dst */,
+                                 const Kwave::MetaDataList &/* meta_data */)
+{
+    return false;
+}
+
+/***************************************************************************/
+/***************************************************************************/
+Kwave::DecoderProxy::DecoderProxy(
+    const QString &module,
+    const QList<Kwave::CodecBase::MimeType> &mime_types)
+    :Kwave::Decoder(), m_module(module)
+{
+    foreach (const Kwave::CodecBase::MimeType &type, mime_types)
+	addMimeType(type);
+}
+
+/***************************************************************************/
+Kwave::DecoderProxy::~DecoderProxy()
+{
+}
+
+/***************************************************************************/
+Kwave::Decoder *Kwave::DecoderProxy::instance()
+{
+    return Q_NULLPTR;
+}
+
+/***************************************************************************/
+bool Kwave::DecoderProxy::open(QWidget */* widget */,
+                               QIODevice &/* source */)
+{
+    return false;
+}
+
+/***************************************************************************/
+bool Kwave::DecoderProxy::decode(QWidget */* widget */,
+                                 Kwave::MultiWriter &/* dst */)
+{
+    return false;
+}
+
+/***************************************************************************/
+void Kwave::DecoderProxy::close()
+{
+}
+
+/***************************************************************************/
+/***************************************************************************/
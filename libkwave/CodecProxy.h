@@ -0,0 +1,117 @@
+/*************************************************************************
+         CodecProxy.h  -  placeholders for codecs of unloaded modules
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef CODEC_PROXY_H
+#define CODEC_PROXY_H
+
+#include "config.h"
+
+#include <QtGlobal>
+#include <QList>
+#include <QString>
+
+#include "libkwave/CodecBase.h"
+#include "libkwave/Decoder.h"
+#include "libkwave/Encoder.h"
+
+namespace Kwave
+{
+
+    /**
+     * Placeholder for the encoders of a codec module that has not been
+     * loaded yet. It only knows the mime types from the plugin manifest,
+     * the CodecManager loads the module when an encoder for one of them
+     * is requested.
+     */
+    class Q_DECL_EXPORT EncoderProxy: public Kwave::Encoder
+    {
+    public:
+	/**
+	 * Constructor
+	 * @param module name of the plugin module with the real encoders
+	 * @param mime_types list of mime types the module can encode
+	 */
+	EncoderProxy(const QString &module,
+	             const QList<Kwave::CodecBase::MimeType> &mime_types);
+
+	/** Destructor */
+	virtual ~EncoderProxy() Q_DECL_OVERRIDE;
+
+	/** Returns the name of the plugin module */
+	inline const QString &module() const { return m_module; }
+
+	/** a proxy can not create encoders, returns a null pointer */
+	virtual Kwave::Encoder *instance() Q_DECL_OVERRIDE;
+
+	/** a proxy can not encode, always fails */
+	virtual bool encode(QWidget *widget,
+	                    Kwave::MultiTrackReader &src,
+	                    QIODevice &dst,
+	                    const Kwave::MetaDataList &meta_data)
+	                    Q_DECL_OVERRIDE;
+
+    private:
+
+	/** name of the plugin module */
+	QString m_module;
+    };
+
+    /**
+     * Placeholder for the decoders of a codec module that has not been
+     * loaded yet, see EncoderProxy.
+     */
+    class Q_DECL_EXPORT DecoderProxy: public Kwave::Decoder
+    {
+    public:
+	/**
+	 * Constructor
+	 * @param module name of the plugin module with the real decoders
+	 * @param mime_types list of mime types the module can decode
+	 */
+	DecoderProxy(const QString &module,
+	             const QList<Kwave::CodecBase::MimeType> &mime_types);
+
+	/** Destructor */
+	virtual ~DecoderProxy() Q_DECL_OVERRIDE;
+
+	/** Returns the name of the plugin module */
+	inline const QString &module() const { return m_module; }
+
+	/** a proxy can not create decoders, returns a null pointer */
+	virtual Kwave::Decoder *instance() Q_DECL_OVERRIDE;
+
+	/** a proxy can not open a source, always fails */
+	virtual bool open(QWidget *widget, QIODevice &source) Q_DECL_OVERRIDE;
+
+	/** a proxy can not decode, always fails */
+	virtual bool decode(QWidget *widget, Kwave::MultiWriter &dst)
+	    Q_DECL_OVERRIDE;
+
+	/** does nothing */
+	virtual void close() Q_DECL_OVERRIDE;
+
+    private:
+
+	/** name of the plugin module */
+	QString m_module;
+    };
+}
+
+#endif /* CODEC_PROXY_H */
+
+//***************************************************************************
+//***************************************************************************
@@ -0,0 +1,185 @@
+/***************************************************************************
+          FloatArray.cpp  -  array of samples in float representation
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "config.h"
+
+#include <new>
+
+#include "libkwave/FloatArray.h"
+#include "libkwave/SamplePool.h"
+#include "libkwave/memcpy.h"
+
+// the pool hands out blocks of sample_t, we use them for floats
+static_assert(sizeof(float) == sizeof(sample_t),
+              "float and sample_t must have the same size");
+
+namespace Kwave
+{
+    namespace
+    {
+	/** allocates a block of floats from the sample pool */
+	inline float *allocateFloats(unsigned int size,
+	                             unsigned int &capacity)
+	{
+	    return reinterpret_cast<float *>(
+		Kwave::SamplePool::allocate(size, capacity));
+	}
+
+	/** gives a block of floats back to the sample pool */
+	inline void releaseFloats(float *data, unsigned int capacity)
+	{
+	    Kwave::SamplePool::release(
+		reinterpret_cast<sample_t *>(data), capacity);
+	}
+    }
+}
+
+//***************************************************************************
+Kwave::FloatArray::FloatArray()
+{
+    m_storage = new(std::nothrow) FloatStorage;
+}
+
+//***************************************************************************
+Kwave::FloatArray::FloatArray(unsigned int size)
+{
+    m_storage = new(std::nothrow) FloatStorage;
+    bool ok = resize(size);
+    if (!ok)
+	qWarning("Kwave::FloatArray::FloatArray(%u) - FAILED, OOM?", size);
+}
+
+//***************************************************************************
+Kwave::FloatArray::~FloatArray()
+{
+}
+
+//***************************************************************************
+float & Kwave::FloatArray::operator [] (unsigned int index)
+{
+    static float dummy = 0;
+    float *p = data();
+
+    if (Q_LIKELY(p))
+	return (*(p + index));
+    else
+	return dummy;
+}
+
+//***************************************************************************
+const float & Kwave::FloatArray::operator [] (unsigned int index) const
+{
+    static const float dummy = 0;
+    const float *p = constData();
+
+    if (Q_LIKELY(p))
+	return (*(p + index));
+    else
+	return dummy;
+}
+
+//***************************************************************************
+bool Kwave::FloatArray::resize(unsigned int size)
+{
+    if (!m_storage) return false;
+    if (size == m_storage->m_size) return true;
+
+    m_storage->resize(size);
+    return (m_storage->m_size == size);
+}
+
+//***************************************************************************
+unsigned int Kwave::FloatArray::size() const
+{
+    return (m_storage) ? m_storage->m_size : 0;
+}
+
+//***************************************************************************
+Kwave::FloatArray::FloatStorage::FloatStorage()
+    :QSharedData()
+{
+    m_size     = 0;
+    m_capacity = 0;
+    m_data     = Q_NULLPTR;
+}
+
+//***************************************************************************
+Kwave::FloatArray::FloatStorage::FloatStorage(const FloatStorage &other)
+    :QSharedData(other)
+{
+    m_size     = 0;
+    m_capacity = 0;
+    m_data     = Q_NULLPTR;
+
+    if (other.m_size) {
+	m_data = Kwave::allocateFloats(other.m_size, m_capacity);
+	if (m_data) {
+	    m_size = other.m_size;
+	    MEMCPY(m_data, other.m_data, m_size * sizeof(float));
+	}
+    }
+}
+
+//***************************************************************************
+Kwave::FloatArray::FloatStorage::~FloatStorage()
+{
+    Kwave::releaseFloats(m_data, m_capacity);
+}
+
+//***************************************************************************
+void Kwave::FloatArray::FloatStorage::resize(unsigned int size)
+{
+    if (!size) {
+	// resize to zero == give the memory back
+	Kwave::releaseFloats(m_data, m_capacity);
+	m_data     = Q_NULLPTR;
+	m_size     = 0;
+	m_capacity = 0;
+	return;
+    }
+
+    if (!m_data || (size > m_capacity) ||
+	!Kwave::SamplePool::isPooled(m_capacity))
+    {
+	// take a new block and copy the existing data
+	unsigned int capacity = 0;
+	float *new_data = Kwave::allocateFloats(size, capacity);
+	if (!new_data) {
+	    qWarning("Kwave::FloatArray::FloatStorage::resize(%u): OOM! "
+	             "- keeping old size %u", size, m_size);
+	    return;
+	}
+	if (m_data) {
+	    MEMCPY(new_data, m_data, qMin(m_size, size) * sizeof(float));
+	    Kwave::releaseFloats(m_data, m_capacity);
+	}
+	m_data     = new_data;
+	m_capacity = capacity;
+    }
+
+    if (size > m_size) {
+	// initialize the new data
+	unsigned int count = size - m_size;
+	float *p = m_data + m_size;
+	while (count--)
+	    *(p++) = 0.0f;
+    }
+    m_size = size;
+}
+
+//***************************************************************************
+//***************************************************************************
@@ -0,0 +1,143 @@
+/***************************************************************************
+            FloatArray.h  -  array of samples in float representation
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef FLOAT_ARRAY_H
+#define FLOAT_ARRAY_H
+
+#include "config.h"
+
+#include <QtGlobal>
+#include <QSharedData>
+#include <QSharedDataPointer>
+
+#include "libkwave/Sample.h"
+
+namespace Kwave
+{
+
+    /**
+     * array of floats, the counterpart of Kwave::SampleArray for the
+     * float based streaming API. The samples are scaled like in
+     * sample2float(), a full scale signal is within [-1.0 ... +1.0],
+     * but values outside of that range are allowed and are passed
+     * unmodified between the stages of a filter chain. The memory comes
+     * from Kwave::SamplePool, like the memory of Kwave::SampleArray.
+     */
+    class Q_DECL_EXPORT FloatArray
+    {
+    public:
+
+	/** Default constructor, creates an empty array */
+	FloatArray();
+
+	/**
+	 * Constructor, creates an array with predefined size
+	 * (not initialized)
+	 * @param size number of samples to hold
+	 */
+	explicit FloatArray(unsigned int size);
+
+	/** Destructor */
+	virtual ~FloatArray();
+
+	/** returns a const pointer to the raw data (non-mutable) */
+	inline const float * constData() const
+	{
+	    if (Q_UNLIKELY(!m_storage)) return Q_NULLPTR;
+	    return m_storage->m_data;
+	}
+
+	/** returns a pointer to the raw data (mutable) */
+	inline float *data()
+	{
+	    if (Q_UNLIKELY(!m_storage)) return Q_NULLPTR;
+	    return m_storage->m_data;
+	}
+
+	/**
+	 * operator [], non-const.
+	 * @param index sample index [0...count()-1]
+	 * @return reference to the requested sample (read/write)
+	 */
+	float & operator [] (unsigned int index);
+
+	/**
+	 * operator [], const.
+	 * @param index sample index [0...count()-1]
+	 * @return reference to the requested sample (read only)
+	 */
+	const float & operator [] (unsigned int index) const;
+
+	/**
+	 * Resizes the array
+	 * @param size new number of samples
+	 * @return true if succeeded, false if failed
+	 */
+	bool resize(unsigned int size);
+
+	/**
+	 * Returns the number of samples.
+	 * @return samples [0...N]
+	 */
+	unsigned int size() const;
+
+	/**
+	 * Returns whether the array is empty.
+	 * The same as (size() == 0).
+	 * @return true if empty, false if not
+	 */
+	inline bool isEmpty() const { return (size() == 0); }
+
+    private:
+
+	class FloatStorage: public QSharedData {
+	public:
+
+	    /** default constructor */
+	    FloatStorage();
+
+	    /** copy constructor */
+	    FloatStorage(const FloatStorage &other);
+
+	    /** destructor */
+	    virtual ~FloatStorage();
+
+	    /**
+	     * Resizes the array
+	     * @param size new number of samples
+	     */
+	    void resize(unsigned int size);
+
+	public:
+	    /** size in samples */
+	    unsigned int m_size;
+
+	    /** number of samples that fit into the allocated memory */
+	    unsigned int m_capacity;
+
+	    /** pointer to the area with the samples (allocated) */
+	    float *m_data;
+	};
+
+	QSharedDataPointer<FloatStorage> m_storage;
+    };
+}
+
+#endif /* FLOAT_ARRAY_H */
+
+//***************************************************************************
+//***************************************************************************
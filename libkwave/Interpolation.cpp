@@ -171,6 +171,135 @@ double Kwave::Interpolation::singleInterpolation(double input)
     return 0;
 }
 
+//***************************************************************************
+void Kwave::Interpolation::blockInterpolation(double pos, double step,
+                                              double *out, unsigned int len)
+{
+    Q_ASSERT(out);
+    Q_ASSERT(step >= 0.0);
+    if (!out || !len) return;
+
+    const unsigned int count = this->count();
+    if (!count) {
+	for (unsigned int k = 0; k < len; k++)
+	    out[k] = 0.0;
+	return;
+    }
+
+    if (step < 0.0) {
+	// positions are not ascending -> no incremental search possible
+	for (unsigned int k = 0; k < len; k++)
+	    out[k] = singleInterpolation(pos + (k * step));
+	return;
+    }
+
+    if (m_type == INTPOL_NPOLYNOMIAL) {
+	// one polynomial over the whole range, no segments
+	for (unsigned int k = 0; k < len; k++) {
+	    const double input = qBound(0.0, pos + (k * step), 1.0);
+	    double ny = m_y[0];
+	    for (unsigned int j = 1; j < count; j++)
+		ny = ny * (input - m_x[j]) + m_y[j];
+	    out[k] = ny;
+	}
+	return;
+    }
+
+    unsigned int degree = 0;
+    switch (m_type) {
+	case INTPOL_POLYNOMIAL3: degree = 3; break;
+	case INTPOL_POLYNOMIAL5: degree = 5; break;
+	case INTPOL_POLYNOMIAL7: degree = 7; break;
+	default: break;
+    }
+    if (degree) {
+	Q_ASSERT(m_curve);
+	if (!m_curve) return;
+    }
+    QVector<double> ax(7);
+    QVector<double> ay(7);
+
+    unsigned int i = 1;
+    unsigned int k = 0;
+    while (k < len) {
+	// find the segment of the current position, the same way as
+	// singleInterpolation() does, but continue where we left off
+	const double first = qBound(0.0, pos + (k * step), 1.0);
+	while ((i < count) && (m_x[i] < first))
+	    i++;
+
+	// find the number of positions within this segment
+	unsigned int end = k + 1;
+	if (i < count) {
+	    while ((end < len) &&
+	           !(m_x[i] < qBound(0.0, pos + (end * step), 1.0)))
+		end++;
+	} else {
+	    end = len;
+	}
+
+	switch (m_type) {
+	    case INTPOL_LINEAR:
+	    {
+		const double x0    = m_x[i - 1];
+		const double y0    = m_y[i - 1];
+		const double slope = (m_y[i] - y0) / (m_x[i] - x0);
+		for (; k < end; k++) {
+		    const double input = qBound(0.0, pos + (k * step), 1.0);
+		    out[k] = y0 + (slope * (input - x0));
+		}
+		break;
+	    }
+	    case INTPOL_SPLINE:
+	    {
+		// convert the spline segment into a cubic polynomial
+		// of b = (input - x0) / h and evaluate it with Horner's rule
+		const double x0 = m_x[i - 1];
+		const double h  = m_x[i] - x0;
+		const double f  = (h * h) / 6.0;
+		const double d0 = m_der[i - 1];
+		const double d1 = m_der[i];
+		const double c0 = m_y[i - 1];
+		const double c1 = (m_y[i] - m_y[i - 1]) - f * (2.0 * d0 + d1);
+		const double c2 = f * 3.0 * d0;
+		const double c3 = f * (d1 - d0);
+		for (; k < end; k++) {
+		    const double input = qBound(0.0, pos + (k * step), 1.0);
+		    const double b = (input - x0) / h;
+		    out[k] = ((c3 * b + c2) * b + c1) * b + c0;
+		}
+		break;
+	    }
+	    case INTPOL_SAH:
+	    {
+		const double y = m_y[i - 1];
+		for (; k < end; k++)
+		    out[k] = y;
+		break;
+	    }
+	    case INTPOL_POLYNOMIAL3:
+	    case INTPOL_POLYNOMIAL5:
+	    case INTPOL_POLYNOMIAL7:
+	    {
+		createPolynom(*m_curve, ax, ay,
+		    Kwave::toInt(i) - 1 - Kwave::toInt(degree / 2), degree);
+		for (; k < end; k++) {
+		    const double input = qBound(0.0, pos + (k * step), 1.0);
+		    double ny = ay[0];
+		    for (unsigned int j = 1; j < degree; j++)
+			ny = ny * (input - ax[j]) + ay[j];
+		    out[k] = ny;
+		}
+		break;
+	    }
+	    default:
+		for (; k < end; k++)
+		    out[k] = 0.0;
+		break;
+	}
+    }
+}
+
 //***************************************************************************
 bool Kwave::Interpolation::prepareInterpolation(const Kwave::Curve &points)
 {
@@ -66,6 +66,21 @@ namespace Kwave
 	 */
 	double singleInterpolation(double pos);
 
+	/**
+	 * Evaluates the interpolation at a sequence of equidistant positions,
+	 * with the same results as calling singleInterpolation() for each
+	 * of them. Walks through the segments of the curve incrementally and
+	 * sets up the polynomial of each segment only once, so that the
+	 * costs do not depend on the number of points.
+	 *
+	 * @param pos the first position [0...1]
+	 * @param step distance between two positions, must not be negative
+	 * @param out receives the interpolated values
+	 * @param len number of values to evaluate
+	 */
+	void blockInterpolation(double pos, double step,
+	                        double *out, unsigned int len);
+
 	/**
 	 * Same as getSingleInterpolation, but return value
 	 * will be limited to be [0...1]
@@ -26,6 +26,10 @@
 #include <KMessageBox>
 
 #include "libkwave/MessageBox.h"
+#include "libkwave/String.h"
+
+// static initializer
+bool Kwave::MessageBox::m_interactive = true;
 
 //***************************************************************************
 Kwave::MessageBox::MessageBox(KMessageBox::DialogType mode, QWidget *parent,
@@ -140,6 +144,22 @@ int Kwave::MessageBox::exec(KMessageBox::DialogType mode, QWidget *parent,
     const QString &button1, const QString &button2,
     const QString &dontAskAgainName)
 {
+    if (!m_interactive) {
+	// non-interactive mode: take the first button
+	qWarning("%s", DBG(message));
+	switch (mode) {
+	    case KMessageBox::QuestionYesNo:       /* FALLTHROUGH */
+	    case KMessageBox::QuestionYesNoCancel: /* FALLTHROUGH */
+	    case KMessageBox::WarningYesNo:        /* FALLTHROUGH */
+	    case KMessageBox::WarningYesNoCancel:
+		return KMessageBox::Yes;
+	    case KMessageBox::WarningContinueCancel:
+		return KMessageBox::Continue;
+	    default:
+		return -1;
+	}
+    }
+
     Kwave::MessageBox box(
 	mode, parent, message, caption,
 	button1, button2,
@@ -148,6 +168,12 @@ int Kwave::MessageBox::exec(KMessageBox::DialogType mode, QWidget *parent,
     return box.retval();
 }
 
+//***************************************************************************
+void Kwave::MessageBox::setInteractive(bool interactive)
+{
+    m_interactive = interactive;
+}
+
 //***************************************************************************
 void Kwave::MessageBox::show()
 {
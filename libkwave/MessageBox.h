@@ -81,6 +81,14 @@ namespace Kwave
 	static int error(QWidget *widget,
 	    QString message, QString caption = QString());
 
+	/**
+	 * Enables or disables the interactive mode. In non-interactive
+	 * mode no message box is shown, the message is only logged and
+	 * the first button (yes/continue) is taken as the answer.
+	 * @param interactive if false, do not show any message box
+	 */
+	static void setInteractive(bool interactive);
+
     private:
 
 	/** Default constructor (not implemented) */
@@ -189,6 +197,9 @@ namespace Kwave
 
 	/** tag for "do not ask again" (optional) */
 	const QString m_dont_ask_again_name;
+
+	/** if false, do not show message boxes (batch mode) */
+	static bool m_interactive;
     };
 }
 
@@ -19,19 +19,21 @@
 
 #include <algorithm>
 
+#include <QMutableMapIterator>
+
 #include "libkwave/MetaDataList.h"
 #include "libkwave/String.h"
 #include "libkwave/Utils.h"
 
 //***************************************************************************
 Kwave::MetaDataList::MetaDataList()
-    :QMap<QString, Kwave::MetaData>()
+    :m_data(), m_index(), m_unbound(), m_index_valid(true)
 {
 }
 
 //***************************************************************************
 Kwave::MetaDataList::MetaDataList(const Kwave::MetaData &meta)
-    :QMap<QString, Kwave::MetaData>()
+    :m_data(), m_index(), m_unbound(), m_index_valid(true)
 {
     add(meta);
 }
@@ -50,7 +52,7 @@ static bool isLessThan(const Kwave::MetaData &m1, const Kwave::MetaData &m2)
 //***************************************************************************
 QList<Kwave::MetaData> Kwave::MetaDataList::toSortedList() const
 {
-    QList<Kwave::MetaData> list = this->values();
+    QList<Kwave::MetaData> list = m_data.values();
 
     if (!list.isEmpty())
 	std::stable_sort(list.begin(), list.end(), isLessThan);
@@ -70,20 +72,25 @@ Kwave::MetaDataList Kwave::MetaDataList::selectByRange(
 {
     Kwave::MetaDataList list;
 
+    if (m_index_valid) {
+	// use the position index
+	QMultiMap<sample_index_t, QString>::const_iterator it =
+	    m_index.lowerBound(first);
+	while ((it != m_index.constEnd()) && (it.key() <= last)) {
+	    list.insertUnindexed(m_data.value(it.value()));
+	    ++it;
+	}
+	return list;
+    }
+
+    // fallback: search through all elements
     Iterator it(*this);
     while (it.hasNext()) {
 	it.next();
 	const Kwave::MetaData &m = it.value();
-	if (m.scope() == Kwave::MetaData::Position) {
-	    if (m.hasProperty(Kwave::MetaData::STDPROP_POS)) {
-		// check for position within the range
-		bool pos_ok = false;
-		const sample_index_t pos =
-		    m[Kwave::MetaData::STDPROP_POS].toLongLong(&pos_ok);
-		if (pos_ok && (pos >= first) && (pos <= last))
-		    list.add(m);
-	    }
-	}
+	sample_index_t pos = 0;
+	if (positionOf(m, pos) && (pos >= first) && (pos <= last))
+	    list.insertUnindexed(m);
     }
     return list;
 }
@@ -92,24 +99,7 @@ Kwave::MetaDataList Kwave::MetaDataList::selectByRange(
 Kwave::MetaDataList Kwave::MetaDataList::selectByPosition(
     sample_index_t pos) const
 {
-    Kwave::MetaDataList list;
-
-    Iterator it(*this);
-    while (it.hasNext()) {
-	it.next();
-	const Kwave::MetaData &m = it.value();
-	if (m.scope() == Kwave::MetaData::Position) {
-	    if (m.hasProperty(Kwave::MetaData::STDPROP_POS)) {
-		// check for position within the range
-		bool pos_ok = false;
-		const sample_index_t p =
-		    m[Kwave::MetaData::STDPROP_POS].toLongLong(&pos_ok);
-		if (pos_ok && (p == pos))
-		    list.add(m);
-	    }
-	}
-    }
-    return list;
+    return selectByRange(pos, pos);
 }
 
 //***************************************************************************
@@ -123,7 +113,7 @@ Kwave::MetaDataList Kwave::MetaDataList::selectByProperty(
 	it.next();
 	const Kwave::MetaData &m = it.value();
 	if (m.hasProperty(property))
-	    list.add(m);
+	    list.insertUnindexed(m);
     }
     return list;
 }
@@ -139,7 +129,7 @@ Kwave::MetaDataList Kwave::MetaDataList::selectByValue(
 	it.next();
 	const Kwave::MetaData &m = it.value();
 	if (m.hasProperty(property) && (m[property] == value))
-	    list.add(m);
+	    list.insertUnindexed(m);
     }
     return list;
 }
@@ -147,22 +137,15 @@ Kwave::MetaDataList Kwave::MetaDataList::selectByValue(
 //***************************************************************************
 bool Kwave::MetaDataList::contains(const Kwave::MetaData &metadata) const
 {
-    QString id = metadata.id();
-
-    Iterator it(*this);
-    while (it.hasNext()) {
-	it.next();
-	const Kwave::MetaData &m = it.value();
-	if (m.id() == id)
-	    return true;
-    }
-    return false;
+    // all elements are mapped by their id
+    return m_data.contains(metadata.id());
 }
 
 //***************************************************************************
 void Kwave::MetaDataList::replace(const Kwave::MetaDataList &list)
 {
     if (list.isEmpty()) return;
+    validateIndex();
 
     // find out which meta data types are affected
     QStringList types;
@@ -173,12 +156,13 @@ void Kwave::MetaDataList::replace(const Kwave::MetaDataList &list)
 	    types.append(type);
 
 	    // remove all elements of that type that are not in the new list
-	    MutableIterator it(*this);
+	    QMutableMapIterator<QString, Kwave::MetaData> it(m_data);
 	    while (it.hasNext()) {
 		it.next();
 		Kwave::MetaData &m = it.value();
 		if (m[Kwave::MetaData::STDPROP_TYPE] == type) {
 		    if (!list.contains(m)) {
+			indexRemove(m);
 			it.remove();
 		    }
 		}
@@ -193,10 +177,21 @@ void Kwave::MetaDataList::replace(const Kwave::MetaDataList &list)
 //***************************************************************************
 void Kwave::MetaDataList::add(const Kwave::MetaData &metadata)
 {
-    if (!metadata.isNull())
-	(*this)[metadata.id()] = metadata;
-    else
+    if (metadata.isNull()) {
 	remove(metadata);
+	return;
+    }
+
+    // replace an existing old version
+    validateIndex();
+    QMap<QString, Kwave::MetaData>::iterator it = m_data.find(metadata.id());
+    if (it != m_data.end()) {
+	indexRemove(it.value());
+	it.value() = metadata;
+    } else {
+	m_data.insert(metadata.id(), metadata);
+    }
+    indexInsert(metadata);
 }
 
 //***************************************************************************
@@ -209,8 +204,12 @@ void Kwave::MetaDataList::add(const Kwave::MetaDataList &list)
 //***************************************************************************
 void Kwave::MetaDataList::remove(const Kwave::MetaData &metadata)
 {
-    if (contains(metadata))
-	QMap<QString, Kwave::MetaData>::remove(metadata.id());
+    const_iterator it = m_data.constFind(metadata.id());
+    if (it == m_data.constEnd()) return;
+
+    validateIndex();
+    indexRemove(it.value());
+    m_data.remove(metadata.id());
 }
 
 //***************************************************************************
@@ -224,26 +223,19 @@ void Kwave::MetaDataList::remove(const Kwave::MetaDataList &list)
 void Kwave::MetaDataList::cropByRange(sample_index_t first,
                                       sample_index_t last)
 {
-
-    MutableIterator it(*this);
-    while (it.hasNext()) {
-	it.next();
-	Kwave::MetaData &m = it.value();
-
-	if (m.scope() & Kwave::MetaData::Position) {
-	    // if the meta data is bound to a position, remove it if
-	    // it is out of scope
-	    const QVariant v_pos = m[Kwave::MetaData::STDPROP_POS];
-	    bool ok = false;
-	    sample_index_t pos = static_cast<sample_index_t>(
-		v_pos.toULongLong(&ok));
-	    if (!ok) continue;
-
-	    if ((pos < first) || (pos > last)) {
-		// out of the selected area -> remove
-		it.remove();
-	    }
-	}
+    validateIndex();
+
+    // remove all position bound elements that are out of scope,
+    // at the left and at the right
+    QMultiMap<sample_index_t, QString>::iterator it = m_index.begin();
+    while ((it != m_index.end()) && (it.key() < first)) {
+	m_data.remove(it.value());
+	it = m_index.erase(it);
+    }
+    it = m_index.upperBound(last);
+    while (it != m_index.end()) {
+	m_data.remove(it.value());
+	it = m_index.erase(it);
     }
 }
 
@@ -267,22 +259,23 @@ void Kwave::MetaDataList::deleteRange(sample_index_t offset,
     const sample_index_t del_last  = offset + length - 1;
 
     if (!length) return;
+    validateIndex();
+
+    // position bound -> remove completely
+    QMultiMap<sample_index_t, QString>::iterator it =
+	m_index.lowerBound(del_first);
+    while ((it != m_index.end()) && (it.key() <= del_last)) {
+	m_data.remove(it.value());
+	it = m_index.erase(it);
+    }
 
-    MutableIterator it(*this);
-    while (it.hasNext()) {
-	it.next();
-	Kwave::MetaData &meta = it.value();
-
-	sample_index_t meta_first  = meta.firstSample();
-	sample_index_t meta_last   = meta.lastSample();
-
-	// check: range overlap?
-	if ((meta_first > del_last) || (meta_last  < del_first))
+    // not position bound but with a position -> check the range
+    foreach (const QString &id, m_unbound) {
+	const Kwave::MetaData meta = m_data.value(id);
+	if ((meta.firstSample() > del_last) || (meta.lastSample() < del_first))
 	    continue;
-
-	// position bound -> remove completely
-	if (meta.hasProperty(Kwave::MetaData::STDPROP_POS))
-	    it.remove();
+	m_data.remove(id);
+	m_unbound.remove(id);
     }
 }
 
@@ -290,31 +283,46 @@ void Kwave::MetaDataList::deleteRange(sample_index_t offset,
 void Kwave::MetaDataList::shiftLeft(sample_index_t offset,
                                     sample_index_t shift)
 {
-    MutableIterator it(*this);
-    while (it.hasNext()) {
-	it.next();
-	Kwave::MetaData &meta = it.value();
+    validateIndex();
+
+    // take all elements at or after the offset out of the index
+    QMultiMap<sample_index_t, QString> moved;
+    QMultiMap<sample_index_t, QString>::iterator it =
+	m_index.lowerBound(offset);
+    while (it != m_index.end()) {
+	const sample_index_t pos = it.key();
+	const QString        id  = it.value();
+	it = m_index.erase(it);
+
+	if (pos >= shift) {
+	    // shift position left
+	    m_data[id][Kwave::MetaData::STDPROP_POS] = pos - shift;
+	    moved.insert(pos - shift, id);
+	} else  {
+	    // do not produce negative coordinates
+	    // -> moving into negative means deleting!
+	    m_data.remove(id);
+	}
+    }
 
-	// check: is it before the offset ?
-	sample_index_t meta_first  = meta.firstSample();
-	if (meta_first < offset)
-	    continue;
+    // re-insert them at their new positions
+    m_index.unite(moved);
 
-	// position bound -> move position
-	if (meta.hasProperty(Kwave::MetaData::STDPROP_POS)) {
-	    bool ok = false;
-	    sample_index_t pos = static_cast<sample_index_t>(
-		meta[Kwave::MetaData::STDPROP_POS].toULongLong(&ok));
-	    if (!ok) continue;
-
-	    if (pos >= shift) {
-		// shift position left
-		meta[Kwave::MetaData::STDPROP_POS] = pos - shift;
-	    } else  {
-		// do not produce negative coordinates
-		// -> moving into negative means deleting!
-		it.remove();
-	    }
+    // not position bound but with a position -> move position
+    foreach (const QString &id, m_unbound) {
+	Kwave::MetaData &meta = m_data[id];
+	if (meta.firstSample() < offset) continue;
+
+	bool ok = false;
+	sample_index_t pos = static_cast<sample_index_t>(
+	    meta[Kwave::MetaData::STDPROP_POS].toULongLong(&ok));
+	if (!ok) continue;
+
+	if (pos >= shift) {
+	    meta[Kwave::MetaData::STDPROP_POS] = pos - shift;
+	} else {
+	    m_data.remove(id);
+	    m_unbound.remove(id);
 	}
     }
 }
@@ -323,33 +331,47 @@ void Kwave::MetaDataList::shiftLeft(sample_index_t offset,
 void Kwave::MetaDataList::shiftRight(sample_index_t offset,
                                      sample_index_t shift)
 {
-    MutableIterator it(*this);
-    it.toBack();
-    while (it.hasPrevious()) {
-	it.previous();
-	Kwave::MetaData &meta = it.value();
-
-	// check: is it before the offset ?
-	sample_index_t meta_last   = meta.lastSample();
-	if (meta_last < offset)
-	    continue;
+    validateIndex();
+
+    // take all elements at or after the offset out of the index
+    QMultiMap<sample_index_t, QString> moved;
+    QMultiMap<sample_index_t, QString>::iterator it =
+	m_index.lowerBound(offset);
+    while (it != m_index.end()) {
+	const sample_index_t pos = it.key();
+	const QString        id  = it.value();
+	it = m_index.erase(it);
+
+	Q_ASSERT(pos + shift >= pos);
+	if (pos + shift >= pos) {
+	    // shift position right
+	    m_data[id][Kwave::MetaData::STDPROP_POS] = pos + shift;
+	    moved.insert(pos + shift, id);
+	} else  {
+	    // do not produce a coordinate overflow
+	    // -> moving outside range means deleting!
+	    m_data.remove(id);
+	}
+    }
 
-	// position bound -> move position
-	if (meta.hasProperty(Kwave::MetaData::STDPROP_POS)) {
-	    bool ok = false;
-	    sample_index_t pos = static_cast<sample_index_t>(
-		meta[Kwave::MetaData::STDPROP_POS].toULongLong(&ok));
-	    if (!ok) continue;
-
-	    Q_ASSERT(pos + shift >= pos);
-	    if (pos + shift >= pos) {
-		// shift position right
-		meta[Kwave::MetaData::STDPROP_POS] = pos + shift;
-	    } else  {
-		// do not produce a coordinate overflow
-		// -> moving outside range means deleting!
-		it.remove();
-	    }
+    // re-insert them at their new positions
+    m_index.unite(moved);
+
+    // not position bound but with a position -> move position
+    foreach (const QString &id, m_unbound) {
+	Kwave::MetaData &meta = m_data[id];
+	if (meta.lastSample() < offset) continue;
+
+	bool ok = false;
+	sample_index_t pos = static_cast<sample_index_t>(
+	    meta[Kwave::MetaData::STDPROP_POS].toULongLong(&ok));
+	if (!ok) continue;
+
+	if (pos + shift >= pos) {
+	    meta[Kwave::MetaData::STDPROP_POS] = pos + shift;
+	} else {
+	    m_data.remove(id);
+	    m_unbound.remove(id);
 	}
     }
 }
@@ -357,28 +379,43 @@ void Kwave::MetaDataList::shiftRight(sample_index_t offset,
 //***************************************************************************
 void Kwave::MetaDataList::scalePositions(double scale)
 {
-    MutableIterator it(*this);
-    while (it.hasNext()) {
-	it.next();
-	Kwave::MetaData &meta = it.value();
-
-	// position bound -> move position
-	if (meta.hasProperty(Kwave::MetaData::STDPROP_POS)) {
-	    bool ok = false;
-	    sample_index_t pos = static_cast<sample_index_t>(
-		meta[Kwave::MetaData::STDPROP_POS].toULongLong(&ok));
-	    if (!ok) continue;
-
-	    sample_index_t scaled_pos = static_cast<sample_index_t>(
-		static_cast<double>(pos) * scale);
-	    if (scaled_pos <= SAMPLE_INDEX_MAX) {
-		// scale position
-		meta[Kwave::MetaData::STDPROP_POS] = scaled_pos;
-	    } else  {
-		// do not produce a coordinate overflow
-		// -> moving outside range means deleting!
-		it.remove();
-	    }
+    validateIndex();
+
+    QMultiMap<sample_index_t, QString> scaled;
+    QMultiMap<sample_index_t, QString>::const_iterator it;
+    for (it = m_index.constBegin(); it != m_index.constEnd(); ++it) {
+	const sample_index_t pos = it.key();
+	const QString        id  = it.value();
+
+	sample_index_t scaled_pos = static_cast<sample_index_t>(
+	    static_cast<double>(pos) * scale);
+	if (scaled_pos <= SAMPLE_INDEX_MAX) {
+	    // scale position
+	    m_data[id][Kwave::MetaData::STDPROP_POS] = scaled_pos;
+	    scaled.insert(scaled_pos, id);
+	} else  {
+	    // do not produce a coordinate overflow
+	    // -> moving outside range means deleting!
+	    m_data.remove(id);
+	}
+    }
+    m_index = scaled;
+
+    // not position bound but with a position -> scale position
+    foreach (const QString &id, m_unbound) {
+	Kwave::MetaData &meta = m_data[id];
+	bool ok = false;
+	sample_index_t pos = static_cast<sample_index_t>(
+	    meta[Kwave::MetaData::STDPROP_POS].toULongLong(&ok));
+	if (!ok) continue;
+
+	sample_index_t scaled_pos = static_cast<sample_index_t>(
+	    static_cast<double>(pos) * scale);
+	if (scaled_pos <= SAMPLE_INDEX_MAX) {
+	    meta[Kwave::MetaData::STDPROP_POS] = scaled_pos;
+	} else {
+	    m_data.remove(id);
+	    m_unbound.remove(id);
 	}
     }
 }
@@ -398,6 +435,84 @@ void Kwave::MetaDataList::dump() const
     qDebug("-----------------");
 }
 
+//***************************************************************************
+void Kwave::MetaDataList::clear()
+{
+    m_data.clear();
+    m_index.clear();
+    m_unbound.clear();
+    m_index_valid = true;
+}
+
+//***************************************************************************
+void Kwave::MetaDataList::addRemoval(const Kwave::MetaData &metadata)
+{
+    remove(metadata);
+
+    // an empty object is neither position bound nor has a position
+    Kwave::MetaData empty(metadata);
+    empty.clear();
+    m_data.insert(empty.id(), empty);
+}
+
+//***************************************************************************
+bool Kwave::MetaDataList::positionOf(const Kwave::MetaData &meta,
+                                     sample_index_t &pos)
+{
+    if (!(meta.scope() & Kwave::MetaData::Position)) return false;
+    if (!meta.hasProperty(Kwave::MetaData::STDPROP_POS)) return false;
+
+    bool ok = false;
+    pos = static_cast<sample_index_t>(
+	meta[Kwave::MetaData::STDPROP_POS].toULongLong(&ok));
+    return ok;
+}
+
+//***************************************************************************
+void Kwave::MetaDataList::validateIndex()
+{
+    if (m_index_valid) return;
+
+    m_index.clear();
+    m_unbound.clear();
+    m_index_valid = true;
+    Iterator it(*this);
+    while (it.hasNext()) {
+	it.next();
+	indexInsert(it.value());
+    }
+}
+
+//***************************************************************************
+void Kwave::MetaDataList::indexInsert(const Kwave::MetaData &meta)
+{
+    if (!m_index_valid) return;
+
+    sample_index_t pos = 0;
+    if (positionOf(meta, pos))
+	m_index.insert(pos, meta.id());
+    else if (meta.hasProperty(Kwave::MetaData::STDPROP_POS))
+	m_unbound.insert(meta.id());
+}
+
+//***************************************************************************
+void Kwave::MetaDataList::indexRemove(const Kwave::MetaData &meta)
+{
+    if (!m_index_valid) return;
+
+    sample_index_t pos = 0;
+    if (positionOf(meta, pos))
+	m_index.remove(pos, meta.id());
+    else
+	m_unbound.remove(meta.id());
+}
+
+//***************************************************************************
+void Kwave::MetaDataList::insertUnindexed(const Kwave::MetaData &meta)
+{
+    m_data.insert(meta.id(), meta);
+    m_index_valid = false;
+}
 
 //***************************************************************************
 //***************************************************************************
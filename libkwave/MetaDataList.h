@@ -23,7 +23,8 @@
 #include <QList>
 #include <QMap>
 #include <QMapIterator>
-#include <QMutableMapIterator>
+#include <QMultiMap>
+#include <QSet>
 #include <QString>
 #include <QVariant>
 
@@ -33,15 +34,36 @@
 namespace Kwave
 {
 
-    class Q_DECL_EXPORT MetaDataList: public QMap<QString, MetaData>
+    /**
+     * List of meta data objects, mapped by their id.
+     *
+     * All position bound objects (scope "Position", with the property
+     * STDPROP_POS) are additionally kept in an index that is ordered by
+     * position, so that range queries, shifts and deletes only have to
+     * touch the objects that are really affected instead of scanning and
+     * parsing the whole list.
+     *
+     * @note The map of objects is private, it can only be read from
+     *       outside and modified through the methods of this class,
+     *       which all keep the index up to date.
+     */
+    class Q_DECL_EXPORT MetaDataList
     {
     public:
 
-	/** const iterator for the meta data list */
-	typedef QMapIterator<QString, MetaData> Iterator;
+	/** const STL style iterator for the meta data list */
+	typedef QMap<QString, MetaData>::const_iterator const_iterator;
 
-	/** mutable iterator for the meta data list */
-	typedef QMutableMapIterator<QString, MetaData> MutableIterator;
+	/** const iterator for the meta data list */
+	class Iterator: public QMapIterator<QString, MetaData>
+	{
+	public:
+	    /** Constructor, iterates over all objects of a list */
+	    explicit Iterator(const MetaDataList &list)
+		:QMapIterator<QString, MetaData>(list.m_data)
+	    {
+	    }
+	};
 
 	/** Default constructor */
 	MetaDataList();
@@ -232,6 +254,103 @@ namespace Kwave
 	/** dump all meta data to stdout (for debugging) */
 	virtual void dump() const;
 
+	/** removes all elements, @see QMap::clear() */
+	void clear();
+
+	/**
+	 * Adds an empty object with the id of a given object, replacing
+	 * the object if present. Adding this list to another one removes
+	 * the object there, see add().
+	 *
+	 * @param metadata the object that should be removed on add()
+	 */
+	void addRemoval(const MetaData &metadata);
+
+	/** returns true if the list is empty, @see QMap::isEmpty() */
+	inline bool isEmpty() const { return m_data.isEmpty(); }
+
+	/** returns the number of elements, @see QMap::count() */
+	inline int count() const { return m_data.count(); }
+
+	/** returns the ids of all elements, sorted by id */
+	inline QList<QString> keys() const { return m_data.keys(); }
+
+	/** returns all elements, sorted by id */
+	inline QList<MetaData> values() const { return m_data.values(); }
+
+	/** returns the element with the smallest id, list must not be empty */
+	inline const MetaData &first() const { return m_data.first(); }
+
+	/**
+	 * returns the element with a given id or an empty object if
+	 * not found
+	 */
+	inline const MetaData operator [] (const QString &id) const {
+	    return m_data[id];
+	}
+
+	/** STL style iterator to the first element */
+	inline const_iterator begin() const { return m_data.constBegin(); }
+
+	/** STL style iterator after the last element */
+	inline const_iterator end() const { return m_data.constEnd(); }
+
+	/** STL style iterator to the first element */
+	inline const_iterator constBegin() const { return m_data.constBegin(); }
+
+	/** STL style iterator after the last element */
+	inline const_iterator constEnd() const { return m_data.constEnd(); }
+
+    private:
+
+	/**
+	 * Determines the position of a position bound meta data object
+	 * @param meta the meta data object
+	 * @param pos receives the position
+	 * @return true if the object is position bound, false otherwise
+	 */
+	static bool positionOf(const MetaData &meta, sample_index_t &pos);
+
+	/** rebuilds the position index if it is not up to date */
+	void validateIndex();
+
+	/**
+	 * adds an object to the position index if it is position bound,
+	 * or to m_unbound if it only has a position property
+	 */
+	void indexInsert(const MetaData &meta);
+
+	/** removes an object from the position index */
+	void indexRemove(const MetaData &meta);
+
+	/**
+	 * Inserts an object without maintaining the position index, for
+	 * building lists that are only used for reading
+	 */
+	void insertUnindexed(const MetaData &meta);
+
+    private:
+
+	/** all meta data objects, mapped by their id */
+	QMap<QString, MetaData> m_data;
+
+	/** index of all position bound objects: position -> id */
+	QMultiMap<sample_index_t, QString> m_index;
+
+	/**
+	 * ids of all objects that have the property STDPROP_POS but are
+	 * not in m_index, because they are not of scope "Position" or the
+	 * position is not valid. They are only few, and shifted or deleted
+	 * through firstSample() and lastSample() like before the index.
+	 */
+	QSet<QString> m_unbound;
+
+	/**
+	 * true if m_index and m_unbound are up to date, false only for
+	 * lists built with insertUnindexed()
+	 */
+	bool m_index_valid;
+
     };
 
 }
@@ -307,7 +307,8 @@ sample_index_t Kwave::MimeData::decode(QWidget *widget, const QMimeData *e,
 	Q_ASSERT(ok);
 
 	// if the sample rates do not match, then we need a rate converter
-        Kwave::StreamObject *rate_converter = Q_NULLPTR;
+        Kwave::MultiTrackSource<Kwave::RateConverter, true> *rate_converter =
+	    Q_NULLPTR;
 	if (ok && !qFuzzyCompare(src_rate, dst_rate)) {
 	    // create a sample rate converter
 	    qDebug("Kwave::MimeData::decode(...) -> rate conversion: "\
@@ -354,8 +355,13 @@ sample_index_t Kwave::MimeData::decode(QWidget *widget, const QMimeData *e,
 		last_output = rate_converter;
 	    }
 
-	    // connect the sink
-	    if (ok) {
+	    // connect the sink, the rate converter delivers floats
+	    if (ok && rate_converter) {
+		ok = Kwave::connect(
+		    *last_output, SIGNAL(output(Kwave::FloatArray)),
+		    dst,          SLOT(input(Kwave::FloatArray))
+		);
+	    } else if (ok) {
 		ok = Kwave::connect(
 		    *last_output, SIGNAL(output(Kwave::SampleArray)),
 		    dst,          SLOT(input(Kwave::SampleArray))
@@ -369,6 +375,12 @@ sample_index_t Kwave::MimeData::decode(QWidget *widget, const QMimeData *e,
 	    // flush all samples that are still in the adapter
 	    adapter.flush();
 
+	    // and those still in the filters of the rate converter
+	    if (rate_converter) {
+		for (unsigned int t = 0; t < rate_converter->tracks(); ++t)
+		    if ((*rate_converter)[t]) (*rate_converter)[t]->finished();
+	    }
+
 	} else if (ok) {
 	    // decode directly without any filter
 	    ok = decoder->decode(widget, dst);
@@ -0,0 +1,345 @@
+/***************************************************************************
+        MixerEngine.cpp  -  block oriented channel mixing engine
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "config.h"
+
+#include <string.h>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+#include "libkwave/MixerEngine.h"
+#include "libkwave/MixerMatrix.h"
+#include "libkwave/SampleConversion.h"
+#include "libkwave/Utils.h"
+
+/**
+ * number of samples per channel that are converted to float and mixed
+ * in one step, small enough to keep all inputs in the L1/L2 cache
+ */
+#define MIXER_BLOCK_SIZE 1024
+
+/** maximum number of terms that have a specialized kernel */
+#define MAX_SPECIALIZED_TERMS 4
+
+//***************************************************************************
+/**
+ * Weighted sum of N inputs, with N known at compile time
+ * @param src array of N pointers to the input floats
+ * @param gain array of N coefficients
+ * @param dst receives the output floats
+ * @param len number of samples
+ */
+template <unsigned int N>
+static void weightedSum(const float * const *src, const float *gain,
+                        float *dst, unsigned int len)
+{
+    unsigned int i = 0;
+
+#ifdef __SSE__
+    __m128 g[N];
+    for (unsigned int k = 0; k < N; k++)
+	g[k] = _mm_set1_ps(gain[k]);
+    for (; i + 4 <= len; i += 4) {
+	__m128 acc = _mm_mul_ps(_mm_loadu_ps(src[0] + i), g[0]);
+	for (unsigned int k = 1; k < N; k++)
+	    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(src[k] + i), g[k]));
+	_mm_storeu_ps(dst + i, acc);
+    }
+#endif
+
+    for (; i < len; i++) {
+	float acc = src[0][i] * gain[0];
+	for (unsigned int k = 1; k < N; k++)
+	    acc += src[k][i] * gain[k];
+	dst[i] = acc;
+    }
+}
+
+//***************************************************************************
+/**
+ * Weighted sum of an arbitrary number of inputs
+ * @see weightedSum()
+ */
+static void weightedSumN(const float * const *src, const float *gain,
+                         unsigned int n, float *dst, unsigned int len)
+{
+    weightedSum<1>(src, gain, dst, len);
+    for (unsigned int k = 1; k < n; k++) {
+	const float *s = src[k];
+	const float  f = gain[k];
+	unsigned int i = 0;
+#ifdef __SSE__
+	const __m128 g = _mm_set1_ps(f);
+	for (; i + 4 <= len; i += 4) {
+	    __m128 acc = _mm_loadu_ps(dst + i);
+	    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(s + i), g));
+	    _mm_storeu_ps(dst + i, acc);
+	}
+#endif
+	for (; i < len; i++)
+	    dst[i] += s[i] * f;
+    }
+}
+
+//***************************************************************************
+/**
+ * Sum of N inputs with a common coefficient, N known at compile time
+ * @param src array of N pointers to the input floats
+ * @param gain the common coefficient
+ * @param dst receives the output floats
+ * @param len number of samples
+ */
+template <unsigned int N>
+static void scaledSum(const float * const *src, float gain,
+                      float *dst, unsigned int len)
+{
+    unsigned int i = 0;
+
+#ifdef __SSE__
+    const __m128 g = _mm_set1_ps(gain);
+    for (; i + 4 <= len; i += 4) {
+	__m128 acc = _mm_loadu_ps(src[0] + i);
+	for (unsigned int k = 1; k < N; k++)
+	    acc = _mm_add_ps(acc, _mm_loadu_ps(src[k] + i));
+	_mm_storeu_ps(dst + i, _mm_mul_ps(acc, g));
+    }
+#endif
+
+    for (; i < len; i++) {
+	float acc = src[0][i];
+	for (unsigned int k = 1; k < N; k++)
+	    acc += src[k][i];
+	dst[i] = acc * gain;
+    }
+}
+
+//***************************************************************************
+Kwave::MixerEngine::MixerEngine(unsigned int inputs, unsigned int outputs)
+    :m_inputs(inputs), m_outputs(outputs), m_kind(Weighted), m_terms(),
+     m_float_input(), m_in_buffer(), m_out_buffer()
+{
+    Kwave::MixerMatrix matrix(inputs, outputs);
+    analyze(matrix);
+}
+
+//***************************************************************************
+Kwave::MixerEngine::MixerEngine(const Kwave::MixerMatrix &matrix,
+                                unsigned int inputs, unsigned int outputs)
+    :m_inputs(inputs), m_outputs(outputs), m_kind(Weighted), m_terms(),
+     m_float_input(), m_in_buffer(), m_out_buffer()
+{
+    analyze(matrix);
+}
+
+//***************************************************************************
+Kwave::MixerEngine::~MixerEngine()
+{
+}
+
+//***************************************************************************
+void Kwave::MixerEngine::analyze(const Kwave::MixerMatrix &matrix)
+{
+    m_terms.resize(Kwave::toInt(m_outputs));
+    for (unsigned int y = 0; y < m_outputs; y++) {
+	QVector<Term> &terms = m_terms[y];
+	for (unsigned int x = 0; x < m_inputs; x++) {
+	    const double gain = matrix[x][y];
+	    if (qFuzzyIsNull(gain)) continue;
+	    Term term;
+	    term.input = x;
+	    term.gain  = gain;
+	    terms.append(term);
+	}
+    }
+
+    // check for a pure copy, each output gets at most one input
+    bool copy     = true;
+    bool identity = (m_inputs == m_outputs);
+    for (unsigned int y = 0; y < m_outputs; y++) {
+	const QVector<Term> &terms = m_terms[y];
+	if (terms.isEmpty()) {
+	    identity = false;
+	    continue;
+	}
+	if ((terms.count() > 1) || !qFuzzyCompare(terms[0].gain, 1.0)) {
+	    copy = identity = false;
+	    break;
+	}
+	if (terms[0].input != y) identity = false;
+    }
+
+    // check for a down-mix to mono with equal weights
+    bool downmix = (m_outputs == 1) && (m_inputs > 1) &&
+	(m_terms[0].count() == Kwave::toInt(m_inputs));
+    if (downmix) {
+	foreach (const Term &term, m_terms[0])
+	    if (!qFuzzyCompare(term.gain, m_terms[0][0].gain))
+		downmix = false;
+    }
+
+    if (identity)
+	m_kind = Identity;
+    else if (copy)
+	m_kind = Copy;
+    else if (downmix)
+	m_kind = Downmix;
+    else
+	m_kind = Weighted;
+
+    // find out which inputs need to be converted to float
+    m_float_input.fill(false, Kwave::toInt(m_inputs));
+    if ((m_kind == Downmix) || (m_kind == Weighted)) {
+	foreach (const QVector<Term> &terms, m_terms) {
+	    if ((terms.count() == 1) && qFuzzyCompare(terms[0].gain, 1.0))
+		continue; // will be copied
+	    foreach (const Term &term, terms)
+		m_float_input[term.input] = true;
+	}
+    }
+}
+
+//***************************************************************************
+void Kwave::MixerEngine::mix(const sample_t * const *in,
+                             sample_t * const *out,
+                             unsigned int len)
+{
+    Q_ASSERT(in);
+    Q_ASSERT(out);
+    if (!in || !out || !len) return;
+
+    // first handle all outputs that are a plain copy or silence
+    for (unsigned int y = 0; y < m_outputs; y++) {
+	const QVector<Term> &terms = m_terms[y];
+	if (terms.isEmpty()) {
+	    memset(out[y], 0x00, len * sizeof(sample_t));
+	} else if ((m_kind == Identity) || (m_kind == Copy) ||
+	           ((m_kind == Weighted) && (terms.count() == 1) &&
+	            qFuzzyCompare(terms[0].gain, 1.0)))
+	{
+	    memcpy(out[y], in[terms[0].input], len * sizeof(sample_t));
+	}
+    }
+    if ((m_kind == Identity) || (m_kind == Copy)) return;
+
+    // prepare the buffers for conversion to float
+    const int block_size = MIXER_BLOCK_SIZE;
+    if (m_in_buffer.size() < Kwave::toInt(m_inputs) * block_size)
+	m_in_buffer.resize(Kwave::toInt(m_inputs) * block_size);
+    if (m_out_buffer.size() < block_size)
+	m_out_buffer.resize(block_size);
+    Q_ASSERT(m_in_buffer.size() >= Kwave::toInt(m_inputs) * block_size);
+    Q_ASSERT(m_out_buffer.size() >= block_size);
+    if (m_in_buffer.size() < Kwave::toInt(m_inputs) * block_size) return;
+    if (m_out_buffer.size() < block_size) return;
+
+    float *in_f  = m_in_buffer.data();
+    float *out_f = m_out_buffer.data();
+    const float *src[MAX_SPECIALIZED_TERMS];
+    float gain[MAX_SPECIALIZED_TERMS];
+    QVector<const float *> src_n;
+    QVector<float> gain_n;
+
+    for (unsigned int offset = 0; offset < len; offset += block_size) {
+	const unsigned int n = qMin(len - offset,
+	                            static_cast<unsigned int>(block_size));
+
+	// convert all needed inputs to float
+	for (unsigned int x = 0; x < m_inputs; x++) {
+	    if (!m_float_input[x]) continue;
+	    Kwave::samples2floats(in[x] + offset, in_f + (x * block_size), n);
+	}
+
+	if (m_kind == Downmix) {
+	    // N -> mono, sum of all inputs with common weight
+	    const float g = static_cast<float>(m_terms[0][0].gain);
+	    src_n.resize(Kwave::toInt(m_inputs));
+	    for (unsigned int x = 0; x < m_inputs; x++)
+		src_n[x] = in_f + (x * block_size);
+	    switch (m_inputs) {
+		case 2:  scaledSum<2>(src_n.constData(), g, out_f, n); break;
+		case 6:  scaledSum<6>(src_n.constData(), g, out_f, n); break;
+		default:
+		    gain_n.fill(g, Kwave::toInt(m_inputs));
+		    weightedSumN(src_n.constData(), gain_n.constData(),
+		                 m_inputs, out_f, n);
+		    break;
+	    }
+	    Kwave::floats2samples(out_f, out[0] + offset, n);
+	    continue;
+	}
+
+	// general case: weighted sum of the non-zero terms
+	for (unsigned int y = 0; y < m_outputs; y++) {
+	    const QVector<Term> &terms = m_terms[y];
+	    const unsigned int count = terms.count();
+	    if (!count) continue;
+	    if ((count == 1) && qFuzzyCompare(terms[0].gain, 1.0))
+		continue; // already copied
+
+	    if (count <= MAX_SPECIALIZED_TERMS) {
+		for (unsigned int k = 0; k < count; k++) {
+		    src[k]  = in_f + (terms[k].input * block_size);
+		    gain[k] = static_cast<float>(terms[k].gain);
+		}
+		switch (count) {
+		    case 1:  weightedSum<1>(src, gain, out_f, n); break;
+		    case 2:  weightedSum<2>(src, gain, out_f, n); break;
+		    case 3:  weightedSum<3>(src, gain, out_f, n); break;
+		    default: weightedSum<4>(src, gain, out_f, n); break;
+		}
+	    } else {
+		src_n.resize(Kwave::toInt(count));
+		gain_n.resize(Kwave::toInt(count));
+		for (unsigned int k = 0; k < count; k++) {
+		    src_n[k]  = in_f + (terms[k].input * block_size);
+		    gain_n[k] = static_cast<float>(terms[k].gain);
+		}
+		weightedSumN(src_n.constData(), gain_n.constData(),
+		             count, out_f, n);
+	    }
+	    Kwave::floats2samples(out_f, out[y] + offset, n);
+	}
+    }
+}
+
+//***************************************************************************
+void Kwave::MixerEngine::mixFrame(const sample_t *in, sample_t *out) const
+{
+    Q_ASSERT(in);
+    Q_ASSERT(out);
+    if (!in || !out) return;
+
+    if ((m_kind == Identity) || (m_kind == Copy)) {
+	for (unsigned int y = 0; y < m_outputs; y++) {
+	    const QVector<Term> &terms = m_terms[y];
+	    out[y] = (terms.isEmpty()) ? 0 : in[terms[0].input];
+	}
+	return;
+    }
+
+    for (unsigned int y = 0; y < m_outputs; y++) {
+	double sum = 0.0;
+	foreach (const Term &term, m_terms[y])
+	    sum += static_cast<double>(in[term.input]) * term.gain;
+	out[y] = static_cast<sample_t>(sum);
+    }
+}
+
+//***************************************************************************
+//***************************************************************************
@@ -0,0 +1,147 @@
+/***************************************************************************
+          MixerEngine.h  -  block oriented channel mixing engine
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef MIXER_ENGINE_H
+#define MIXER_ENGINE_H
+
+#include "config.h"
+
+#include <QtGlobal>
+#include <QVector>
+
+#include "libkwave/Sample.h"
+
+namespace Kwave
+{
+
+    class MixerMatrix;
+
+    /**
+     * Mixes a number of input channels into a number of output channels,
+     * using the coefficients of a Kwave::MixerMatrix. The matrix is
+     * analyzed once when the engine is created and reduced to a list of
+     * non-zero terms per output, common layouts are handled by
+     * specialized kernels:
+     * - identity and pure copies (mono -> N, default stereo -> 5.1):
+     *   plain memcpy without any arithmetic
+     * - N -> mono with equal weights: sum of all inputs, scaled once
+     * - all others (5.1 -> stereo, sparse or dense matrices): weighted
+     *   sum over the non-zero terms only
+     *
+     * Blocks are processed in float with SIMD instructions if available,
+     * single frames (as used for playback) in double precision.
+     */
+    class Q_DECL_EXPORT MixerEngine
+    {
+    public:
+
+	/** layout of the mixer matrix, determines the kernel */
+	typedef enum {
+	    Identity, /**< each input goes to the same output      */
+	    Copy,     /**< each output is a copy of one input      */
+	    Downmix,  /**< one output, sum of equally weighted inputs */
+	    Weighted  /**< general case, weighted sum per output   */
+	} Kind;
+
+	/**
+	 * Constructor, uses the default Kwave::MixerMatrix
+	 * @param inputs number of input channels
+	 * @param outputs number of output channels
+	 */
+	MixerEngine(unsigned int inputs, unsigned int outputs);
+
+	/**
+	 * Constructor, with a given mixer matrix
+	 * @param matrix the mixer matrix, only used within the constructor
+	 * @param inputs number of input channels (columns of the matrix)
+	 * @param outputs number of output channels (rows of the matrix)
+	 */
+	MixerEngine(const Kwave::MixerMatrix &matrix,
+	            unsigned int inputs, unsigned int outputs);
+
+	/** Destructor */
+	virtual ~MixerEngine();
+
+	/** returns the number of inputs */
+	inline unsigned int inputs() const { return m_inputs; }
+
+	/** returns the number of outputs */
+	inline unsigned int outputs() const { return m_outputs; }
+
+	/** returns the detected layout of the mixer matrix */
+	inline Kind kind() const { return m_kind; }
+
+	/**
+	 * Mixes blocks of samples, one buffer per channel.
+	 *
+	 * @param in array of pointers to the input buffers, one per input
+	 * @param out array of pointers to the output buffers, one per
+	 *            output, must not overlap with the input buffers
+	 * @param len number of samples per channel
+	 */
+	void mix(const sample_t * const *in, sample_t * const *out,
+	         unsigned int len);
+
+	/**
+	 * Mixes a single frame of samples
+	 *
+	 * @param in pointer to one sample per input
+	 * @param out pointer to one sample per output
+	 */
+	void mixFrame(const sample_t *in, sample_t *out) const;
+
+    private:
+
+	/** builds the list of terms and detects the layout */
+	void analyze(const Kwave::MixerMatrix &matrix);
+
+	/** one non-zero coefficient of the matrix */
+	typedef struct {
+	    unsigned int input; /**< index of the input */
+	    double       gain;  /**< coefficient        */
+	} Term;
+
+    private:
+
+	/** number of inputs */
+	unsigned int m_inputs;
+
+	/** number of outputs */
+	unsigned int m_outputs;
+
+	/** layout of the matrix */
+	Kind m_kind;
+
+	/** list of non-zero terms, per output */
+	QVector< QVector<Term> > m_terms;
+
+	/** true for each input that is needed as float */
+	QVector<bool> m_float_input;
+
+	/** buffer for inputs converted to float, one block per input */
+	QVector<float> m_in_buffer;
+
+	/** buffer for one output block in float */
+	QVector<float> m_out_buffer;
+
+    };
+}
+
+#endif /* MIXER_ENGINE_H */
+
+//***************************************************************************
+//***************************************************************************
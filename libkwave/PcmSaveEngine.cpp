@@ -0,0 +1,322 @@
+/***************************************************************************
+         PcmSaveEngine.cpp  -  parallel writing of PCM data into a file
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <new>
+
+#include <QFileDevice>
+#include <QFutureSynchronizer>
+#include <QIODevice>
+#include <QMutexLocker>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrentRun>
+
+#include "libkwave/MultiTrackReader.h"
+#include "libkwave/PcmSaveEngine.h"
+#include "libkwave/SampleArray.h"
+#include "libkwave/SampleConversion.h"
+#include "libkwave/SampleReader.h"
+#include "libkwave/Utils.h"
+
+/** size of one write buffer [bytes] */
+#define PCM_SAVE_BUFFER_SIZE (4 * 1024 * 1024)
+
+/** alignment of the write buffers [bytes] */
+#define PCM_SAVE_ALIGNMENT 4096
+
+/** number of write buffers per chunk */
+#define PCM_SAVE_BUFFERS_PER_CHUNK 8
+
+/** interval for updating the progress of the source [ms] */
+#define PCM_SAVE_PROGRESS_INTERVAL 100
+
+//***************************************************************************
+namespace Kwave
+{
+    namespace
+    {
+	/**
+	 * Writes a block of data to a given position in a file, repeats
+	 * the write after interruptions or partial writes
+	 * @return true if succeeded, false if failed
+	 */
+	bool pwriteAll(int fd, const char *data, size_t size, qint64 pos)
+	{
+	    while (size) {
+		const ssize_t written = ::pwrite(fd, data, size,
+		                                 static_cast<off_t>(pos));
+		if (written < 0) {
+		    if (errno == EINTR) continue;
+		    qWarning("PcmSaveEngine: write failed: %s",
+		             strerror(errno));
+		    return false;
+		}
+		if (!written) return false; // should never happen
+		data += written;
+		pos  += written;
+		size -= static_cast<size_t>(written);
+	    }
+	    return true;
+	}
+    }
+}
+
+//***************************************************************************
+Kwave::PcmSaveEngine::PcmSaveEngine(unsigned int bits)
+    :m_bits(bits), m_tracks(0), m_frame_size(0), m_buffer_frames(0),
+     m_fd(-1), m_offset(0), m_first(0), m_length(0), m_chunk_frames(0),
+     m_chunks(0), m_stripes(), m_next_chunk(0), m_stop(0), m_lock(),
+     m_progress(), m_done(), m_active(0), m_failed(false), m_written(0)
+{
+    Q_ASSERT((bits == 8) || (bits == 16) || (bits == 24) || (bits == 32));
+}
+
+//***************************************************************************
+Kwave::PcmSaveEngine::~PcmSaveEngine()
+{
+}
+
+//***************************************************************************
+bool Kwave::PcmSaveEngine::isSupported(QIODevice &dst)
+{
+    QFileDevice *file = qobject_cast<QFileDevice *>(&dst);
+    return (file && file->isOpen() && (file->handle() >= 0));
+}
+
+//***************************************************************************
+bool Kwave::PcmSaveEngine::save(Kwave::MultiTrackReader &src,
+                                QIODevice &dst, sample_index_t length)
+{
+    m_written = 0;
+    if (!isSupported(dst)) return false;
+    if (!length) return true;
+
+    m_tracks        = src.tracks();
+    m_frame_size    = m_tracks * (m_bits / 8);
+    if (!m_frame_size) return false;
+    m_buffer_frames = qMax(1U, PCM_SAVE_BUFFER_SIZE / m_frame_size);
+    m_chunk_frames  = static_cast<sample_index_t>(m_buffer_frames) *
+                      PCM_SAVE_BUFFERS_PER_CHUNK;
+    m_chunks        = Kwave::toUint((length + m_chunk_frames - 1) /
+                                    m_chunk_frames);
+    m_length        = length;
+
+    // everything that has been written through the device so far
+    // must be in the file before we write around it
+    QFileDevice *file = qobject_cast<QFileDevice *>(&dst);
+    if (!file->flush()) return false;
+    m_fd     = file->handle();
+    m_offset = file->pos();
+
+    // take the stripes of the whole range, the workers create their
+    // readers from them, independent from the source
+    Kwave::SampleReader *first_reader = src[0];
+    m_first = (first_reader) ? first_reader->pos() : 0;
+    m_stripes.resize(Kwave::toInt(m_tracks));
+    for (unsigned int t = 0; t < m_tracks; t++) {
+	Kwave::SampleReader *reader = src[t];
+	m_stripes[t] = (reader) ?
+	    reader->stripes(m_first, m_first + length - 1) :
+	    Kwave::Stripe::List(m_first, m_first + length - 1);
+    }
+
+    // allocate the space for the whole data in advance
+    const qint64 size = static_cast<qint64>(length) * m_frame_size;
+    const int res = ::posix_fallocate(m_fd, static_cast<off_t>(m_offset),
+                                      static_cast<off_t>(size));
+    if (res == ENOSPC) {
+	qWarning("PcmSaveEngine: not enough space for %lld bytes",
+	         static_cast<long long int>(size));
+	return false;
+    }
+    // other errors mean that the file system does not support it
+
+    m_next_chunk.storeRelease(0);
+    m_stop.storeRelease(0);
+    m_done.fill(false, Kwave::toInt(m_chunks));
+    m_failed = false;
+
+    // start the workers, one per CPU
+    const int threads = qBound(1, QThread::idealThreadCount(),
+                               Kwave::toInt(m_chunks));
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+    QFutureSynchronizer<void> synchronizer;
+    m_active = threads;
+    for (int i = 0; i < threads; i++) {
+	synchronizer.addFuture(QtConcurrent::run(&pool,
+	    this, &Kwave::PcmSaveEngine::work));
+    }
+
+    // forward the progress to the source and watch out for cancel
+    sample_index_t skipped = 0;
+    {
+	QMutexLocker lock(&m_lock);
+	while (m_active) {
+	    m_progress.wait(&m_lock, PCM_SAVE_PROGRESS_INTERVAL);
+	    const sample_index_t done = qMin<sample_index_t>(length,
+		completedChunks() * m_chunk_frames);
+	    lock.unlock();
+	    if (done > skipped) {
+		src.skip(done - skipped);
+		skipped = done;
+	    }
+	    if (src.isCanceled()) m_stop.storeRelease(1);
+	    lock.relock();
+	}
+    }
+    synchronizer.waitForFinished();
+
+    m_written = qMin<sample_index_t>(length,
+	completedChunks() * m_chunk_frames);
+    const qint64 end = m_offset + static_cast<qint64>(m_written) *
+                       m_frame_size;
+    if (m_written < length) {
+	// canceled or failed: cut off everything after the last chunk
+	// that has been written completely
+	if (::ftruncate(m_fd, static_cast<off_t>(end)) != 0)
+	    qWarning("PcmSaveEngine: truncating the file failed");
+    }
+    m_stripes.clear();
+
+    dst.seek(end);
+    return !m_failed;
+}
+
+//***************************************************************************
+void Kwave::PcmSaveEngine::work()
+{
+    for (;;) {
+	if (m_stop.loadAcquire()) break;
+	const int index = m_next_chunk.fetchAndAddOrdered(1);
+	if (index >= Kwave::toInt(m_chunks)) break;
+
+	bool complete = false;
+	const bool ok = encodeChunk(static_cast<unsigned int>(index),
+	                            complete);
+
+	QMutexLocker lock(&m_lock);
+	if (!ok) {
+	    m_failed = true;
+	    m_stop.storeRelease(1);
+	}
+	if (complete) m_done[index] = true;
+	m_progress.wakeAll();
+    }
+
+    QMutexLocker lock(&m_lock);
+    m_active--;
+    m_progress.wakeAll();
+}
+
+//***************************************************************************
+bool Kwave::PcmSaveEngine::encodeChunk(unsigned int index, bool &complete)
+{
+    complete = false;
+
+    const sample_index_t start = static_cast<sample_index_t>(index) *
+                                 m_chunk_frames;
+    const sample_index_t count = qMin(m_chunk_frames, m_length - start);
+    const sample_index_t first = m_first + start;
+    const sample_index_t last  = first + count - 1;
+
+    // one reader per track, on the stripes of this chunk only
+    QVector<Kwave::SampleReader *> readers(Kwave::toInt(m_tracks));
+    QVector<Kwave::SampleArray>    in(Kwave::toInt(m_tracks));
+    QVector<const sample_t *>      in_ptr(Kwave::toInt(m_tracks));
+    bool ok = true;
+    for (unsigned int t = 0; t < m_tracks; t++) {
+	Kwave::Stripe::List stripes(first, last);
+	foreach (const Kwave::Stripe &s, m_stripes[t]) {
+	    if (s.start() > last) break;
+	    if (s.end() < first) continue;
+	    stripes.append(s);
+	}
+	readers[t] = new(std::nothrow)
+	    Kwave::SampleReader(Kwave::SinglePassForward, stripes);
+	if (!readers[t] || !in[t].resize(m_buffer_frames)) ok = false;
+    }
+
+    // aligned buffer for the PCM data
+    void *buffer = Q_NULLPTR;
+    if (::posix_memalign(&buffer, PCM_SAVE_ALIGNMENT,
+                         m_buffer_frames * m_frame_size) != 0)
+    {
+	buffer = Q_NULLPTR;
+	ok = false;
+    }
+
+    qint64 pos = m_offset + static_cast<qint64>(start) * m_frame_size;
+    sample_index_t rest = count;
+    while (ok && rest && !m_stop.loadAcquire()) {
+	const unsigned int frames = Kwave::toUint(
+	    qMin<sample_index_t>(rest, m_buffer_frames));
+	for (unsigned int t = 0; t < m_tracks; t++) {
+	    const unsigned int got = readers[t]->read(in[t], 0, frames);
+	    if (got < frames) {
+		memset(in[t].data() + got, 0x00,
+		       (frames - got) * sizeof(sample_t));
+	    }
+	    in_ptr[t] = in[t].constData();
+	}
+
+	quint8 *out = static_cast<quint8 *>(buffer);
+	ok = Kwave::samples2pcm(in_ptr.constData(), m_bits, m_tracks,
+	                        out, frames);
+	const size_t bytes = static_cast<size_t>(frames) * m_frame_size;
+	if (ok) ok = Kwave::pwriteAll(m_fd, static_cast<const char *>(buffer),
+	                              bytes, pos);
+
+	pos  += static_cast<qint64>(bytes);
+	rest -= frames;
+    }
+    complete = ok && !rest;
+
+    ::free(buffer);
+    qDeleteAll(readers);
+    return ok;
+}
+
+//***************************************************************************
+unsigned int Kwave::PcmSaveEngine::completedChunks() const
+{
+    unsigned int count = 0;
+    while ((count < m_chunks) && m_done[count])
+	count++;
+    return count;
+}
+
+//***************************************************************************
+bool Kwave::PcmSaveEngine::sync(QIODevice &dst)
+{
+    QFileDevice *file = qobject_cast<QFileDevice *>(&dst);
+    if (!file || (file->handle() < 0)) return false;
+
+    if (!file->flush()) return false;
+    return (::fsync(file->handle()) == 0);
+}
+
+//***************************************************************************
+//***************************************************************************
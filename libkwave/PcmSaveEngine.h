@@ -0,0 +1,186 @@
+/***************************************************************************
+           PcmSaveEngine.h  -  parallel writing of PCM data into a file
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef PCM_SAVE_ENGINE_H
+#define PCM_SAVE_ENGINE_H
+
+#include "config.h"
+
+#include <QtGlobal>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QVector>
+#include <QWaitCondition>
+
+#include "libkwave/Sample.h"
+#include "libkwave/Stripe.h"
+
+class QIODevice;
+
+namespace Kwave
+{
+
+    class MultiTrackReader;
+
+    /**
+     * Writes the samples of a Kwave::MultiTrackReader as interleaved
+     * little-endian integer PCM data into a file. The range of samples
+     * is split into chunks of some megabytes, which are read and converted
+     * by a pool of threads, each chunk with its own readers, and are
+     * written with pwrite() directly into their place in the file, in
+     * big blocks from aligned buffers.
+     *
+     * The space for all the data is allocated before, which keeps the
+     * file in one piece on the disk and detects a full disk before the
+     * first block is written.
+     */
+    class Q_DECL_EXPORT PcmSaveEngine
+    {
+    public:
+
+	/**
+	 * Constructor
+	 * @param bits number of bits per sample: 8, 16, 24 or 32,
+	 *             8 bit data is unsigned, all others are signed
+	 */
+	explicit PcmSaveEngine(unsigned int bits);
+
+	/** Destructor */
+	virtual ~PcmSaveEngine();
+
+	/**
+	 * Returns true if a device can be used for saving, which is
+	 * the case for all open files
+	 * @param dst the destination device
+	 */
+	static bool isSupported(QIODevice &dst);
+
+	/**
+	 * Encodes and writes the samples, starting at the current position
+	 * of the destination. When done, the destination is positioned
+	 * directly after the last written sample frame. If the source gets
+	 * canceled, the file is truncated after the last complete chunk.
+	 *
+	 * @param src reader for the samples, one reader per track, all at
+	 *            the same position and not yet read from
+	 * @param dst the destination file, see isSupported()
+	 * @param length number of sample frames to write
+	 * @return true if succeeded or canceled, false if failed
+	 */
+	bool save(Kwave::MultiTrackReader &src, QIODevice &dst,
+	          sample_index_t length);
+
+	/**
+	 * Returns the number of sample frames written by the last call
+	 * of save(), which is less than requested if it has been canceled
+	 */
+	inline sample_index_t written() const { return m_written; }
+
+	/**
+	 * Flushes the buffers of a file and waits until all of its data
+	 * has reached the disk.
+	 * @param dst the file
+	 * @return true if succeeded, false if failed
+	 */
+	static bool sync(QIODevice &dst);
+
+    private:
+
+	/** main loop of one worker thread, takes chunks until done */
+	void work();
+
+	/**
+	 * Reads, converts and writes one chunk
+	 * @param index index of the chunk [0...m_chunks-1]
+	 * @param complete receives true if the whole chunk has been
+	 *                 written, false if stopped before
+	 * @return true if succeeded, false if failed
+	 */
+	bool encodeChunk(unsigned int index, bool &complete);
+
+	/**
+	 * Returns the number of chunks, counted from the start, which
+	 * are complete. m_lock must be held.
+	 */
+	unsigned int completedChunks() const;
+
+    private:
+
+	/** number of bits per sample */
+	unsigned int m_bits;
+
+	/** number of tracks */
+	unsigned int m_tracks;
+
+	/** number of bytes per sample frame */
+	unsigned int m_frame_size;
+
+	/** sample frames per write buffer */
+	unsigned int m_buffer_frames;
+
+	/** file descriptor of the destination */
+	int m_fd;
+
+	/** position of the first sample frame in the file [bytes] */
+	qint64 m_offset;
+
+	/** index of the first sample to write */
+	sample_index_t m_first;
+
+	/** number of sample frames to write */
+	sample_index_t m_length;
+
+	/** sample frames per chunk */
+	sample_index_t m_chunk_frames;
+
+	/** number of chunks */
+	unsigned int m_chunks;
+
+	/** stripes of the whole range, one list per track */
+	QVector<Kwave::Stripe::List> m_stripes;
+
+	/** index of the next chunk to be taken by a worker */
+	QAtomicInt m_next_chunk;
+
+	/** set to stop all workers, after cancel or error */
+	QAtomicInt m_stop;
+
+	/** lock for m_done, m_active and m_failed */
+	QMutex m_lock;
+
+	/** signaled whenever a chunk is done or a worker ends */
+	QWaitCondition m_progress;
+
+	/** one flag per chunk, true if written completely */
+	QVector<bool> m_done;
+
+	/** number of workers that are still running */
+	int m_active;
+
+	/** true if a read or write error occurred */
+	bool m_failed;
+
+	/** number of sample frames written by the last save() */
+	sample_index_t m_written;
+
+    };
+}
+
+#endif /* PCM_SAVE_ENGINE_H */
+
+//***************************************************************************
+//***************************************************************************
@@ -23,7 +23,7 @@
 #include <QMutexLocker>
 
 #include "libkwave/MessageBox.h"
-#include "libkwave/MixerMatrix.h"
+#include "libkwave/MixerEngine.h"
 #include "libkwave/MultiTrackReader.h"
 #include "libkwave/PlayBackDevice.h"
 #include "libkwave/PlayBackTypesMap.h"
@@ -401,7 +401,7 @@ void Kwave::PlaybackController::run_wrapper(const QVariant &params)
 {
     Q_UNUSED(params)
 
-    Kwave::MixerMatrix *mixer = Q_NULLPTR;
+    Kwave::MixerEngine *mixer = Q_NULLPTR;
     sample_index_t first      = m_playback_start;
     sample_index_t last       = m_playback_end;
     unsigned int out_channels = m_playback_params.channels;
@@ -446,7 +446,6 @@ void Kwave::PlaybackController::run_wrapper(const QVariant &params)
 
 	while ((pos++ <= last) && !m_thread.isInterruptionRequested()) {
 	    unsigned int x;
-	    unsigned int y;
 	    bool seek_again = false;
 	    bool seek_done  = false;
 
@@ -464,7 +463,7 @@ void Kwave::PlaybackController::run_wrapper(const QVariant &params)
 		    audible_tracks = m_signal_manager.selectedTracks();
 		    audible_count = audible_tracks.count();
 		    mixer = new(std::nothrow)
-			Kwave::MixerMatrix(audible_count, out_channels);
+			Kwave::MixerEngine(audible_count, out_channels);
 		    Q_ASSERT(mixer);
 		    if (!mixer) break;
 		    seek_again = true; // re-synchronize all reader positions
@@ -494,15 +493,8 @@ void Kwave::PlaybackController::run_wrapper(const QVariant &params)
 		if (!stream->eof()) (*stream) >> in_samples[x];
 	    }
 
-	    // multiply matrix with input to get output
-	    const Kwave::SampleArray &in = in_samples;
-	    for (y = 0; y < out_channels; ++y) {
-		double sum = 0;
-		for (x = 0; x < audible_count; ++x) {
-		    sum += static_cast<double>(in[x]) * (*mixer)[x][y];
-		}
-		out_samples[y] = static_cast<sample_t>(sum);
-	    }
+	    // mix the input to get output
+	    mixer->mixFrame(in_samples.constData(), out_samples.data());
 
 	    // write samples to the playback device
 	    int result = -1;
@@ -540,6 +532,8 @@ void Kwave::PlaybackController::run_wrapper(const QVariant &params)
 
     } while (m_loop_mode && !m_thread.isInterruptionRequested());
 
+    if (mixer) delete mixer;
+
     // playback is done
     emit sigDevicePlaybackDone();
 //     qDebug("PlaybackController::run() done.");
@@ -35,6 +35,7 @@
 #include "libkwave/ConfirmCancelProxy.h"
 #include "libkwave/Plugin.h"
 #include "libkwave/PluginManager.h"
+#include "libkwave/Profiler.h"
 #include "libkwave/Sample.h"
 #include "libkwave/SignalManager.h"
 #include "libkwave/String.h"
@@ -395,7 +396,11 @@ void Kwave::Plugin::run_wrapper(const QVariant &params)
     t.start();
 
     // call the plugin's run function in this worker thread context
-    run(params.toStringList());
+    {
+	Kwave::ProfileScope profile(Kwave::Profiler::isEnabled() ?
+	    Kwave::Profiler::intern(_("plugin:") + name()) : "plugin");
+	run(params.toStringList());
+    }
 
     // evaluate the elapsed time
     double seconds = static_cast<double>(t.elapsed()) * 1E-3;
@@ -435,6 +440,13 @@ void Kwave::Plugin::use()
     m_usage_count++;
 }
 
+//***************************************************************************
+unsigned int Kwave::Plugin::usageCount()
+{
+    QMutexLocker lock(&m_usage_lock);
+    return m_usage_count;
+}
+
 //***************************************************************************
 void Kwave::Plugin::release()
 {
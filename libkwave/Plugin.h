@@ -268,6 +268,9 @@ namespace Kwave
 	/** increments the usage counter */
 	void use();
 
+	/** returns the current value of the usage counter */
+	unsigned int usageCount();
+
 	/** assign this plugin to a new plugin manager (when migrating) */
 	void setPluginManager(Kwave::PluginManager *new_plugin_manager);
 
@@ -22,11 +22,15 @@
 #include <new>
 
 #include <QApplication>
+#include <QDateTime>
 #include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
 #include <QLatin1Char>
 #include <QLibrary>
 #include <QLibraryInfo>
 #include <QMutableListIterator>
+#include <QStandardPaths>
 #include <QtGlobal>
 #include <QVariantList>
 
@@ -36,9 +40,14 @@
 #include <KMainWindow>
 #include <KPluginInfo>
 #include <KPluginFactory>
+#include <KPluginLoader>
 #include <KPluginMetaData>
 #include <KSharedConfig>
 
+#include "libkwave/CodecManager.h"
+#include "libkwave/CodecPlugin.h"
+#include "libkwave/Decoder.h"
+#include "libkwave/Encoder.h"
 #include "libkwave/MessageBox.h"
 #include "libkwave/MultiPlaybackSink.h"
 #include "libkwave/PlayBackDevice.h"
@@ -46,12 +55,16 @@
 #include "libkwave/Plugin.h"
 #include "libkwave/PluginManager.h"
 #include "libkwave/SignalManager.h"
+#include "libkwave/String.h"
 #include "libkwave/Utils.h"
 #include "libkwave/Writer.h"
 #include "libkwave/undo/UndoAction.h"
 #include "libkwave/undo/UndoModifyAction.h"
 #include "libkwave/undo/UndoTransactionGuard.h"
 
+/** name of the plugin manifest file, in the cache directory */
+#define PLUGIN_MANIFEST_FILE _("plugin-manifest")
+
 //***************************************************************************
 // static initializers
 
@@ -67,7 +80,9 @@ Kwave::PluginManager::PluginManager(QWidget *parent,
      m_running_plugins(),
      m_parent_widget(parent),
      m_signal_manager(signal_manager),
-     m_view_manager(Q_NULLPTR)
+     m_view_manager(Q_NULLPTR),
+     m_record_commands(false),
+     m_recorded_commands()
 {
 }
 
@@ -119,23 +134,119 @@ Kwave::PluginManager::~PluginManager()
 	}
     }
 
+    // the last instance takes the codec proxies with it
+    if (m_plugin_modules.isEmpty())
+	Kwave::CodecManager::unregisterCodecModules();
+
     // we are no longer the active instance
     if (m_active_instance == this)
         m_active_instance = Q_NULLPTR;
 }
 
+//***************************************************************************
+/**
+ * Returns a string that identifies the version of a plugin module,
+ * changes whenever Kwave or the shared object has changed
+ * @param library path of the shared object
+ */
+static QString moduleStamp(const QString &library)
+{
+    QFileInfo file(library);
+    return _("%1:%2:%3").arg(
+	_(KWAVE_VERSION)).arg(
+	file.size()).arg(
+	file.lastModified().toMSecsSinceEpoch());
+}
+
+//***************************************************************************
+/**
+ * Saves a list of mime types into a group of the plugin manifest,
+ * one entry per mime type with name, description and patterns
+ * @param cfg the group in the manifest
+ * @param types list of mime types
+ */
+static void saveMimeTypes(KConfigGroup cfg,
+                          const QList<Kwave::CodecBase::MimeType> &types)
+{
+    cfg.deleteGroup();
+    int index = 0;
+    foreach (const Kwave::CodecBase::MimeType &type, types) {
+	QStringList entry;
+	entry << type.name << type.description << type.patterns;
+	cfg.writeEntry(QString::number(index++), entry);
+    }
+}
+
+//***************************************************************************
+/**
+ * Reads a list of mime types saved with saveMimeTypes()
+ * @param cfg the group in the manifest
+ * @return list of mime types, in the original order
+ */
+static QList<Kwave::CodecBase::MimeType> readMimeTypes(const KConfigGroup &cfg)
+{
+    QList<Kwave::CodecBase::MimeType> types;
+    for (int index = 0; ; ++index) {
+	QStringList entry =
+	    cfg.readEntry(QString::number(index), QStringList());
+	if (entry.count() < 2) break;
+
+	Kwave::CodecBase::MimeType type;
+	type.name        = entry.takeFirst();
+	type.description = entry.takeFirst();
+	type.patterns    = entry;
+	types.append(type);
+    }
+    return types;
+}
+
 //***************************************************************************
 bool Kwave::PluginManager::loadAllPlugins()
 {
+    QElapsedTimer timer;
+    timer.start();
+    unsigned int loaded = 0;
+
+    // the manifest contains what we learned about each plugin module
+    // during the last start: whether it stays in memory and which
+    // commands it emits when loaded
+    KConfig manifest(PLUGIN_MANIFEST_FILE, KConfig::SimpleConfig,
+                     QStandardPaths::CacheLocation);
+
     // Try to load all plugins. This has to be called only once per
     // instance of the main window!
     // NOTE: this also gives each plugin the chance to stay in memory
     //       if necessary (e.g. for codecs)
-    for (QMap<QString, PluginModule>::iterator it(m_plugin_modules.begin());
-	 it != m_plugin_modules.end(); ++it)
-    {
-	const QString      &name   = it.key();
-	KwavePluginPointer  plugin = createPluginInstance(name);
+    QMap<QString, PluginModule>::iterator it(m_plugin_modules.begin());
+    while (it != m_plugin_modules.end()) {
+	const QString  name  = it.key();
+	const QString  stamp = moduleStamp(it.value().m_library);
+	KConfigGroup   cfg   = manifest.group(name);
+
+	const bool codec = cfg.readEntry("codec", false);
+	if ((cfg.readEntry("stamp", QString()) == stamp) &&
+	    (codec || !cfg.readEntry("persistent", true)))
+	{
+	    // known as non-persistent or as codec: only repeat the
+	    // commands that it would emit and announce the mime types
+	    // of a codec, load it later on first use
+	    if (codec) Kwave::CodecManager::registerCodecModule(name,
+		readMimeTypes(cfg.group("encoder")),
+		readMimeTypes(cfg.group("decoder")));
+	    const QStringList commands =
+		cfg.readEntry("commands", QStringList());
+	    foreach (const QString &command, commands)
+		enqueueCommand(command);
+	    ++it;
+	    continue;
+	}
+
+	emit sigProgress(i18n("Loading plugin %1...", name));
+	QApplication::processEvents();
+
+	m_recorded_commands.clear();
+	m_record_commands = true;
+	KwavePluginPointer plugin = createPluginInstance(name);
 	if (plugin) {
 // 	    qDebug("PluginManager::loadAllPlugins(): plugin '%s'",
 // 		   DBG(plugin->name()));
@@ -144,6 +255,28 @@ bool Kwave::PluginManager::loadAllPlugins()
 	    // now the plugin is present and loaded
 	    QStringList last_params = defaultParams(name);
 	    plugin->load(last_params);
+	    m_record_commands = false;
+
+	    // if the plugin holds a reference to itself, it stays in memory
+	    const bool persistent = (plugin->usageCount() > 1);
+
+	    // remember the mime types of a codec, so that it does not
+	    // need to be loaded on the next start
+	    Kwave::CodecPlugin *codec_plugin =
+		dynamic_cast<Kwave::CodecPlugin *>(plugin.data());
+	    if (codec_plugin) {
+		QList<Kwave::CodecBase::MimeType> encoding;
+		foreach (Kwave::Encoder *enc, codec_plugin->encoders())
+		    if (enc) encoding += enc->mimeTypes();
+		QList<Kwave::CodecBase::MimeType> decoding;
+		foreach (Kwave::Decoder *dec, codec_plugin->decoders())
+		    if (dec) decoding += dec->mimeTypes();
+
+		saveMimeTypes(cfg.group("encoder"), encoding);
+		saveMimeTypes(cfg.group("decoder"), decoding);
+		Kwave::CodecManager::registerCodecModule(
+		    name, encoding, decoding);
+	    }
 
 	    // reduce use count again, we loaded the plugin only to give
 	    // it a chance to register some service if necessary (e.g. a
@@ -151,13 +284,27 @@ bool Kwave::PluginManager::loadAllPlugins()
 	    // Most plugins fall back to use count zero and will be
 	    // deleted again.
 	    plugin->release();
+
+	    cfg.writeEntry("stamp",      stamp);
+	    cfg.writeEntry("persistent", persistent);
+	    cfg.writeEntry("codec",      (codec_plugin != Q_NULLPTR));
+	    cfg.writeEntry("commands",   m_recorded_commands);
+	    loaded++;
+	    ++it;
 	} else {
 	    // loading failed => remove it from the list
+	    m_record_commands = false;
 	    qWarning("PluginManager::loadAllPlugins(): removing '%s' "
 	            "from list", DBG(name));
-	    m_plugin_modules.remove(name);
+	    manifest.deleteGroup(name);
+	    it = m_plugin_modules.erase(it);
 	}
+	m_recorded_commands.clear();
     }
+    manifest.sync();
+
+    qDebug("PluginManager: loaded %u of %d plugins in %lld ms",
+           loaded, m_plugin_modules.count(), timer.elapsed());
 
     return !m_plugin_modules.isEmpty();
 }
@@ -196,8 +343,11 @@ Kwave::Plugin *Kwave::PluginManager::createPluginInstance(const QString &name)
 //     qDebug("loadPlugin(%s) [module use count=%d]",
 //         DBG(name), info.m_use_count);
 
-    KPluginFactory *factory = info.m_factory;
-    Q_ASSERT(factory);
+    KPluginFactory *factory = moduleFactory(info);
+    if (!factory) {
+	qWarning("PluginManager::loadPlugin('%s'): loading failed", DBG(name));
+        return Q_NULLPTR;
+    }
 
     // call the loader function to create an instance
     QVariantList args;
@@ -220,6 +370,36 @@ Kwave::Plugin *Kwave::PluginManager::createPluginInstance(const QString &name)
     return plugin;
 }
 
+//***************************************************************************
+bool Kwave::PluginManager::loadPersistent(const QString &name)
+{
+    // check: this must be called from the GUI thread only!
+    Q_ASSERT(this->thread() == QThread::currentThread());
+    Q_ASSERT(this->thread() == qApp->thread());
+
+    KwavePluginPointer plugin = createPluginInstance(name);
+    if (!plugin) return false;
+
+    QStringList last_params = defaultParams(name);
+    plugin->load(last_params);
+    plugin->release();
+    return true;
+}
+
+//***************************************************************************
+bool Kwave::PluginManager::loadCodecModule(const QString &name)
+{
+    Kwave::PluginManager *mgr = m_active_instance;
+    if (!mgr) return false;
+    if (!m_plugin_modules.contains(name)) return false;
+
+    // plugins can only be created in the GUI thread
+    Q_ASSERT(QThread::currentThread() == mgr->thread());
+    if (QThread::currentThread() != mgr->thread()) return false;
+
+    return mgr->loadPersistent(name);
+}
+
 //***************************************************************************
 int Kwave::PluginManager::executePlugin(const QString &name,
                                         QStringList *params)
@@ -502,6 +682,7 @@ void Kwave::PluginManager::registerViewManager(Kwave::ViewManager *view_manager)
 //***************************************************************************
 void Kwave::PluginManager::enqueueCommand(const QString &command)
 {
+    if (m_record_commands) m_recorded_commands.append(command);
     emit sigCommand(command);
 }
 
@@ -623,6 +804,10 @@ void Kwave::PluginManager::searchPluginModules()
 	return;
     }
 
+    QElapsedTimer timer;
+    timer.start();
+
+    // NOTE: this only reads the meta data, without loading the modules
     KPluginInfo::List plugins = KPluginInfo::fromMetaData(
 	KPluginLoader::findPlugins(_("kwave"))
     );
@@ -658,22 +843,13 @@ void Kwave::PluginManager::searchPluginModules()
 	    continue;
 	}
 
-	KPluginLoader loader(library);
-	KPluginFactory* factory = loader.factory();
-	if (!factory) {
-	    qWarning("plugin '%s': loading failed", DBG(name));
-	    continue;
-	}
-
-	emit sigProgress(i18n("Loading plugin %1...", name));
-	QApplication::processEvents();
-
 	PluginModule info;
 	info.m_name        = name;
 	info.m_author      = author;
 	info.m_description = i18n(description.toUtf8());
 	info.m_version     = settings;
-	info.m_factory     = factory;
+	info.m_library     = library;
+	info.m_factory     = Q_NULLPTR; // loaded on first use
 	info.m_use_count   = 1;
 
 	m_plugin_modules.insert(info.m_name, info);
@@ -681,7 +857,21 @@ void Kwave::PluginManager::searchPluginModules()
 	qDebug("%16s %5s written by %s", DBG(name), DBG(settings), DBG(author));
     }
 
-    qDebug("--- \n found %d plugins\n", m_plugin_modules.count());
+    qDebug("--- \n found %d plugins in %lld ms\n",
+           m_plugin_modules.count(), timer.elapsed());
+}
+
+//***************************************************************************
+KPluginFactory *Kwave::PluginManager::moduleFactory(PluginModule &info)
+{
+    if (!info.m_factory) {
+	KPluginLoader loader(info.m_library);
+	info.m_factory = loader.factory();
+	if (!info.m_factory)
+	    qWarning("plugin '%s': loading failed: %s",
+	             DBG(info.m_name), DBG(loader.errorString()));
+    }
+    return info.m_factory;
 }
 
 //***************************************************************************
@@ -27,6 +27,7 @@
 #include <QMutableListIterator>
 #include <QObject>
 #include <QPointer>
+#include <QStringList>
 #include <QWidget>
 
 #include "libkwave/InsertMode.h"
@@ -35,7 +36,6 @@
 
 class QLibrary;
 class QString;
-class QStringList;
 
 class KPluginFactory;
 
@@ -79,8 +79,18 @@ namespace Kwave
 	 * it will stay loaded in memory, all other (non-persistent)
 	 * plugins will be unloaded afterwards. This also filters out
 	 * all plugins that do not correctly load.
+	 *
+	 * The result is stored in a manifest in the cache directory.
+	 * Plugins that are known from the manifest as non-persistent are
+	 * not loaded again, only the commands they emitted in their load()
+	 * function (e.g. menu entries) are repeated. Such plugins are
+	 * loaded on their first use. The same applies to codecs, their
+	 * mime types are recorded in the manifest and registered in the
+	 * CodecManager, which loads them on the first encode or decode.
+	 * A plugin is loaded again if it's shared object has changed.
+	 *
 	 * @internal used once by each toplevel window at startup
-	 * @return true if at least one plugin was loaded, false if none
+	 * @return true if at least one plugin is known, false if none
 	 */
 	bool loadAllPlugins();
 
@@ -230,6 +240,8 @@ namespace Kwave
 	 * the KDE's standard search algorithm) and creates a map of
 	 * plugin names and file names. First it collects a list of
 	 * filenames and then filters it to sort out invalid entries.
+	 * Only the meta data of the plugins is read, the shared objects
+	 * are not loaded before the plugin is used.
 	 */
 	void searchPluginModules();
 
@@ -239,7 +251,8 @@ namespace Kwave
 	    QString            m_author;      /**< name of the author   */
 	    QString            m_description; /**< short description    */
 	    QString            m_version;     /**< settings version     */
-	    KPluginFactory    *m_factory;     /**< plugin factory       */
+	    QString            m_library;     /**< path of the module   */
+	    KPluginFactory    *m_factory;     /**< plugin factory or 0  */
 	    int                m_use_count;   /**< usage counter        */
 	} PluginModule;
 
@@ -261,6 +274,16 @@ namespace Kwave
 	/** Let this instance be the active one */
 	void setActive() { m_active_instance = this; }
 
+	/**
+	 * Loads a codec module that is known from the manifest through
+	 * the active instance and lets it stay in memory, like
+	 * loadAllPlugins() does without the manifest.
+	 * @note must be called from the GUI thread
+	 * @param name the name of the plugin module
+	 * @return true if the module has been loaded
+	 */
+	static bool loadCodecModule(const QString &name);
+
     signals:
 
 	/**
@@ -339,6 +362,14 @@ namespace Kwave
 	 */
 	Kwave::Plugin *createPluginInstance(const QString &name);
 
+	/**
+	 * Loads a plugin and gives it the chance to stay in memory,
+	 * see loadCodecModule()
+	 * @param name the name of the plugin
+	 * @return true if the plugin has been loaded
+	 */
+	bool loadPersistent(const QString &name);
+
 	/**
 	 * Saves a plugin's default parameters to the user's configuration
 	 * file. The whole section in the configuration file will be deleted
@@ -356,6 +387,14 @@ namespace Kwave
 	/** connects all signals from and to a plugin */
 	void disconnectPlugin(Kwave::Plugin *plugin);
 
+	/**
+	 * Returns the factory of a plugin module, loads the shared
+	 * object on first use
+	 * @param info the plugin module
+	 * @return pointer to the factory or null if loading failed
+	 */
+	KPluginFactory *moduleFactory(PluginModule &info);
+
     private:
 
 	/** pointer to the currently active instance */
@@ -382,6 +421,15 @@ namespace Kwave
 	/** interface for registering a SignalView */
 	ViewManager *m_view_manager;
 
+	/**
+	 * if true, all commands passed to enqueueCommand() are
+	 * recorded in m_recorded_commands
+	 */
+	bool m_record_commands;
+
+	/** commands recorded while loading a plugin */
+	QStringList m_recorded_commands;
+
     };
 }
 
@@ -0,0 +1,351 @@
+/***************************************************************************
+           Profiler.cpp  -  low overhead instrumentation of hot paths
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "config.h"
+
+#include <new>
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QMutableListIterator>
+#include <QMutexLocker>
+#include <QPair>
+#include <QThread>
+#include <QVector>
+
+#include "libkwave/Profiler.h"
+#include "libkwave/String.h"
+
+/** number of events per thread, must be a power of two */
+#define PROFILER_RING_SIZE (32 * 1024)
+
+namespace Kwave
+{
+    namespace
+    {
+	/** one recorded event */
+	typedef struct {
+	    const char           *m_name;     /**< name of the stage    */
+	    Kwave::Profiler::Kind m_kind;     /**< work or wait         */
+	    qint64                m_start;    /**< start time [ns]      */
+	    qint64                m_duration; /**< duration [ns]        */
+	    quint64               m_items;    /**< processed samples    */
+	} Event;
+
+	/**
+	 * ring of events of one thread, written only by the owning
+	 * thread, can be read by any other thread
+	 */
+	class Ring
+	{
+	public:
+	    /** Constructor */
+	    Ring(int id, const QString &name)
+		:m_events(PROFILER_RING_SIZE), m_written(0),
+		 m_id(id), m_name(name), m_finished(false)
+	    {
+	    }
+
+	    /**
+	     * Takes a copy of the events that have been written after a
+	     * given time, skipping those that have been overwritten by the
+	     * owning thread during copying
+	     * @param since start time of the oldest event to take [ns]
+	     * @return list of events
+	     */
+	    QVector<Event> snapshot(qint64 since) const
+	    {
+		QVector<Event> events;
+		const quint64 end   = m_written.loadAcquire();
+		const quint64 begin = (end > PROFILER_RING_SIZE) ?
+		    (end - PROFILER_RING_SIZE) : 0;
+		events.reserve(static_cast<int>(end - begin));
+		for (quint64 i = begin; i < end; ++i)
+		    events.append(m_events[i & (PROFILER_RING_SIZE - 1)]);
+
+		// the slot of the event that is currently written and all
+		// before it might have changed in between
+		const quint64 after = m_written.loadAcquire();
+		const quint64 valid = (after >= PROFILER_RING_SIZE) ?
+		    (after - PROFILER_RING_SIZE + 1) : 0;
+		if (valid > begin)
+		    events.remove(0, qMin(events.count(),
+		                          static_cast<int>(valid - begin)));
+
+		QMutableVectorIterator<Event> it(events);
+		while (it.hasNext())
+		    if (it.next().m_start < since) it.remove();
+		return events;
+	    }
+
+	    /** the events */
+	    QVector<Event> m_events;
+
+	    /** number of events written so far */
+	    QAtomicInteger<quint64> m_written;
+
+	    /** sequential id of the thread */
+	    int m_id;
+
+	    /** name of the thread */
+	    QString m_name;
+
+	    /** true when the thread has finished */
+	    bool m_finished;
+	};
+
+	/** owner of the ring of the current thread */
+	class RingHolder
+	{
+	public:
+	    /** Constructor */
+	    RingHolder() :m_ring(Q_NULLPTR) { }
+
+	    /** Destructor, the ring is released when the thread ends */
+	    ~RingHolder();
+
+	    /** the ring, or null if the thread has no events yet */
+	    Ring *m_ring;
+	};
+
+	/** clock for all time stamps */
+	QElapsedTimer g_clock;
+
+	/** start of the current profiling session [ns] */
+	qint64 g_session_start = 0;
+
+	/** lock for the list of rings and the interned names */
+	QMutex g_lock;
+
+	/** list of all rings */
+	QList<Ring *> g_rings;
+
+	/** number of rings that have been created */
+	int g_ring_count = 0;
+
+	/** interned names */
+	QHash<QString, QByteArray> g_names;
+
+	/** the ring of the current thread */
+	thread_local RingHolder t_ring;
+
+	//*******************************************************************
+	RingHolder::~RingHolder()
+	{
+	    QMutexLocker _lock(&g_lock);
+	    if (m_ring) m_ring->m_finished = true;
+	}
+
+	//*******************************************************************
+	Ring *createRing()
+	{
+	    QMutexLocker _lock(&g_lock);
+
+	    QThread *thread = QThread::currentThread();
+	    QString name = (thread) ? thread->objectName() : QString();
+	    if (!name.length()) {
+		bool main = QCoreApplication::instance() &&
+		    (thread == QCoreApplication::instance()->thread());
+		name = (main) ? _("main") :
+		    _("thread %1").arg(g_ring_count + 1);
+	    }
+
+	    Ring *ring = new(std::nothrow) Ring(++g_ring_count, name);
+	    if (ring) g_rings.append(ring);
+	    return ring;
+	}
+
+	//*******************************************************************
+	QList< QPair<Ring *, QVector<Event> > > snapshots()
+	{
+	    QList< QPair<Ring *, QVector<Event> > > list;
+	    QMutexLocker _lock(&g_lock);
+	    foreach (Ring *ring, g_rings)
+		list.append(qMakePair(ring, ring->snapshot(g_session_start)));
+	    return list;
+	}
+    }
+}
+
+// static initializer
+QAtomicInt Kwave::Profiler::m_enabled(0);
+
+//***************************************************************************
+void Kwave::Profiler::setEnabled(bool enable)
+{
+    QMutexLocker _lock(&g_lock);
+
+    if (enable && !isEnabled()) {
+	if (!g_clock.isValid()) g_clock.start();
+	g_session_start = g_clock.nsecsElapsed();
+
+	// rings of threads that have finished are no longer needed
+	QMutableListIterator<Ring *> it(g_rings);
+	while (it.hasNext()) {
+	    Ring *ring = it.next();
+	    if (!ring->m_finished) continue;
+	    delete ring;
+	    it.remove();
+	}
+    }
+
+    m_enabled.storeRelease(enable ? 1 : 0);
+}
+
+//***************************************************************************
+qint64 Kwave::Profiler::now()
+{
+    return g_clock.nsecsElapsed();
+}
+
+//***************************************************************************
+void Kwave::Profiler::record(const char *name, Kind kind,
+                             qint64 start, qint64 duration, quint64 items)
+{
+    Ring *ring = t_ring.m_ring;
+    if (Q_UNLIKELY(!ring)) {
+	ring = createRing();
+	if (!ring) return;
+	t_ring.m_ring = ring;
+    }
+
+    const quint64 index = ring->m_written.loadRelaxed();
+    Event &event = ring->m_events[index & (PROFILER_RING_SIZE - 1)];
+    event.m_name     = name;
+    event.m_kind     = kind;
+    event.m_start    = start;
+    event.m_duration = duration;
+    event.m_items    = items;
+    ring->m_written.storeRelease(index + 1);
+}
+
+//***************************************************************************
+const char *Kwave::Profiler::intern(const QString &name)
+{
+    QMutexLocker _lock(&g_lock);
+    if (!g_names.contains(name)) g_names.insert(name, name.toUtf8());
+    return g_names[name].constData();
+}
+
+//***************************************************************************
+void Kwave::Profiler::lock(QMutex &mutex, const char *name)
+{
+    if (!isEnabled()) {
+	mutex.lock();
+	return;
+    }
+    if (mutex.tryLock()) return; // not contended
+
+    // the mutex is held by someone else -> measure the time we wait
+    const qint64 start = now();
+    mutex.lock();
+    record(name, Wait, start, now() - start, 0);
+}
+
+//***************************************************************************
+QList<Kwave::Profiler::Statistics> Kwave::Profiler::statistics()
+{
+    QMap<QString, Statistics> map;
+
+    typedef QPair<Ring *, QVector<Event> > Snapshot;
+    foreach (const Snapshot &snapshot, snapshots()) {
+	foreach (const Event &event, snapshot.second) {
+	    const QString name = _(event.m_name);
+	    const QString key  = name + QString::number(event.m_kind);
+	    if (!map.contains(key)) {
+		Statistics s;
+		s.m_name  = name;
+		s.m_kind  = event.m_kind;
+		s.m_count = 0;
+		s.m_time  = 0;
+		s.m_max   = 0;
+		s.m_items = 0;
+		map.insert(key, s);
+	    }
+	    Statistics &s = map[key];
+	    s.m_count++;
+	    s.m_time  += event.m_duration;
+	    s.m_items += event.m_items;
+	    if (event.m_duration > s.m_max) s.m_max = event.m_duration;
+	}
+    }
+
+    return map.values();
+}
+
+//***************************************************************************
+bool Kwave::Profiler::writeChromeTrace(const QString &filename)
+{
+    const qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray events;
+
+    typedef QPair<Ring *, QVector<Event> > Snapshot;
+    foreach (const Snapshot &snapshot, snapshots()) {
+	const Ring *ring = snapshot.first;
+
+	// meta data: name of the thread
+	QJsonObject thread_args;
+	thread_args[_("name")] = ring->m_name;
+	QJsonObject thread_name;
+	thread_name[_("name")] = _("thread_name");
+	thread_name[_("ph")]   = _("M");
+	thread_name[_("pid")]  = pid;
+	thread_name[_("tid")]  = ring->m_id;
+	thread_name[_("args")] = thread_args;
+	events.append(thread_name);
+
+	// complete events, time stamps in microseconds
+	foreach (const Event &event, snapshot.second) {
+	    QJsonObject e;
+	    e[_("name")] = _(event.m_name);
+	    e[_("cat")]  = (event.m_kind == Wait) ? _("wait") : _("work");
+	    e[_("ph")]   = _("X");
+	    e[_("ts")]   = static_cast<double>(event.m_start) / 1E3;
+	    e[_("dur")]  = static_cast<double>(event.m_duration) / 1E3;
+	    e[_("pid")]  = pid;
+	    e[_("tid")]  = ring->m_id;
+	    if (event.m_items) {
+		QJsonObject args;
+		args[_("items")] = static_cast<double>(event.m_items);
+		e[_("args")] = args;
+	    }
+	    events.append(e);
+	}
+    }
+
+    QJsonObject root;
+    root[_("traceEvents")]     = events;
+    root[_("displayTimeUnit")] = _("ms");
+
+    const QByteArray json =
+	QJsonDocument(root).toJson(QJsonDocument::Compact);
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    bool ok = (file.write(json) == json.size());
+    file.close();
+    return ok;
+}
+
+//***************************************************************************
+//***************************************************************************
@@ -0,0 +1,214 @@
+/***************************************************************************
+             Profiler.h  -  low overhead instrumentation of hot paths
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "config.h"
+
+#include <QtGlobal>
+#include <QAtomicInt>
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+namespace Kwave
+{
+
+    /**
+     * Collects timing events of the hot paths of Kwave, like reading and
+     * writing samples, plugins, codecs, playback and recording.
+     *
+     * Each thread writes its events into its own ring buffer, without
+     * any locking. The rings are only read when the statistics are
+     * requested or when the events are exported in the "Chrome trace"
+     * format (as understood by chrome://tracing or Perfetto). When the
+     * profiler is disabled, which is the default, each instrumented scope
+     * costs only one atomic load.
+     */
+    class Q_DECL_EXPORT Profiler
+    {
+    public:
+
+	/** kind of an event */
+	typedef enum {
+	    Work = 0, /**< time spent processing data      */
+	    Wait = 1  /**< time spent waiting for a lock   */
+	} Kind;
+
+	/** statistics of one stage, summed up over all threads */
+	typedef struct {
+	    QString m_name;  /**< name of the stage                */
+	    Kind    m_kind;  /**< kind of the events               */
+	    quint64 m_count; /**< number of events                 */
+	    qint64  m_time;  /**< sum of all durations [ns]        */
+	    qint64  m_max;   /**< longest duration [ns]            */
+	    quint64 m_items; /**< number of processed samples      */
+	} Statistics;
+
+	/** returns true if events are collected */
+	static inline bool isEnabled() {
+	    return (m_enabled.loadRelaxed() != 0);
+	}
+
+	/**
+	 * Enables or disables the collection of events. Enabling discards
+	 * all events collected before.
+	 * @param enable if true, collect events
+	 */
+	static void setEnabled(bool enable);
+
+	/** returns the current time [ns], relative to the start */
+	static qint64 now();
+
+	/**
+	 * Records an event in the ring of the current thread
+	 * @param name name of the stage, must be a static string or a
+	 *             string returned by intern()
+	 * @param kind kind of the event
+	 * @param start start time [ns], as returned by now()
+	 * @param duration duration of the event [ns]
+	 * @param items number of processed samples, or zero
+	 */
+	static void record(const char *name, Kind kind,
+	                   qint64 start, qint64 duration, quint64 items);
+
+	/**
+	 * Returns a pointer to a copy of a string, that stays valid until
+	 * the program ends. Equal strings return the same pointer.
+	 * @param name a name of a stage that is not a static string
+	 * @return a null terminated string in UTF-8
+	 */
+	static const char *intern(const QString &name);
+
+	/**
+	 * Locks a mutex and records the time spent for waiting as event
+	 * of the kind "Wait", only if the mutex was not available at once
+	 * @param mutex the mutex to lock
+	 * @param name name of the lock, must be a static string
+	 */
+	static void lock(QMutex &mutex, const char *name);
+
+	/**
+	 * Returns the statistics of all stages, calculated from the events
+	 * that are currently in the rings
+	 */
+	static QList<Kwave::Profiler::Statistics> statistics();
+
+	/**
+	 * Writes all events that are currently in the rings into a file,
+	 * in the JSON format of "Chrome trace"
+	 * @param filename name of the file
+	 * @return true if succeeded, false if the file could not be written
+	 */
+	static bool writeChromeTrace(const QString &filename);
+
+    private:
+
+	/** non-zero if enabled */
+	static QAtomicInt m_enabled;
+
+    };
+
+    /**
+     * Measures the time of a scope, from the constructor until done()
+     * or the destructor, and records it as event
+     */
+    class Q_DECL_EXPORT ProfileScope
+    {
+    public:
+
+	/**
+	 * Constructor, starts the time measurement
+	 * @param name name of the stage, must be a static string or a
+	 *             string returned by Profiler::intern()
+	 * @param kind kind of the event, work or wait
+	 */
+	explicit ProfileScope(const char *name,
+	    Kwave::Profiler::Kind kind = Kwave::Profiler::Work)
+	    :m_name(name), m_kind(kind),
+	     m_start(Kwave::Profiler::isEnabled() ?
+	             Kwave::Profiler::now() : -1),
+	     m_items(0)
+	{
+	}
+
+	/** Destructor, records the event if not already done */
+	virtual ~ProfileScope() { done(); }
+
+	/** sets the number of samples processed within the scope */
+	inline void setItems(quint64 items) { m_items = items; }
+
+	/** ends the time measurement and records the event */
+	inline void done() {
+	    if (m_start < 0) return;
+	    Kwave::Profiler::record(m_name, m_kind, m_start,
+	                            Kwave::Profiler::now() - m_start, m_items);
+	    m_start = -1;
+	}
+
+    private:
+
+	/** name of the stage */
+	const char *m_name;
+
+	/** kind of the event */
+	Kwave::Profiler::Kind m_kind;
+
+	/** start time [ns], negative if not enabled or already done */
+	qint64 m_start;
+
+	/** number of processed samples */
+	quint64 m_items;
+
+    };
+
+    /**
+     * Replacement for a QMutexLocker, that records the time spent for
+     * waiting on the mutex
+     */
+    class Q_DECL_EXPORT ProfileMutexLocker
+    {
+    public:
+
+	/**
+	 * Constructor, locks the mutex
+	 * @param mutex pointer to the mutex
+	 * @param name name of the lock, must be a static string
+	 */
+	ProfileMutexLocker(QMutex *mutex, const char *name)
+	    :m_mutex(mutex)
+	{
+	    Kwave::Profiler::lock(*m_mutex, name);
+	}
+
+	/** Destructor, unlocks the mutex */
+	virtual ~ProfileMutexLocker() { m_mutex->unlock(); }
+
+    private:
+
+	/** the locked mutex */
+	QMutex *m_mutex;
+
+    };
+
+}
+
+#endif /* PROFILER_H */
+
+//***************************************************************************
+//***************************************************************************
@@ -0,0 +1,276 @@
+/***************************************************************************
+       ReadAheadDevice.cpp  -  file access with read-ahead in a thread
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "config.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <new>
+
+#include <QMutexLocker>
+#include <QThread>
+
+#include "libkwave/ReadAheadDevice.h"
+#include "libkwave/String.h"
+#include "libkwave/memcpy.h"
+
+//***************************************************************************
+namespace Kwave
+{
+    /** thread that runs the read-ahead loop of a device */
+    class ReadAheadThread: public QThread
+    {
+    public:
+	/** Constructor */
+	explicit ReadAheadThread(Kwave::ReadAheadDevice &device)
+	    :QThread(Q_NULLPTR), m_device(device)
+	{
+	    setObjectName(_("read ahead"));
+	}
+
+	/** Destructor */
+	virtual ~ReadAheadThread() Q_DECL_OVERRIDE
+	{
+	    wait();
+	}
+
+    protected:
+	/** runs the loop of the device */
+	virtual void run() Q_DECL_OVERRIDE
+	{
+	    m_device.readAhead();
+	}
+
+    private:
+	/** the device to read for */
+	Kwave::ReadAheadDevice &m_device;
+    };
+}
+
+//***************************************************************************
+Kwave::ReadAheadDevice::ReadAheadDevice(QFileDevice &file,
+                                        unsigned int depth,
+                                        unsigned int block_size)
+    :QIODevice(Q_NULLPTR), m_file(file), m_depth(qMax(2U, depth)),
+     m_block_size(qMax(4096U, block_size)), m_thread(Q_NULLPTR),
+     m_lock(), m_block_read(), m_block_free(), m_queue(),
+     m_next_offset(0), m_generation(0), m_eof(false), m_error(false),
+     m_stop(false)
+{
+}
+
+//***************************************************************************
+Kwave::ReadAheadDevice::~ReadAheadDevice()
+{
+    close();
+}
+
+//***************************************************************************
+bool Kwave::ReadAheadDevice::open(QIODevice::OpenMode mode)
+{
+    if (mode & QIODevice::WriteOnly) {
+	qWarning("ReadAheadDevice: writing is not supported");
+	return false;
+    }
+    if (isOpen()) return false;
+
+    if (!m_file.isOpen() &&
+        !m_file.open(QIODevice::ReadOnly | QIODevice::Unbuffered))
+	return false;
+    if (m_file.handle() < 0) {
+	m_file.close();
+	return false;
+    }
+
+    {
+	QMutexLocker lock(&m_lock);
+	m_queue.clear();
+	m_next_offset = 0;
+	m_eof         = false;
+	m_error       = false;
+	m_stop        = false;
+    }
+
+    // we have our own buffers, no need for more buffering in QIODevice
+    if (!QIODevice::open(mode | QIODevice::Unbuffered)) {
+	m_file.close();
+	return false;
+    }
+
+    m_thread = new(std::nothrow) Kwave::ReadAheadThread(*this);
+    if (!m_thread) {
+	close();
+	return false;
+    }
+    m_thread->start();
+    return true;
+}
+
+//***************************************************************************
+void Kwave::ReadAheadDevice::close()
+{
+    if (m_thread) {
+	{
+	    QMutexLocker lock(&m_lock);
+	    m_stop = true;
+	    m_block_free.wakeAll();
+	}
+	delete m_thread; // waits until the thread has finished
+	m_thread = Q_NULLPTR;
+    }
+
+    {
+	QMutexLocker lock(&m_lock);
+	m_queue.clear();
+    }
+
+    if (isOpen()) {
+	QIODevice::close();
+	m_file.close();
+    }
+}
+
+//***************************************************************************
+qint64 Kwave::ReadAheadDevice::size() const
+{
+    return m_file.size();
+}
+
+//***************************************************************************
+QFileDevice *Kwave::ReadAheadDevice::fileOf(QIODevice *device)
+{
+    Kwave::ReadAheadDevice *read_ahead =
+	qobject_cast<Kwave::ReadAheadDevice *>(device);
+    if (read_ahead) return &(read_ahead->file());
+    return qobject_cast<QFileDevice *>(device);
+}
+
+//***************************************************************************
+qint64 Kwave::ReadAheadDevice::readData(char *data, qint64 maxlen)
+{
+    QMutexLocker lock(&m_lock);
+    qint64 pos  = this->pos();
+    qint64 done = 0;
+
+    while (done < maxlen) {
+	// give back all blocks before the current position
+	while (!m_queue.isEmpty() &&
+	       (m_queue.first().m_offset + m_queue.first().m_data.size() <=
+	        pos))
+	{
+	    m_queue.removeFirst();
+	    m_block_free.wakeAll();
+	}
+
+	if (!m_queue.isEmpty() && (m_queue.first().m_offset <= pos)) {
+	    // take the data from the first block
+	    const Block &block = m_queue.first();
+	    const qint64 offset = pos - block.m_offset;
+	    const qint64 len = qMin(maxlen - done,
+	        static_cast<qint64>(block.m_data.size()) - offset);
+	    MEMCPY(data + done, block.m_data.constData() + offset,
+	           static_cast<size_t>(len));
+	    done += len;
+	    pos  += len;
+	    continue;
+	}
+
+	if (m_queue.isEmpty() && (pos == m_next_offset)) {
+	    // the block we need is just being read
+	    if (m_error) return (done) ? done : -1;
+	    if (m_eof) break;
+	    m_block_read.wait(&m_lock);
+	    continue;
+	}
+
+	// we have been moved somewhere else
+	restart(pos);
+    }
+
+    return done;
+}
+
+//***************************************************************************
+qint64 Kwave::ReadAheadDevice::writeData(const char *data, qint64 len)
+{
+    Q_UNUSED(data)
+    Q_UNUSED(len)
+    return -1;
+}
+
+//***************************************************************************
+void Kwave::ReadAheadDevice::restart(qint64 pos)
+{
+    m_queue.clear();
+    m_generation++;
+    m_next_offset = pos;
+    m_eof         = false;
+    m_error       = false;
+    m_block_free.wakeAll();
+}
+
+//***************************************************************************
+void Kwave::ReadAheadDevice::readAhead()
+{
+    const int fd = m_file.handle();
+
+    QMutexLocker lock(&m_lock);
+    while (!m_stop) {
+	if (m_eof || m_error ||
+	    (m_queue.count() >= static_cast<int>(m_depth)))
+	{
+	    m_block_free.wait(&m_lock);
+	    continue;
+	}
+
+	// read the next block, without holding the lock
+	const qint64  offset     = m_next_offset;
+	const quint64 generation = m_generation;
+	lock.unlock();
+
+	QByteArray data;
+	data.resize(static_cast<int>(m_block_size));
+	ssize_t len;
+	do {
+	    len = ::pread(fd, data.data(), m_block_size,
+	                  static_cast<off_t>(offset));
+	} while ((len < 0) && (errno == EINTR));
+
+	lock.relock();
+	if (generation != m_generation) continue; // outdated
+
+	if (len < 0) {
+	    qWarning("ReadAheadDevice: read failed: %s", strerror(errno));
+	    m_error = true;
+	} else if (!len) {
+	    m_eof = true;
+	} else {
+	    data.resize(static_cast<int>(len));
+	    Block block;
+	    block.m_offset = offset;
+	    block.m_data   = data;
+	    m_queue.append(block);
+	    m_next_offset = offset + len;
+	}
+	m_block_read.wakeAll();
+    }
+}
+
+//***************************************************************************
+//***************************************************************************
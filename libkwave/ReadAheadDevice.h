@@ -0,0 +1,175 @@
+/***************************************************************************
+         ReadAheadDevice.h  -  file access with read-ahead in a thread
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef READ_AHEAD_DEVICE_H
+#define READ_AHEAD_DEVICE_H
+
+#include "config.h"
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QFileDevice>
+#include <QIODevice>
+#include <QList>
+#include <QMutex>
+#include <QWaitCondition>
+
+/** default number of blocks that are read in advance */
+#define READ_AHEAD_DEPTH 4
+
+/** default size of the blocks that are read in advance [bytes] */
+#define READ_AHEAD_BLOCK_SIZE (1024 * 1024)
+
+class QThread;
+
+namespace Kwave
+{
+
+    /**
+     * Read only access to a file, for the decoders. A thread reads the
+     * blocks that follow the current position in advance, with pread()
+     * in big blocks, so that the decoder works on one block while the
+     * next ones are coming from the disk. This hides the latency of slow
+     * disks and network file systems behind the decoding.
+     *
+     * Seeking is possible at any time, a position outside of the blocks
+     * that have been read in advance restarts the read-ahead from there.
+     */
+    class Q_DECL_EXPORT ReadAheadDevice: public QIODevice
+    {
+	Q_OBJECT
+    public:
+
+	/**
+	 * Constructor
+	 * @param file the file to read from, must not be opened
+	 * @param depth number of blocks to read in advance, at least two
+	 * @param block_size size of the blocks [bytes]
+	 */
+	explicit ReadAheadDevice(QFileDevice &file,
+	                         unsigned int depth = READ_AHEAD_DEPTH,
+	                         unsigned int block_size =
+	                             READ_AHEAD_BLOCK_SIZE);
+
+	/** Destructor, closes the device */
+        virtual ~ReadAheadDevice() Q_DECL_OVERRIDE;
+
+	/**
+	 * Opens the file and starts reading in advance
+	 * @param mode open mode, only QIODevice::ReadOnly is supported
+	 * @return true if succeeded, false if failed
+	 */
+        virtual bool open(QIODevice::OpenMode mode) Q_DECL_OVERRIDE;
+
+	/** Stops reading in advance and closes the file */
+        virtual void close() Q_DECL_OVERRIDE;
+
+	/** the device supports random access */
+        virtual bool isSequential() const Q_DECL_OVERRIDE { return false; }
+
+	/** returns the size of the file [bytes] */
+        virtual qint64 size() const Q_DECL_OVERRIDE;
+
+	/** returns the file that is read */
+	inline QFileDevice &file() const { return m_file; }
+
+	/**
+	 * Returns the file behind a device, which is either the device
+	 * itself or the file of a Kwave::ReadAheadDevice, for code that
+	 * needs to access the file directly, e.g. for mapping it.
+	 * @param device any I/O device
+	 * @return pointer to the file or null if it is no file
+	 */
+	static QFileDevice *fileOf(QIODevice *device);
+
+    protected:
+
+	/** @see QIODevice::readData() */
+        virtual qint64 readData(char *data, qint64 maxlen) Q_DECL_OVERRIDE;
+
+	/** writing is not supported, always fails */
+        virtual qint64 writeData(const char *data, qint64 len)
+	    Q_DECL_OVERRIDE;
+
+    private:
+
+	friend class ReadAheadThread;
+
+	/** main loop of the read-ahead thread */
+	void readAhead();
+
+	/**
+	 * Discards all blocks and restarts reading in advance at a new
+	 * position. m_lock must be held.
+	 * @param pos the new position in the file [bytes]
+	 */
+	void restart(qint64 pos);
+
+	/** a block that has been read in advance */
+	typedef struct {
+	    qint64     m_offset; /**< position in the file */
+	    QByteArray m_data;   /**< content of the block */
+	} Block;
+
+    private:
+
+	/** the file to read from */
+	QFileDevice &m_file;
+
+	/** number of blocks to read in advance */
+	unsigned int m_depth;
+
+	/** size of a block [bytes] */
+	unsigned int m_block_size;
+
+	/** the thread that reads in advance */
+	QThread *m_thread;
+
+	/** lock for all members below */
+	QMutex m_lock;
+
+	/** signaled when a block has been read */
+	QWaitCondition m_block_read;
+
+	/** signaled when a block is free or the thread should stop */
+	QWaitCondition m_block_free;
+
+	/** blocks that have been read in advance, in ascending order */
+	QList<Kwave::ReadAheadDevice::Block> m_queue;
+
+	/** position of the next block to read [bytes] */
+	qint64 m_next_offset;
+
+	/** incremented on each restart, outdates blocks in transit */
+	quint64 m_generation;
+
+	/** true if the end of the file has been reached */
+	bool m_eof;
+
+	/** true if reading failed */
+	bool m_error;
+
+	/** true if the read-ahead thread should stop */
+	bool m_stop;
+
+    };
+}
+
+#endif /* READ_AHEAD_DEVICE_H */
+
+//***************************************************************************
+//***************************************************************************
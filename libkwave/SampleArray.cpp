@@ -21,6 +21,7 @@
 #include <stdlib.h>
 
 #include "libkwave/SampleArray.h"
+#include "libkwave/SamplePool.h"
 #include "libkwave/memcpy.h"
 
 //***************************************************************************
@@ -81,12 +82,13 @@ const sample_t & Kwave::SampleArray::operator [] (unsigned int index) const
 }
 
 //***************************************************************************
-bool Kwave::SampleArray::resize(unsigned int size)
+bool Kwave::SampleArray::resize(unsigned int size, bool exact)
 {
     if (!m_storage) return false;
-    if (size == m_storage->m_size) return true;
+    if ((size == m_storage->m_size) && (!size || (exact == m_storage->m_exact)))
+	return true;
 
-    m_storage->resize(size);
+    m_storage->resize(size, exact);
     if (size && (m_storage->m_size > size)) {
 	qWarning("Kwave::SampleArray::resize(): shrinking from %u to %u "
 	         "failed, keeping old memory", m_storage->m_size, size);
@@ -106,6 +108,8 @@ Kwave::SampleArray::SampleStorage::SampleStorage()
     :QSharedData()
 {
     m_size     = 0;
+    m_capacity = 0;
+    m_exact    = false;
     m_data     = Q_NULLPTR;
 }
 
@@ -114,12 +118,13 @@ Kwave::SampleArray::SampleStorage::SampleStorage(const SampleStorage &other)
     :QSharedData(other)
 {
     m_size     = 0;
+    m_capacity = 0;
+    m_exact    = other.m_exact;
     m_data     = Q_NULLPTR;
 
     if (other.m_size) {
-	m_data = static_cast<sample_t *>(
-	    ::malloc(other.m_size * sizeof(sample_t))
-	);
+	m_data = Kwave::SamplePool::allocate(other.m_size, m_capacity,
+	                                     m_exact);
 	if (m_data) {
 	    m_size = other.m_size;
 	    MEMCPY(m_data, other.m_data, m_size * sizeof(sample_t));
@@ -130,38 +135,68 @@ Kwave::SampleArray::SampleStorage::SampleStorage(const SampleStorage &other)
 //***************************************************************************
 Kwave::SampleArray::SampleStorage::~SampleStorage()
 {
-    if (m_data) ::free(m_data);
+    Kwave::SamplePool::release(m_data, m_capacity, m_exact);
 }
 
 //***************************************************************************
-void Kwave::SampleArray::SampleStorage::resize(unsigned int size)
+void Kwave::SampleArray::SampleStorage::resize(unsigned int size,
+                                               bool exact)
 {
-    if (size) {
-	// resize using realloc, keep existing data
+    if (!size) {
+	// resize to zero == give the memory back
+	Kwave::SamplePool::release(m_data, m_capacity, m_exact);
+	m_data     = Q_NULLPTR;
+	m_size     = 0;
+	m_capacity = 0;
+	m_exact    = false;
+	return;
+    }
+
+    const bool pooled = !m_exact && Kwave::SamplePool::isPooled(m_capacity);
+    if (m_data && (exact == m_exact) && (size <= m_capacity) &&
+        (pooled || (size == m_capacity)))
+    {
+	// fits into the current block
+    } else if (m_data && !pooled &&
+               (exact || !Kwave::SamplePool::isPooled(size)))
+    {
+	// block from the heap, resize using realloc, keep existing data
 	sample_t *new_data = static_cast<sample_t *>(
 	    ::realloc(m_data, size * sizeof(sample_t)));
-	if (new_data) {
-	    // successful
-	    m_data = new_data;
-	    if (size > m_size) {
-		// initialize the new data
-		unsigned int count = size - m_size;
-		sample_t *p = m_data + m_size;
-		while (count--)
-		    *(p++) = 0;
-	    }
-	    m_size = size;
-	} else {
+	if (!new_data) {
 	    qWarning("Kwave::SampleArray::SampleStorage::resize(%u): OOM! "
 	             "- keeping old size %u", size, m_size);
+	    return;
 	}
+	m_data     = new_data;
+	m_capacity = size;
     } else {
-	// resize to zero == delete/free memory
-	Q_ASSERT(m_data);
-	::free(m_data);
-        m_data = Q_NULLPTR;
-	m_size = 0;
+	// take a new block and copy the existing data
+	unsigned int capacity = 0;
+	sample_t *new_data =
+	    Kwave::SamplePool::allocate(size, capacity, exact);
+	if (!new_data) {
+	    qWarning("Kwave::SampleArray::SampleStorage::resize(%u): OOM! "
+	             "- keeping old size %u", size, m_size);
+	    return;
+	}
+	if (m_data) {
+	    MEMCPY(new_data, m_data, qMin(m_size, size) * sizeof(sample_t));
+	    Kwave::SamplePool::release(m_data, m_capacity, m_exact);
+	}
+	m_data     = new_data;
+	m_capacity = capacity;
+    }
+    m_exact = exact;
+
+    if (size > m_size) {
+	// initialize the new data
+	unsigned int count = size - m_size;
+	sample_t *p = m_data + m_size;
+	while (count--)
+	    *(p++) = 0;
     }
+    m_size = size;
 }
 
 //***************************************************************************
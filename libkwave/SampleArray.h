@@ -84,9 +84,13 @@ namespace Kwave
 	/**
 	 * Resizes the array
 	 * @param size new number of samples
+	 * @param exact if true, the memory is allocated with exactly the
+	 *              given size from the heap instead of the sample pool
+	 *              and shrinking gives memory back, for long living
+	 *              arrays like the storage of stripes
 	 * @return true if succeeded, false if failed
 	 */
-	bool resize(unsigned int size);
+	bool resize(unsigned int size, bool exact = false);
 
 	/**
 	 * Returns the number of samples.
@@ -118,13 +122,21 @@ namespace Kwave
 	    /**
 	     * Resizes the array
 	     * @param size new number of samples
+	     * @param exact allocate exactly the given size, bypassing the
+	     *              sample pool
 	     */
-	    void resize(unsigned int size);
+	    void resize(unsigned int size, bool exact);
 
 	public:
 	    /** size in samples */
 	    unsigned int m_size;
 
+	    /** number of samples that fit into the allocated memory */
+	    unsigned int m_capacity;
+
+	    /** true if the memory has exactly the size, not from the pool */
+	    bool m_exact;
+
 	    /** pointer to the area with the samples (allocated) */
 	    sample_t *m_data;
 	};
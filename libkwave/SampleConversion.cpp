@@ -0,0 +1,413 @@
+/***************************************************************************
+   SampleConversion.cpp  -  block conversion between sample_t and float
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "config.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "libkwave/SampleConversion.h"
+
+//***************************************************************************
+void Kwave::samples2floats(const sample_t *in, float *out,
+                           unsigned int count)
+{
+    Q_ASSERT(in);
+    Q_ASSERT(out);
+    if (!in || !out) return;
+
+#ifdef __SSE2__
+    // 2^-23 is exact, so multiplication gives the same result as the
+    // division in sample2float()
+    const __m128 scale = _mm_set1_ps(
+	1.0f / static_cast<float>(1 << (SAMPLE_BITS - 1)));
+    while (count >= 8) {
+	__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+	__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 4));
+	_mm_storeu_ps(out,     _mm_mul_ps(_mm_cvtepi32_ps(a), scale));
+	_mm_storeu_ps(out + 4, _mm_mul_ps(_mm_cvtepi32_ps(b), scale));
+	in    += 8;
+	out   += 8;
+	count -= 8;
+    }
+#else
+    // work blockwise to allow loop unrolling
+    const unsigned int block_size = 16;
+    while (count >= block_size) {
+	for (unsigned int i = 0; i < block_size; i++)
+	    out[i] = sample2float(in[i]);
+	in    += block_size;
+	out   += block_size;
+	count -= block_size;
+    }
+#endif
+
+    for (; count; count--)
+	(*out++) = sample2float(*(in++));
+}
+
+//***************************************************************************
+void Kwave::floats2samples(const float *in, sample_t *out,
+                           unsigned int count)
+{
+    Q_ASSERT(in);
+    Q_ASSERT(out);
+    if (!in || !out) return;
+
+#ifdef __SSE2__
+    const __m128 scale = _mm_set1_ps(
+	static_cast<float>(1 << (SAMPLE_BITS - 1)));
+    while (count >= 8) {
+	__m128 a = _mm_mul_ps(_mm_loadu_ps(in),     scale);
+	__m128 b = _mm_mul_ps(_mm_loadu_ps(in + 4), scale);
+	// cvttps truncates towards zero, like the static_cast
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(out),
+	                 _mm_cvttps_epi32(a));
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(out + 4),
+	                 _mm_cvttps_epi32(b));
+	in    += 8;
+	out   += 8;
+	count -= 8;
+    }
+#else
+    // work blockwise to allow loop unrolling
+    const unsigned int block_size = 16;
+    while (count >= block_size) {
+	for (unsigned int i = 0; i < block_size; i++)
+	    out[i] = float2sample(in[i]);
+	in    += block_size;
+	out   += block_size;
+	count -= block_size;
+    }
+#endif
+
+    for (; count; count--)
+	(*out++) = float2sample(*(in++));
+}
+
+//***************************************************************************
+/** converts one little-endian PCM sample with BITS bits */
+template <unsigned int BITS>
+static inline sample_t pcmSample(const quint8 *p)
+{
+    switch (BITS) {
+	case 8:
+	    return (static_cast<sample_t>(p[0]) - 128) * (1 << 16);
+	case 16:
+	    return static_cast<sample_t>(static_cast<qint16>(
+		static_cast<quint16>(p[0] | (p[1] << 8)))) * (1 << 8);
+	case 24: {
+	    const sample_t v = static_cast<sample_t>(
+		p[0] | (p[1] << 8) | (p[2] << 16));
+	    return (v ^ 0x800000) - 0x800000;
+	}
+	default: {
+	    const qint32 v = static_cast<qint32>(
+		static_cast<quint32>(p[0])         |
+		(static_cast<quint32>(p[1]) <<  8) |
+		(static_cast<quint32>(p[2]) << 16) |
+		(static_cast<quint32>(p[3]) << 24));
+	    return static_cast<sample_t>(v / (1 << 8));
+	}
+    }
+}
+
+//***************************************************************************
+/** de-interleaves and converts PCM data with BITS bits per sample */
+template <unsigned int BITS>
+static void deinterleave(const quint8 *in, unsigned int tracks,
+                         sample_t * const *out, unsigned int frames)
+{
+    const unsigned int bytes = BITS / 8;
+    unsigned int first = 0;
+
+#ifdef __SSE2__
+    if ((BITS == 16) && (tracks <= 2)) {
+	// the 16 bit value goes into the upper half of a 32 bit lane,
+	// an arithmetic shift by 8 gives the sign extended sample
+	const __m128i zero = _mm_setzero_si128();
+	if (tracks == 1) {
+	    sample_t *o = out[0];
+	    for (; first + 8 <= frames; first += 8) {
+		const __m128i x = _mm_loadu_si128(
+		    reinterpret_cast<const __m128i *>(in + (2 * first)));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(o + first),
+		    _mm_srai_epi32(_mm_unpacklo_epi16(zero, x), 8));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(o + first + 4),
+		    _mm_srai_epi32(_mm_unpackhi_epi16(zero, x), 8));
+	    }
+	} else {
+	    sample_t *l = out[0];
+	    sample_t *r = out[1];
+	    for (; first + 4 <= frames; first += 4) {
+		const __m128i x = _mm_loadu_si128(
+		    reinterpret_cast<const __m128i *>(in + (4 * first)));
+		// L0 R0 L1 R1 and L2 R2 L3 R3
+		const __m128i a = _mm_srai_epi32(_mm_unpacklo_epi16(zero, x), 8);
+		const __m128i b = _mm_srai_epi32(_mm_unpackhi_epi16(zero, x), 8);
+		// L0 L1 R0 R1 and L2 L3 R2 R3
+		const __m128i c = _mm_shuffle_epi32(a, _MM_SHUFFLE(3, 1, 2, 0));
+		const __m128i d = _mm_shuffle_epi32(b, _MM_SHUFFLE(3, 1, 2, 0));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(l + first),
+		    _mm_unpacklo_epi64(c, d));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(r + first),
+		    _mm_unpackhi_epi64(c, d));
+	    }
+	}
+    }
+#endif
+
+    // generic version, one track after the other
+    const unsigned int stride = tracks * bytes;
+    for (unsigned int t = 0; t < tracks; t++) {
+	const quint8 *p = in + (first * stride) + (t * bytes);
+	sample_t     *o = out[t];
+	for (unsigned int i = first; i < frames; i++, p += stride)
+	    o[i] = pcmSample<BITS>(p);
+    }
+}
+
+//***************************************************************************
+bool Kwave::pcm2samples(const quint8 *in, unsigned int bits,
+                        unsigned int tracks, sample_t * const *out,
+                        unsigned int frames)
+{
+    Q_ASSERT(in);
+    Q_ASSERT(out);
+    if (!in || !out || !tracks) return false;
+
+    switch (bits) {
+	case 8:  deinterleave<8>(in,  tracks, out, frames); return true;
+	case 16: deinterleave<16>(in, tracks, out, frames); return true;
+	case 24: deinterleave<24>(in, tracks, out, frames); return true;
+	case 32: deinterleave<32>(in, tracks, out, frames); return true;
+	default: return false;
+    }
+}
+
+//***************************************************************************
+/** converts one sample into little-endian PCM with BITS bits */
+template <unsigned int BITS>
+static inline void pcmStore(sample_t s, quint8 *p)
+{
+    switch (BITS) {
+	case 8:
+	    p[0] = static_cast<quint8>((s >> 16) + 128);
+	    break;
+	case 16:
+	    p[0] = static_cast<quint8>(s >>  8);
+	    p[1] = static_cast<quint8>(s >> 16);
+	    break;
+	case 24:
+	    p[0] = static_cast<quint8>(s);
+	    p[1] = static_cast<quint8>(s >>  8);
+	    p[2] = static_cast<quint8>(s >> 16);
+	    break;
+	default:
+	    p[0] = 0;
+	    p[1] = static_cast<quint8>(s);
+	    p[2] = static_cast<quint8>(s >>  8);
+	    p[3] = static_cast<quint8>(s >> 16);
+	    break;
+    }
+}
+
+//***************************************************************************
+/** converts and interleaves samples into PCM data with BITS bits */
+template <unsigned int BITS>
+static void interleave(const sample_t * const *in, unsigned int tracks,
+                       quint8 *out, unsigned int frames)
+{
+    const unsigned int bytes = BITS / 8;
+    unsigned int first = 0;
+
+#ifdef __SSE2__
+    if ((BITS == 16) && (tracks <= 2)) {
+	// drop the lowest 8 bits, then pack into 16 bit lanes
+	if (tracks == 1) {
+	    const sample_t *i0 = in[0];
+	    for (; first + 8 <= frames; first += 8) {
+		const __m128i a = _mm_srai_epi32(_mm_loadu_si128(
+		    reinterpret_cast<const __m128i *>(i0 + first)), 8);
+		const __m128i b = _mm_srai_epi32(_mm_loadu_si128(
+		    reinterpret_cast<const __m128i *>(i0 + first + 4)), 8);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out + (2 * first)),
+		    _mm_packs_epi32(a, b));
+	    }
+	} else {
+	    const sample_t *l = in[0];
+	    const sample_t *r = in[1];
+	    for (; first + 8 <= frames; first += 8) {
+		const __m128i l16 = _mm_packs_epi32(
+		    _mm_srai_epi32(_mm_loadu_si128(
+			reinterpret_cast<const __m128i *>(l + first)), 8),
+		    _mm_srai_epi32(_mm_loadu_si128(
+			reinterpret_cast<const __m128i *>(l + first + 4)), 8));
+		const __m128i r16 = _mm_packs_epi32(
+		    _mm_srai_epi32(_mm_loadu_si128(
+			reinterpret_cast<const __m128i *>(r + first)), 8),
+		    _mm_srai_epi32(_mm_loadu_si128(
+			reinterpret_cast<const __m128i *>(r + first + 4)), 8));
+		__m128i *o = reinterpret_cast<__m128i *>(out + (4 * first));
+		_mm_storeu_si128(o,     _mm_unpacklo_epi16(l16, r16));
+		_mm_storeu_si128(o + 1, _mm_unpackhi_epi16(l16, r16));
+	    }
+	}
+    }
+#endif
+
+    // generic version, one track after the other
+    const unsigned int stride = tracks * bytes;
+    for (unsigned int t = 0; t < tracks; t++) {
+	const sample_t *i = in[t];
+	quint8         *p = out + (first * stride) + (t * bytes);
+	for (unsigned int n = first; n < frames; n++, p += stride)
+	    pcmStore<BITS>(i[n], p);
+    }
+}
+
+//***************************************************************************
+bool Kwave::samples2pcm(const sample_t * const *in, unsigned int bits,
+                        unsigned int tracks, quint8 *out,
+                        unsigned int frames)
+{
+    Q_ASSERT(in);
+    Q_ASSERT(out);
+    if (!in || !out || !tracks) return false;
+
+    switch (bits) {
+	case 8:  interleave<8>(in,  tracks, out, frames); return true;
+	case 16: interleave<16>(in, tracks, out, frames); return true;
+	case 24: interleave<24>(in, tracks, out, frames); return true;
+	case 32: interleave<32>(in, tracks, out, frames); return true;
+	default: return false;
+    }
+}
+
+//***************************************************************************
+/** one step of a xorshift random generator */
+static inline quint32 xorshift(quint32 x)
+{
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+//***************************************************************************
+/** converts one fixed point value, see fixed2samples() */
+static inline sample_t fixed2sample(qint32 value, unsigned int shift,
+                                    qint32 min, qint32 max, quint32 *dither)
+{
+    const qint32 mask = (1 << shift) - 1;
+
+    // bias for rounding to the nearest value
+    qint32 offset = (shift) ? (1 << (shift - 1)) : 0;
+    if (dither) {
+	// triangular distribution: difference of two uniform values
+	const quint32 r = xorshift(*dither);
+	*dither = r;
+	offset += static_cast<qint32>(r & mask) -
+	          static_cast<qint32>((r >> 16) & mask);
+    }
+
+    value = qBound(min, value, max);
+    value = (value + offset) >> shift;
+    return qBound<qint32>(SAMPLE_MIN, value, SAMPLE_MAX);
+}
+
+#ifdef __SSE2__
+//***************************************************************************
+/** clips four values to [lo ... hi] (there is no pminsd in SSE2) */
+static inline __m128i clip4(__m128i v, __m128i lo, __m128i hi)
+{
+    const __m128i above = _mm_cmpgt_epi32(v, hi);
+    v = _mm_or_si128(_mm_and_si128(above, hi), _mm_andnot_si128(above, v));
+    const __m128i below = _mm_cmplt_epi32(v, lo);
+    v = _mm_or_si128(_mm_and_si128(below, lo), _mm_andnot_si128(below, v));
+    return v;
+}
+#endif
+
+//***************************************************************************
+void Kwave::fixed2samples(const qint32 *in, unsigned int frac_bits,
+                          sample_t *out, unsigned int count,
+                          quint32 *dither)
+{
+    Q_ASSERT(in);
+    Q_ASSERT(out);
+    Q_ASSERT(frac_bits + 1 >= SAMPLE_BITS);
+    Q_ASSERT(frac_bits <= 30);
+    if (!in || !out) return;
+    if ((frac_bits + 1 < SAMPLE_BITS) || (frac_bits > 30)) return;
+
+    const unsigned int shift = frac_bits + 1 - SAMPLE_BITS;
+    const qint32       min   = -(1 << frac_bits);
+    const qint32       max   =  (1 << frac_bits) - 1;
+    if (!shift) dither = Q_NULLPTR; // nothing to quantize
+
+#ifdef __SSE2__
+    // the four lanes correspond to the four dither generators
+    const __m128i v_min   = _mm_set1_epi32(min);
+    const __m128i v_max   = _mm_set1_epi32(max);
+    const __m128i s_min   = _mm_set1_epi32(SAMPLE_MIN);
+    const __m128i s_max   = _mm_set1_epi32(SAMPLE_MAX);
+    const __m128i v_mask  = _mm_set1_epi32((1 << shift) - 1);
+    const __m128i v_bias  = _mm_set1_epi32((shift) ? (1 << (shift - 1)) : 0);
+    const __m128i v_shift = _mm_cvtsi32_si128(static_cast<int>(shift));
+    __m128i state = (dither) ? _mm_loadu_si128(
+	reinterpret_cast<const __m128i *>(dither)) : _mm_setzero_si128();
+    while (count >= 4) {
+	__m128i offset = v_bias;
+	if (dither) {
+	    state = _mm_xor_si128(state, _mm_slli_epi32(state, 13));
+	    state = _mm_xor_si128(state, _mm_srli_epi32(state, 17));
+	    state = _mm_xor_si128(state, _mm_slli_epi32(state, 5));
+	    offset = _mm_add_epi32(offset, _mm_sub_epi32(
+		_mm_and_si128(state, v_mask),
+		_mm_and_si128(_mm_srli_epi32(state, 16), v_mask)));
+	}
+	__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+	v = clip4(v, v_min, v_max);
+	v = _mm_sra_epi32(_mm_add_epi32(v, offset), v_shift);
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(out),
+	                 clip4(v, s_min, s_max));
+	in    += 4;
+	out   += 4;
+	count -= 4;
+    }
+    if (dither)
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(dither), state);
+#else
+    while (count >= 4) {
+	for (unsigned int lane = 0; lane < 4; lane++)
+	    out[lane] = fixed2sample(in[lane], shift, min, max,
+	                             (dither) ? &(dither[lane]) : Q_NULLPTR);
+	in    += 4;
+	out   += 4;
+	count -= 4;
+    }
+#endif
+
+    for (unsigned int lane = 0; lane < count; lane++)
+	out[lane] = fixed2sample(in[lane], shift, min, max,
+	                         (dither) ? &(dither[lane]) : Q_NULLPTR);
+}
+
+//***************************************************************************
+//***************************************************************************
@@ -0,0 +1,115 @@
+/***************************************************************************
+     SampleConversion.h  -  block conversion between sample_t and float
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef SAMPLE_CONVERSION_H
+#define SAMPLE_CONVERSION_H
+
+#include "config.h"
+
+#include <QtGlobal>
+
+#include "libkwave/Sample.h"
+
+namespace Kwave
+{
+
+    /**
+     * Converts a block of samples into floats, with the same scaling
+     * as sample2float(). Uses SIMD instructions if available.
+     *
+     * @param in pointer to the input samples
+     * @param out pointer to the output floats
+     * @param count number of samples to convert
+     */
+    void Q_DECL_EXPORT samples2floats(const sample_t *in, float *out,
+                                      unsigned int count);
+
+    /**
+     * Converts a block of floats back into samples, with the same scaling
+     * and rounding (truncation) as float2sample(). Uses SIMD instructions
+     * if available.
+     *
+     * @param in pointer to the input floats
+     * @param out pointer to the output samples
+     * @param count number of samples to convert
+     */
+    void Q_DECL_EXPORT floats2samples(const float *in, sample_t *out,
+                                      unsigned int count);
+
+    /**
+     * Converts interleaved little-endian integer PCM data, as found in
+     * WAV files, into one block of samples per track. The scaling is
+     * the same as through libaudiofile: 8 bit data is unsigned, 16, 24
+     * and 32 bit data is signed, 32 bit data is truncated towards zero.
+     * Uses SIMD instructions for the common case of 16 bit mono/stereo.
+     *
+     * @param in pointer to the raw PCM data
+     * @param bits number of bits per sample: 8, 16, 24 or 32
+     * @param tracks number of interleaved tracks
+     * @param out array with one output pointer per track
+     * @param frames number of sample frames to convert
+     * @return true if succeeded, false if the format is not supported
+     */
+    bool Q_DECL_EXPORT pcm2samples(const quint8 *in, unsigned int bits,
+                                   unsigned int tracks,
+                                   sample_t * const *out,
+                                   unsigned int frames);
+
+    /**
+     * Converts one block of samples per track into interleaved
+     * little-endian integer PCM data, the counterpart of pcm2samples().
+     * Surplus bits are truncated, 8 bit data is unsigned.
+     *
+     * @param in array with one input pointer per track
+     * @param bits number of bits per sample: 8, 16, 24 or 32
+     * @param tracks number of tracks
+     * @param out receives the raw PCM data
+     * @param frames number of sample frames to convert
+     * @return true if succeeded, false if the format is not supported
+     */
+    bool Q_DECL_EXPORT samples2pcm(const sample_t * const *in,
+                                   unsigned int bits, unsigned int tracks,
+                                   quint8 *out, unsigned int frames);
+
+    /**
+     * Converts fixed point values with a given number of fraction bits,
+     * as produced by fixed point decoders like libmad, into samples.
+     * The input is clipped to [-1.0 ... +1.0[ and rounded to the nearest
+     * sample value, optionally with triangular (TPDF) dither of +/- one
+     * least significant bit of the output. The dither comes from four
+     * interleaved xorshift generators, so that the SIMD version (if
+     * available) produces exactly the same result as the plain version.
+     *
+     * @param in pointer to the fixed point values
+     * @param frac_bits number of fraction bits of the input,
+     *        [SAMPLE_BITS - 1 ... 30]
+     * @param out pointer to the output samples
+     * @param count number of samples to convert
+     * @param dither state of the dither generators, an array of four
+     *        non-zero values that is updated, or null for no dither
+     */
+    void Q_DECL_EXPORT fixed2samples(const qint32 *in,
+                                     unsigned int frac_bits,
+                                     sample_t *out, unsigned int count,
+                                     quint32 *dither);
+
+}
+
+#endif /* SAMPLE_CONVERSION_H */
+
+//***************************************************************************
+//***************************************************************************
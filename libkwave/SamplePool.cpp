@@ -0,0 +1,188 @@
+/***************************************************************************
+          SamplePool.cpp  -  recycling of memory for arrays of samples
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "config.h"
+
+#include <stdlib.h>
+
+#include "libkwave/SamplePool.h"
+
+/** size of the smallest size class [samples] */
+#define SAMPLE_POOL_MIN_SIZE 1024
+
+/** number of size classes, from SAMPLE_POOL_MIN_SIZE to the maximum */
+#define SAMPLE_POOL_CLASSES 11
+
+/** maximum number of cached blocks per size class and thread */
+#define SAMPLE_POOL_BLOCKS_PER_CLASS 8
+
+/** maximum amount of cached memory per thread [bytes] */
+#define SAMPLE_POOL_CACHE_BYTES (16 * 1024 * 1024)
+
+namespace Kwave
+{
+    namespace
+    {
+	/**
+	 * Set by the destructor of the cache of the current thread. This
+	 * is a trivially destructible flag, it can still be read after the
+	 * end of the thread, when arrays that are freed by static
+	 * destructors have to bypass the cache.
+	 */
+	thread_local bool t_cache_destroyed = false;
+
+	/** cache with free blocks of one thread */
+	class Cache
+	{
+	public:
+	    /** Constructor */
+	    Cache() :m_bytes(0)
+	    {
+		for (int i = 0; i < SAMPLE_POOL_CLASSES; ++i)
+		    m_count[i] = 0;
+	    }
+
+	    /** Destructor, frees all cached blocks when the thread ends */
+	    ~Cache()
+	    {
+		for (int i = 0; i < SAMPLE_POOL_CLASSES; ++i)
+		    while (m_count[i])
+			::free(m_blocks[i][--m_count[i]]);
+		t_cache_destroyed = true;
+	    }
+
+	    /** free blocks, per size class */
+	    sample_t *m_blocks[SAMPLE_POOL_CLASSES]
+	                      [SAMPLE_POOL_BLOCKS_PER_CLASS];
+
+	    /** number of free blocks, per size class */
+	    int m_count[SAMPLE_POOL_CLASSES];
+
+	    /** size of all cached blocks [bytes] */
+	    quint64 m_bytes;
+	};
+
+	/** the cache of the current thread */
+	thread_local Cache t_cache;
+
+	//*******************************************************************
+	/**
+	 * Returns the cache of the current thread
+	 * @return pointer to the cache, or null after it has been destroyed
+	 */
+	Cache *threadCache()
+	{
+	    if (t_cache_destroyed) return Q_NULLPTR;
+	    return &t_cache;
+	}
+
+	//*******************************************************************
+	/**
+	 * Returns the size class of a number of samples
+	 * @param size number of samples, not bigger than SAMPLE_POOL_MAX_SIZE
+	 * @return index of the smallest class that can hold the samples
+	 */
+	int sizeClass(unsigned int size)
+	{
+	    int cls = 0;
+	    unsigned int capacity = SAMPLE_POOL_MIN_SIZE;
+	    while (capacity < size) {
+		capacity <<= 1;
+		cls++;
+	    }
+	    return cls;
+	}
+    }
+}
+
+// static initializers
+QAtomicInteger<quint64> Kwave::SamplePool::m_allocations(0);
+QAtomicInteger<quint64> Kwave::SamplePool::m_reused(0);
+
+//***************************************************************************
+sample_t *Kwave::SamplePool::allocate(unsigned int size,
+                                      unsigned int &capacity,
+                                      bool exact)
+{
+    Q_ASSERT(size);
+    if (exact || (size > SAMPLE_POOL_MAX_SIZE)) {
+	// exact size or too big for the pool, take it from the heap
+	capacity = size;
+	m_allocations.fetchAndAddRelaxed(1);
+	return static_cast<sample_t *>(::malloc(size * sizeof(sample_t)));
+    }
+
+    const int cls = sizeClass(size);
+    capacity = SAMPLE_POOL_MIN_SIZE << cls;
+    const quint64 bytes = capacity * sizeof(sample_t);
+
+    Cache *cache = threadCache();
+    if (cache && cache->m_count[cls]) {
+	// recycle a block from the cache
+	m_reused.fetchAndAddRelaxed(1);
+	cache->m_bytes -= bytes;
+	return cache->m_blocks[cls][--cache->m_count[cls]];
+    }
+
+    void *data = Q_NULLPTR;
+    if (::posix_memalign(&data, SAMPLE_POOL_ALIGNMENT, bytes) != 0)
+	return Q_NULLPTR; // OOM
+    m_allocations.fetchAndAddRelaxed(1);
+    return static_cast<sample_t *>(data);
+}
+
+//***************************************************************************
+void Kwave::SamplePool::release(sample_t *data, unsigned int capacity,
+                                bool exact)
+{
+    if (!data) return;
+    if (exact || !isPooled(capacity)) {
+	::free(data);
+	return;
+    }
+
+    const int     cls   = sizeClass(capacity);
+    const quint64 bytes = capacity * sizeof(sample_t);
+    Cache *cache = threadCache();
+    if (cache &&
+        (cache->m_count[cls] < SAMPLE_POOL_BLOCKS_PER_CLASS) &&
+        (cache->m_bytes + bytes <= SAMPLE_POOL_CACHE_BYTES))
+    {
+	cache->m_blocks[cls][cache->m_count[cls]++] = data;
+	cache->m_bytes += bytes;
+    } else {
+	::free(data);
+    }
+}
+
+//***************************************************************************
+bool Kwave::SamplePool::isPooled(unsigned int capacity)
+{
+    return (capacity <= SAMPLE_POOL_MAX_SIZE);
+}
+
+//***************************************************************************
+Kwave::SamplePool::Statistics Kwave::SamplePool::statistics()
+{
+    Statistics statistics;
+    statistics.m_allocations = m_allocations.loadRelaxed();
+    statistics.m_reused      = m_reused.loadRelaxed();
+    return statistics;
+}
+
+//***************************************************************************
+//***************************************************************************
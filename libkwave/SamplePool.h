@@ -0,0 +1,108 @@
+/***************************************************************************
+            SamplePool.h  -  recycling of memory for arrays of samples
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef SAMPLE_POOL_H
+#define SAMPLE_POOL_H
+
+#include "config.h"
+
+#include <QtGlobal>
+#include <QAtomicInteger>
+
+#include "libkwave/Sample.h"
+
+/** alignment of all pooled sample buffers [bytes] */
+#define SAMPLE_POOL_ALIGNMENT 64
+
+/** size of the largest block that is managed by the pool [samples] */
+#define SAMPLE_POOL_MAX_SIZE (1024 * 1024)
+
+namespace Kwave
+{
+
+    /**
+     * Allocator for the storage of Kwave::SampleArray, which keeps the
+     * blocks of memory that have been freed in a per-thread cache, sorted
+     * by size classes (powers of two). The streaming modules allocate and
+     * free blocks of the same size over and over again, these requests
+     * are served from the cache without going to the heap.
+     *
+     * All blocks up to SAMPLE_POOL_MAX_SIZE samples are aligned to
+     * SAMPLE_POOL_ALIGNMENT bytes, which is suitable for all SIMD
+     * instruction sets. Bigger blocks and blocks of exact size, like the
+     * data of stripes, are allocated directly from the heap and are not
+     * aligned beyond what malloc() guarantees.
+     */
+    class Q_DECL_EXPORT SamplePool
+    {
+    public:
+
+	/** counters, for statistics */
+	typedef struct {
+	    quint64 m_allocations; /**< allocations from the heap       */
+	    quint64 m_reused;      /**< allocations served by the cache */
+	} Statistics;
+
+	/**
+	 * Allocates a block of memory for samples
+	 * @param size number of samples, must not be zero
+	 * @param capacity receives the number of samples that fit into
+	 *                 the block, which might be more than requested
+	 * @param exact if true, bypass the pool and take a block of exactly
+	 *              the requested size from the heap, which can be
+	 *              handled with realloc()
+	 * @return pointer to the samples (not initialized) or null
+	 */
+	static sample_t *allocate(unsigned int size, unsigned int &capacity,
+	                          bool exact = false);
+
+	/**
+	 * Gives a block of memory back, puts it into the cache of the
+	 * calling thread if possible
+	 * @param data pointer to the samples, as returned by allocate()
+	 * @param capacity the capacity, as returned by allocate()
+	 * @param exact the same as passed to allocate()
+	 */
+	static void release(sample_t *data, unsigned int capacity,
+	                    bool exact = false);
+
+	/**
+	 * Returns true if blocks of a given capacity are managed by the
+	 * pool, false if they come from malloc() directly and can be
+	 * handled with realloc()
+	 * @param capacity number of samples
+	 */
+	static bool isPooled(unsigned int capacity);
+
+	/** returns the counters of allocations, summed over all threads */
+	static Kwave::SamplePool::Statistics statistics();
+
+    private:
+
+	/** number of allocations from the heap */
+	static QAtomicInteger<quint64> m_allocations;
+
+	/** number of allocations served by the cache */
+	static QAtomicInteger<quint64> m_reused;
+
+    };
+}
+
+#endif /* SAMPLE_POOL_H */
+
+//***************************************************************************
+//***************************************************************************
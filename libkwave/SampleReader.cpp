@@ -19,7 +19,9 @@
 
 #include <QApplication>
 
+#include "libkwave/Profiler.h"
 #include "libkwave/Sample.h"
+#include "libkwave/SampleConversion.h"
 #include "libkwave/SampleReader.h"
 #include "libkwave/Stripe.h"
 #include "libkwave/Utils.h"
@@ -79,9 +81,12 @@ void Kwave::SampleReader::fillBuffer()
     if (rest > m_buffer.size()) rest = m_buffer.size();
     Q_ASSERT(rest);
 
+    Kwave::ProfileScope profile("SampleReader::fillBuffer");
     unsigned int len = readSamples(m_src_position, m_buffer, 0, rest);
     Q_ASSERT(len == rest);
     m_buffer_used  += len;
+    profile.setItems(len);
+    profile.done();
 
     // inform others that we proceeded
     if (m_progress_time.elapsed() > MIN_PROGRESS_INTERVAL) {
@@ -218,6 +223,28 @@ void Kwave::SampleReader::skip(sample_index_t count)
 	    m_stripes.removeFirst();
 	}
     }
+
+    // inform others that we proceeded
+    if (m_progress_time.elapsed() > MIN_PROGRESS_INTERVAL) {
+	m_progress_time.restart();
+	emit proceeded();
+    }
+}
+
+//***************************************************************************
+Kwave::Stripe::List Kwave::SampleReader::stripes(sample_index_t first,
+                                                 sample_index_t last) const
+{
+    Q_ASSERT((m_mode != Kwave::SinglePassForward) ||
+             (first >= m_src_position));
+    Kwave::Stripe::List list(first, last);
+    foreach (const Kwave::Stripe &s, m_stripes) {
+	if (!s.length()) continue;
+	if (s.start() > last) break;
+	if (s.end() < first) continue;
+	list.append(s);
+    }
+    return list;
 }
 
 //***************************************************************************
@@ -294,6 +321,16 @@ void Kwave::SampleReader::goOn()
     Kwave::SampleArray buffer(blockSize());
     (*this) >> buffer;
     emit output(buffer);
+
+    // convert only once, for all receivers of the float API
+    if (receivers(SIGNAL(output(Kwave::FloatArray)))) {
+	Kwave::FloatArray floats(buffer.size());
+	if (floats.size() == buffer.size()) {
+	    Kwave::samples2floats(buffer.constData(), floats.data(),
+	                          buffer.size());
+	    emit output(floats);
+	}
+    }
 }
 
 //***************************************************************************
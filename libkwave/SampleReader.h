@@ -26,6 +26,7 @@
 #include <QList>
 #include <QObject>
 
+#include "libkwave/FloatArray.h"
 #include "libkwave/InsertMode.h"
 #include "libkwave/ReaderMode.h"
 #include "libkwave/Sample.h"
@@ -105,6 +106,17 @@ namespace Kwave
 	/** Seeks to a given position */
 	void seek(sample_index_t pos);
 
+	/**
+	 * Returns the stripes that cover a range of samples of this reader,
+	 * for example for creating independent readers for parts of the
+	 * range that can be used in other threads.
+	 * @param first index of the first sample, not before pos()
+	 * @param last index of the last sample
+	 * @return list of stripes, with left() and right() set to the range
+	 */
+	Kwave::Stripe::List stripes(sample_index_t first,
+	                            sample_index_t last) const;
+
 	/**
 	 * Returns the current read position.
 	 */
@@ -145,6 +157,13 @@ namespace Kwave
 	 */
 	void output(Kwave::SampleArray data);
 
+	/**
+	 * Interface for the float based streaming API, only emitted if
+	 * something is connected to it.
+	 * @param data sample data that has been read, converted to float
+	 */
+	void output(Kwave::FloatArray data);
+
     protected:
 
 	/** Fills the sample buffer */
@@ -572,6 +572,19 @@ unsigned int Kwave::Signal::trackIndex(const Kwave::Track *track)
     return (index >= 0) ? index : m_tracks.count();
 }
 
+//***************************************************************************
+void Kwave::Signal::flushChanges()
+{
+    QList<Kwave::Track *> tracks;
+    {
+	QReadLocker lock(&m_lock_tracks);
+	tracks = m_tracks;
+    }
+
+    foreach (Kwave::Track *track, tracks)
+	if (track) track->flushChanges();
+}
+
 //***************************************************************************
 void Kwave::Signal::slotSamplesInserted(Kwave::Track *src,
                                         sample_index_t offset,
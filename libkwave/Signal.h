@@ -190,6 +190,12 @@ namespace Kwave
 	 */
 	sample_index_t length();
 
+	/**
+	 * Delivers the pending changes of all tracks now
+	 * @see Track::flushChanges()
+	 */
+	void flushChanges();
+
 	/**
 	 * Queries if a track is selected. If the index of the track is
 	 * out of range, the return value will be false.
@@ -48,6 +48,8 @@
 #include "libkwave/MultiTrackReader.h"
 #include "libkwave/MultiTrackWriter.h"
 #include "libkwave/Parser.h"
+#include "libkwave/Profiler.h"
+#include "libkwave/ReadAheadDevice.h"
 #include "libkwave/Sample.h"
 #include "libkwave/Signal.h"
 #include "libkwave/SignalManager.h"
@@ -131,6 +133,9 @@ int Kwave::SignalManager::loadFile(const QUrl &url)
     QString filename = url.path();
     QFile src(filename);
     QFileInfo fi(src);
+
+    // the decoder reads through a device that reads the file in advance
+    Kwave::ReadAheadDevice source(src);
     {
 	Kwave::FileInfo info(m_meta_data);
 	info.set(Kwave::INF_FILENAME, fi.absoluteFilePath());
@@ -157,7 +162,7 @@ int Kwave::SignalManager::loadFile(const QUrl &url)
 	m_signal.close();
 
 	// open the source file
-	if (!(res = decoder->open(m_parent_widget, src))) {
+	if (!(res = decoder->open(m_parent_widget, source))) {
 	    qWarning("unable to open source: '%s'", DBG(url.toDisplayString()));
 	    res = -EIO;
 	    break;
@@ -231,6 +236,7 @@ int Kwave::SignalManager::loadFile(const QUrl &url)
 
 	// now decode
 	res = 0;
+	Kwave::ProfileScope profile("Decoder::decode");
 	if (!decoder->decode(m_parent_widget, writers)) {
 	    qWarning("decoding failed.");
 	    res = -EIO;
@@ -240,6 +246,8 @@ int Kwave::SignalManager::loadFile(const QUrl &url)
 	    meta_data = decoder->metaData();
 	    info = Kwave::FileInfo(meta_data);
 	}
+	profile.setItems(this->length() * this->tracks());
+	profile.done();
 
 	decoder->close();
 
@@ -425,6 +433,8 @@ int Kwave::SignalManager::save(const QUrl &url, bool selection)
 
 	// invoke the encoder...
 	bool encoded = false;
+	Kwave::ProfileScope profile("Encoder::encode");
+	profile.setItems(len * tracks);
 	m_meta_data.replace(Kwave::MetaDataList(file_info));
 
 	if (selection) {
@@ -447,6 +457,7 @@ int Kwave::SignalManager::save(const QUrl &url, bool selection)
 	    m_meta_data.replace(Kwave::MetaDataList(file_info));
 	    encoded = encoder->encode(m_parent_widget, src, dst, m_meta_data);
 	}
+	profile.done();
 	if (!encoded) {
 	    Kwave::MessageBox::error(m_parent_widget,
 	        i18n("An error occurred while saving the file."));
@@ -860,6 +871,23 @@ int Kwave::SignalManager::executeCommand(const QString &command)
 	Kwave::UndoTransactionGuard undo(*this, i18n("Toggle Track Selection"));
 	selectTrack(track, !(trackSelected(track)));
 
+    // range selection
+    CASE_COMMAND("selectall")
+	selectRange(0, this->length());
+    CASE_COMMAND("selectnext")
+	if (length)
+	    selectRange(m_selection.last() + 1, length);
+	else
+	    selectRange(this->length() - 1, 0);
+    CASE_COMMAND("selectprev")
+	sample_index_t len = (length) ? length : 1;
+	if (len > offset) len = offset;
+	selectRange(offset - len, len);
+    CASE_COMMAND("selecttoleft")
+	selectRange(0, m_selection.last() + 1);
+    CASE_COMMAND("selecttoright")
+	selectRange(offset, this->length() - offset);
+
     // playback control
     CASE_COMMAND("playback_start")
 	m_playback_controller.playbackStart();
@@ -1286,6 +1314,9 @@ void Kwave::SignalManager::closeUndoTransaction()
 // 	if (m_undo_transaction)
 // 	    m_undo_transaction->dump("closed undo transaction: ");
 
+	// deliver the changes of the transaction without further delay
+	m_signal.flushChanges();
+
 	// declare the current transaction as "closed"
 	rememberCurrentSelection();
         m_undo_transaction = Q_NULLPTR;
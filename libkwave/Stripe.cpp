@@ -106,7 +106,7 @@ unsigned int Kwave::Stripe::resize(unsigned int length)
     unsigned int old_length = m_data.size();
     if (old_length == length) return old_length; // nothing to do
 
-    if (!m_data.resize(length)) {
+    if (!m_data.resize(length, true)) {
 	qWarning("Stripe::resize(%u) failed, out of memory ?", length);
 	return m_data.size();
     }
@@ -127,7 +127,7 @@ unsigned int Kwave::Stripe::append(const Kwave::SampleArray &samples,
 
     unsigned int old_length = m_data.size();
     unsigned int new_length = old_length + count;
-    if (!m_data.resize(new_length))
+    if (!m_data.resize(new_length, true))
 	return 0; // out of memory
 
     // append to the end of the area
@@ -170,7 +170,7 @@ void Kwave::Stripe::deleteRange(unsigned int offset, unsigned int length)
     }
 
     // resize the buffer to it's new size
-    m_data.resize(size - length);
+    m_data.resize(size - length, true);
 }
 
 //***************************************************************************
@@ -193,16 +193,20 @@ bool Kwave::Stripe::combine(unsigned int offset, Kwave::Stripe &other)
 }
 
 //***************************************************************************
-void Kwave::Stripe::overwrite(unsigned int offset,
+bool Kwave::Stripe::overwrite(unsigned int offset,
 	const Kwave::SampleArray &source,
 	unsigned int srcoff, unsigned int srclen)
 {
     QMutexLocker lock(&m_lock);
+    if (offset + srclen > m_data.size()) return false; // out of range
 
     const sample_t *src = source.constData();
     sample_t       *dst = this->m_data.data();
     unsigned int    len = srclen * sizeof(sample_t);
+    if (!src || !dst) return false; // detaching failed, maybe OOM ?
     MEMCPY(dst + offset, src + srcoff, len);
+
+    return true;
 }
 
 //***************************************************************************
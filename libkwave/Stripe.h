@@ -130,10 +130,12 @@ namespace Kwave
 	 * @param source array of samples to be copied
 	 * @param srcoff offset within the source array
 	 * @param srclen length of the data in the source array
+	 * @return true if succeeded or false if failed (e.g. out of memory
+	 *         when detaching shared storage)
 	 * @warning this method is intended to be used only internally
-	 *          and lacks any error-checking in order to be fast!
+	 *          and does not check the source range in order to be fast!
 	 */
-	void overwrite(unsigned int offset, const Kwave::SampleArray &source,
+	bool overwrite(unsigned int offset, const Kwave::SampleArray &source,
 	               unsigned int srcoff, unsigned int srclen);
 
 	/**
@@ -229,7 +231,10 @@ namespace Kwave
 	/** start position within the track */
 	sample_index_t m_start;
 
-	/** pointer to the shared data */
+	/**
+	 * pointer to the shared data, with exactly the size of the stripe
+	 * (not taken from the sample pool)
+	 */
 	Kwave::SampleArray m_data;
 
     };
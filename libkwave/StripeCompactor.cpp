@@ -0,0 +1,135 @@
+/***************************************************************************
+     StripeCompactor.cpp  -  background defragmentation of tracks
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "config.h"
+
+#include <QMutexLocker>
+
+#include "libkwave/String.h"
+#include "libkwave/StripeCompactor.h"
+#include "libkwave/Track.h"
+
+/** maximum time of one compaction step [ms] */
+#define COMPACTOR_SLICE 5
+
+/** pause between two compaction steps [ms] */
+#define COMPACTOR_PAUSE 5
+
+/** pause after a track has been found locked by someone else [ms] */
+#define COMPACTOR_BACKOFF 50
+
+//***************************************************************************
+Kwave::StripeCompactor::StripeCompactor()
+    :QThread(Q_NULLPTR), m_lock(), m_more_work(), m_step_done(),
+     m_queue(), m_current(Q_NULLPTR)
+{
+    setObjectName(_("stripe compactor"));
+}
+
+//***************************************************************************
+Kwave::StripeCompactor::~StripeCompactor()
+{
+    {
+	QMutexLocker lock(&m_lock);
+	requestInterruption();
+	m_more_work.wakeAll();
+    }
+    wait();
+}
+
+//***************************************************************************
+Kwave::StripeCompactor &Kwave::StripeCompactor::instance()
+{
+    static Kwave::StripeCompactor compactor;
+    return compactor;
+}
+
+//***************************************************************************
+void Kwave::StripeCompactor::schedule(Kwave::Track *track,
+                                      unsigned int score)
+{
+    Q_ASSERT(track);
+    if (!track) return;
+
+    Kwave::StripeCompactor &self = instance();
+    QMutexLocker lock(&self.m_lock);
+    if (!score) {
+	self.m_queue.remove(track);
+	return;
+    }
+
+    self.m_queue[track] = score;
+    if (!self.isRunning())
+	self.start(QThread::IdlePriority);
+    self.m_more_work.wakeAll();
+}
+
+//***************************************************************************
+void Kwave::StripeCompactor::remove(Kwave::Track *track)
+{
+    Kwave::StripeCompactor &self = instance();
+    QMutexLocker lock(&self.m_lock);
+    while (self.m_current == track)
+	self.m_step_done.wait(&self.m_lock);
+    self.m_queue.remove(track);
+}
+
+//***************************************************************************
+void Kwave::StripeCompactor::run()
+{
+    QMutexLocker lock(&m_lock);
+    while (!isInterruptionRequested()) {
+	if (m_queue.isEmpty()) {
+	    m_more_work.wait(&m_lock);
+	    continue;
+	}
+
+	// take the most fragmented track
+	QHash<Kwave::Track *, unsigned int>::const_iterator it;
+	Kwave::Track *track = Q_NULLPTR;
+	unsigned int  score = 0;
+	for (it = m_queue.constBegin(); it != m_queue.constEnd(); ++it) {
+	    if (it.value() <= score) continue;
+	    track = it.key();
+	    score = it.value();
+	}
+	m_queue.remove(track);
+	m_current = track;
+	lock.unlock();
+
+	// do one time slice of work, without holding our lock
+	const int remaining = track->compactStep(COMPACTOR_SLICE);
+
+	lock.relock();
+	m_current = Q_NULLPTR;
+	if (remaining != 0) {
+	    // not finished or busy -> try again later
+	    unsigned int &queued = m_queue[track];
+	    queued = qMax(queued, (remaining < 0) ?
+		score : static_cast<unsigned int>(remaining));
+	}
+	m_step_done.wakeAll();
+
+	// give the rest of the application some air
+	lock.unlock();
+	msleep((remaining < 0) ? COMPACTOR_BACKOFF : COMPACTOR_PAUSE);
+	lock.relock();
+    }
+}
+
+//***************************************************************************
+//***************************************************************************
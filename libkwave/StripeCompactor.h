@@ -0,0 +1,102 @@
+/***************************************************************************
+       StripeCompactor.h  -  background defragmentation of tracks
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef STRIPE_COMPACTOR_H
+#define STRIPE_COMPACTOR_H
+
+#include "config.h"
+
+#include <QtGlobal>
+#include <QHash>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+
+namespace Kwave
+{
+
+    class Track;
+
+    /**
+     * Low priority thread that merges small neighbour stripes of tracks
+     * in the background, in short time slices. Tracks get scheduled
+     * together with their fragmentation score, the most fragmented track
+     * is compacted first. Each merge step only uses a try-lock on the
+     * track, so that the compaction always gives way to readers and
+     * writers of the track.
+     */
+    class Q_DECL_EXPORT StripeCompactor: public QThread
+    {
+	Q_OBJECT
+    public:
+
+	/**
+	 * Puts a track into the queue of tracks to compact, or updates
+	 * its fragmentation score if it is already queued
+	 * @param track the track to compact
+	 * @param score fragmentation score, zero removes it from the queue
+	 */
+	static void schedule(Kwave::Track *track, unsigned int score);
+
+	/**
+	 * Removes a track from the queue and waits until the current
+	 * compaction step of the track (if any) has finished. Must be
+	 * called before the track is deleted.
+	 * @param track the track to remove
+	 */
+	static void remove(Kwave::Track *track);
+
+    protected:
+
+	/** the main loop of the thread */
+        virtual void run() Q_DECL_OVERRIDE;
+
+    private:
+
+	/** Constructor */
+	StripeCompactor();
+
+	/** Destructor, stops the thread */
+        virtual ~StripeCompactor() Q_DECL_OVERRIDE;
+
+	/** returns the one and only instance */
+	static Kwave::StripeCompactor &instance();
+
+    private:
+
+	/** lock for the queue and the current track */
+	QMutex m_lock;
+
+	/** signaled when new tracks are queued or the thread should stop */
+	QWaitCondition m_more_work;
+
+	/** signaled after each compaction step */
+	QWaitCondition m_step_done;
+
+	/** queued tracks with their fragmentation score */
+	QHash<Kwave::Track *, unsigned int> m_queue;
+
+	/** the track that is currently compacted, or null */
+	Kwave::Track *m_current;
+
+    };
+}
+
+#endif /* STRIPE_COMPACTOR_H */
+
+//***************************************************************************
+//***************************************************************************
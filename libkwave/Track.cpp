@@ -19,12 +19,17 @@
 
 #include <new>
 
+#include <QCoreApplication>
+#include <QElapsedTimer>
 #include <QMutexLocker>
 #include <QReadLocker>
+#include <QThread>
 #include <QWriteLocker>
 
+#include "libkwave/Profiler.h"
 #include "libkwave/SampleReader.h"
 #include "libkwave/Stripe.h"
+#include "libkwave/StripeCompactor.h"
 #include "libkwave/Track.h"
 #include "libkwave/TrackWriter.h"
 #include "libkwave/Utils.h"
@@ -54,18 +59,31 @@
  */
 #define STRIPE_LENGTH_MINIMUM (STRIPE_LENGTH_OPTIMAL / 2)
 
+/**
+ * Minimum interval between two deliveries of changes made by other
+ * threads than the one of the track [ms]
+ */
+#define CHANGE_DELIVERY_INTERVAL 40
+
 //***************************************************************************
 Kwave::Track::Track()
     :m_lock(QMutex::Recursive), m_lock_usage(), m_stripes(), m_selected(true),
-     m_uuid(QUuid::createUuid())
+     m_uuid(QUuid::createUuid()), m_fragmentation(0), m_compact_position(0),
+     m_lock_version(), m_version(), m_length(0),
+     m_journal(), m_journal_timer(this)
 {
+    initJournal();
 }
 
 //***************************************************************************
 Kwave::Track::Track(sample_index_t length, QUuid *uuid)
     :m_lock(QMutex::Recursive), m_lock_usage(), m_stripes(), m_selected(true),
-     m_uuid((uuid) ? *uuid : QUuid::createUuid())
+     m_uuid((uuid) ? *uuid : QUuid::createUuid()),
+     m_fragmentation(0), m_compact_position(0),
+     m_lock_version(), m_version(), m_length(0),
+     m_journal(), m_journal_timer(this)
 {
+    initJournal();
     if (length <= STRIPE_LENGTH_MAXIMUM) {
 	if (length) appendStripe(length);
     } else {
@@ -73,11 +91,30 @@ Kwave::Track::Track(sample_index_t length, QUuid *uuid)
 	s.resize(STRIPE_LENGTH_OPTIMAL);
 	if (s.length()) m_stripes.append(s);
     }
+    m_length.storeRelaxed(unlockedLength());
+}
+
+//***************************************************************************
+void Kwave::Track::initJournal()
+{
+    // changes from other threads are delivered through the event loop
+    // of the main thread
+    QCoreApplication *app = QCoreApplication::instance();
+    if (app && (thread() != app->thread()))
+	moveToThread(app->thread());
+
+    m_journal_timer.setSingleShot(true);
+    m_journal_timer.setInterval(CHANGE_DELIVERY_INTERVAL);
+    connect(&m_journal_timer, SIGNAL(timeout()),
+            this, SLOT(flushChanges()));
 }
 
 //***************************************************************************
 Kwave::Track::~Track()
 {
+    // no longer compact in the background
+    Kwave::StripeCompactor::remove(this);
+
     // wait until all readers are finished
     QWriteLocker lock_usage(&m_lock_usage);
 
@@ -85,6 +122,7 @@ Kwave::Track::~Track()
     QMutexLocker lock(&m_lock);
 
     // delete all stripes
+    m_version.reset();
     m_stripes.clear();
 }
 
@@ -98,7 +136,7 @@ void Kwave::Track::appendStripe(sample_index_t length)
 
 	Stripe s(start);
 	s.resize(len);
-	if (len) emit sigSamplesInserted(this, start, len);
+	if (len) notify(Kwave::ChangeJournal::Inserted, start, len);
 
 	length -= len;
 	start  += len;
@@ -172,8 +210,7 @@ bool Kwave::Track::mergeStripe(Kwave::Stripe &stripe)
 //***************************************************************************
 sample_index_t Kwave::Track::length()
 {
-    QMutexLocker lock(&m_lock);
-    return unlockedLength();
+    return m_length.loadAcquire();
 }
 
 //***************************************************************************
@@ -205,15 +242,65 @@ Kwave::Writer *Kwave::Track::openWriter(Kwave::InsertMode mode,
     return stream;
 }
 
+//***************************************************************************
+QExplicitlySharedDataPointer<Kwave::Track::Version>
+    Kwave::Track::pinVersion()
+{
+    {
+	QMutexLocker lock_version(&m_lock_version);
+	if (m_version) return m_version;
+    }
+
+    // no valid version -> wait for the current writer and create a new
+    // one, which shares the list of stripes with the track
+    QMutexLocker lock(&m_lock);
+    QMutexLocker lock_version(&m_lock_version);
+    if (!m_version) {
+	Version *version = new(std::nothrow) Version(m_stripes);
+	Q_ASSERT(version);
+	m_version = QExplicitlySharedDataPointer<Version>(version);
+    }
+    return m_version;
+}
+
+//***************************************************************************
+void Kwave::Track::beginEdit()
+{
+    QMutexLocker lock_version(&m_lock_version);
+
+    // if no reader uses the current version, drop it to avoid a copy of
+    // the list and the data on write. Otherwise readers that come during
+    // the edit can still get the old version, without waiting.
+    if (m_version && (m_version->ref.loadRelaxed() == 1))
+	m_version.reset();
+}
+
+//***************************************************************************
+void Kwave::Track::commitEdit()
+{
+    m_length.storeRelease(unlockedLength());
+
+    QMutexLocker lock_version(&m_lock_version);
+    m_version.reset();
+}
+
 //***************************************************************************
 Kwave::Stripe::List Kwave::Track::stripes(sample_index_t left,
                                           sample_index_t right)
 {
-    QMutexLocker lock(&m_lock);
+    QExplicitlySharedDataPointer<Version> version = pinVersion();
+    if (!version) return Kwave::Stripe::List(left, right); // OOM ?
+    return collectStripes(version->m_stripes, left, right);
+}
 
+//***************************************************************************
+Kwave::Stripe::List Kwave::Track::collectStripes(
+    const QList<Kwave::Stripe> &list, sample_index_t left,
+    sample_index_t right)
+{
     // collect all stripes that are in the requested range
     Kwave::Stripe::List stripes(left, right);
-    foreach (const Stripe &stripe, m_stripes) {
+    foreach (const Stripe &stripe, list) {
 	if (!stripe.length()) continue;
 	sample_index_t start = stripe.start();
 	sample_index_t end   = stripe.end();
@@ -253,12 +340,14 @@ bool Kwave::Track::mergeStripes(const Kwave::Stripe::List &stripes)
     bool succeeded = true;
     {
 	QMutexLocker lock(&m_lock);
+	beginEdit();
 	foreach (Stripe stripe, stripes) {
 	    if (!mergeStripe(stripe)) {
 		succeeded = false;
 		break;
 	    }
 	}
+	commitEdit();
     }
 
     // do some defragmentation, to combine the ends of the inserted stripes
@@ -266,7 +355,7 @@ bool Kwave::Track::mergeStripes(const Kwave::Stripe::List &stripes)
 
     const sample_index_t left  = stripes.left();
     const sample_index_t right = stripes.right();
-    emit sigSamplesModified(this, left, right - left + 1);
+    notify(Kwave::ChangeJournal::Modified, left, right - left + 1);
     return succeeded;
 }
 
@@ -274,13 +363,17 @@ bool Kwave::Track::mergeStripes(const Kwave::Stripe::List &stripes)
 Kwave::SampleReader *Kwave::Track::openReader(Kwave::ReaderMode mode,
 	sample_index_t left, sample_index_t right)
 {
-    QMutexLocker lock(&m_lock);
+    // pin the latest version, readers do not need to wait for writers
+    QExplicitlySharedDataPointer<Version> version = pinVersion();
+    if (!version) return Q_NULLPTR; // OOM ?
 
-    const sample_index_t length = unlockedLength();
+    const QList<Kwave::Stripe> &list = version->m_stripes;
+    const sample_index_t length = (list.isEmpty()) ? 0 :
+	(list.last().start() + list.last().length());
     if (right >= length) right = (length) ? (length - 1) : 0;
 
     // collect all stripes that are in the requested range
-    Kwave::Stripe::List stripe_list = stripes(left, right);
+    Kwave::Stripe::List stripe_list = collectStripes(list, left, right);
 
     // create the input stream
     Kwave::SampleReader *stream =
@@ -300,14 +393,16 @@ void Kwave::Track::deleteRange(sample_index_t offset, sample_index_t length,
 
     {
 	QMutexLocker lock(&m_lock);
+	beginEdit();
 	unlockedDelete(offset, length, make_gap);
+	commitEdit();
     }
 
     // deletion without gap might have left some fragments
     if (!make_gap)
 	defragment();
 
-    emit sigSamplesDeleted(this, offset, length);
+    notify(Kwave::ChangeJournal::Deleted, offset, length);
 }
 
 //***************************************************************************
@@ -318,6 +413,7 @@ bool Kwave::Track::insertSpace(sample_index_t offset, sample_index_t shift)
 
     {
 	QMutexLocker lock(&m_lock);
+	beginEdit();
 	sample_index_t len = unlockedLength();
 	if (offset < len) {
 	    // find out whether the offset is within a stripe and
@@ -335,7 +431,10 @@ bool Kwave::Track::insertSpace(sample_index_t offset, sample_index_t shift)
 		Stripe new_stripe = splitStripe(s,
 		    Kwave::toUint(offset - start)
 		);
-		if (!new_stripe.length()) return false; // OOM ?
+		if (!new_stripe.length()) {
+		    commitEdit();
+		    return false; // OOM ?
+		}
 		it.insert(new_stripe);
 		break;
 	    }
@@ -349,10 +448,11 @@ bool Kwave::Track::insertSpace(sample_index_t offset, sample_index_t shift)
 	    s.resize(1);
 	    if (s.length()) m_stripes.append(s);
 	}
+	commitEdit();
     }
 
 //     dump();
-    emit sigSamplesInserted(this, offset, shift);
+    notify(Kwave::ChangeJournal::Inserted, offset, shift);
     return true;
 }
 
@@ -542,6 +642,50 @@ bool Kwave::Track::appendAfter(Stripe *stripe,  sample_index_t offset,
     return true;
 }
 
+//***************************************************************************
+bool Kwave::Track::unlockedOverwrite(sample_index_t offset,
+                                     const Kwave::SampleArray &buffer,
+                                     unsigned int buf_offset,
+                                     unsigned int length)
+{
+    const sample_index_t last = offset + length - 1;
+
+    // find the first stripe that contains the start of the range
+    const int count = m_stripes.count();
+    int first = 0;
+    while ((first < count) && (!m_stripes.at(first).length() ||
+                               (m_stripes.at(first).end() < offset)))
+	first++;
+    if ((first >= count) || (m_stripes.at(first).start() > offset))
+	return false; // starts in a gap or after the end
+
+    // check that the stripes cover the whole range without gaps
+    int index = first;
+    sample_index_t end = m_stripes.at(index).end();
+    while (end < last) {
+	if (++index >= count) return false; // beyond the end
+	const Stripe &s = m_stripes.at(index);
+	if (!s.length()) continue;
+	if (s.start() != end + 1) return false; // gap
+	end = s.end();
+    }
+
+    // copy the samples into the stripes, this detaches only the storage
+    // of stripes that are shared with someone else
+    sample_index_t pos = offset;
+    for (index = first; pos <= last; ++index) {
+	Stripe &s = m_stripes[index];
+	if (!s.length()) continue;
+	const unsigned int n = Kwave::toUint(qMin(s.end(), last) - pos + 1);
+	if (!s.overwrite(Kwave::toUint(pos - s.start()), buffer,
+	                 buf_offset + Kwave::toUint(pos - offset), n))
+	    return false; // detaching failed, the caller writes it again
+	pos += n;
+    }
+
+    return true;
+}
+
 //***************************************************************************
 void Kwave::Track::moveRight(sample_index_t offset, sample_index_t shift)
 {
@@ -567,25 +711,31 @@ bool Kwave::Track::writeSamples(Kwave::InsertMode mode,
     Q_ASSERT(length);
     if (!length) return true; // nothing to do !?
 
+    Kwave::ProfileScope profile("Track::writeSamples");
+    profile.setItems(length);
+
     switch (mode) {
 	case Kwave::Append: {
 // 	    qDebug("writeSamples() - Append");
 	    bool appended;
 	    {
-		QMutexLocker _lock(&m_lock);
+		Kwave::ProfileMutexLocker _lock(&m_lock, "Track::m_lock");
+		beginEdit();
 		appended = appendAfter(
                     m_stripes.isEmpty() ? Q_NULLPTR : &(m_stripes.last()),
 		    offset, buffer,
 		    buf_offset, length);
+		commitEdit();
 	    }
 	    if (appended)
-		emit sigSamplesInserted(this, offset, length);
+		notify(Kwave::ChangeJournal::Inserted, offset, length);
 	    else
 		return false; /* out of memory */
 	    break;
 	}
 	case Kwave::Insert: {
-	    m_lock.lock();
+	    Kwave::Profiler::lock(m_lock, "Track::m_lock");
+	    beginEdit();
 
 // 	    qDebug("Kwave::Track::writeSamples() - Insert @ %u, length=%u",
 // 		   offset, length);
@@ -627,8 +777,9 @@ bool Kwave::Track::writeSamples(Kwave::InsertMode mode,
 		moveRight(offset, length);
 		appendAfter(stripe_before, offset, buffer,
 		            buf_offset, length);
+		commitEdit();
 		m_lock.unlock();
-		emit sigSamplesInserted(this, offset, length);
+		notify(Kwave::ChangeJournal::Inserted, offset, length);
 		break;
 	    }
 
@@ -646,6 +797,7 @@ bool Kwave::Track::writeSamples(Kwave::InsertMode mode,
 		    Kwave::toUint(offset - target_stripe->start())
 		);
 		if (!new_stripe.length()) {
+		    commitEdit();
 		    m_lock.unlock();
 		    break;
 		}
@@ -657,8 +809,9 @@ bool Kwave::Track::writeSamples(Kwave::InsertMode mode,
 		            buf_offset, length);
 	    }
 
+	    commitEdit();
 	    m_lock.unlock();
-	    emit sigSamplesInserted(this, offset, length);
+	    notify(Kwave::ChangeJournal::Inserted, offset, length);
 
 	    break;
 	}
@@ -668,23 +821,30 @@ bool Kwave::Track::writeSamples(Kwave::InsertMode mode,
 // 	    qDebug("writeSamples() - Overwrite [%u - %u]", left, right);
 
 	    {
-		QMutexLocker _lock(&m_lock);
-
-		// delete old content, producing a gap
-		unlockedDelete(offset, length, true);
-
-		// fill in the content of the buffer, append to the stripe
-		// before the gap if possible
-                Stripe *stripe_before = Q_NULLPTR;
-		QMutableListIterator<Stripe> it(m_stripes);
-		while (it.hasNext()) {
-		    Stripe &s = it.next();
-		    if (s.start() >= offset) break;
-		    if (s.end() < offset) stripe_before = &s;
+		Kwave::ProfileMutexLocker _lock(&m_lock, "Track::m_lock");
+		beginEdit();
+
+		// copy into the existing stripes if they cover the range,
+		// which leaves the list of stripes as it is
+		if (!unlockedOverwrite(offset, buffer, buf_offset, length)) {
+		    // delete old content, producing a gap
+		    unlockedDelete(offset, length, true);
+
+		    // fill in the content of the buffer, append to the
+		    // stripe before the gap if possible
+		    Stripe *stripe_before = Q_NULLPTR;
+		    QMutableListIterator<Stripe> it(m_stripes);
+		    while (it.hasNext()) {
+			Stripe &s = it.next();
+			if (s.start() >= offset) break;
+			if (s.end() < offset) stripe_before = &s;
+		    }
+		    appendAfter(stripe_before, offset, buffer,
+		                buf_offset, length);
 		}
-		appendAfter(stripe_before, offset, buffer, buf_offset, length);
+		commitEdit();
 	    }
-	    emit sigSamplesModified(this, offset, length);
+	    notify(Kwave::ChangeJournal::Modified, offset, length);
 	    break;
 	}
     }
@@ -693,70 +853,171 @@ bool Kwave::Track::writeSamples(Kwave::InsertMode mode,
 }
 
 //***************************************************************************
-void Kwave::Track::defragment()
+unsigned int Kwave::Track::unlockedFragmentation()
 {
+    // count all pairs of neighbour stripes that could be combined
+    unsigned int score = 0;
+    const Kwave::Stripe *before = Q_NULLPTR;
+    foreach (const Kwave::Stripe &stripe, m_stripes) {
+	if (before && canCombine(*before, stripe)) score++;
+	before = &stripe;
+    }
+    return score;
+}
+
+//***************************************************************************
+bool Kwave::Track::canCombine(const Kwave::Stripe &before,
+                              const Kwave::Stripe &stripe)
+{
+    const sample_index_t combined_len = stripe.end() - before.start() + 1;
+    if (combined_len > STRIPE_LENGTH_MAXIMUM)
+	return false; // would be too large
+
+    return ((before.length() < STRIPE_LENGTH_MINIMUM) ||
+            (stripe.length() < STRIPE_LENGTH_MINIMUM));
+}
 
+//***************************************************************************
+unsigned int Kwave::Track::fragmentation() const
+{
+    return static_cast<unsigned int>(m_fragmentation.loadRelaxed());
+}
+
+//***************************************************************************
+void Kwave::Track::defragment()
+{
     if (!m_lock.tryLock()) {
-	// this could happen when there are two or more writers
-// 	qDebug("Track::defragment() - busy");
+	// this could happen when there are two or more writers,
+	// let the compactor find out later
+	Kwave::StripeCompactor::schedule(this, qMax(fragmentation(), 1U));
 	return;
     }
 
-    if (m_stripes.count() > 1)
-    {
-// 	qDebug("Track::defragment(), state before:");
-// 	dump();
+    const unsigned int score = unlockedFragmentation();
+    m_fragmentation.storeRelaxed(static_cast<int>(score));
+    m_compact_position = 0;
+    m_lock.unlock();
 
-// 	unsigned int   index  = 0;
-        Kwave::Stripe *before = Q_NULLPTR;
-        Kwave::Stripe *stripe = Q_NULLPTR;
+    // the real work is done in the background
+    Kwave::StripeCompactor::schedule(this, score);
+}
 
-	// use a quick and simple algorithm:
-	// iterate over all stripes and analyze pairwise
-	QMutableListIterator<Kwave::Stripe> it(m_stripes);
-	while (it.hasNext()) {
-	    before = stripe;
-	    stripe = &(it.next());
-	    if (!before) continue; // skip the first entry
-// 	    index++;
-
-// 	    qDebug("Track::defragment(), checking #%u [%llu..%llu] (%u)",
-// 		    index, stripe->start(), stripe->end(), stripe->length());
-
-	    const sample_index_t before_start = before->start();
-	    const sample_index_t stripe_end   = stripe->end();
-	    const sample_index_t combined_len = stripe_end - before_start + 1;
-
-	    if (combined_len > STRIPE_LENGTH_MAXIMUM)
-		continue; // would be too large
-
-	    if ((before->length() < STRIPE_LENGTH_MINIMUM) ||
-		(stripe->length() < STRIPE_LENGTH_MINIMUM)) {
-// 		qDebug("Track::defragment(), combine #%u [%llu..%llu] & "
-// 		       "#%u [%llu..%llu] => [%llu..%llu] (%llu)",
-// 		       index - 1, before->start(), before->end(),
-// 		       index, stripe->start(), stripe->end(),
-// 		       before->start(), stripe->end(), combined_len);
-
-		// try to resize the stripe before to contain the
-		// combined length
-		const unsigned int offset = Kwave::toUint(
-		    stripe->start() - before_start);
-		if (!before->combine(offset, *stripe))
-		    continue; // not possible, maybe OOM ?
-
-		// remove the current stripe, to avoid an overlap
-		it.remove();
-		stripe = before;
-// 		index--;
-	    }
+//***************************************************************************
+int Kwave::Track::compactStep(int budget)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    unsigned int score = fragmentation();
+    do {
+	// give way to everyone else who wants to access the track
+	if (!m_lock.tryLock()) return -1;
+
+	// find the next pair of stripes that can be combined, starting
+	// at the position where the last step stopped
+	const int count = m_stripes.count();
+	int index = 1;
+	while (index < count) {
+	    const Kwave::Stripe &stripe = m_stripes.at(index);
+	    if ((stripe.end() >= m_compact_position) &&
+		canCombine(m_stripes.at(index - 1), stripe)) break;
+	    index++;
 	}
 
-// 	qDebug("Track::defragment(), state after:");
-// 	dump();
+	if (index >= count) {
+	    // reached the end, everything that was possible has been done
+	    score = unlockedFragmentation();
+	    m_fragmentation.storeRelaxed(static_cast<int>(score));
+	    m_compact_position = 0;
+	    m_lock.unlock();
+	    return 0;
+	}
+
+	Kwave::ProfileScope _profile("Track::compact");
+	beginEdit();
+	Kwave::Stripe &before = m_stripes[index - 1];
+	Kwave::Stripe &stripe = m_stripes[index];
+	const unsigned int offset = Kwave::toUint(
+	    stripe.start() - before.start());
+	_profile.setItems(stripe.length());
+	if (before.combine(offset, stripe)) {
+	    // remove the current stripe, to avoid an overlap
+	    m_compact_position = before.start();
+	    m_stripes.removeAt(index);
+	    if (score) score--;
+	} else {
+	    // not possible, maybe OOM ? -> skip this one
+	    m_compact_position = stripe.end() + 1;
+	}
+	commitEdit();
+	m_fragmentation.storeRelaxed(static_cast<int>(score));
+	m_lock.unlock();
+	_profile.done();
+
+	QThread::yieldCurrentThread();
+    } while (timer.elapsed() < budget);
+
+    return qMax(score, 1U);
+}
+
+//***************************************************************************
+void Kwave::Track::notify(Kwave::ChangeJournal::Kind kind,
+                          sample_index_t offset, sample_index_t length)
+{
+    if (QThread::currentThread() == thread()) {
+	// deliver directly, but not before the changes that are pending
+	if (!m_journal.isEmpty()) flushChanges();
+	deliver(kind, offset, length);
+	return;
+    }
+
+    // from some other thread -> collect and deliver later
+    if (m_journal.record(kind, offset, length))
+	QMetaObject::invokeMethod(this, "scheduleDelivery",
+	                          Qt::QueuedConnection);
+}
+
+//***************************************************************************
+void Kwave::Track::deliver(Kwave::ChangeJournal::Kind kind,
+                           sample_index_t offset, sample_index_t length)
+{
+    switch (kind) {
+	case Kwave::ChangeJournal::Inserted:
+	    emit sigSamplesInserted(this, offset, length);
+	    break;
+	case Kwave::ChangeJournal::Deleted:
+	    emit sigSamplesDeleted(this, offset, length);
+	    break;
+	case Kwave::ChangeJournal::Modified:
+	    emit sigSamplesModified(this, offset, length);
+	    break;
     }
+}
 
-    m_lock.unlock();
+//***************************************************************************
+void Kwave::Track::scheduleDelivery()
+{
+    if (!m_journal_timer.isActive()) m_journal_timer.start();
+}
+
+//***************************************************************************
+void Kwave::Track::flushChanges()
+{
+    if (QThread::currentThread() != thread()) {
+	QMetaObject::invokeMethod(this, "flushChanges",
+	                          Qt::QueuedConnection);
+	return;
+    }
+
+    m_journal_timer.stop();
+    foreach (const Kwave::ChangeJournal::Change &change, m_journal.take())
+	deliver(change.m_kind, change.m_offset, change.m_length);
+}
+
+//***************************************************************************
+QList<Kwave::ChangeJournal::Change> Kwave::Track::pendingChanges() const
+{
+    return m_journal.pending();
 }
 
 //***************************************************************************
@@ -21,12 +21,17 @@
 #include "config.h"
 
 #include <QtGlobal>
+#include <QAtomicInt>
+#include <QExplicitlySharedDataPointer>
 #include <QList>
 #include <QMutex>
 #include <QObject>
 #include <QReadWriteLock>
+#include <QSharedData>
+#include <QTimer>
 #include <QUuid>
 
+#include "libkwave/ChangeJournal.h"
 #include "libkwave/InsertMode.h"
 #include "libkwave/ReaderMode.h"
 #include "libkwave/SampleArray.h"
@@ -37,6 +42,7 @@ namespace Kwave
 {
 
     class SampleReader;
+    class StripeCompactor;
     class TrackWriter;
     class Writer;
 
@@ -65,6 +71,8 @@ namespace Kwave
 	/**
 	 * Returns the length of the track. This is equivalent
 	 * to the position of the last sample of the last Stripe.
+	 * @note does not wait for writers, returns the length after
+	 *       the last completed modification
 	 */
 	sample_index_t length();
 
@@ -141,14 +149,44 @@ namespace Kwave
 	/** returns the unique ID of this track instance */
 	const QUuid &uuid() const { return m_uuid; }
 
+	/**
+	 * Returns the fragmentation score of the track, the number of
+	 * neighbour stripes that could be combined. Updated by
+	 * defragment() and during the background compaction.
+	 */
+	unsigned int fragmentation() const;
+
+	/**
+	 * Returns the changes that have been made by other threads and
+	 * that have not been delivered through the signals yet. Can be
+	 * used to find out which ranges will soon be reported as dirty.
+	 */
+	QList<Kwave::ChangeJournal::Change> pendingChanges() const;
+
     public slots:
 
 	/** toggles the selection of the slot on/off */
 	void toggleSelection();
 
-	/** do some defragmentation of stripes */
+	/**
+	 * Updates the fragmentation score and schedules the track for
+	 * merging small stripes in the background
+	 * @see Kwave::StripeCompactor
+	 */
 	void defragment();
 
+	/**
+	 * Delivers all pending changes through the signals now, instead
+	 * of waiting for the next interval. Can be called from any thread,
+	 * the signals are always emitted in the thread of the track.
+	 */
+	void flushChanges();
+
+    private slots:
+
+	/** starts the timer for delivering the pending changes */
+	void scheduleDelivery();
+
     signals:
 
 	/**
@@ -187,6 +225,81 @@ namespace Kwave
 	void sigSelectionChanged(bool selected);
 
     private:
+
+	/** moves the track to the main thread and sets up the timer */
+	void initJournal();
+
+	/**
+	 * Reports a change of the samples. Changes from the thread of the
+	 * track are emitted directly, changes from other threads are merged
+	 * in the journal and delivered at a limited rate.
+	 * @param kind the kind of the change
+	 * @param offset index of the first sample
+	 * @param length number of samples
+	 */
+	void notify(Kwave::ChangeJournal::Kind kind,
+	            sample_index_t offset, sample_index_t length);
+
+	/**
+	 * Emits the signal that belongs to a kind of change
+	 * @param kind the kind of the change
+	 * @param offset index of the first sample
+	 * @param length number of samples
+	 */
+	void deliver(Kwave::ChangeJournal::Kind kind,
+	             sample_index_t offset, sample_index_t length);
+
+	/**
+	 * Immutable state of the list of stripes, as seen by readers.
+	 * Shares the list with the track until the next modification.
+	 */
+	class Version: public QSharedData
+	{
+	public:
+	    /** Constructor */
+	    explicit Version(const QList<Kwave::Stripe> &stripes)
+		:QSharedData(), m_stripes(stripes)
+	    {
+	    }
+
+	    /** the stripes of this version */
+	    const QList<Kwave::Stripe> m_stripes;
+	};
+
+	/**
+	 * Returns the latest version of the list of stripes and keeps it
+	 * alive as long as the returned pointer exists. Only waits for a
+	 * writer if there is no valid version.
+	 * @return pointer to the version, null if out of memory
+	 */
+	QExplicitlySharedDataPointer<Version> pinVersion();
+
+	/**
+	 * Must be called before modifying the list of stripes. Drops the
+	 * current version if no reader uses it.
+	 * @note must be called with m_lock held
+	 */
+	void beginEdit();
+
+	/**
+	 * Must be called after modifying the list of stripes, updates the
+	 * length and invalidates the current version.
+	 * @note must be called with m_lock held
+	 */
+	void commitEdit();
+
+	/**
+	 * Collects the stripes of a list that are within a range of samples,
+	 * stripes that are only partially in the range get cropped.
+	 * @param list the list of stripes
+	 * @param left index of the first sample
+	 * @param right index of the last sample
+	 * @return list of stripes
+	 */
+	static Kwave::Stripe::List collectStripes(
+	    const QList<Kwave::Stripe> &list,
+	    sample_index_t left, sample_index_t right);
+
 	/**
 	 * Returns the current length of the stripe in samples. This
 	 * function uses no locks and is therefore reserved for internal
@@ -220,6 +333,24 @@ namespace Kwave
 	                 const Kwave::SampleArray &buffer,
 	                 unsigned int buf_offset, unsigned int length);
 
+	/**
+	 * Overwrites samples within existing stripes, without changing
+	 * the list of stripes. Only possible if the range is completely
+	 * covered by stripes, without any gaps.
+	 *
+	 * @param offset position of the first sample to overwrite
+	 * @param buffer array with samples
+	 * @param buf_offset offset within the buffer
+	 * @param length number of samples to write, must not be zero
+	 * @return true if done, false if not possible. The range is left
+	 *         unchanged if it is not covered, but might be partially
+	 *         overwritten if copying into a stripe failed.
+	 * @note this must be private, it does no locking !
+	 */
+	bool unlockedOverwrite(sample_index_t offset,
+	                       const Kwave::SampleArray &buffer,
+	                       unsigned int buf_offset, unsigned int length);
+
 	/**
 	 * Move all stripes after an offset to the right. Only looks at the
 	 * start position of the stripes, comparing with ">=", if the start
@@ -259,6 +390,23 @@ namespace Kwave
 	 */
 	bool mergeStripe(Kwave::Stripe &stripe);
 
+	/**
+	 * Returns the number of neighbour stripes that could be combined.
+	 * @note this must be private, it does no locking !
+	 */
+	unsigned int unlockedFragmentation();
+
+	/**
+	 * Checks whether two neighbour stripes should be combined, which
+	 * is the case if one of them is smaller than the minimum size and
+	 * the result would not be bigger than the maximum size
+	 * @param before the stripe on the left side
+	 * @param stripe the stripe on the right side
+	 * @return true if they should be combined
+	 */
+	static bool canCombine(const Kwave::Stripe &before,
+	                       const Kwave::Stripe &stripe);
+
 	/**
 	 * dump the list of stripes, for debugging
 	 * @internal for debugging only
@@ -267,6 +415,7 @@ namespace Kwave
 
     protected:
 
+	friend class Kwave::StripeCompactor;
 	friend class Kwave::TrackWriter;
 
 	/**
@@ -292,6 +441,16 @@ namespace Kwave
 	/** decrements the usage counter (read lock to m_lock_usage) */
 	void release();
 
+	/**
+	 * Combines small neighbour stripes, one pair at a time. Holds the
+	 * lock of the track only for one merge and gives up as soon as
+	 * the track is locked by someone else.
+	 * @param budget maximum time to spend [ms]
+	 * @return the remaining fragmentation score, zero if done or
+	 *         -1 if the track was busy
+	 */
+	int compactStep(int budget);
+
     private:
 
 	/**
@@ -317,6 +476,27 @@ namespace Kwave
 
 	/** unique ID */
 	QUuid m_uuid;
+
+	/** fragmentation score, as returned by fragmentation() */
+	QAtomicInt m_fragmentation;
+
+	/** position where the background compaction continues */
+	sample_index_t m_compact_position;
+
+	/** lock for the pointer to the current version, held only shortly */
+	QMutex m_lock_version;
+
+	/** the current version, or null if modified since the last read */
+	QExplicitlySharedDataPointer<Version> m_version;
+
+	/** length of the track after the last modification */
+	QAtomicInteger<sample_index_t> m_length;
+
+	/** changes from other threads, not yet delivered */
+	Kwave::ChangeJournal m_journal;
+
+	/** timer for limiting the rate of deliveries */
+	QTimer m_journal_timer;
     };
 }
 
@@ -20,6 +20,7 @@
 #include <QApplication>
 
 #include "libkwave/InsertMode.h"
+#include "libkwave/Profiler.h"
 #include "libkwave/Track.h"
 #include "libkwave/TrackWriter.h"
 #include "libkwave/Utils.h"
@@ -64,6 +65,8 @@ bool Kwave::TrackWriter::write(const Kwave::SampleArray &buffer,
 // 	   m_position, m_position + count - 1,
 // 	   m_position + count - m_first);
 
+    Kwave::ProfileScope profile("TrackWriter::write");
+    profile.setItems(count);
     if (!m_track.writeSamples(m_mode, m_position, buffer, 0, count)) {
 	count = 0;
 	return false; /* out of memory */
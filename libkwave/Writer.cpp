@@ -20,6 +20,9 @@
 
 #include <QObject>
 
+#include "libkwave/FloatArray.h"
+#include "libkwave/SampleArray.h"
+#include "libkwave/SampleConversion.h"
 #include "libkwave/SampleReader.h"
 #include "libkwave/Utils.h"
 #include "libkwave/Writer.h"
@@ -154,5 +157,37 @@ void Kwave::Writer::input(Kwave::SampleArray data)
     if (data.size()) (*this) << data;
 }
 
+//***************************************************************************
+void Kwave::Writer::input(Kwave::FloatArray data)
+{
+    const unsigned int count = data.size();
+    if (!count) return;
+
+    Kwave::SampleArray samples(count);
+    if (samples.size() != count) return; // OOM
+
+    // clip to the range of sample_t, float2sample() does not clip and
+    // would produce values out of the range of sample_t
+    const float *in = data.constData();
+    sample_t   *out = samples.data();
+    const float min = sample2float(SAMPLE_MIN);
+    const float max = sample2float(SAMPLE_MAX);
+    bool clipped = false;
+    for (unsigned int i = 0; i < count; i++) {
+	if (Q_UNLIKELY((in[i] < min) || (in[i] > max))) {
+	    clipped = true;
+	    break;
+	}
+    }
+    if (Q_UNLIKELY(clipped)) {
+	for (unsigned int i = 0; i < count; i++)
+	    out[i] = float2sample(qBound(min, in[i], max));
+    } else {
+	Kwave::floats2samples(in, out, count);
+    }
+
+    (*this) << samples;
+}
+
 //***************************************************************************
 //***************************************************************************
@@ -29,6 +29,7 @@
 
 namespace Kwave
 {
+    class FloatArray;
     class SampleArray;
     class SampleReader;
 
@@ -143,6 +144,14 @@ namespace Kwave
 	 */
 	void input(Kwave::SampleArray data);
 
+	/**
+	 * Interface for the float based streaming API. The data gets
+	 * clipped to the range of sample_t, this is the only place where
+	 * clipping occurs in a float based filter chain.
+	 * @param data sample data to write, in float representation
+	 */
+	void input(Kwave::FloatArray data);
+
     protected:
 
 	/** first sample */
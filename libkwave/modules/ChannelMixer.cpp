@@ -27,7 +27,7 @@
 #include <QObject>
 #include <QVarLengthArray>
 
-#include "libkwave/MixerMatrix.h"
+#include "libkwave/MixerEngine.h"
 #include "libkwave/Sample.h"
 #include "libkwave/Utils.h"
 #include "libkwave/modules/ChannelMixer.h"
@@ -37,7 +37,7 @@
 //***************************************************************************
 Kwave::ChannelMixer::ChannelMixer(unsigned int inputs, unsigned int outputs)
     :Kwave::SampleSource(),
-     m_matrix(Q_NULLPTR),
+     m_mixer(Q_NULLPTR),
      m_inputs(inputs),
      m_outputs(outputs),
      m_indexer(),
@@ -82,12 +82,11 @@ bool Kwave::ChannelMixer::init()
 	if (!ok) return false;
     }
 
-    // create the mixer matrix
-    // create a translation matrix for mixing up/down to the desired
+    // create a mixer engine for mixing up/down to the desired
     // number of output channels
-    m_matrix = new(std::nothrow) Kwave::MixerMatrix(m_inputs, m_outputs);
-    Q_ASSERT(m_matrix);
-    if (!m_matrix) return false;
+    m_mixer = new(std::nothrow) Kwave::MixerEngine(m_inputs, m_outputs);
+    Q_ASSERT(m_mixer);
+    if (!m_mixer) return false;
 
     // everything succeeded
     return true;
@@ -111,6 +110,9 @@ Kwave::ChannelMixer::~ChannelMixer()
 	if (buffer) delete buffer;
 	m_output_buffer.remove(0);
     }
+
+    if (m_mixer) delete m_mixer;
+    m_mixer = Q_NULLPTR;
 }
 
 //***************************************************************************
@@ -189,13 +191,13 @@ void Kwave::ChannelMixer::idxInput(unsigned int index, Kwave::SampleArray data)
     }
 
     // mix if we are ready
-    if (ready && m_matrix) mix();
+    if (ready && m_mixer) mix();
 }
 
 //***************************************************************************
 void Kwave::ChannelMixer::mix()
 {
-    Q_ASSERT(m_matrix);
+    Q_ASSERT(m_mixer);
 
     // all inputs should contain a buffer, dequeue them into a vector
     // and form an array of pointers to the raw data, for speeding up
@@ -237,20 +239,11 @@ void Kwave::ChannelMixer::mix()
 	output[track] = buffer->data().data();
     }
 
-    // mix all channels together, using the mixer matrix
-    for (unsigned int y = 0; y < m_outputs; y++) {
-	sample_t *out = output[y];
-	for (unsigned int pos = 0; pos < min_len; pos++) {
-	    double sum = 0.0;
-	    for (unsigned int x = 0; x < m_inputs; x++) {
-		const double f = (*m_matrix)[x][y];
-		const double i = static_cast<double>(input[x][pos]);
-		sum += (f * i);
-	    }
-	    out[pos] = static_cast<sample_t>(sum);
-	}
+    // mix all channels together, using the mixer engine
+    m_mixer->mix(input.constData(), output.constData(), min_len);
 
-	// emit the output
+    // emit the output
+    for (unsigned int y = 0; y < m_outputs; y++) {
 	Kwave::SampleBuffer *out_buf = m_output_buffer[y];
 	if (Q_UNLIKELY(out_buf->constData().size() > min_len)) {
 	    bool ok = out_buf->data().resize(min_len);
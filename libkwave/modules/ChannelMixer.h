@@ -36,7 +36,7 @@
 namespace Kwave
 {
 
-    class MixerMatrix;
+    class MixerEngine;
 
     class Q_DECL_EXPORT ChannelMixer: public Kwave::SampleSource
     {
@@ -109,8 +109,8 @@ namespace Kwave
 
 	private:
 
-	    /** mixer matrix */
-	    Kwave::MixerMatrix *m_matrix;
+	    /** mixer engine, built from the mixer matrix */
+	    Kwave::MixerEngine *m_mixer;
 
 	    /** number of inputs */
 	    unsigned int m_inputs;
@@ -15,6 +15,8 @@
  *                                                                         *
  ***************************************************************************/
 
+#include "libkwave/Interpolation.h"
+#include "libkwave/Utils.h"
 #include "libkwave/modules/CurveStreamAdapter.h"
 
 /***************************************************************************/
@@ -23,7 +25,8 @@ Kwave::CurveStreamAdapter::CurveStreamAdapter(Kwave::Curve &curve,
     :Kwave::SampleSource(),
      m_position(0), m_length(length),
      m_interpolation(curve.interpolation()),
-     m_buffer(blockSize())
+     m_buffer(blockSize()),
+     m_values(Kwave::toInt(blockSize()))
 {
 }
 
@@ -35,23 +38,39 @@ Kwave::CurveStreamAdapter::~CurveStreamAdapter()
 /***************************************************************************/
 void Kwave::CurveStreamAdapter::goOn()
 {
-    unsigned int offset;
-    double x_max = static_cast<double>(m_length);
+    const double x_max = static_cast<double>(m_length);
     const unsigned int samples = blockSize();
 
-    // fill with interpolated points
-    for (offset = 0; offset < samples; ++offset) {
+    if (m_values.size() < Kwave::toInt(samples))
+	m_values.resize(Kwave::toInt(samples));
+    if ((m_buffer.size() < samples) && !m_buffer.resize(samples))
+	return; // OOM ?
+    double *values = m_values.data();
+
+    // fill with interpolated points, block by block up to
+    // the next wrap-around
+    unsigned int offset = 0;
+    while (offset < samples) {
+	const sample_index_t rest = m_length - m_position + 1;
+	const unsigned int len = (rest < (samples - offset)) ?
+	    Kwave::toUint(rest) : (samples - offset);
+
 	// x is [0.0 ... 1.0]
 	const double x = static_cast<double>(m_position) / x_max;
-	const double y = m_interpolation.singleInterpolation(x);
-	m_buffer[offset] = double2sample(y);
-	m_position++;
+	m_interpolation.blockInterpolation(x, 1.0 / x_max,
+	                                   values + offset, len);
+	offset     += len;
+	m_position += len;
 
 	// wrap-around, for periodic signals
 	if (m_position > m_length)
 	    m_position = 0;
     }
 
+    sample_t *buffer = m_buffer.data();
+    for (offset = 0; offset < samples; ++offset)
+	buffer[offset] = double2sample(values[offset]);
+
     emit output(m_buffer);
 }
 
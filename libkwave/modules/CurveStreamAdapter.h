@@ -21,6 +21,7 @@
 #include "config.h"
 
 #include <QtGlobal>
+#include <QVector>
 
 #include "libkwave/Curve.h"
 #include "libkwave/SampleSource.h"
@@ -65,6 +66,9 @@ namespace Kwave
 	/** array with the interpolated curve data */
 	Kwave::SampleArray m_buffer;
 
+	/** interpolated curve data, before conversion to samples */
+	QVector<double> m_values;
+
     };
 
 }
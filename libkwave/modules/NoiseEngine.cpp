@@ -0,0 +1,356 @@
+/***************************************************************************
+        NoiseEngine.cpp  -  seekable block oriented noise generator
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "config.h"
+
+#include <math.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "libkwave/String.h"
+#include "libkwave/modules/NoiseEngine.h"
+
+/* constants of the Philox4x32 generator, see Salmon et al.,
+ * "Parallel Random Numbers: As Easy as 1, 2, 3", SC11 */
+#define PHILOX_M0     0xD2511F53U
+#define PHILOX_M1     0xCD9E8D57U
+#define PHILOX_W0     0x9E3779B9U
+#define PHILOX_W1     0xBB67AE85U
+#define PHILOX_ROUNDS 10
+
+/** scale for converting a signed 32 bit integer to [-1.0 ... +1.0] */
+#define NOISE_SCALE (1.0f / 2147483648.0f)
+
+/** number of samples that are summed up in one step, for pink and brown */
+#define NOISE_ENGINE_CHUNK 1024
+
+//***************************************************************************
+/**
+ * Philox4x32-10: converts a counter and a key into four random numbers
+ * @param ctr the counter, four 32 bit words
+ * @param key the key, two 32 bit words
+ * @param out receives four random 32 bit words
+ */
+static inline void philox(const quint32 *ctr, const quint32 *key,
+                          quint32 *out)
+{
+    quint32 x0 = ctr[0], x1 = ctr[1], x2 = ctr[2], x3 = ctr[3];
+    quint32 k0 = key[0], k1 = key[1];
+
+    for (unsigned int round = 0; round < PHILOX_ROUNDS; round++) {
+	const quint64 p0 = static_cast<quint64>(PHILOX_M0) * x0;
+	const quint64 p1 = static_cast<quint64>(PHILOX_M1) * x2;
+	const quint32 hi0 = static_cast<quint32>(p0 >> 32);
+	const quint32 lo0 = static_cast<quint32>(p0);
+	const quint32 hi1 = static_cast<quint32>(p1 >> 32);
+	const quint32 lo1 = static_cast<quint32>(p1);
+	x0 = hi1 ^ x1 ^ k0;
+	x1 = lo1;
+	x2 = hi0 ^ x3 ^ k1;
+	x3 = lo0;
+	k0 += PHILOX_W0;
+	k1 += PHILOX_W1;
+    }
+
+    out[0] = x0;
+    out[1] = x1;
+    out[2] = x2;
+    out[3] = x3;
+}
+
+#ifdef __SSE2__
+//***************************************************************************
+/** multiplies four 32 bit lanes with a constant, returns hi and lo words */
+static inline void mulhilo4(__m128i a, __m128i m, __m128i &hi, __m128i &lo)
+{
+    const __m128i even = _mm_mul_epu32(a, m);
+    const __m128i odd  = _mm_mul_epu32(_mm_srli_epi64(a, 32), m);
+    lo = _mm_unpacklo_epi32(
+	_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+	_mm_shuffle_epi32(odd,  _MM_SHUFFLE(0, 0, 2, 0)));
+    hi = _mm_unpacklo_epi32(
+	_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 3, 1)),
+	_mm_shuffle_epi32(odd,  _MM_SHUFFLE(0, 0, 3, 1)));
+}
+
+//***************************************************************************
+/**
+ * Philox4x32-10 for four consecutive counters in parallel, produces
+ * 16 random numbers, converted to float [-1.0 ... +1.0]
+ * @param block index of the first counter block
+ * @param stream third word of the counter
+ * @param row fourth word of the counter
+ * @param key the key, two 32 bit words
+ * @param out receives 16 floats, in the same order as the scalar version
+ */
+static inline void philox4(quint64 block, quint32 stream, quint32 row,
+                           const quint32 *key, float *out)
+{
+    const quint64 b0 = block, b1 = block + 1, b2 = block + 2, b3 = block + 3;
+    __m128i x0 = _mm_set_epi32(
+	static_cast<int>(b3), static_cast<int>(b2),
+	static_cast<int>(b1), static_cast<int>(b0));
+    __m128i x1 = _mm_set_epi32(
+	static_cast<int>(b3 >> 32), static_cast<int>(b2 >> 32),
+	static_cast<int>(b1 >> 32), static_cast<int>(b0 >> 32));
+    __m128i x2 = _mm_set1_epi32(static_cast<int>(stream));
+    __m128i x3 = _mm_set1_epi32(static_cast<int>(row));
+    __m128i k0 = _mm_set1_epi32(static_cast<int>(key[0]));
+    __m128i k1 = _mm_set1_epi32(static_cast<int>(key[1]));
+    const __m128i m0 = _mm_set1_epi32(static_cast<int>(PHILOX_M0));
+    const __m128i m1 = _mm_set1_epi32(static_cast<int>(PHILOX_M1));
+    const __m128i w0 = _mm_set1_epi32(static_cast<int>(PHILOX_W0));
+    const __m128i w1 = _mm_set1_epi32(static_cast<int>(PHILOX_W1));
+
+    for (unsigned int round = 0; round < PHILOX_ROUNDS; round++) {
+	__m128i hi0, lo0, hi1, lo1;
+	mulhilo4(x0, m0, hi0, lo0);
+	mulhilo4(x2, m1, hi1, lo1);
+	x0 = _mm_xor_si128(_mm_xor_si128(hi1, x1), k0);
+	x1 = lo1;
+	x2 = _mm_xor_si128(_mm_xor_si128(hi0, x3), k1);
+	x3 = lo0;
+	k0 = _mm_add_epi32(k0, w0);
+	k1 = _mm_add_epi32(k1, w1);
+    }
+
+    // convert to float and transpose, one counter block after the other
+    const __m128 scale = _mm_set1_ps(NOISE_SCALE);
+    __m128 f0 = _mm_mul_ps(_mm_cvtepi32_ps(x0), scale);
+    __m128 f1 = _mm_mul_ps(_mm_cvtepi32_ps(x1), scale);
+    __m128 f2 = _mm_mul_ps(_mm_cvtepi32_ps(x2), scale);
+    __m128 f3 = _mm_mul_ps(_mm_cvtepi32_ps(x3), scale);
+    _MM_TRANSPOSE4_PS(f0, f1, f2, f3);
+    _mm_storeu_ps(out,      f0);
+    _mm_storeu_ps(out + 4,  f1);
+    _mm_storeu_ps(out + 8,  f2);
+    _mm_storeu_ps(out + 12, f3);
+}
+#endif /* __SSE2__ */
+
+//***************************************************************************
+Kwave::NoiseEngine::NoiseEngine(quint64 seed, quint32 stream,
+                                Spectrum spectrum)
+    :m_seed(seed), m_stream(stream), m_spectrum(spectrum), m_position(0)
+{
+}
+
+//***************************************************************************
+Kwave::NoiseEngine::~NoiseEngine()
+{
+}
+
+//***************************************************************************
+void Kwave::NoiseEngine::setSeed(quint64 seed)
+{
+    m_seed = seed;
+}
+
+//***************************************************************************
+void Kwave::NoiseEngine::setStream(quint32 stream)
+{
+    m_stream = stream;
+}
+
+//***************************************************************************
+void Kwave::NoiseEngine::setSpectrum(Spectrum spectrum)
+{
+    m_spectrum = spectrum;
+}
+
+//***************************************************************************
+void Kwave::NoiseEngine::seek(quint64 position)
+{
+    m_position = position;
+}
+
+//***************************************************************************
+void Kwave::NoiseEngine::generate(float *out, unsigned int len)
+{
+    Q_ASSERT(out);
+    if (!out || !len) return;
+
+    switch (m_spectrum) {
+	case Pink:
+	    generateRows(out, len, false);
+	    break;
+	case Brown:
+	    generateRows(out, len, true);
+	    break;
+	default:
+	    generateWhite(out, len);
+	    break;
+    }
+
+    m_position += len;
+}
+
+//***************************************************************************
+void Kwave::NoiseEngine::generateWhite(float *out, unsigned int len)
+{
+    randomValues(0, m_position, out, len);
+}
+
+//***************************************************************************
+void Kwave::NoiseEngine::randomValues(quint32 row, quint64 pos,
+                                      float *out, unsigned int len)
+{
+    const quint32 key[2] = {
+	static_cast<quint32>(m_seed),
+	static_cast<quint32>(m_seed >> 32)
+    };
+    quint32 ctr[4];
+    quint32 rnd[4];
+
+    // unaligned start, use only a part of the first block
+    while (len && (pos & 3)) {
+	const quint64 block = pos >> 2;
+	ctr[0] = static_cast<quint32>(block);
+	ctr[1] = static_cast<quint32>(block >> 32);
+	ctr[2] = m_stream;
+	ctr[3] = row;
+	philox(ctr, key, rnd);
+	*(out++) = static_cast<qint32>(rnd[pos & 3]) * NOISE_SCALE;
+	pos++;
+	len--;
+    }
+
+#ifdef __SSE2__
+    // four blocks of four random numbers each in parallel
+    while (len >= 16) {
+	philox4(pos >> 2, m_stream, row, key, out);
+	out += 16;
+	pos += 16;
+	len -= 16;
+    }
+#endif
+
+    // remaining blocks
+    while (len) {
+	const quint64 block = pos >> 2;
+	ctr[0] = static_cast<quint32>(block);
+	ctr[1] = static_cast<quint32>(block >> 32);
+	ctr[2] = m_stream;
+	ctr[3] = row;
+	philox(ctr, key, rnd);
+	for (unsigned int i = 0; (i < 4) && len; i++, len--, pos++)
+	    *(out++) = static_cast<qint32>(rnd[i]) * NOISE_SCALE;
+    }
+}
+
+//***************************************************************************
+void Kwave::NoiseEngine::generateRows(float *out, unsigned int len,
+                                      bool interpolate)
+{
+    generateWhite(out, len);
+
+    // weights of the rows: equal for pink noise, increasing by 3dB per
+    // octave for brown noise
+    double weight[NOISE_ENGINE_ROWS + 1];
+    double total = 1.0;
+    for (unsigned int k = 1; k <= NOISE_ENGINE_ROWS; k++) {
+	weight[k] = (interpolate) ? pow(2.0, 0.5 * k) : 1.0;
+	total += weight[k];
+    }
+    const double scale = 1.0 / total;
+
+    // The sum of all rows >= k only changes every 2^k samples (pink) or
+    // is linear between multiples of 2^k (brown). So it is calculated
+    // from the highest row down to the lowest one, on a grid that gets
+    // twice as fine with each row. Each grid value is a function of
+    // it's absolute index only, so the result does not depend on the
+    // block boundaries.
+    const unsigned int grid_size = (NOISE_ENGINE_CHUNK / 2) + 4;
+    double grid_a[grid_size];
+    double grid_b[grid_size];
+    float  row[grid_size];
+    for (unsigned int offset = 0; offset < len; offset += NOISE_ENGINE_CHUNK) {
+	const unsigned int count = qMin(len - offset,
+	    static_cast<unsigned int>(NOISE_ENGINE_CHUNK));
+	const quint64 n    = m_position + offset;
+	const unsigned int extra = (interpolate) ? 1 : 0;
+
+	double *coarse = grid_a;
+	double *fine   = grid_b;
+	quint64 coarse_first = 0;
+	for (unsigned int k = NOISE_ENGINE_ROWS; k >= 1; k--) {
+	    const quint64 first = n >> k;
+	    const unsigned int values = static_cast<unsigned int>(
+		((n + count - 1) >> k) - first) + 1 + extra;
+	    randomValues(k, first, row, values);
+
+	    for (unsigned int v = 0; v < values; v++) {
+		const quint64 j = first + v;
+		double sum = weight[k] * row[v];
+		if (k < NOISE_ENGINE_ROWS) {
+		    const unsigned int c = static_cast<unsigned int>(
+			(j >> 1) - coarse_first);
+		    if (interpolate && (j & 1))
+			sum += 0.5 * (coarse[c] + coarse[c + 1]);
+		    else
+			sum += coarse[c];
+		}
+		fine[v] = sum;
+	    }
+
+	    double *t = coarse;
+	    coarse = fine;
+	    fine   = t;
+	    coarse_first = first;
+	}
+
+	// add the finest grid to the white noise
+	for (unsigned int i = 0; i < count; i++) {
+	    const quint64 m = n + i;
+	    const unsigned int c = static_cast<unsigned int>(
+		(m >> 1) - coarse_first);
+	    double sum = out[offset + i];
+	    if (interpolate && (m & 1))
+		sum += 0.5 * (coarse[c] + coarse[c + 1]);
+	    else
+		sum += coarse[c];
+	    out[offset + i] = static_cast<float>(sum * scale);
+	}
+    }
+}
+
+//***************************************************************************
+Kwave::NoiseEngine::Spectrum Kwave::NoiseEngine::spectrumFromName(
+    const QString &name, bool *ok)
+{
+    if (ok) *ok = true;
+    if (name == _("white")) return White;
+    if (name == _("pink"))  return Pink;
+    if (name == _("brown")) return Brown;
+    if (ok) *ok = false;
+    return White;
+}
+
+//***************************************************************************
+QString Kwave::NoiseEngine::spectrumName(Spectrum spectrum)
+{
+    switch (spectrum) {
+	case Pink:  return _("pink");
+	case Brown: return _("brown");
+	default:    return _("white");
+    }
+}
+
+//***************************************************************************
+//***************************************************************************
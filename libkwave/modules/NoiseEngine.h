@@ -0,0 +1,155 @@
+/***************************************************************************
+          NoiseEngine.h  -  seekable block oriented noise generator
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef NOISE_ENGINE_H
+#define NOISE_ENGINE_H
+
+#include "config.h"
+
+#include <QtGlobal>
+#include <QString>
+
+/** number of octave rows for pink and brown noise */
+#define NOISE_ENGINE_ROWS 16
+
+namespace Kwave
+{
+
+    /**
+     * Noise generator on float data, based on the counter based random
+     * number generator "Philox4x32-10". Every random number is a pure
+     * function of (seed, stream, position), so the generator can be
+     * positioned anywhere within the signal without any costs, and long
+     * signals can be filled in parallel in several segments with exactly
+     * the same result as in one pass.
+     *
+     * The pink and brown spectra are produced without any filter state:
+     * pink noise by the Voss-McCartney algorithm (sum of random rows that
+     * are held for 2^k samples) and brown noise by a weighted sum of
+     * linear interpolated rows, with a weight that increases by 3dB per
+     * octave. The peak value of all spectra is within [-1.0 ... +1.0].
+     */
+    class Q_DECL_EXPORT NoiseEngine
+    {
+    public:
+
+	/** spectrum of the noise */
+	typedef enum {
+	    White = 0, /**< flat spectrum               */
+	    Pink  = 1, /**< -3dB per octave, 1/f        */
+	    Brown = 2  /**< -6dB per octave, 1/f^2      */
+	} Spectrum;
+
+	/**
+	 * Constructor
+	 * @param seed the seed of the random numbers
+	 * @param stream index of an independent stream, e.g. the track
+	 * @param spectrum the spectrum, see Spectrum
+	 */
+	NoiseEngine(quint64 seed = 0, quint32 stream = 0,
+	            Spectrum spectrum = White);
+
+	/** Destructor */
+	virtual ~NoiseEngine();
+
+	/** sets a new seed, does not change the position */
+	void setSeed(quint64 seed);
+
+	/** sets a new stream index, does not change the position */
+	void setStream(quint32 stream);
+
+	/** sets a new spectrum */
+	void setSpectrum(Spectrum spectrum);
+
+	/** returns the current spectrum */
+	inline Spectrum spectrum() const { return m_spectrum; }
+
+	/**
+	 * Sets the position of the next generated sample
+	 * @param position index of the sample
+	 */
+	void seek(quint64 position);
+
+	/** returns the position of the next generated sample */
+	inline quint64 position() const { return m_position; }
+
+	/**
+	 * Generates a block of noise, in the range [-1.0 ... +1.0]
+	 * @param out receives the noise
+	 * @param len number of samples to generate
+	 */
+	void generate(float *out, unsigned int len);
+
+	/**
+	 * Returns the spectrum that corresponds to a name:
+	 * "white", "pink" or "brown"
+	 * @param name the name of the spectrum
+	 * @param ok receives true if the name was valid
+	 */
+	static Spectrum spectrumFromName(const QString &name, bool *ok);
+
+	/** returns the (non-localized) name of a spectrum */
+	static QString spectrumName(Spectrum spectrum);
+
+    private:
+
+	/** generates white noise */
+	void generateWhite(float *out, unsigned int len);
+
+	/**
+	 * Generates pink or brown noise, as sum of white noise
+	 * and the octave rows
+	 * @param out receives the noise
+	 * @param len number of samples to generate
+	 * @param interpolate if false, hold the values of the rows
+	 *                    (pink noise), otherwise interpolate linearly
+	 *                    between them (brown noise)
+	 */
+	void generateRows(float *out, unsigned int len, bool interpolate);
+
+	/**
+	 * Produces random values, converted to float [-1.0 ... +1.0]
+	 * @param row index of the row, zero for the white noise and
+	 *            [1 ... NOISE_ENGINE_ROWS] for the octave rows
+	 * @param pos index of the first value within the row
+	 * @param out receives the random values
+	 * @param len number of values
+	 */
+	void randomValues(quint32 row, quint64 pos,
+	                  float *out, unsigned int len);
+
+    private:
+
+	/** seed of the random numbers */
+	quint64 m_seed;
+
+	/** index of the stream */
+	quint32 m_stream;
+
+	/** spectrum */
+	Spectrum m_spectrum;
+
+	/** position of the next sample */
+	quint64 m_position;
+
+    };
+}
+
+#endif /* NOISE_ENGINE_H */
+
+//***************************************************************************
+//***************************************************************************
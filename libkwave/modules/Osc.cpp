@@ -17,15 +17,17 @@
 
 #include "config.h"
 
-#include <math.h>
-
+#include "libkwave/SampleConversion.h"
+#include "libkwave/Utils.h"
 #include "libkwave/modules/Osc.h"
 
 //***************************************************************************
 Kwave::Osc::Osc()
     :Kwave::SampleSource(),
-    m_buffer(blockSize()), m_omega_t(0.0), m_f(44.1), m_a(1.0)
+    m_buffer(blockSize()), m_float_buffer(Kwave::toInt(blockSize())),
+    m_oscillator(Kwave::Oscillator::Sine)
 {
+    m_oscillator.setFrequency(1.0 / 44.1);
 }
 
 //***************************************************************************
@@ -36,24 +38,14 @@ Kwave::Osc::~Osc()
 //***************************************************************************
 void Kwave::Osc::goOn()
 {
-    unsigned int samples = m_buffer.size();
-    const double two_pi = 2.0 * M_PI;
-
-    Q_ASSERT(!qFuzzyIsNull(m_f));
-    if (qFuzzyIsNull(m_f)) return;
+    const unsigned int samples = m_buffer.size();
 
-    double omega = two_pi / m_f;
-    for (unsigned int sample = 0; sample < samples; sample++) {
-	// calculate one sample as sin(w * t)
-	m_buffer[sample] = double2sample(m_a * sin(m_omega_t));
+    Q_ASSERT(m_float_buffer.size() >= Kwave::toInt(samples));
+    if (m_float_buffer.size() < Kwave::toInt(samples)) return;
 
-	// next time, t++
-	m_omega_t += omega;
-
-	// limit the argument of sin() to [0 ... 4*Pi]
-	while (m_omega_t > two_pi)
-	    m_omega_t -= two_pi;
-    }
+    m_oscillator.generate(m_float_buffer.data(), samples);
+    Kwave::floats2samples(m_float_buffer.constData(), m_buffer.data(),
+                          samples);
 
     emit output(m_buffer);
 }
@@ -61,19 +53,29 @@ void Kwave::Osc::goOn()
 //***************************************************************************
 void Kwave::Osc::setFrequency(const QVariant &f)
 {
-    m_f = QVariant(f).toDouble();
+    const double f_samples = QVariant(f).toDouble();
+    Q_ASSERT(!qFuzzyIsNull(f_samples));
+    if (qFuzzyIsNull(f_samples)) return;
+    m_oscillator.setFrequency(1.0 / f_samples);
 }
 
 //***************************************************************************
 void Kwave::Osc::setPhase(const QVariant &p)
 {
-    m_omega_t = QVariant(p).toDouble();
+    m_oscillator.setPhase(QVariant(p).toDouble());
 }
 
 //***************************************************************************
 void Kwave::Osc::setAmplitude(const QVariant &a)
 {
-    m_a = QVariant(a).toDouble();
+    m_oscillator.setAmplitude(QVariant(a).toDouble());
+}
+
+//***************************************************************************
+void Kwave::Osc::setWaveform(const QVariant &w)
+{
+    m_oscillator.setWaveform(
+	static_cast<Kwave::Oscillator::Waveform>(QVariant(w).toInt()));
 }
 
 //***************************************************************************
@@ -23,8 +23,10 @@
 #include <QtGlobal>
 #include <QObject>
 #include <QVariant>
+#include <QVector>
 
 #include "libkwave/SampleSource.h"
+#include "libkwave/modules/Oscillator.h"
 
 namespace Kwave
 {
@@ -67,19 +69,22 @@ namespace Kwave
 	     */
 	    void setAmplitude(const QVariant &a);
 
+	    /**
+	     * Sets the waveform, as integer value of
+	     * Kwave::Oscillator::Waveform. The default is a sine wave.
+	     */
+	    void setWaveform(const QVariant &w);
+
 	private:
 
 	    /** buffer for output data */
 	    Kwave::SampleArray m_buffer;
 
-	    /** current time multiplied by 2*Pi*f */
-	    double m_omega_t;
-
-	    /** frequency [samples/period] */
-	    double m_f;
+	    /** buffer for the output of the oscillator */
+	    QVector<float> m_float_buffer;
 
-	    /** amplitude [0...1] */
-	    double m_a;
+	    /** the oscillator that does the work */
+	    Kwave::Oscillator m_oscillator;
     };
 }
 
@@ -0,0 +1,304 @@
+/***************************************************************************
+         Oscillator.cpp  -  block oriented tone generator
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "config.h"
+
+#include <math.h>
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVector>
+
+#include "libkwave/String.h"
+#include "libkwave/modules/Oscillator.h"
+
+/** number of bits of the wavetable index */
+#define OSC_TABLE_BITS 12
+
+/** number of points per wavetable */
+#define OSC_TABLE_SIZE (1 << OSC_TABLE_BITS)
+
+/** number of band-limited tables per waveform, up to 1024 harmonics */
+#define OSC_LEVELS 11
+
+/** number of waveforms */
+#define OSC_WAVEFORMS 4
+
+/**
+ * maximum number of samples generated in one step, limits the
+ * accumulated error of the quadrature oscillators
+ */
+#define OSC_BLOCK_SIZE 256
+
+/** number of quadrature oscillators that run in parallel */
+#define OSC_LANES 4
+
+//***************************************************************************
+/** stores or adds a value to the output, depending on ADD */
+template <bool ADD> static inline void put(float &out, double value)
+{
+    if (ADD)
+	out += static_cast<float>(value);
+    else
+	out  = static_cast<float>(value);
+}
+
+//***************************************************************************
+Kwave::Oscillator::Oscillator(Waveform waveform)
+    :m_waveform(waveform), m_phase(0.0), m_inc(0.0), m_amplitude(1.0),
+     m_sweep_step(0.0), m_sweep_end(0.0), m_sweep_rest(0)
+{
+}
+
+//***************************************************************************
+Kwave::Oscillator::~Oscillator()
+{
+}
+
+//***************************************************************************
+void Kwave::Oscillator::setWaveform(Waveform waveform)
+{
+    m_waveform = waveform;
+}
+
+//***************************************************************************
+void Kwave::Oscillator::setFrequency(double f)
+{
+    m_inc        = qBound(0.0, f, 0.5);
+    m_sweep_rest = 0;
+    m_sweep_step = 0.0;
+}
+
+//***************************************************************************
+void Kwave::Oscillator::setPhase(double phase)
+{
+    m_phase = phase / (2.0 * M_PI);
+    m_phase -= floor(m_phase);
+}
+
+//***************************************************************************
+double Kwave::Oscillator::phase() const
+{
+    return m_phase * 2.0 * M_PI;
+}
+
+//***************************************************************************
+void Kwave::Oscillator::setAmplitude(double a)
+{
+    m_amplitude = a;
+}
+
+//***************************************************************************
+void Kwave::Oscillator::sweepTo(double f, quint64 length)
+{
+    f = qBound(0.0, f, 0.5);
+    if (!length) {
+	setFrequency(f);
+	return;
+    }
+    m_sweep_end  = f;
+    m_sweep_rest = length;
+    m_sweep_step = (f - m_inc) / static_cast<double>(length);
+}
+
+//***************************************************************************
+void Kwave::Oscillator::generate(float *out, unsigned int len, bool add)
+{
+    Q_ASSERT(out);
+    if (!out) return;
+
+    while (len) {
+	unsigned int n = qMin(len, static_cast<unsigned int>(OSC_BLOCK_SIZE));
+	if (m_sweep_rest && (n > m_sweep_rest))
+	    n = static_cast<unsigned int>(m_sweep_rest);
+
+	if ((m_waveform == Sine) && !m_sweep_rest) {
+	    if (add) generateSine<true>(out, n);
+	    else     generateSine<false>(out, n);
+	} else {
+	    if (add) generateTable<true>(out, n);
+	    else     generateTable<false>(out, n);
+	}
+
+	out += n;
+	len -= n;
+    }
+}
+
+//***************************************************************************
+template <bool ADD>
+void Kwave::Oscillator::generateSine(float *out, unsigned int len)
+{
+    const double w = 2.0 * M_PI * m_inc;
+    const double a = m_amplitude;
+
+    // start the oscillators at the exact phase of the first samples
+    double re[OSC_LANES];
+    double im[OSC_LANES];
+    for (unsigned int k = 0; k < OSC_LANES; k++) {
+	const double arg = (2.0 * M_PI * m_phase) + (k * w);
+	re[k] = a * cos(arg);
+	im[k] = a * sin(arg);
+    }
+
+    // each oscillator advances by OSC_LANES samples per step
+    const double c = cos(OSC_LANES * w);
+    const double s = sin(OSC_LANES * w);
+
+    unsigned int i = 0;
+    for (; i + OSC_LANES <= len; i += OSC_LANES) {
+	for (unsigned int k = 0; k < OSC_LANES; k++)
+	    put<ADD>(out[i + k], im[k]);
+	for (unsigned int k = 0; k < OSC_LANES; k++) {
+	    const double r = (re[k] * c) - (im[k] * s);
+	    im[k] = (re[k] * s) + (im[k] * c);
+	    re[k] = r;
+	}
+    }
+    for (unsigned int k = 0; i < len; i++, k++)
+	put<ADD>(out[i], im[k]);
+
+    m_phase += static_cast<double>(len) * m_inc;
+    m_phase -= floor(m_phase);
+}
+
+//***************************************************************************
+template <bool ADD>
+void Kwave::Oscillator::generateTable(float *out, unsigned int len)
+{
+    // choose the table with the most harmonics below the Nyquist
+    // frequency, for the highest frequency within this block
+    double inc_max = m_inc;
+    if (m_sweep_rest)
+	inc_max = qMax(inc_max, m_inc + (len * m_sweep_step));
+    unsigned int level = OSC_LEVELS - 1;
+    if (inc_max > 0.0) {
+	const double harmonics = 0.5 / inc_max;
+	level = 0;
+	while ((level < OSC_LEVELS - 1) &&
+	       (static_cast<double>(1U << (level + 1)) <= harmonics))
+	    level++;
+    }
+
+    const float *t = table(m_waveform, level);
+    if (!t) return; // OOM ?
+
+    const double a    = m_amplitude;
+    const double step = m_sweep_rest ? m_sweep_step : 0.0;
+    double phase      = m_phase;
+    double inc        = m_inc;
+    for (unsigned int i = 0; i < len; i++) {
+	const double       pos  = phase * OSC_TABLE_SIZE;
+	const unsigned int idx  = static_cast<unsigned int>(pos);
+	const double       frac = pos - idx;
+	const double       v    = t[idx] + (frac * (t[idx + 1] - t[idx]));
+	put<ADD>(out[i], a * v);
+
+	phase += inc;
+	if (phase >= 1.0) phase -= 1.0;
+	if (phase <  0.0) phase += 1.0;
+	inc += step;
+    }
+    m_phase = phase;
+
+    if (m_sweep_rest) {
+	m_sweep_rest -= len;
+	m_inc = (m_sweep_rest) ? inc : m_sweep_end;
+    }
+}
+
+//***************************************************************************
+const float *Kwave::Oscillator::table(Waveform waveform, unsigned int level)
+{
+    static QMutex lock;
+    static QVector<float> tables[OSC_WAVEFORMS][OSC_LEVELS];
+
+    if (waveform == Sine) level = 0;
+    Q_ASSERT(level < OSC_LEVELS);
+    if (level >= OSC_LEVELS) return Q_NULLPTR;
+
+    QMutexLocker _lock(&lock);
+
+    QVector<float> &t = tables[waveform][level];
+    if (!t.isEmpty()) return t.constData();
+
+    t.resize(OSC_TABLE_SIZE + 1);
+    if (t.size() != OSC_TABLE_SIZE + 1) return Q_NULLPTR;
+
+    // additive synthesis, with sin(k * x) from the recurrence
+    // sin((k + 1) * x) = 2 * cos(x) * sin(k * x) - sin((k - 1) * x)
+    const unsigned int harmonics = (waveform == Sine) ? 1 : (1U << level);
+    double max = 0.0;
+    for (unsigned int i = 0; i < OSC_TABLE_SIZE; i++) {
+	const double x  = (2.0 * M_PI * i) / OSC_TABLE_SIZE;
+	const double c2 = 2.0 * cos(x);
+	double s_prev   = 0.0;
+	double s        = sin(x);
+	double y        = 0.0;
+	for (unsigned int k = 1; k <= harmonics; k++) {
+	    double coeff = 0.0;
+	    switch (waveform) {
+		case Sine:
+		    coeff = 1.0;
+		    break;
+		case Square:
+		    if (k & 1) coeff = 1.0 / k;
+		    break;
+		case Sawtooth:
+		    coeff = ((k & 1) ? 1.0 : -1.0) / k;
+		    break;
+		case Triangle:
+		    if (k & 1)
+			coeff = ((k & 2) ? -1.0 : 1.0) /
+			        (static_cast<double>(k) * k);
+		    break;
+	    }
+	    y += coeff * s;
+
+	    const double s_next = (c2 * s) - s_prev;
+	    s_prev = s;
+	    s      = s_next;
+	}
+	t[i] = static_cast<float>(y);
+	max  = qMax(max, fabs(y));
+    }
+
+    // normalize to a peak value of 1.0, including the Gibbs overshoot
+    if (max > 0.0) {
+	for (unsigned int i = 0; i < OSC_TABLE_SIZE; i++)
+	    t[i] = static_cast<float>(t[i] / max);
+    }
+    t[OSC_TABLE_SIZE] = t[0]; // guard point for the interpolation
+
+    return t.constData();
+}
+
+//***************************************************************************
+Kwave::Oscillator::Waveform Kwave::Oscillator::waveformFromName(
+    const QString &name, bool *ok)
+{
+    if (ok) *ok = true;
+    if (name == _("sine"))     return Sine;
+    if (name == _("square"))   return Square;
+    if (name == _("sawtooth")) return Sawtooth;
+    if (name == _("triangle")) return Triangle;
+    if (ok) *ok = false;
+    return Sine;
+}
+
+//***************************************************************************
+//***************************************************************************
@@ -0,0 +1,169 @@
+/***************************************************************************
+           Oscillator.h  -  block oriented tone generator
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef OSCILLATOR_H
+#define OSCILLATOR_H
+
+#include "config.h"
+
+#include <QtGlobal>
+#include <QString>
+
+namespace Kwave
+{
+
+    /**
+     * Single channel tone generator on float data, without any
+     * Qt signal/slot overhead. Works with a phase accumulator, so that
+     * changes of frequency and waveform are phase continuous.
+     *
+     * Sine waves with constant frequency are generated by a set of
+     * recursive quadrature oscillators that run in parallel and are
+     * re-synchronized to the phase accumulator for each block. All other
+     * waveforms and frequency sweeps use band-limited wavetables, with
+     * one table per octave, so that no harmonics above the Nyquist
+     * frequency are produced.
+     *
+     * A multi-tone signal can be generated by summing up the output of
+     * several oscillators, see generate().
+     */
+    class Q_DECL_EXPORT Oscillator
+    {
+    public:
+
+	/** waveform of the oscillator */
+	typedef enum {
+	    Sine     = 0, /**< sine wave                     */
+	    Square   = 1, /**< band-limited square wave      */
+	    Sawtooth = 2, /**< band-limited rising sawtooth  */
+	    Triangle = 3  /**< band-limited triangle wave    */
+	} Waveform;
+
+	/**
+	 * Constructor
+	 * @param waveform the initial waveform, see Waveform
+	 */
+	explicit Oscillator(Waveform waveform = Sine);
+
+	/** Destructor */
+	virtual ~Oscillator();
+
+	/** returns the current waveform */
+	inline Waveform waveform() const { return m_waveform; }
+
+	/** sets a new waveform, phase continuous */
+	void setWaveform(Waveform waveform);
+
+	/**
+	 * Sets the frequency, normed to the sample rate, in the range
+	 * [0.0 ... 0.5]. Stops a running sweep.
+	 * @param f frequency / sample rate
+	 */
+	void setFrequency(double f);
+
+	/** returns the current frequency, normed to the sample rate */
+	inline double frequency() const { return m_inc; }
+
+	/**
+	 * Sets the phase
+	 * @param phase the new phase in RAD [0...2*Pi]
+	 */
+	void setPhase(double phase);
+
+	/** returns the current phase in RAD [0...2*Pi] */
+	double phase() const;
+
+	/**
+	 * Sets the amplitude, normed to the range of [0.0 ... 1.0]
+	 * @param a the new amplitude
+	 */
+	void setAmplitude(double a);
+
+	/**
+	 * Starts a linear frequency sweep from the current frequency
+	 * to a new frequency. After the sweep the frequency stays at
+	 * the end frequency.
+	 * @param f the end frequency, normed to the sample rate
+	 * @param length duration of the sweep in samples
+	 */
+	void sweepTo(double f, quint64 length);
+
+	/**
+	 * Generates a block of samples
+	 * @param out receives the generated samples
+	 * @param len number of samples to generate
+	 * @param add if true, the generated samples are added to the
+	 *            content of the output buffer instead of overwriting it
+	 */
+	void generate(float *out, unsigned int len, bool add = false);
+
+	/**
+	 * Returns the waveform that corresponds to a name: "sine",
+	 * "square", "sawtooth" or "triangle"
+	 * @param name the name of the waveform
+	 * @param ok receives true if the name was valid
+	 */
+	static Waveform waveformFromName(const QString &name, bool *ok);
+
+    private:
+
+	/** generates a sine wave with the quadrature oscillators */
+	template <bool ADD> void generateSine(float *out, unsigned int len);
+
+	/** generates a waveform through the wavetables */
+	template <bool ADD> void generateTable(float *out, unsigned int len);
+
+	/**
+	 * Returns a band-limited wavetable, creates it on first use
+	 * @param waveform the waveform, see Waveform
+	 * @param level the index of the table, the table contains
+	 *              2^level harmonics (not used for sine)
+	 * @return pointer to the table, with one guard point
+	 *         at the end, or null if out of memory
+	 */
+	static const float *table(Waveform waveform, unsigned int level);
+
+    private:
+
+	/** current waveform */
+	Waveform m_waveform;
+
+	/** current phase, in periods [0 ... 1.0[ */
+	double m_phase;
+
+	/** phase increment per sample = frequency / sample rate */
+	double m_inc;
+
+	/** amplitude [0 ... 1.0] */
+	double m_amplitude;
+
+	/** change of m_inc per sample while sweeping */
+	double m_sweep_step;
+
+	/** end frequency of the sweep */
+	double m_sweep_end;
+
+	/** remaining number of samples of a sweep */
+	quint64 m_sweep_rest;
+
+    };
+}
+
+#endif /* OSCILLATOR_H */
+
+//***************************************************************************
+//***************************************************************************
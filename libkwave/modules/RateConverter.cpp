@@ -17,27 +17,25 @@
 
 #include "config.h"
 
-#include <math.h>
+#include <new>
 
+#include "libkwave/SampleConversion.h"
 #include "libkwave/Utils.h"
+#include "libkwave/memcpy.h"
 #include "libkwave/modules/RateConverter.h"
 
 //***************************************************************************
 Kwave::RateConverter::RateConverter()
-    :Kwave::SampleSource(), m_ratio(1.0), m_converter(Q_NULLPTR),
-     m_converter_in(), m_converter_out()
+    :Kwave::SampleSource(), m_ratio(1.0),
+     m_quality(Kwave::Resampler::Medium), m_converter(Q_NULLPTR),
+     m_converter_in(), m_converter_out(), m_samples_out(), m_floats_out()
 {
-    int error = 0;
-    m_converter = src_new(SRC_SINC_MEDIUM_QUALITY, 1, &error);
-    Q_ASSERT(m_converter);
-    if (!m_converter) qWarning("creating converter failed: '%s",
-	src_strerror(error));
 }
 
 //***************************************************************************
 Kwave::RateConverter::~RateConverter()
 {
-    if (m_converter) src_delete(m_converter);
+    delete m_converter;
 }
 
 //***************************************************************************
@@ -50,86 +48,131 @@ void Kwave::RateConverter::input(Kwave::SampleArray data)
 {
     // shortcut for ratio == 1:1
     if ((m_ratio == 1.0) || data.isEmpty()) {
-	emit output(data);
+	emitOutput(data, Kwave::FloatArray());
 	return;
     }
 
-    // normal processing
-    Kwave::SampleArray samples_out;
+    // convert the input buffer into an array of floats
     const unsigned int in_len = data.size();
+    m_converter_in.resize(Kwave::toInt(in_len));
+    Kwave::samples2floats(data.constData(), m_converter_in.data(), in_len);
 
-    // convert the input buffer into an array of floats
-    m_converter_in.resize(in_len);
-    float          *f_in = m_converter_in.data();
-    const sample_t *s_in = data.constData();
-    Q_ASSERT(f_in);
-    Q_ASSERT(s_in);
-
-    // work blockwise to allow loop unrolling
-    unsigned int remaining = in_len;
-    const unsigned int block_size = 16;
-    while (remaining >= block_size) {
-	for (unsigned int i = 0; i < block_size; i++)
-	    f_in[i] = sample2float(s_in[i]);
-	f_in      += block_size;
-	s_in      += block_size;
-	remaining -= block_size;
+    convert(m_converter_in.constData(), in_len, false);
+}
+
+//***************************************************************************
+void Kwave::RateConverter::input(Kwave::FloatArray data)
+{
+    // shortcut for ratio == 1:1
+    if ((m_ratio == 1.0) || data.isEmpty()) {
+	emitOutput(Kwave::SampleArray(), data);
+	return;
+    }
+
+    convert(data.constData(), data.size(), false);
+}
+
+//***************************************************************************
+void Kwave::RateConverter::finished()
+{
+    // nothing to flush if nothing has been converted yet
+    if (!m_converter) return;
+
+    convert(Q_NULLPTR, 0, true);
+
+    // start over with a fresh converter for the next stream
+    delete m_converter;
+    m_converter = Q_NULLPTR;
+}
+
+//***************************************************************************
+void Kwave::RateConverter::convert(const float *in, unsigned int len,
+                                   bool last)
+{
+    // create the converter on demand, after ratio and quality are known
+    if (!m_converter) {
+	m_converter = new(std::nothrow) Kwave::Resampler(m_quality, m_ratio);
+	Q_ASSERT(m_converter);
+	if (m_converter && !m_converter->isOk()) {
+	    delete m_converter;
+	    m_converter = Q_NULLPTR;
+	}
+	if (!m_converter) return;
     }
-    for (; remaining; remaining--)
-	(*f_in++) = sample2float(*(s_in++));
-
-    // prepare the output buffer (estimated size, rounded up)
-    // worst case would be factor 2, which means that there was a 100%
-    // leftover remaining from the previous pass
-    // just for safety we limit the extra output space to some
-    // (hopefully) reasonable range between 4096 and 16384
-    const unsigned int out_len = Kwave::toUint(
-	ceil(static_cast<double>(in_len) * m_ratio)
-    );
-    const unsigned int extra = qBound<unsigned int>(4096, out_len, 16384);
-    m_converter_out.resize(out_len + extra);
-
-    // set up the sample rate converter input
-    SRC_DATA src;
-    src.data_in           = m_converter_in.data();
-    src.data_out          = m_converter_out.data();
-    src.input_frames      = in_len;
-    src.output_frames     = out_len + extra;
-    src.input_frames_used = 0;
-    src.output_frames_gen = 0;
-    src.end_of_input      = (in_len == 0) ? 1 : 0;
-    src.src_ratio         = m_ratio;
 
     // let the converter run...
-    int error = src_process(m_converter, &src);
-    if (error) qWarning("SRC error: '%s'", src_strerror(error));
-    Q_ASSERT(!error);
-
-    // convert the result back from floats to sample_t
-    unsigned int gen = Kwave::toUint(src.output_frames_gen);
-    Kwave::SampleArray out(gen);
-    const float *f_out = src.data_out;
-    sample_t    *s_out = out.data();
-
-    // work blockwise to allow loop unrolling
-    remaining = gen;
-    while (remaining >= block_size) {
-	for (unsigned int i = 0; i < block_size; ++i)
-	    s_out[i] = float2sample(f_out[i]);
-	s_out     += block_size;
-	f_out     += block_size;
-	remaining -= block_size;
+    const unsigned int gen = m_converter->process(
+	in, len, m_converter_out, last);
+    if (!gen) return;
+
+    // convert the result back from floats to sample_t, re-use the
+    // output buffer if nobody else holds a reference to it
+    if (receivers(SIGNAL(output(Kwave::SampleArray)))) {
+	if (!m_samples_out.resize(gen)) return;
+	Kwave::floats2samples(m_converter_out.constData(),
+	                      m_samples_out.data(), gen);
+	emit output(m_samples_out);
     }
-    for (; remaining; remaining--, ++s_out, ++f_out)
-	*s_out = float2sample(*f_out);
 
-    emit output(out);
+    // the same for floats, without any conversion
+    if (receivers(SIGNAL(output(Kwave::FloatArray)))) {
+	if (!m_floats_out.resize(gen)) return;
+	MEMCPY(m_floats_out.data(), m_converter_out.constData(),
+	       gen * sizeof(float));
+	emit output(m_floats_out);
+    }
+}
+
+//***************************************************************************
+void Kwave::RateConverter::emitOutput(Kwave::SampleArray samples,
+                                      Kwave::FloatArray floats)
+{
+    const unsigned int len = qMax(samples.size(), floats.size());
+
+    if (receivers(SIGNAL(output(Kwave::SampleArray)))) {
+	if (samples.size() != len) {
+	    if (!m_samples_out.resize(len)) return;
+	    Kwave::floats2samples(floats.constData(),
+	                          m_samples_out.data(), len);
+	    samples = m_samples_out;
+	}
+	emit output(samples);
+    }
+
+    if (receivers(SIGNAL(output(Kwave::FloatArray)))) {
+	if (floats.size() != len) {
+	    if (!m_floats_out.resize(len)) return;
+	    Kwave::samples2floats(samples.constData(),
+	                          m_floats_out.data(), len);
+	    floats = m_floats_out;
+	}
+	emit output(floats);
+    }
 }
 
 //***************************************************************************
 void Kwave::RateConverter::setRatio(const QVariant ratio)
 {
-    m_ratio = QVariant(ratio).toDouble();
+    const double r = QVariant(ratio).toDouble();
+    if (qFuzzyCompare(r, m_ratio)) return;
+    m_ratio = r;
+
+    // needs a new converter
+    delete m_converter;
+    m_converter = Q_NULLPTR;
+}
+
+//***************************************************************************
+void Kwave::RateConverter::setQuality(const QVariant q)
+{
+    const Kwave::Resampler::Quality quality =
+	static_cast<Kwave::Resampler::Quality>(QVariant(q).toInt());
+    if (quality == m_quality) return;
+    m_quality = quality;
+
+    // needs a new converter
+    delete m_converter;
+    m_converter = Q_NULLPTR;
 }
 
 //***************************************************************************
@@ -22,13 +22,13 @@
 
 #include <QtGlobal>
 #include <QObject>
-#include <QVarLengthArray>
 #include <QVariant>
+#include <QVector>
 
-#include <samplerate.h>
-
+#include "libkwave/FloatArray.h"
 #include "libkwave/SampleArray.h"
 #include "libkwave/SampleSource.h"
+#include "libkwave/modules/Resampler.h"
 
 namespace Kwave
 {
@@ -47,34 +47,87 @@ namespace Kwave
 	/** does nothing, processing is done in input() */
         virtual void goOn() Q_DECL_OVERRIDE;
 
+	/**
+	 * Must be called at the end of the input, flushes the samples
+	 * that are still in the delay line of the converter and emits them.
+	 * The next input starts a new stream.
+	 */
+	void finished();
+
     signals:
 
 	/** emits a block with the filtered data */
 	void output(Kwave::SampleArray data);
 
+	/** emits a block with the filtered data, in float representation */
+	void output(Kwave::FloatArray data);
+
     public slots:
 
 	/** receives input data and also directly does the calculation */
 	void input(Kwave::SampleArray data);
 
+	/**
+	 * receives input data in float representation, which is passed to
+	 * the resampler without conversion
+	 */
+	void input(Kwave::FloatArray data);
+
 	/**
 	 * Sets the conversion ratio, ((new rate) / (old rate))
 	 */
 	void setRatio(const QVariant r);
 
+	/**
+	 * Sets the quality of the conversion, as numeric value of
+	 * Kwave::Resampler::Quality. Default is "Medium".
+	 */
+	void setQuality(const QVariant q);
+
+    private:
+
+	/**
+	 * Runs the resampler and emits the result, as SampleArray and/or
+	 * as FloatArray, depending on what is connected
+	 * @param in pointer to the input samples
+	 * @param len number of input samples
+	 * @param last if true, flush the converter after the input
+	 */
+	void convert(const float *in, unsigned int len, bool last);
+
+	/**
+	 * Emits a block of samples on all connected outputs, converts only
+	 * if something is connected to the other representation
+	 * @param samples the block as SampleArray, might be empty
+	 * @param floats the same block as FloatArray, might be empty
+	 */
+	void emitOutput(Kwave::SampleArray samples, Kwave::FloatArray floats);
+
     private:
 
 	/** conversion ratio, ((new rate) / (old rate)) */
 	double m_ratio;
 
-	/** sample rate converter context for libsamplerate */
-	SRC_STATE *m_converter;
+	/** quality of the conversion */
+	Kwave::Resampler::Quality m_quality;
+
+	/** the resampler, created on demand */
+	Kwave::Resampler *m_converter;
 
 	/** input values for the sample rate converter */
-	QVarLengthArray<float, 65536> m_converter_in;
+	QVector<float> m_converter_in;
 
 	/** output values for the sample rate converter */
-	QVarLengthArray<float, 65536> m_converter_out;
+	QVector<float> m_converter_out;
+
+	/**
+	 * buffer for the output, re-used as long as the receiver does not
+	 * hold a reference to the previous block
+	 */
+	Kwave::SampleArray m_samples_out;
+
+	/** the same for the output in float representation */
+	Kwave::FloatArray m_floats_out;
 
     };
 }
@@ -0,0 +1,389 @@
+/***************************************************************************
+          Resampler.cpp  -  sample rate conversion engine
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "config.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <limits>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+#include "libkwave/String.h"
+#include "libkwave/Utils.h"
+#include "libkwave/modules/Resampler.h"
+
+/** highest interpolation/decimation factor of the polyphase filter */
+#define POLYPHASE_MAX_FACTOR 1024
+
+/**
+ * minimum number of taps per phase of the polyphase filter, will be
+ * scaled up by the decimation ratio when downsampling
+ */
+#define POLYPHASE_TAPS 128
+
+/** usable bandwidth of the polyphase filter, relative to Nyquist */
+#define POLYPHASE_BANDWIDTH 0.91
+
+/** beta of the Kaiser window, gives approximately 90dB stop band */
+#define POLYPHASE_KAISER_BETA 8.6
+
+//***************************************************************************
+/**
+ * modified Bessel function of the first kind, order zero
+ * (needed for the Kaiser window)
+ */
+static double bessel_i0(double x)
+{
+    double sum  = 1.0;
+    double term = 1.0;
+    const double x2 = (x * x) / 4.0;
+    for (unsigned int k = 1; k < 100; k++) {
+	term *= x2 / (static_cast<double>(k) * static_cast<double>(k));
+	sum  += term;
+	if (term < (sum * 1E-12)) break;
+    }
+    return sum;
+}
+
+//***************************************************************************
+/**
+ * dot product of input samples and filter coefficients
+ * @param x input samples
+ * @param c coefficients
+ * @param n number of taps, must be a multiple of 8
+ */
+static inline float dot(const float *x, const float *c, unsigned int n)
+{
+#ifdef __SSE__
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (unsigned int i = 0; i < n; i += 8) {
+	acc0 = _mm_add_ps(acc0,
+	    _mm_mul_ps(_mm_loadu_ps(x + i),     _mm_loadu_ps(c + i)));
+	acc1 = _mm_add_ps(acc1,
+	    _mm_mul_ps(_mm_loadu_ps(x + i + 4), _mm_loadu_ps(c + i + 4)));
+    }
+    acc0 = _mm_add_ps(acc0, acc1);
+    float sum[4];
+    _mm_storeu_ps(sum, acc0);
+    return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+#else
+    float sum[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+    for (unsigned int i = 0; i < n; i += 8) {
+	for (unsigned int j = 0; j < 8; j++)
+	    sum[j] += x[i + j] * c[i + j];
+    }
+    return ((sum[0] + sum[1]) + (sum[2] + sum[3])) +
+           ((sum[4] + sum[5]) + (sum[6] + sum[7]));
+#endif
+}
+
+//***************************************************************************
+Kwave::Resampler::Resampler(Quality quality, double ratio)
+    :m_quality(quality), m_ratio(ratio), m_converter(Q_NULLPTR),
+     m_up(1), m_down(1), m_taps(0), m_coeff(), m_history(),
+     m_history_start(0), m_base(0), m_phase(0), m_in_total(0),
+     m_out_total(0)
+{
+    if (m_quality == Polyphase) {
+	if (rational(ratio, m_up, m_down))
+	    initPolyphase();
+	else
+	    m_quality = Best;
+    }
+
+    if (m_quality != Polyphase) {
+	int type;
+	switch (m_quality) {
+	    case Linear:
+		type = SRC_LINEAR;
+		break;
+	    case Medium:
+		type = SRC_SINC_MEDIUM_QUALITY;
+		break;
+	    default:
+		type = SRC_SINC_BEST_QUALITY;
+		break;
+	}
+
+	int error = 0;
+	m_converter = src_new(type, 1, &error);
+	Q_ASSERT(m_converter);
+	if (!m_converter) qWarning("creating converter failed: '%s",
+	    src_strerror(error));
+    }
+}
+
+//***************************************************************************
+Kwave::Resampler::~Resampler()
+{
+    if (m_converter) src_delete(m_converter);
+}
+
+//***************************************************************************
+bool Kwave::Resampler::isOk() const
+{
+    return (m_quality == Polyphase) ? !m_coeff.isEmpty() :
+                                      (m_converter != Q_NULLPTR);
+}
+
+//***************************************************************************
+bool Kwave::Resampler::rational(double ratio, unsigned int &up,
+                                unsigned int &down)
+{
+    if (ratio <= 0.0) return false;
+
+    for (unsigned int d = 1; d <= POLYPHASE_MAX_FACTOR; d++) {
+	const double u = floor((ratio * static_cast<double>(d)) + 0.5);
+	if ((u < 1.0) || (u > POLYPHASE_MAX_FACTOR)) continue;
+	if (fabs((u / static_cast<double>(d)) - ratio) > (ratio * 1E-9))
+	    continue;
+
+	// found the smallest denominator -> already reduced
+	up   = static_cast<unsigned int>(u);
+	down = d;
+	return true;
+    }
+    return false;
+}
+
+//***************************************************************************
+Kwave::Resampler::Quality Kwave::Resampler::qualityFromName(
+    const QString &name, bool *ok)
+{
+    if (ok) *ok = true;
+    if (name == _("linear"))    return Linear;
+    if (name == _("medium"))    return Medium;
+    if (name == _("best"))      return Best;
+    if (name == _("polyphase")) return Polyphase;
+
+    if (ok) *ok = false;
+    return Medium;
+}
+
+//***************************************************************************
+void Kwave::Resampler::initPolyphase()
+{
+    // when downsampling, the cutoff gets lower and we need more taps
+    // to get the same steepness
+    double taps = POLYPHASE_TAPS;
+    if (m_down > m_up)
+	taps *= static_cast<double>(m_down) / static_cast<double>(m_up);
+    m_taps = Kwave::round_up<unsigned int>(
+	Kwave::toUint(ceil(taps)), 8);
+
+    // prototype low pass, designed for the interpolated rate
+    const unsigned int n    = m_taps * m_up;
+    const double       half = static_cast<double>(n) / 2.0;
+    const double       fc   = POLYPHASE_BANDWIDTH * 0.5 /
+	static_cast<double>(qMax(m_up, m_down));
+    const double       i0_beta = bessel_i0(POLYPHASE_KAISER_BETA);
+
+    QVector<double> h(Kwave::toInt(n));
+    for (unsigned int t = 0; t < n; t++) {
+	const double x = static_cast<double>(t) - half;
+	const double s = (qFuzzyIsNull(x)) ? (2.0 * fc) :
+	    (sin(2.0 * M_PI * fc * x) / (M_PI * x));
+	const double r = x / half;
+	const double w = (fabs(r) < 1.0) ?
+	    (bessel_i0(POLYPHASE_KAISER_BETA * sqrt(1.0 - (r * r))) /
+	     i0_beta) : 0.0;
+	h[t] = s * w;
+    }
+
+    // split into phases, normalize each phase to unity gain and
+    // store the coefficients in reverse order
+    m_coeff.resize(Kwave::toInt(m_taps * m_up));
+    for (unsigned int p = 0; p < m_up; p++) {
+	double sum = 0.0;
+	for (unsigned int k = 0; k < m_taps; k++)
+	    sum += h[p + (k * m_up)];
+	if (qFuzzyIsNull(sum)) sum = 1.0;
+
+	float *c = m_coeff.data() + (p * m_taps);
+	for (unsigned int k = 0; k < m_taps; k++)
+	    c[m_taps - 1 - k] = static_cast<float>(h[p + (k * m_up)] / sum);
+    }
+
+    // history: the first output needs (m_taps / 2) - 1 samples before
+    // the first input sample, which are zero
+    const unsigned int pre = (m_taps / 2) - 1;
+    m_history.fill(0.0f, Kwave::toInt(pre));
+    m_history_start = -static_cast<qint64>(pre);
+    m_base      = 0;
+    m_phase     = 0;
+    m_in_total  = 0;
+    m_out_total = 0;
+}
+
+//***************************************************************************
+unsigned int Kwave::Resampler::process(const float *in, unsigned int len,
+                                       QVector<float> &out, bool last)
+{
+    if (!isOk()) {
+	out.resize(0);
+	return 0;
+    }
+
+    return (m_quality == Polyphase) ?
+	processPolyphase(in, len, out, last) :
+	processSRC(in, len, out, last);
+}
+
+//***************************************************************************
+unsigned int Kwave::Resampler::processPolyphase(const float *in,
+                                                unsigned int len,
+                                                QVector<float> &out,
+                                                bool last)
+{
+    const qint64 half = m_taps / 2;
+
+    // append the new input to the history
+    const int old_size = m_history.size();
+    if (len) {
+	m_history.resize(old_size + Kwave::toInt(len));
+	memcpy(m_history.data() + old_size, in, len * sizeof(float));
+	m_in_total += len;
+    }
+
+    // at the end: pad with zeroes to get the look-ahead for the
+    // last output samples
+    if (last) m_history.insert(m_history.size(), Kwave::toInt(half), 0.0f);
+
+    // number of output samples we are allowed to produce in total
+    const quint64 limit = (last) ?
+	(((m_in_total * m_up) + m_down - 1) / m_down) :
+	std::numeric_limits<quint64>::max();
+
+    // the highest input index that can be used as center of a filter
+    const qint64 max_base = m_history_start + m_history.size() - 1 - half;
+    quint64 estimate = (max_base >= m_base) ?
+	(((static_cast<quint64>(max_base - m_base) + 1) * m_up) / m_down + 2)
+	: 0;
+    if (m_out_total + estimate > limit) estimate = limit - m_out_total;
+    out.resize(Kwave::toInt(estimate));
+
+    float          *dst   = out.data();
+    unsigned int    count = 0;
+    const float    *hist  = m_history.constData();
+    const float    *coeff = m_coeff.constData();
+    while ((m_out_total < limit) && (m_base <= max_base) &&
+           (count < estimate))
+    {
+	const float *x = hist + (m_base - half + 1 - m_history_start);
+	const float *c = coeff + (m_phase * m_taps);
+	dst[count++] = dot(x, c, m_taps);
+	m_out_total++;
+
+	// advance to the next output sample
+	m_phase += m_down;
+	m_base  += m_phase / m_up;
+	m_phase %= m_up;
+    }
+    out.resize(Kwave::toInt(count));
+
+    // discard history that is no longer needed
+    const qint64 keep_from = m_base - half + 1;
+    if (keep_from > m_history_start) {
+	const int drop = Kwave::toInt(qMin<qint64>(
+	    keep_from - m_history_start, m_history.size()));
+	m_history.remove(0, drop);
+	m_history_start += drop;
+    }
+
+    return count;
+}
+
+//***************************************************************************
+unsigned int Kwave::Resampler::processSRC(const float *in, unsigned int len,
+                                          QVector<float> &out, bool last)
+{
+    unsigned int total     = 0;
+    long int     remaining = len;
+    const float *p         = in;
+
+    // libsamplerate does not accept a null pointer, even without input
+    static const float no_input = 0.0f;
+
+    while (true) {
+	// prepare the output buffer (estimated size, rounded up)
+	// just for safety we limit the extra output space to some
+	// (hopefully) reasonable range between 4096 and 16384
+	const unsigned int out_len = Kwave::toUint(
+	    ceil(static_cast<double>(remaining) * m_ratio));
+	const unsigned int extra = qBound<unsigned int>(4096, out_len, 16384);
+	out.resize(Kwave::toInt(total + out_len + extra));
+
+	SRC_DATA src;
+	src.data_in           = (remaining) ? p : &no_input;
+	src.data_out          = out.data() + total;
+	src.input_frames      = remaining;
+	src.output_frames     = out_len + extra;
+	src.input_frames_used = 0;
+	src.output_frames_gen = 0;
+	src.end_of_input      = (last) ? 1 : 0;
+	src.src_ratio         = m_ratio;
+
+	// let the converter run...
+	int error = src_process(m_converter, &src);
+	if (error) qWarning("SRC error: '%s'", src_strerror(error));
+	Q_ASSERT(!error);
+	if (error) break;
+
+	p         += src.input_frames_used;
+	remaining -= src.input_frames_used;
+	total     += Kwave::toUint(src.output_frames_gen);
+
+	if (!src.input_frames_used && !src.output_frames_gen)
+	    break; // nothing more to get out
+	if (!remaining && !last)
+	    break; // all input consumed, flushing happens later
+    }
+
+    out.resize(Kwave::toInt(total));
+    return total;
+}
+
+//***************************************************************************
+bool Kwave::Resampler::convertChunk(Quality quality, double ratio,
+                                    const float *in, unsigned int len,
+                                    unsigned int skip,
+                                    float *out, unsigned int count)
+{
+    Kwave::Resampler converter(quality, ratio);
+    if (!converter.isOk()) return false;
+
+    QVector<float> buffer;
+    const unsigned int gen = converter.process(in, len, buffer, true);
+
+    // take the part after the pre-roll and pad the rest
+    unsigned int avail = (gen > skip) ? (gen - skip) : 0;
+    if (avail > count) avail = count;
+    if (avail)
+	memcpy(out, buffer.constData() + skip, avail * sizeof(float));
+    if (avail < count)
+	memset(out + avail, 0x00, (count - avail) * sizeof(float));
+
+    return true;
+}
+
+//***************************************************************************
+//***************************************************************************
@@ -0,0 +1,203 @@
+/***************************************************************************
+            Resampler.h  -  sample rate conversion engine
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include "config.h"
+
+#include <QtGlobal>
+#include <QString>
+#include <QVector>
+
+#include <samplerate.h>
+
+namespace Kwave
+{
+
+    /**
+     * Single channel sample rate converter on float data, without any
+     * Qt signal/slot overhead. Uses libsamplerate for arbitrary ratios
+     * and an own polyphase FIR filter for rational ratios with small
+     * factors, like 44.1kHz <-> 48kHz or 48kHz <-> 96kHz.
+     */
+    class Q_DECL_EXPORT Resampler
+    {
+    public:
+
+	/** quality / algorithm of the conversion */
+	typedef enum {
+	    Linear    = 0, /**< linear interpolation, fastest     */
+	    Medium    = 1, /**< medium quality sinc interpolation */
+	    Best      = 2, /**< best quality sinc interpolation   */
+	    Polyphase = 3  /**< polyphase FIR, for rational ratios only,
+	                        falls back to "Best" otherwise    */
+	} Quality;
+
+	/**
+	 * Constructor
+	 * @param quality the requested quality, see Quality
+	 * @param ratio conversion ratio, ((new rate) / (old rate))
+	 */
+	Resampler(Quality quality, double ratio);
+
+	/** Destructor */
+	virtual ~Resampler();
+
+	/** returns true if the converter has been set up successfully */
+	bool isOk() const;
+
+	/**
+	 * Returns the effective quality, which might differ from the
+	 * requested one if the polyphase filter is not applicable
+	 */
+	inline Quality quality() const { return m_quality; }
+
+	/** returns the conversion ratio */
+	inline double ratio() const { return m_ratio; }
+
+	/**
+	 * Converts a block of samples. The output buffer is resized to
+	 * the number of generated samples, but never shrinks it's
+	 * internal storage, so it can be re-used for the next call
+	 * without re-allocation.
+	 *
+	 * @param in pointer to the input samples, may be null if len is zero
+	 * @param len number of input samples
+	 * @param out receives the output samples
+	 * @param last if true, this is the last block and the converter
+	 *             is flushed
+	 * @return number of generated samples
+	 */
+	unsigned int process(const float *in, unsigned int len,
+	                     QVector<float> &out, bool last);
+
+	/**
+	 * Converts a self-contained chunk of samples, using a new converter
+	 * instance. Intended for processing long tracks in several
+	 * overlapping chunks in parallel. The result is identical to a
+	 * serial conversion only with the polyphase filter, libsamplerate
+	 * starts each chunk with a new phase and filter state.
+	 *
+	 * @param quality the requested quality, see Quality
+	 * @param ratio conversion ratio, ((new rate) / (old rate))
+	 * @param in pointer to the input samples, including pre-roll
+	 *           and post-roll
+	 * @param len number of input samples
+	 * @param skip number of output samples that belong to the
+	 *             pre-roll and are discarded
+	 * @param out receives the output samples
+	 * @param count number of output samples to deliver, will be
+	 *              padded with zeroes if the converter produced less
+	 * @return true if succeeded, false if failed
+	 */
+	static bool convertChunk(Quality quality, double ratio,
+	                         const float *in, unsigned int len,
+	                         unsigned int skip,
+	                         float *out, unsigned int count);
+
+	/**
+	 * Tries to express a conversion ratio as a fraction up / down
+	 * with small integer factors.
+	 *
+	 * @param ratio conversion ratio, ((new rate) / (old rate))
+	 * @param up receives the interpolation factor
+	 * @param down receives the decimation factor
+	 * @return true if successful, false if the ratio is not rational
+	 *         within a reasonable range of factors
+	 */
+	static bool rational(double ratio, unsigned int &up,
+	                     unsigned int &down);
+
+	/**
+	 * Returns the quality that corresponds to a name, as used in
+	 * plugin parameters: "linear", "medium", "best" or "polyphase"
+	 * @param name the name of the quality
+	 * @param ok receives true if the name was valid
+	 */
+	static Quality qualityFromName(const QString &name, bool *ok);
+
+    private:
+
+	/** creates the filter coefficients for the polyphase filter */
+	void initPolyphase();
+
+	/**
+	 * Processes a block through the polyphase filter
+	 * @see process()
+	 */
+	unsigned int processPolyphase(const float *in, unsigned int len,
+	                              QVector<float> &out, bool last);
+
+	/**
+	 * Processes a block through libsamplerate
+	 * @see process()
+	 */
+	unsigned int processSRC(const float *in, unsigned int len,
+	                        QVector<float> &out, bool last);
+
+    private:
+
+	/** effective quality */
+	Quality m_quality;
+
+	/** conversion ratio, ((new rate) / (old rate)) */
+	double m_ratio;
+
+	/** sample rate converter context for libsamplerate */
+	SRC_STATE *m_converter;
+
+	/** polyphase: interpolation factor */
+	unsigned int m_up;
+
+	/** polyphase: decimation factor */
+	unsigned int m_down;
+
+	/** polyphase: number of taps per phase */
+	unsigned int m_taps;
+
+	/**
+	 * polyphase: filter coefficients, m_up phases with m_taps
+	 * coefficients each, in reverse order for a simple dot product
+	 */
+	QVector<float> m_coeff;
+
+	/** polyphase: input history and not yet processed input */
+	QVector<float> m_history;
+
+	/** polyphase: input index of the first sample in m_history */
+	qint64 m_history_start;
+
+	/** polyphase: input index of the current output sample */
+	qint64 m_base;
+
+	/** polyphase: phase of the current output sample [0...m_up-1] */
+	unsigned int m_phase;
+
+	/** polyphase: total number of input samples so far */
+	quint64 m_in_total;
+
+	/** polyphase: total number of output samples so far */
+	quint64 m_out_total;
+
+    };
+}
+
+#endif /* RESAMPLER_H */
+
+//***************************************************************************
+//***************************************************************************
@@ -17,19 +17,99 @@
 
 #include "config.h"
 
+#include <unistd.h>
+
+#include <QFile>
 #include <QString>
 #include <QVariant>
 
+#include "libkwave/Sample.h"
+#include "libkwave/String.h"
 #include "libkwave/modules/StreamObject.h"
 
-/** interactive mode */
-bool Kwave::StreamObject::m_interactive = false;
+/** block size in interactive mode [samples] */
+#define BLOCK_SIZE_INTERACTIVE (8 * 1024)
+
+/** smallest block size in non-interactive mode [samples] */
+#define BLOCK_SIZE_MINIMUM (32 * 1024)
+
+/** largest block size in non-interactive mode [samples] */
+#define BLOCK_SIZE_MAXIMUM (512 * 1024)
+
+/**
+ * number of blocks that should fit into the cache at the same time,
+ * input and output of one stage plus some temporary buffers
+ */
+#define BLOCKS_IN_CACHE 4
+
+namespace Kwave
+{
+    namespace
+    {
+	/** interactive mode of the current thread */
+	thread_local bool t_interactive = false;
+
+	//*******************************************************************
+	/**
+	 * Returns the size of the largest cache of one CPU core that is not
+	 * shared with other cores, normally the L2 cache
+	 * @return size in bytes or zero if unknown
+	 */
+	quint64 coreCacheSize()
+	{
+	    long int size = -1;
+#ifdef _SC_LEVEL2_CACHE_SIZE
+	    size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+	    if (size > 0) return static_cast<quint64>(size);
+
+	    // fallback: read it from sysfs, the value is something like
+	    // "1024K" or "2M"
+	    QFile file(_("/sys/devices/system/cpu/cpu0/cache/index2/size"));
+	    if (!file.open(QIODevice::ReadOnly)) return 0;
+	    QString text = QString::fromLatin1(file.readAll()).trimmed();
+	    quint64 factor = 1;
+	    if (text.endsWith(_("K"))) factor = 1024;
+	    if (text.endsWith(_("M"))) factor = 1024 * 1024;
+	    if (factor > 1) text.chop(1);
+	    bool ok = false;
+	    const quint64 value = text.toULongLong(&ok);
+	    return (ok) ? (value * factor) : 0;
+	}
+
+	//*******************************************************************
+	/** calculates the block size for non-interactive mode [samples] */
+	unsigned int calculateBlockSize()
+	{
+	    // unknown cache geometry -> use the maximum
+	    const quint64 cache = coreCacheSize();
+	    if (!cache) return BLOCK_SIZE_MAXIMUM;
+
+	    // largest power of two that fits into the cache
+	    const quint64 limit = cache / (BLOCKS_IN_CACHE * sizeof(sample_t));
+	    unsigned int size = BLOCK_SIZE_MAXIMUM;
+	    while ((size > BLOCK_SIZE_MINIMUM) && (size > limit))
+		size /= 2;
+	    return size;
+	}
+
+	//*******************************************************************
+	/** returns the block size for non-interactive mode [samples] */
+	unsigned int cacheBlockSize()
+	{
+	    static const unsigned int block_size = calculateBlockSize();
+	    return block_size;
+	}
+    }
+}
 
 //***************************************************************************
 Kwave::StreamObject::StreamObject(QObject *parent)
     :QObject(Q_NULLPTR /*parent*/),
      m_lock_set_attribute(QMutex::Recursive),
-     m_canceled(false)
+     m_canceled(false),
+     m_block_size((t_interactive) ? BLOCK_SIZE_INTERACTIVE :
+                  cacheBlockSize())
 {
     Q_UNUSED(parent)
 }
@@ -66,13 +146,19 @@ void Kwave::StreamObject::setAttribute(const char *attribute,
 //***************************************************************************
 unsigned int Kwave::StreamObject::blockSize() const
 {
-    return (m_interactive) ? 8*1024 : 512*1024;
+    return m_block_size;
 }
 
 //***************************************************************************
 void Kwave::StreamObject::setInteractive(bool interactive)
 {
-    m_interactive = interactive;
+    t_interactive = interactive;
+}
+
+//***************************************************************************
+bool Kwave::StreamObject::isInteractive()
+{
+    return t_interactive;
 }
 
 //***************************************************************************
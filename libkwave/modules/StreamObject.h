@@ -88,8 +88,13 @@ namespace Kwave
 	}
 
 	/**
-	 * Returns the block size used for producing data.
-	 * @return currently 32k [samples]
+	 * Returns the block size used for producing data. In interactive
+	 * mode this is 8k samples. Otherwise the block size is chosen in a
+	 * way that the buffers of one stage of a chain of stream objects
+	 * fit into the (per core) cache, so that each block passes through
+	 * the whole chain while it is still in the cache.
+	 * @return number of samples per block
+	 * @see setInteractive
 	 */
 	virtual unsigned int blockSize() const;
 
@@ -107,9 +112,16 @@ namespace Kwave
 	 * use a smaller block size for creating objects to get better
 	 * response time to parameter changes. In non-interactive mode
 	 * the block size is higher for better performance.
+	 * @note the mode applies to the stream objects that are created
+	 *       by the calling thread, so that plugins running at the
+	 *       same time do not change each other's block size
+	 * @param interactive if true, use the small block size
 	 */
 	static void setInteractive(bool interactive);
 
+	/** returns true if the calling thread is in interactive mode */
+	static bool isInteractive();
+
 	/** returns true if the transfer has been canceled */
 	virtual bool isCanceled() const { return m_canceled; }
 
@@ -140,14 +152,17 @@ namespace Kwave
 	/** Mutex for locking access to setAttribute (recursive) */
 	QMutex m_lock_set_attribute;
 
-	/** interactive mode: if enabled, use smaller block size */
-	static bool m_interactive;
-
 	/**
 	 * Initialized as false, will be true if the transfer has
 	 * been canceled
 	 */
 	bool m_canceled;
+
+	/**
+	 * block size, depends on the mode of the thread that created
+	 * the object
+	 */
+	unsigned int m_block_size;
     };
 }
 
@@ -118,9 +118,7 @@ Kwave::UndoAction *Kwave::UndoModifyMetaDataAction::undo(
 		old_data.add(current_data[meta.id()]);
 	    } else {
 		// add an empty entry that will delete the old one when added
-		Kwave::MetaData empty_element(meta);
-		old_data.add(empty_element);
-		old_data[empty_element.id()].clear();
+		old_data.addRemoval(meta);
 	    }
 	}
 
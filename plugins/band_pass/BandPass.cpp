@@ -27,7 +27,7 @@
 
 //***************************************************************************
 Kwave::BandPass::BandPass()
-    :Kwave::SampleSource(Q_NULLPTR), m_buffer(blockSize()),
+    :Kwave::SampleSource(Q_NULLPTR), m_buffer(blockSize()), m_float_buffer(),
     m_frequency(0.5), m_bandwidth(0.1)
 {
     initFilter();
@@ -43,6 +43,7 @@ Kwave::BandPass::~BandPass()
 void Kwave::BandPass::goOn()
 {
     emit output(m_buffer);
+    emit output(m_float_buffer);
 }
 
 //***************************************************************************
@@ -137,6 +138,34 @@ void Kwave::BandPass::input(Kwave::SampleArray data)
     }
 }
 
+//***************************************************************************
+void Kwave::BandPass::input(Kwave::FloatArray data)
+{
+    const Kwave::FloatArray &in = data;
+    bool ok = m_float_buffer.resize(in.size());
+    Q_ASSERT(ok);
+    Q_UNUSED(ok)
+
+    setfilter_2polebp(m_frequency, m_bandwidth);
+
+    for (unsigned i = 0; i < in.size(); ++i)
+    {
+	// do the filtering, without clipping
+	m_filter.x = static_cast<double>(in[i]);
+	m_filter.y =
+	    m_filter.cx  * m_filter.x  +
+	    m_filter.cx1 * m_filter.x1 +
+	    m_filter.cx2 * m_filter.x2 +
+	    m_filter.cy1 * m_filter.y1 +
+	    m_filter.cy2 * m_filter.y2;
+	m_filter.x2 = m_filter.x1;
+	m_filter.x1 = m_filter.x;
+	m_filter.y2 = m_filter.y1;
+	m_filter.y1 = m_filter.y;
+	m_float_buffer[i] = static_cast<float>(0.95 * m_filter.y);
+    }
+}
+
 //***************************************************************************
 void Kwave::BandPass::setFrequency(const QVariant fc)
 {
@@ -38,6 +38,7 @@
 #include "libkwave/MultiWriter.h"
 #include "libkwave/Sample.h"
 #include "libkwave/SampleArray.h"
+#include "libkwave/SampleConversion.h"
 #include "libkwave/String.h"
 #include "libkwave/Utils.h"
 #include "libkwave/Writer.h"
@@ -46,6 +47,15 @@
 #include "MP3CodecPlugin.h"
 #include "MP3Decoder.h"
 
+/**
+ * size of the output blocks in samples, large enough to be passed
+ * by the writers to the tracks without intermediate copy
+ */
+#define MP3_BLOCK_SIZE (512 * 1024)
+
+/** mask for the sync word, MPEG version, layer and sample rate */
+#define MP3_HEADER_FIXED_MASK 0xFFFE0C00
+
 //***************************************************************************
 Kwave::MP3Decoder::MP3Decoder()
     :Kwave::Decoder(),
@@ -56,11 +66,16 @@ Kwave::MP3Decoder::MP3Decoder()
      m_buffer_size(0),
      m_prepended_bytes(0),
      m_appended_bytes(0),
+     m_guard(Q_NULLPTR),
+     m_blocks(),
+     m_block_used(0),
      m_failures(0),
      m_parent_widget(Q_NULLPTR)
 {
     REGISTER_MIME_TYPES
     REGISTER_COMPRESSION_TYPES
+
+    for (unsigned int i = 0; i < 4; i++) m_dither[i] = 0;
 }
 
 //***************************************************************************
@@ -466,9 +481,148 @@ bool Kwave::MP3Decoder::open(QWidget *widget, QIODevice &src)
     m_buffer = static_cast<unsigned char *>(malloc(m_buffer_size));
     if (!m_buffer) return false; // out of memory :-(
 
+    // get the exact length from the frame headers, this replaces the
+    // estimation from the first header and the length from the ID3 tag
+    // and allows to allocate the whole signal in advance
+    const sample_index_t length = scanLength();
+    if (length) {
+	info = Kwave::FileInfo(metaData());
+	info.setLength(length);
+	metaData().replace(Kwave::MetaDataList(info));
+    }
+
+    return true;
+}
+
+//***************************************************************************
+/**
+ * Parses the header of a MPEG audio frame
+ * @param p pointer to the four bytes of the header
+ * @param length receives the length of the frame in bytes
+ * @param samples receives the number of samples per track
+ * @return true if the header is valid and not in free format
+ */
+static bool parseFrameHeader(const unsigned char *p,
+                             unsigned int &length, unsigned int &samples)
+{
+    /* bitrates in kbit/s: MPEG-1 layer I, II, III, MPEG-2/2.5 I, II+III */
+    static const unsigned int bitrates[5][15] = {
+	{0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448},
+	{0, 32, 48, 56,  64,  80,  96, 112, 128, 160, 192, 224, 256, 320, 384},
+	{0, 32, 40, 48,  56,  64,  80,  96, 112, 128, 160, 192, 224, 256, 320},
+	{0, 32, 48, 56,  64,  80,  96, 112, 128, 144, 160, 176, 192, 224, 256},
+	{0,  8, 16, 24,  32,  40,  48,  56,  64,  80,  96, 112, 128, 144, 160}
+    };
+    static const unsigned int rates[3] = { 44100, 48000, 32000 };
+
+    if ((p[0] != 0xFF) || ((p[1] & 0xE0) != 0xE0)) return false;
+
+    const unsigned int version  = (p[1] >> 3) & 0x03; // 0=2.5, 2=2, 3=1
+    const unsigned int layer    = 4 - ((p[1] >> 1) & 0x03);
+    const unsigned int br_index = (p[2] >> 4) & 0x0F;
+    const unsigned int sr_index = (p[2] >> 2) & 0x03;
+    const unsigned int padding  = (p[2] >> 1) & 0x01;
+    if ((version == 1) || (layer > 3)) return false; // reserved
+    if (!br_index || (br_index == 15)) return false; // free format / bad
+    if (sr_index == 3) return false;                 // reserved
+
+    const bool mpeg1 = (version == 3);
+    unsigned int rate = rates[sr_index];
+    if (version == 2) rate /= 2;
+    if (version == 0) rate /= 4;
+
+    const unsigned int table = (mpeg1) ? (layer - 1) : ((layer == 1) ? 3 : 4);
+    const unsigned int bitrate = bitrates[table][br_index] * 1000;
+
+    if (layer == 1) {
+	length  = (((12 * bitrate) / rate) + padding) * 4;
+	samples = 384;
+    } else if ((layer == 3) && !mpeg1) {
+	length  = ((72 * bitrate) / rate) + padding;
+	samples = 576;
+    } else {
+	length  = ((144 * bitrate) / rate) + padding;
+	samples = 1152;
+    }
     return true;
 }
 
+//***************************************************************************
+sample_index_t Kwave::MP3Decoder::scanLength()
+{
+    Q_ASSERT(m_source);
+    Q_ASSERT(m_buffer);
+    if (!m_source || !m_buffer) return 0;
+
+    const qint64 first = static_cast<qint64>(m_prepended_bytes);
+    const qint64 end   = m_source->size() -
+                         static_cast<qint64>(m_appended_bytes);
+    qint64 buf_start   = 0;
+    qint64 buf_len     = 0;
+    qint64 pos         = first;
+    quint32 fixed      = 0;
+    sample_index_t length = 0;
+
+    while (pos + 4 <= end) {
+	// read the next part of the source if the header is not in the buffer
+	if ((pos < buf_start) || (pos + 4 > buf_start + buf_len)) {
+	    if (!m_source->seek(pos)) return 0;
+	    buf_start = pos;
+	    buf_len   = m_source->read(reinterpret_cast<char *>(m_buffer),
+	                               qMin<qint64>(m_buffer_size, end - pos));
+	    if (buf_len < 4) return 0;
+	}
+
+	const unsigned char *p = m_buffer + (pos - buf_start);
+	const quint32 header = (static_cast<quint32>(p[0]) << 24) |
+	                       (static_cast<quint32>(p[1]) << 16) |
+	                       (static_cast<quint32>(p[2]) <<  8) |
+	                        static_cast<quint32>(p[3]);
+	unsigned int frame_length = 0;
+	unsigned int samples      = 0;
+	const bool valid = parseFrameHeader(p, frame_length, samples);
+
+	if (!fixed) {
+	    // search for the first frame, like libmad: it must be followed
+	    // by a frame of the same version, layer and sample rate
+	    bool found = valid;
+	    const qint64 next = pos + frame_length;
+	    if (found && (next + 4 <= buf_start + buf_len)) {
+		const unsigned char *n = m_buffer + (next - buf_start);
+		unsigned int l, s;
+		const quint32 h = (static_cast<quint32>(n[0]) << 24) |
+		                  (static_cast<quint32>(n[1]) << 16) |
+		                  (static_cast<quint32>(n[2]) <<  8) |
+		                   static_cast<quint32>(n[3]);
+		found = parseFrameHeader(n, l, s) &&
+		    ((h & MP3_HEADER_FIXED_MASK) ==
+		     (header & MP3_HEADER_FIXED_MASK));
+	    }
+	    if (!found) {
+		// give up if there is no sync within the first buffer
+		if (++pos - first >= m_buffer_size) return 0;
+		continue;
+	    }
+	    fixed = header & MP3_HEADER_FIXED_MASK;
+	} else if (!valid || ((header & MP3_HEADER_FIXED_MASK) != fixed)) {
+	    // free format or garbage, length unknown
+	    qDebug("MP3Decoder::scanLength(): no frame at %lld",
+	           static_cast<long long int>(pos));
+	    return 0;
+	}
+
+	// a truncated frame at the end will not be decoded
+	if (pos + frame_length > end) break;
+
+	length += samples;
+	pos    += frame_length;
+    }
+
+    qDebug("MP3Decoder::scanLength(): %llu samples",
+           static_cast<unsigned long long int>(length));
+    return length;
+}
+
 //***************************************************************************
 static enum mad_flow _input_adapter(void *data, struct mad_stream *stream)
 {
@@ -505,6 +659,11 @@ enum mad_flow Kwave::MP3Decoder::handleError(void */*data*/,
     if (m_failures >= 2) return MAD_FLOW_CONTINUE; // ignore errors
     if (stream->error == MAD_ERROR_NONE) return MAD_FLOW_CONTINUE; // ???
 
+    // no sync within the guard bytes at the end is not an error
+    if ((stream->error == MAD_ERROR_LOSTSYNC) && m_guard &&
+        (stream->this_frame >= m_guard))
+	return MAD_FLOW_CONTINUE;
+
     QString error;
     switch (stream->error) {
 	case MAD_ERROR_BUFLEN:
@@ -580,9 +739,17 @@ enum mad_flow Kwave::MP3Decoder::fillInput(struct mad_stream *stream)
         bytes_to_read = Kwave::toUint(
 	    m_source->size() - m_appended_bytes - m_source->pos());
 
-    // abort if nothing more to read, even if there are
-    // some "left-overs" from the previous pass
-    if (!bytes_to_read) return MAD_FLOW_STOP;
+    // at the end, append some zero bytes to the "left-overs" from
+    // the previous pass, otherwise libmad does not decode the last frame
+    if (!bytes_to_read) {
+	if (m_guard || !rest) return MAD_FLOW_STOP;
+	if (rest + MAD_BUFFER_GUARD > static_cast<size_t>(m_buffer_size))
+	    return MAD_FLOW_STOP;
+	memset(m_buffer + rest, 0x00, MAD_BUFFER_GUARD);
+	m_guard = m_buffer + rest;
+	mad_stream_buffer(stream, m_buffer, rest + MAD_BUFFER_GUARD);
+	return MAD_FLOW_CONTINUE;
+    }
 
     // read from source to fill up the buffer
     size_t size = rest;
@@ -596,105 +763,55 @@ enum mad_flow Kwave::MP3Decoder::fillInput(struct mad_stream *stream)
     return MAD_FLOW_CONTINUE;
 }
 
-/**
- * (copied from mpg231, mad.c)
- * @author Rob Leslie
- */
-namespace Kwave {
-    typedef struct {
-	mad_fixed_t error[3];
-	mad_fixed_t random;
-    } audio_dither;
-}
-
-/**
- * 32-bit pseudo-random number generator
- * (copied from mpg231, mad.c)
- * @author Rob Leslie
- */
-static inline quint32 prng(quint32 state)
-{
-    return (state * 0x0019660dL + 0x3c6ef35fL) & 0xffffffffL;
-}
-
-/**
- * generic linear sample quantize and dither routine
- * (copied from mpg231, mad.c)
- * @author Rob Leslie
- */
-static inline qint32 audio_linear_dither(unsigned int bits,
-    mad_fixed_t sample, Kwave::audio_dither *dither)
+//***************************************************************************
+enum mad_flow Kwave::MP3Decoder::processOutput(void */*data*/,
+    struct mad_header const */*header*/, struct mad_pcm *pcm)
 {
-    unsigned int scalebits;
-    mad_fixed_t output, mask, random;
-
-    enum {
-	MIN = -MAD_F_ONE,
-	MAX =  MAD_F_ONE - 1
-    };
-
-    /* noise shape */
-    sample += dither->error[0] - dither->error[1] + dither->error[2];
-
-    dither->error[2] = dither->error[1];
-    dither->error[1] = dither->error[0] / 2;
-
-    /* bias */
-    output = sample + mad_fixed_t(1L << (MAD_F_FRACBITS + 1 - bits - 1));
-
-    scalebits = MAD_F_FRACBITS + 1 - bits;
-    mask = mad_fixed_t(1L << scalebits) - 1;
-
-    /* dither */
-    random  = static_cast<mad_fixed_t>(prng(dither->random));
-    output += (random & mask) - (dither->random & mask);
-
-    dither->random = random;
+    const unsigned int tracks = m_dest->tracks();
+    if (!tracks || !pcm->channels) return MAD_FLOW_CONTINUE;
+    Q_ASSERT(Kwave::toInt(tracks) == m_blocks.count());
+
+    unsigned int offset = 0;
+    while (offset < pcm->length) {
+	const unsigned int len = qMin<unsigned int>(
+	    pcm->length - offset, MP3_BLOCK_SIZE - m_block_used);
+
+	// render the samples into Kwave's internal format,
+	// directly into the output blocks
+	for (unsigned int track = 0; track < tracks; ++track) {
+	    const unsigned int channel = qMin<unsigned int>(track,
+		pcm->channels - 1);
+	    Kwave::fixed2samples(pcm->samples[channel] + offset,
+	                         MAD_F_FRACBITS,
+	                         m_blocks[track].data() + m_block_used,
+	                         len, m_dither);
+	}
+	m_block_used += len;
+	offset       += len;
 
-    /* clip */
-    if (output > MAX) {
-	output = MAX;
-	if (sample > MAX) sample = MAX;
-    } else if (output < MIN) {
-	output = MIN;
-	if (sample < MIN) sample = MIN;
+	if ((m_block_used >= MP3_BLOCK_SIZE) && !flushBlocks())
+	    return MAD_FLOW_BREAK;
     }
 
-    /* quantize */
-    output &= ~mask;
-
-    /* error feedback */
-    dither->error[0] = sample - output;
-
-    /* scale */
-    return output >> scalebits;
+    return MAD_FLOW_CONTINUE;
 }
 
 //***************************************************************************
-enum mad_flow Kwave::MP3Decoder::processOutput(void */*data*/,
-    struct mad_header const */*header*/, struct mad_pcm *pcm)
+bool Kwave::MP3Decoder::flushBlocks()
 {
-    static Kwave::audio_dither dither;
-    qint32 sample;
-    Kwave::SampleArray buffer(pcm->length);
+    if (!m_block_used) return true;
 
-    // loop over all tracks
     const unsigned int tracks = m_dest->tracks();
     for (unsigned int track = 0; track < tracks; ++track) {
-	unsigned int nsamples = pcm->length;
-	mad_fixed_t const *p = pcm->samples[track];
-	unsigned int ofs = 0;
-
-	// and render samples into Kwave's internal format
-	while (nsamples--) {
-	    sample = static_cast<qint32>(audio_linear_dither(SAMPLE_BITS,
-	             static_cast<mad_fixed_t>(*p++), &dither));
-	    buffer[ofs++] = static_cast<sample_t>(sample);
-	}
-	*(*m_dest)[track] << buffer;
+	Kwave::SampleArray &block = m_blocks[track];
+	if ((m_block_used < block.size()) && !block.resize(m_block_used))
+	    return false;
+	*(*m_dest)[track] << block;
+	if ((block.size() < MP3_BLOCK_SIZE) && !block.resize(MP3_BLOCK_SIZE))
+	    return false;
     }
-
-    return MAD_FLOW_CONTINUE;
+    m_block_used = 0;
+    return true;
 }
 
 //***************************************************************************
@@ -708,6 +825,21 @@ bool Kwave::MP3Decoder::decode(QWidget *widget, Kwave::MultiWriter &dst)
     m_dest = &dst;
     m_failures = 0;
     m_parent_widget = widget;
+    m_guard = Q_NULLPTR;
+
+    // allocate the output blocks
+    const unsigned int tracks = dst.tracks();
+    m_blocks.resize(Kwave::toInt(tracks));
+    for (unsigned int track = 0; track < tracks; ++track)
+	if (!m_blocks[track].resize(MP3_BLOCK_SIZE)) return false;
+    m_block_used = 0;
+
+    // start the dither generators at a fixed state, so that decoding
+    // the same file always gives the same result
+    m_dither[0] = 0x9E3779B9;
+    m_dither[1] = 0x7F4A7C15;
+    m_dither[2] = 0x85EBCA6B;
+    m_dither[3] = 0xC2B2AE35;
 
     // setup the decoder
     struct mad_decoder decoder;
@@ -725,6 +857,10 @@ bool Kwave::MP3Decoder::decode(QWidget *widget, Kwave::MultiWriter &dst)
     // release the decoder
     mad_decoder_finish(&decoder);
 
+    // pass the rest of the output and release the blocks
+    if (!flushBlocks()) result = -1;
+    m_blocks.clear();
+
     return (result == 0);
 }
 
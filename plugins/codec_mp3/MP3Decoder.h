@@ -25,9 +25,11 @@
 #include <id3/globals.h>
 
 #include <QString>
+#include <QVector>
 
 #include "libkwave/Decoder.h"
 #include "libkwave/FileInfo.h"
+#include "libkwave/SampleArray.h"
 
 #include "ID3_PropertyMap.h"
 
@@ -94,6 +96,21 @@ namespace Kwave
 	/** parse all known ID3 tags */
 	bool parseID3Tags(ID3_Tag &tag);
 
+	/**
+	 * Scans the headers of all MPEG frames of the source, without
+	 * decoding them, and returns the number of samples that libmad
+	 * will produce.
+	 * @return number of samples per track, or zero if the stream
+	 *         contains free format frames or invalid data
+	 */
+	sample_index_t scanLength();
+
+	/**
+	 * Passes the filled part of the output blocks to the writers
+	 * @return true if succeeded, false if out of memory
+	 */
+	bool flushBlocks();
+
 	/**
 	 * parse a ID3 frame into a string
 	 * @param frame a ID3 frame
@@ -124,6 +141,21 @@ namespace Kwave
 	/** number of appended bytes / id3v1 tag */
 	size_t m_appended_bytes;
 
+	/**
+	 * start of the guard bytes that have been appended to the input
+	 * at the end of the stream, null as long as the end is not reached
+	 */
+	const unsigned char *m_guard;
+
+	/** output blocks, one per track */
+	QVector<Kwave::SampleArray> m_blocks;
+
+	/** number of samples used in each of the output blocks */
+	unsigned int m_block_used;
+
+	/** state of the dither generators */
+	quint32 m_dither[4];
+
 	/** number of failures */
 	unsigned int m_failures;
 
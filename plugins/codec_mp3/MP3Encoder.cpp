@@ -27,9 +27,12 @@
 #include <QByteArray>
 #include <QDate>
 #include <QDateTime>
+#include <QElapsedTimer>
+#include <QFileInfo>
 #include <QLatin1Char>
 #include <QList>
 #include <QMap>
+#include <QRegExp>
 
 #include <KLocalizedString>
 
@@ -37,7 +40,7 @@
 #include "libkwave/GenreType.h"
 #include "libkwave/MessageBox.h"
 #include "libkwave/MetaDataList.h"
-#include "libkwave/MixerMatrix.h"
+#include "libkwave/MixerEngine.h"
 #include "libkwave/MultiTrackReader.h"
 #include "libkwave/Sample.h"
 #include "libkwave/SampleReader.h"
@@ -49,6 +52,10 @@
 #include "MP3Encoder.h"
 #include "MP3EncoderSettings.h"
 
+#ifdef HAVE_LAME
+#include "MP3LameEngine.h"
+#endif
+
 /***************************************************************************/
 Kwave::MP3Encoder::MP3Encoder()
     :Kwave::Encoder(),
@@ -254,6 +261,78 @@ void Kwave::MP3Encoder::encodeID3Tags(const Kwave::MetaDataList &meta_data,
     tag.Update();
 }
 
+#ifdef HAVE_LAME
+/***************************************************************************/
+Kwave::MP3LameEngine *Kwave::MP3Encoder::createLameEngine(
+    const Kwave::FileInfo &info,
+    const Kwave::MP3EncoderSettings &settings,
+    unsigned int channels)
+{
+    if (!Kwave::MP3EncoderSettings::useLibrary()) return Q_NULLPTR;
+
+    // only for LAME, not for other programs like TwoLAME or tooLAME
+    const QString program = QFileInfo(settings.m_path).baseName();
+    if ((settings.m_name != _("LAME")) && (program != _("lame")))
+	return Q_NULLPTR;
+
+    Kwave::MP3LameEngine *engine = new(std::nothrow)
+	Kwave::MP3LameEngine(channels, Kwave::toUint(info.rate()));
+    if (!engine) return Q_NULLPTR;
+
+    // nominal / lower / upper bitrate, the same way as for the
+    // external program
+    int bitrate_min =   8;
+    int bitrate_max = 320;
+    int bitrate_nom = 128;
+    int nominal = 0;
+    int lower   = 0;
+    int upper   = 0;
+    if (info.contains(Kwave::INF_BITRATE_NOMINAL)) {
+	bitrate_nom = info.get(Kwave::INF_BITRATE_NOMINAL).toInt() / 1000;
+	bitrate_nom = qBound(bitrate_min, bitrate_nom, bitrate_max);
+	nominal = bitrate_nom;
+    }
+    if (info.contains(Kwave::INF_BITRATE_LOWER)) {
+	int bitrate = info.get(Kwave::INF_BITRATE_LOWER).toInt() / 1000;
+	lower = qBound(bitrate_min, bitrate, bitrate_nom);
+    }
+    if (info.contains(Kwave::INF_BITRATE_UPPER)) {
+	int bitrate = info.get(Kwave::INF_BITRATE_UPPER).toInt() / 1000;
+	upper = qBound(bitrate_nom, bitrate, bitrate_max);
+    }
+    engine->setBitrate(nominal, lower, upper);
+
+    if (info.contains(Kwave::INF_MPEG_EMPHASIS)) {
+	int emphasis = info.get(Kwave::INF_MPEG_EMPHASIS).toInt();
+	engine->setEmphasis(((emphasis == 1) || (emphasis == 3)) ?
+	                    emphasis : 0);
+    }
+
+    engine->setFlags(
+	info.contains(Kwave::INF_COPYRIGHTED) &&
+	    info.get(Kwave::INF_COPYRIGHTED).toBool(),
+	!(info.contains(Kwave::INF_ORIGINAL) &&
+	    !info.get(Kwave::INF_ORIGINAL).toBool()),
+	(settings.m_flags.m_protect.length() != 0)
+    );
+
+    // take over "-q <n>" and "--strictly-enforce-ISO" from the settings
+    int quality = -1;
+    QRegExp rx_quality(_("-q\\s*(\\d)"));
+    if (rx_quality.indexIn(settings.m_encoding.m_noise_shaping) >= 0)
+	quality = rx_quality.cap(1).toInt();
+    engine->setQuality(quality,
+	settings.m_encoding.m_compatibility.contains(
+	    _("--strictly-enforce-ISO")));
+
+    if (!engine->init()) {
+	delete engine;
+	return Q_NULLPTR;
+    }
+    return engine;
+}
+#endif
+
 #define OPTION(__field__) \
     if (settings.__field__.length()) m_params.append(settings.__field__)
 
@@ -270,7 +349,9 @@ bool Kwave::MP3Encoder::encode(QWidget *widget, Kwave::MultiTrackReader &src,
     bool result = true;
     ID3_Tag id3_tag;
     Kwave::MP3EncoderSettings settings;
+    QElapsedTimer timer;
 
+    timer.start();
     settings.load();
 
     ID3_TagType id3_tag_type = ID3TT_ID3V2;
@@ -314,6 +395,37 @@ bool Kwave::MP3Encoder::encode(QWidget *widget, Kwave::MultiTrackReader &src,
     ID3_QIODeviceWriter id3_writer(dst);
     encodeID3Tags(meta_data, id3_tag);
 
+#ifdef HAVE_LAME
+    // use the LAME library in-process if LAME is selected, the external
+    // program is only a fallback
+    Kwave::MP3LameEngine *lame = createLameEngine(info, settings, out_tracks);
+    if (lame) {
+	if (id3_tag_type == ID3TT_ID3V2)
+	    id3_tag.Render(id3_writer, id3_tag_type);
+
+	result = lame->encode(src, dst);
+	delete lame;
+	if (!result) {
+	    Kwave::MessageBox::error(widget,
+		i18n("An error occurred while encoding with the "
+		     "LAME library."));
+	}
+
+	if (id3_tag_type != ID3TT_ID3V2)
+	    id3_tag.Render(id3_writer, id3_tag_type);
+
+	{
+	    QMutexLocker _lock(&m_lock);
+	    m_dst = Q_NULLPTR;
+	    dst.close();
+	}
+
+	qDebug("MP3Encoder::encode(): %lld ms for %0.1f s (LAME library)",
+	       timer.elapsed(), static_cast<double>(length) / rate);
+	return result;
+    }
+#endif
+
     OPTION(m_flags.m_prepend);          // optional parameters at the very start
 
     // mandantory audio input format and encoding options
@@ -430,9 +542,9 @@ bool Kwave::MP3Encoder::encode(QWidget *widget, Kwave::MultiTrackReader &src,
     if (id3_tag_type == ID3TT_ID3V2)
 	id3_tag.Render(id3_writer, id3_tag_type);
 
-    // MP3 supports only mono and stereo, prepare a mixer matrix
+    // MP3 supports only mono and stereo, prepare a mixer
     // (not used in case of tracks <= 2)
-    Kwave::MixerMatrix mixer(tracks, out_tracks);
+    Kwave::MixerEngine mixer(tracks, out_tracks);
 
     // read in from the sample readers
     const unsigned int buf_len = sizeof(m_write_buffer);
@@ -466,14 +578,8 @@ bool Kwave::MP3Encoder::encode(QWidget *widget, Kwave::MultiTrackReader &src,
 	    }
 
 	    if (tracks > 2) {
-		// multiply matrix with input to get output
-		const Kwave::SampleArray &in = in_samples;
-		for (y = 0; y < out_tracks; ++y) {
-		    double sum = 0;
-		    for (x = 0; x < tracks; ++x)
-			sum += static_cast<double>(in[x]) * mixer[x][y];
-		    out_samples[y] = static_cast<sample_t>(sum);
-		}
+		// mix the input to get output
+		mixer.mixFrame(in_samples.constData(), out_samples.data());
 
 		// use output of the matrix
 		src_buf = out_samples.constData();
@@ -563,6 +669,8 @@ bool Kwave::MP3Encoder::encode(QWidget *widget, Kwave::MultiTrackReader &src,
 	dst.close();
     }
 
+    qDebug("MP3Encoder::encode(): %lld ms for %0.1f s (external program)",
+           timer.elapsed(), static_cast<double>(length) / rate);
     return result;
 }
 
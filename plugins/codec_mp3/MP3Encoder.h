@@ -29,6 +29,7 @@
 #include "libkwave/Encoder.h"
 
 #include "ID3_PropertyMap.h"
+#include "MP3EncoderSettings.h"
 
 class ID3_Tag;
 class QIODevice;
@@ -37,6 +38,8 @@ class QWidget;
 namespace Kwave
 {
 
+    class FileInfo;
+    class MP3LameEngine;
     class MultiTrackReader;
 
     class MP3Encoder: public Kwave::Encoder
@@ -85,6 +88,22 @@ namespace Kwave
 	void encodeID3Tags(const Kwave::MetaDataList &meta_data,
 	                   ID3_Tag &tag);
 
+#ifdef HAVE_LAME
+	/**
+	 * Creates an encoder that uses the LAME library in-process,
+	 * if LAME is the selected encoder program
+	 * @param info file info with bitrates, emphasis and flags
+	 * @param settings the encoder settings
+	 * @param channels number of output channels
+	 * @return a new engine or null if LAME is not selected or the
+	 *         library rejected the settings
+	 */
+	Kwave::MP3LameEngine *createLameEngine(
+	    const Kwave::FileInfo &info,
+	    const Kwave::MP3EncoderSettings &settings,
+	    unsigned int channels);
+#endif
+
     private:
 
 	/** property - to - ID3 mapping */
@@ -27,9 +27,6 @@
 
 #include "MP3EncoderSettings.h"
 
-/** name of the section in the config file */
-#define MP3_ENCODER_CONFIG_GROUP "MP3_Encoder_Settings"
-
 /**
  * load from config file
  * @param field receives the value
@@ -148,5 +145,12 @@ void Kwave::MP3EncoderSettings::save()
     SAVE(m_info.m_version,                 "info_version_______________");
 }
 
+/***************************************************************************/
+bool Kwave::MP3EncoderSettings::useLibrary()
+{
+    KConfigGroup cfg = KSharedConfig::openConfig()->group(MP3_ENCODER_CONFIG_GROUP);
+    return cfg.readEntry(MP3_ENCODER_USE_LIBRARY, true);
+}
+
 /***************************************************************************/
 /***************************************************************************/
@@ -21,6 +21,12 @@
 #include <QtGlobal>
 #include <QString>
 
+/** name of the section in the config file */
+#define MP3_ENCODER_CONFIG_GROUP "MP3_Encoder_Settings"
+
+/** name of the hidden option for useLibrary() in the config file */
+#define MP3_ENCODER_USE_LIBRARY "use_library________________"
+
 namespace Kwave
 {
 
@@ -33,6 +39,14 @@ namespace Kwave
 	/** save to a config file */
 	void save();
 
+	/**
+	 * Returns whether LAME is used in-process through the library,
+	 * which is the default. This is a hidden option, not touched by
+	 * the dialog, for falling back to the external program (e.g. for
+	 * comparing both in the benchmark).
+	 */
+	static bool useLibrary();
+
 	QString m_name;                 /**< name of the program (preset) */
 	QString m_path;                 /**< path to the executable       */
 
@@ -0,0 +1,629 @@
+/***************************************************************************
+      MP3LameEngine.cpp  -  MP3 encoding with the LAME library
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "config.h"
+
+#include <new>
+#include <string.h>
+
+#include <QFuture>
+#include <QIODevice>
+#include <QList>
+#include <QThreadPool>
+#include <QtConcurrentRun>
+
+#include "libkwave/MixerEngine.h"
+#include "libkwave/MultiTrackReader.h"
+#include "libkwave/SampleReader.h"
+#include "libkwave/Utils.h"
+
+#include "MP3LameEngine.h"
+
+/**
+ * number of samples of a MPEG-1 layer III frame, segments start at
+ * multiples of it (also a multiple of the MPEG-2 frame size)
+ */
+#define FRAME_GRID 1152
+
+/** length of a segment, in units of FRAME_GRID (~13s at 44.1kHz) */
+#define SEGMENT_FRAMES 512
+
+/** overlap before a segment, for settling the encoder [FRAME_GRID] */
+#define PREROLL_FRAMES 4
+
+/** maximum number of frames to search for a join */
+#define SEARCH_FRAMES 16
+
+/** overlap after a segment, covers the search and the encoder delay */
+#define POSTROLL_FRAMES (SEARCH_FRAMES + 2)
+
+/** number of samples read from the source at once */
+#define READ_BLOCK_SIZE (64 * FRAME_GRID)
+
+/** worst case size of the encoded data, see lame.h */
+#define MP3_BUFFER_SIZE(samples) ((samples) + ((samples) / 4) + 7200)
+
+//***************************************************************************
+Kwave::MP3LameEngine::MP3LameEngine(unsigned int channels, unsigned int rate)
+    :m_channels(qBound(1U, channels, 2U)), m_rate(rate),
+     m_frame_size((rate >= 32000) ? 1152 : 576),
+     m_rate_supported(false), m_bitrate_nominal(0), m_bitrate_lower(0),
+     m_bitrate_upper(0), m_emphasis(0), m_copyright(false),
+     m_original(true), m_crc(false), m_quality(-1), m_strict_iso(false),
+     m_in(), m_out(), m_pending(Q_NULLPTR)
+{
+    static const unsigned int rates[] = {
+	 8000, 11025, 12000, 16000, 22050, 24000, 32000, 44100, 48000
+    };
+    for (unsigned int i = 0; i < sizeof(rates) / sizeof(rates[0]); ++i)
+	if (rates[i] == rate) m_rate_supported = true;
+}
+
+//***************************************************************************
+Kwave::MP3LameEngine::~MP3LameEngine()
+{
+    delete m_pending;
+}
+
+//***************************************************************************
+void Kwave::MP3LameEngine::setBitrate(int nominal, int lower, int upper)
+{
+    m_bitrate_nominal = nominal;
+    m_bitrate_lower   = lower;
+    m_bitrate_upper   = upper;
+}
+
+//***************************************************************************
+void Kwave::MP3LameEngine::setEmphasis(int emphasis)
+{
+    m_emphasis = emphasis;
+}
+
+//***************************************************************************
+void Kwave::MP3LameEngine::setFlags(bool copyright, bool original, bool crc)
+{
+    m_copyright = copyright;
+    m_original  = original;
+    m_crc       = crc;
+}
+
+//***************************************************************************
+void Kwave::MP3LameEngine::setQuality(int quality, bool strict_iso)
+{
+    m_quality    = quality;
+    m_strict_iso = strict_iso;
+}
+
+//***************************************************************************
+lame_t Kwave::MP3LameEngine::createEncoder(bool reservoir) const
+{
+    lame_t gfp = lame_init();
+    if (!gfp) return Q_NULLPTR;
+
+    lame_set_num_channels(gfp, static_cast<int>(m_channels));
+    lame_set_in_samplerate(gfp, static_cast<int>(m_rate));
+    if (m_rate_supported) {
+	// never resample, otherwise the frames would not match the
+	// positions of the segments
+	lame_set_out_samplerate(gfp, static_cast<int>(m_rate));
+    }
+    lame_set_mode(gfp, (m_channels == 1) ? MONO : JOINT_STEREO);
+
+    if (m_bitrate_nominal) {
+	lame_set_VBR(gfp, vbr_abr);
+	lame_set_VBR_mean_bitrate_kbps(gfp, m_bitrate_nominal);
+	if (m_bitrate_lower)
+	    lame_set_VBR_min_bitrate_kbps(gfp, m_bitrate_lower);
+	if (m_bitrate_upper)
+	    lame_set_VBR_max_bitrate_kbps(gfp, m_bitrate_upper);
+    } else {
+	lame_set_VBR(gfp, vbr_off);
+	if (m_bitrate_lower) lame_set_brate(gfp, m_bitrate_lower);
+    }
+
+    lame_set_emphasis(gfp, m_emphasis);
+    lame_set_copyright(gfp, m_copyright ? 1 : 0);
+    lame_set_original(gfp, m_original ? 1 : 0);
+    lame_set_error_protection(gfp, m_crc ? 1 : 0);
+    if (m_quality >= 0) lame_set_quality(gfp, m_quality);
+    lame_set_strict_ISO(gfp, m_strict_iso ? 1 : 0);
+
+    // no Xing/Info frame, it can not be written into a stream
+    lame_set_bWriteVbrTag(gfp, 0);
+    lame_set_disable_reservoir(gfp, reservoir ? 0 : 1);
+
+    if (lame_init_params(gfp) < 0) {
+	lame_close(gfp);
+	return Q_NULLPTR;
+    }
+    return gfp;
+}
+
+//***************************************************************************
+bool Kwave::MP3LameEngine::init()
+{
+    lame_t gfp = createEncoder(true);
+    if (!gfp) {
+	qWarning("MP3LameEngine: the LAME library rejected the settings");
+	return false;
+    }
+    m_frame_size = static_cast<unsigned int>(lame_get_framesize(gfp));
+    if ((m_frame_size != 1152) && (m_frame_size != 576))
+	m_rate_supported = false;
+    lame_close(gfp);
+    return true;
+}
+
+//***************************************************************************
+unsigned int Kwave::MP3LameEngine::readBlock(Kwave::MultiTrackReader &src,
+                                             Kwave::MixerEngine &mixer,
+                                             QVector<float> *out,
+                                             unsigned int length)
+{
+    const unsigned int tracks = src.tracks();
+    if (static_cast<unsigned int>(m_in.size()) != tracks)
+	m_in.resize(tracks);
+    if (static_cast<unsigned int>(m_out.size()) != m_channels)
+	m_out.resize(m_channels);
+
+    // read all tracks, up to the shortest one
+    QVector<const sample_t *> in(tracks);
+    for (unsigned int t = 0; t < tracks; ++t) {
+	Kwave::SampleReader *reader = src[t];
+	if (!reader || !m_in[t].resize(length)) return 0;
+	length = qMin(length, reader->read(m_in[t], 0, length));
+	in[t] = m_in[t].constData();
+    }
+    if (!length) return 0;
+
+    // mix down to mono/stereo if necessary
+    QVector<const sample_t *> samples(in);
+    if (tracks != m_channels) {
+	QVector<sample_t *> mixed(m_channels);
+	for (unsigned int c = 0; c < m_channels; ++c) {
+	    if (!m_out[c].resize(length)) return 0;
+	    mixed[c] = m_out[c].data();
+	}
+	mixer.mix(in.constData(), mixed.constData(), length);
+	samples.resize(m_channels);
+	for (unsigned int c = 0; c < m_channels; ++c)
+	    samples[c] = m_out[c].constData();
+    }
+
+    // append as float
+    for (unsigned int c = 0; c < m_channels; ++c) {
+	const int pos = out[c].size();
+	out[c].resize(pos + static_cast<int>(length));
+	const sample_t *s = samples[c];
+	float          *d = out[c].data() + pos;
+	for (unsigned int i = 0; i < length; ++i)
+	    d[i] = sample2float(s[i]);
+    }
+
+    return length;
+}
+
+//***************************************************************************
+bool Kwave::MP3LameEngine::encode(Kwave::MultiTrackReader &src,
+                                  QIODevice &dst)
+{
+    const sample_index_t length = src.last() - src.first() + 1;
+    const int threads =
+	qMax(1, QThreadPool::globalInstance()->maxThreadCount());
+    Kwave::MixerEngine mixer(src.tracks(), m_channels);
+
+    // cut into segments only if it is worth it
+    const sample_index_t segment = SEGMENT_FRAMES * FRAME_GRID;
+    if (!m_rate_supported || (threads < 2) || (length < 2 * segment))
+	return encodeSequential(src, mixer, dst, length);
+    else
+	return encodeParallel(src, mixer, dst, length, threads);
+}
+
+//***************************************************************************
+bool Kwave::MP3LameEngine::encodeSequential(Kwave::MultiTrackReader &src,
+                                            Kwave::MixerEngine &mixer,
+                                            QIODevice &dst,
+                                            sample_index_t length)
+{
+    lame_t gfp = createEncoder(true);
+    if (!gfp) return false;
+
+    QVector<float> pcm[2];
+    QByteArray mp3;
+    bool ok = true;
+    sample_index_t rest = length;
+    while (ok && rest && !src.isCanceled()) {
+	pcm[0].resize(0);
+	pcm[1].resize(0);
+	unsigned int len = readBlock(src, mixer, pcm,
+	    Kwave::toUint(qMin<sample_index_t>(rest, READ_BLOCK_SIZE)));
+	if (!len) break;
+
+	mp3.resize(MP3_BUFFER_SIZE(len));
+	int n = lame_encode_buffer_ieee_float(gfp,
+	    pcm[0].constData(), pcm[m_channels - 1].constData(),
+	    static_cast<int>(len),
+	    reinterpret_cast<unsigned char *>(mp3.data()), mp3.size());
+	if (n < 0)
+	    ok = false;
+	else if (n && (dst.write(mp3.constData(), n) != n))
+	    ok = false;
+
+	rest -= len;
+    }
+
+    if (ok) {
+	mp3.resize(MP3_BUFFER_SIZE(0));
+	int n = lame_encode_flush(gfp,
+	    reinterpret_cast<unsigned char *>(mp3.data()), mp3.size());
+	if (n < 0)
+	    ok = false;
+	else if (n && (dst.write(mp3.constData(), n) != n))
+	    ok = false;
+    }
+
+    lame_close(gfp);
+    return ok;
+}
+
+//***************************************************************************
+bool Kwave::MP3LameEngine::encodeParallel(Kwave::MultiTrackReader &src,
+                                          Kwave::MixerEngine &mixer,
+                                          QIODevice &dst,
+                                          sample_index_t length,
+                                          int threads)
+{
+    const sample_index_t segment  = SEGMENT_FRAMES  * FRAME_GRID;
+    const sample_index_t preroll  = PREROLL_FRAMES  * FRAME_GRID;
+    const sample_index_t postroll = POSTROLL_FRAMES * FRAME_GRID;
+    const sample_index_t count    = length / segment; // last one is longer
+
+    // window with the samples that are needed by the current and the
+    // next segment, [window_start ... read_pos[
+    QVector<float> window[2];
+    sample_index_t window_start = 0;
+    sample_index_t read_pos     = 0;
+
+    QList<Segment *>      queue;
+    QList< QFuture<void> > futures;
+    bool ok = true;
+
+    for (sample_index_t k = 0; ok && (k < count); ++k) {
+	const sample_index_t start = k * segment;
+	const sample_index_t end   = (k + 1 < count) ?
+	                             (start + segment) : length;
+	const sample_index_t first = (k) ? (start - preroll) : 0;
+	const sample_index_t last  = qMin(end + postroll, length);
+
+	// read up to the end of the overlap after the segment
+	while (read_pos < last) {
+	    if (src.isCanceled()) break;
+	    unsigned int len = readBlock(src, mixer, window,
+		Kwave::toUint(qMin<sample_index_t>(last - read_pos,
+		                                   READ_BLOCK_SIZE)));
+	    if (!len) break;
+	    read_pos += len;
+	}
+	if (read_pos < last) break; // canceled or eof
+
+	Segment *seg = new(std::nothrow) Segment;
+	if (!seg) {
+	    ok = false;
+	    break;
+	}
+	seg->m_first_frame = first / m_frame_size;
+	seg->m_start_frame = start / m_frame_size;
+	seg->m_reservoir   = true;
+	seg->m_ok          = false;
+	seg->m_keep        = 0;
+	const int ofs = Kwave::toInt(first - window_start);
+	const int len = Kwave::toInt(last  - first);
+	for (unsigned int c = 0; c < m_channels; ++c)
+	    seg->m_pcm[c] = window[c].mid(ofs, len);
+
+	// drop all samples that are not needed by the next segment
+	const sample_index_t next_first = end - preroll;
+	const int drop = Kwave::toInt(qMin(next_first, read_pos) -
+	                              window_start);
+	for (unsigned int c = 0; c < m_channels; ++c)
+	    window[c].remove(0, drop);
+	window_start += drop;
+
+	queue.append(seg);
+	futures.append(QtConcurrent::run(this,
+	    &Kwave::MP3LameEngine::encodeSegment, seg));
+
+	// limit the number of segments in memory, this also keeps the
+	// progress of reading close to the progress of encoding
+	while (ok && (queue.count() > threads)) {
+	    futures.first().waitForFinished();
+	    futures.removeFirst();
+	    ok = writeSegment(queue.takeFirst(), dst);
+	}
+    }
+
+    // wait for the remaining segments and write them out
+    while (!queue.isEmpty()) {
+	futures.first().waitForFinished();
+	futures.removeFirst();
+	Segment *seg = queue.takeFirst();
+	if (ok)
+	    ok = writeSegment(seg, dst);
+	else
+	    delete seg;
+    }
+
+    // the last segment is written up to its end
+    if (m_pending) {
+	if (ok) {
+	    const QByteArray &mp3 = m_pending->m_mp3;
+	    const int from = m_pending->m_frames.isEmpty() ? mp3.size() :
+		m_pending->m_frames[m_pending->m_keep].m_offset;
+	    const qint64 n = mp3.size() - from;
+	    if (n && (dst.write(mp3.constData() + from, n) != n))
+		ok = false;
+	}
+	delete m_pending;
+	m_pending = Q_NULLPTR;
+    }
+
+    return ok;
+}
+
+//***************************************************************************
+void Kwave::MP3LameEngine::encodeSegment(Segment *segment) const
+{
+    Q_ASSERT(segment);
+    if (!segment) return;
+
+    segment->m_ok = false;
+    segment->m_mp3.clear();
+    segment->m_frames.clear();
+
+    lame_t gfp = createEncoder(segment->m_reservoir);
+    if (!gfp) return;
+
+    const int len = segment->m_pcm[0].size();
+    segment->m_mp3.resize(MP3_BUFFER_SIZE(len) + MP3_BUFFER_SIZE(0));
+    unsigned char *out =
+	reinterpret_cast<unsigned char *>(segment->m_mp3.data());
+    const int size = segment->m_mp3.size();
+
+    int n = lame_encode_buffer_ieee_float(gfp,
+	segment->m_pcm[0].constData(),
+	segment->m_pcm[m_channels - 1].constData(),
+	len, out, size);
+    if (n >= 0) {
+	int f = lame_encode_flush(gfp, out + n, size - n);
+	if (f >= 0) {
+	    segment->m_mp3.resize(n + f);
+	    segment->m_ok = parseFrames(segment->m_mp3, segment->m_frames);
+	}
+    }
+    lame_close(gfp);
+}
+
+//***************************************************************************
+bool Kwave::MP3LameEngine::writeSegment(Segment *segment, QIODevice &dst)
+{
+    Q_ASSERT(segment);
+    if (!segment) return false;
+    if (!segment->m_ok || segment->m_frames.isEmpty()) {
+	qWarning("MP3LameEngine: encoding a segment failed");
+	delete segment;
+	return false;
+    }
+
+    if (!m_pending) {
+	// the first segment starts at the start of the signal
+	segment->m_keep = 0;
+    } else {
+	int cut_prev = -1;
+	int cut_next = -1;
+	if (!join(*m_pending, *segment, cut_prev, cut_next)) {
+	    // no frame found, the bit reservoir of this segment could
+	    // not be joined -> fall back to a segment without reservoir
+	    qDebug("MP3LameEngine: no join at frame %llu, "
+	           "re-encoding without bit reservoir",
+	           static_cast<unsigned long long int>(
+	               segment->m_start_frame));
+	    segment->m_reservoir = false;
+	    encodeSegment(segment);
+	    if (!segment->m_ok ||
+	        !join(*m_pending, *segment, cut_prev, cut_next))
+	    {
+		qWarning("MP3LameEngine: joining segments failed");
+		delete segment;
+		return false;
+	    }
+	}
+
+	// write out the previous segment up to the join
+	const QByteArray &mp3 = m_pending->m_mp3;
+	const int from = m_pending->m_frames[m_pending->m_keep].m_offset;
+	const qint64 n = m_pending->m_frames[cut_prev].m_offset - from;
+	const bool ok = (dst.write(mp3.constData() + from, n) == n);
+	delete m_pending;
+	m_pending = Q_NULLPTR;
+	segment->m_keep = cut_next;
+	if (!ok) {
+	    delete segment;
+	    return false;
+	}
+    }
+
+    // the input is no longer needed
+    segment->m_pcm[0] = QVector<float>();
+    segment->m_pcm[1] = QVector<float>();
+
+    m_pending = segment;
+    return true;
+}
+
+//***************************************************************************
+bool Kwave::MP3LameEngine::join(Segment &prev, Segment &next,
+                                int &cut_prev, int &cut_next)
+{
+    // the frames of both segments are on the same grid, a frame with
+    // the global index g is prev.m_frames[g - prev.m_first_frame] and
+    // next.m_frames[g - next.m_first_frame]
+    const quint64 end = next.m_start_frame + SEARCH_FRAMES;
+    for (quint64 g = next.m_start_frame; g < end; ++g) {
+	if (g <= prev.m_first_frame || g <= next.m_first_frame) continue;
+	const int p = Kwave::toInt(g - prev.m_first_frame);
+	const int n = Kwave::toInt(g - next.m_first_frame);
+	if ((p >= prev.m_frames.count()) || (n >= next.m_frames.count()))
+	    break;
+	if (p <= prev.m_keep) continue;
+
+	// the main data of frame g in the next segment starts within
+	// the bit reservoir of the previous frames. The previous segment
+	// must have reserved at least the same space for its own frame g,
+	// then the bytes can be taken over without touching the main
+	// data of the previous frames.
+	const int needed   = next.m_frames[n].m_main_data_begin;
+	const int reserved = prev.m_frames[p].m_main_data_begin;
+	if (needed > reserved) continue;
+	if (mainDataSpace(prev.m_frames, prev.m_keep, p) < needed) continue;
+	if (mainDataSpace(next.m_frames, 0, n) < needed) continue;
+
+	copyMainData(prev.m_mp3, prev.m_frames, p,
+	             next.m_mp3, next.m_frames, n, needed);
+	cut_prev = p;
+	cut_next = n;
+	return true;
+    }
+    return false;
+}
+
+//***************************************************************************
+bool Kwave::MP3LameEngine::parseFrames(const QByteArray &data,
+                                       QVector<Frame> &frames)
+{
+    // bitrates of layer III [kbit/s], MPEG-1 and MPEG-2/2.5
+    static const int bitrates[2][16] = {
+	{ 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0},
+	{ 0,  8, 16, 24, 32, 40, 48, 56,  64,  80,  96, 112, 128, 144, 160, 0}
+    };
+    // sample rates, indexed by the version bits: 2.5 / reserved / 2 / 1
+    static const int rates[4][3] = {
+	{ 11025, 12000,  8000 },
+	{     0,     0,     0 },
+	{ 22050, 24000, 16000 },
+	{ 44100, 48000, 32000 }
+    };
+
+    const quint8 *p = reinterpret_cast<const quint8 *>(data.constData());
+    const int size = data.size();
+    int offset = 0;
+
+    frames.clear();
+    while (offset + 4 <= size) {
+	const quint32 h =
+	    (static_cast<quint32>(p[offset + 0]) << 24) |
+	    (static_cast<quint32>(p[offset + 1]) << 16) |
+	    (static_cast<quint32>(p[offset + 2]) <<  8) |
+	    (static_cast<quint32>(p[offset + 3]));
+	if ((h & 0xFFE00000U) != 0xFFE00000U) return false; // no sync
+
+	const unsigned int version = (h >> 19) & 0x03;
+	const unsigned int layer   = (h >> 17) & 0x03;
+	const bool         crc     = !((h >> 16) & 0x01);
+	const unsigned int br_idx  = (h >> 12) & 0x0F;
+	const unsigned int sr_idx  = (h >> 10) & 0x03;
+	const unsigned int padding = (h >>  9) & 0x01;
+	const bool         mono    = (((h >> 6) & 0x03) == 3);
+	if ((version == 1) || (layer != 1) || (sr_idx == 3)) return false;
+
+	const bool mpeg1   = (version == 3);
+	const int  bitrate = bitrates[mpeg1 ? 0 : 1][br_idx] * 1000;
+	const int  rate    = rates[version][sr_idx];
+	if (!bitrate) return false; // free format is not supported
+
+	Frame frame;
+	frame.m_offset    = offset;
+	frame.m_length    = ((mpeg1 ? 144 : 72) * bitrate / rate) +
+	                    static_cast<int>(padding);
+	frame.m_main_data = 4 + (crc ? 2 : 0) +
+	    (mpeg1 ? (mono ? 17 : 32) : (mono ? 9 : 17));
+	if ((offset + frame.m_length > size) ||
+	    (frame.m_main_data > frame.m_length))
+	    return false;
+
+	// main_data_begin: first 9 bits (MPEG-1) / 8 bits of the side info
+	const quint8 *side = p + offset + 4 + (crc ? 2 : 0);
+	frame.m_main_data_begin = (mpeg1) ?
+	    ((side[0] << 1) | (side[1] >> 7)) : side[0];
+
+	frames.append(frame);
+	offset += frame.m_length;
+    }
+
+    return (offset == size);
+}
+
+//***************************************************************************
+int Kwave::MP3LameEngine::mainDataSpace(const QVector<Frame> &frames,
+                                        int first, int end)
+{
+    int space = 0;
+    for (int i = qMax(first, 0); i < end; ++i)
+	space += frames[i].m_length - frames[i].m_main_data;
+    return space;
+}
+
+//***************************************************************************
+void Kwave::MP3LameEngine::copyMainData(QByteArray &dst,
+                                        const QVector<Frame> &dst_frames,
+                                        int dst_index,
+                                        const QByteArray &src,
+                                        const QVector<Frame> &src_frames,
+                                        int src_index, int count)
+{
+    // walk backwards through the main data areas of both streams,
+    // skipping the headers and side information
+    int d     = dst_index - 1;
+    int s     = src_index - 1;
+    int d_end = (d >= 0) ?
+	(dst_frames[d].m_offset + dst_frames[d].m_length) : 0;
+    int s_end = (s >= 0) ?
+	(src_frames[s].m_offset + src_frames[s].m_length) : 0;
+    while (count > 0) {
+	if ((d < 0) || (s < 0)) break;
+	const int d_start = dst_frames[d].m_offset + dst_frames[d].m_main_data;
+	const int s_start = src_frames[s].m_offset + src_frames[s].m_main_data;
+	const int n = qMin(count, qMin(d_end - d_start, s_end - s_start));
+	if (n > 0) {
+	    memcpy(dst.data() + d_end - n, src.constData() + s_end - n, n);
+	    d_end -= n;
+	    s_end -= n;
+	    count -= n;
+	}
+	if (d_end <= d_start) {
+	    if (--d >= 0)
+		d_end = dst_frames[d].m_offset + dst_frames[d].m_length;
+	}
+	if (s_end <= s_start) {
+	    if (--s >= 0)
+		s_end = src_frames[s].m_offset + src_frames[s].m_length;
+	}
+    }
+}
+
+//***************************************************************************
+//***************************************************************************
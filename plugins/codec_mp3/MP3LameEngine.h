@@ -0,0 +1,288 @@
+/***************************************************************************
+        MP3LameEngine.h  -  MP3 encoding with the LAME library
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef MP3_LAME_ENGINE_H
+#define MP3_LAME_ENGINE_H
+
+#include "config.h"
+
+#include <lame/lame.h>
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QVector>
+
+#include "libkwave/Sample.h"
+#include "libkwave/SampleArray.h"
+
+class QIODevice;
+
+namespace Kwave
+{
+
+    class MixerEngine;
+    class MultiTrackReader;
+
+    /**
+     * Encodes MP3 in-process through the API of the LAME library.
+     *
+     * Long signals are cut into segments that are encoded in parallel,
+     * each one with its own instance of the encoder and some frames of
+     * overlap before and after the segment. The segments are joined at
+     * a frame where the bit reservoir of the following segment fits into
+     * the space that the preceding segment has reserved for it, so that
+     * the main data of the first frame after the join is still complete.
+     * If no such frame is found, the segment is encoded again without
+     * bit reservoir.
+     */
+    class MP3LameEngine
+    {
+    public:
+
+	/**
+	 * Constructor
+	 * @param channels number of output channels, 1 or 2
+	 * @param rate sample rate [samples / second]
+	 */
+	MP3LameEngine(unsigned int channels, unsigned int rate);
+
+	/** Destructor */
+	virtual ~MP3LameEngine();
+
+	/**
+	 * Sets the bitrates, all values in kbit/s, zero if not set
+	 * @param nominal average bitrate (ABR mode) or zero for CBR
+	 * @param lower minimum bitrate, or bitrate in CBR mode
+	 * @param upper maximum bitrate
+	 */
+	void setBitrate(int nominal, int lower, int upper);
+
+	/**
+	 * Sets the emphasis mode
+	 * @param emphasis 0 = none, 1 = 50/15ms, 3 = CCIT J.17
+	 */
+	void setEmphasis(int emphasis);
+
+	/**
+	 * Sets the flags of the MPEG header
+	 * @param copyright true if copyrighted
+	 * @param original true if original
+	 * @param crc true to add a CRC to each frame
+	 */
+	void setFlags(bool copyright, bool original, bool crc);
+
+	/**
+	 * Sets the quality of the encoder
+	 * @param quality algorithm quality [0 ... 9], or -1 for default
+	 * @param strict_iso if true, strictly enforce ISO compliance
+	 */
+	void setQuality(int quality, bool strict_iso);
+
+	/**
+	 * Checks the settings by creating an encoder
+	 * @return true if the LAME library accepted the settings
+	 */
+	bool init();
+
+	/**
+	 * Encodes all samples of a source and writes the MP3 frames
+	 * to a device
+	 * @param src MultiTrackReader used as source of the audio data,
+	 *            mixed down to the number of output channels
+	 * @param dst device that receives the MP3 frames
+	 * @return true if successful or canceled, false on errors
+	 */
+	bool encode(Kwave::MultiTrackReader &src, QIODevice &dst);
+
+    private:
+
+	/** position of one MP3 frame within the encoded data */
+	typedef struct {
+	    int m_offset;          /**< offset of the header [bytes]     */
+	    int m_length;          /**< length of the frame [bytes]      */
+	    int m_main_data;       /**< offset of the main data [bytes]  */
+	    int m_main_data_begin; /**< main data in previous frames     */
+	} Frame;
+
+	/** one segment for parallel encoding */
+	typedef struct {
+	    quint64         m_first_frame; /**< index of the first frame  */
+	    quint64         m_start_frame; /**< first frame without overlap */
+	    bool            m_reservoir;   /**< false: without reservoir  */
+	    bool            m_ok;          /**< true if encoded           */
+	    QVector<float>  m_pcm[2];      /**< input samples, per channel */
+	    QByteArray      m_mp3;         /**< encoded frames            */
+	    QVector<Frame>  m_frames;      /**< list of encoded frames    */
+	    int             m_keep;        /**< index of the first frame
+	                                        that will be written      */
+	} Segment;
+
+	/**
+	 * Creates and initializes an instance of the encoder
+	 * @param reservoir if false, disable the bit reservoir
+	 * @return an encoder or null if failed
+	 */
+	lame_t createEncoder(bool reservoir) const;
+
+	/**
+	 * Reads a block of samples, mixes it down to the output channels
+	 * and appends it to a float buffer per channel
+	 * @param src the source of the samples
+	 * @param mixer mixer from the tracks of the source to the channels
+	 * @param out array with one buffer per channel
+	 * @param length number of samples to read
+	 * @return number of samples read
+	 */
+	unsigned int readBlock(Kwave::MultiTrackReader &src,
+	                       Kwave::MixerEngine &mixer,
+	                       QVector<float> *out, unsigned int length);
+
+	/** encodes the whole source with one encoder, block by block */
+	bool encodeSequential(Kwave::MultiTrackReader &src,
+	                      Kwave::MixerEngine &mixer,
+	                      QIODevice &dst, sample_index_t length);
+
+	/** encodes the source in segments, in parallel */
+	bool encodeParallel(Kwave::MultiTrackReader &src,
+	                    Kwave::MixerEngine &mixer,
+	                    QIODevice &dst, sample_index_t length,
+	                    int threads);
+
+	/**
+	 * Encodes one segment, called in the context of a worker thread
+	 * @param segment the segment, receives the MP3 frames
+	 */
+	void encodeSegment(Segment *segment) const;
+
+	/**
+	 * Joins a segment to the previous one and writes out the frames
+	 * of the previous one, up to the join
+	 * @param segment the next segment, the ownership is taken over
+	 * @param dst device that receives the MP3 frames
+	 * @return true if successful, false on errors
+	 */
+	bool writeSegment(Segment *segment, QIODevice &dst);
+
+	/**
+	 * Searches for a frame that can be used for joining two segments
+	 * and copies the main data of that frame from the bit reservoir
+	 * of the next segment into the previous segment.
+	 * @param prev the previous segment
+	 * @param next the next segment
+	 * @param cut_prev receives the index of the join in prev
+	 * @param cut_next receives the index of the join in next
+	 * @return true if a join has been found
+	 */
+	static bool join(Segment &prev, Segment &next,
+	                 int &cut_prev, int &cut_next);
+
+	/**
+	 * Splits encoded data into MP3 frames
+	 * @param data the encoded data, layer III frames only
+	 * @param frames receives the list of frames
+	 * @return true if the data contained only complete frames
+	 */
+	static bool parseFrames(const QByteArray &data,
+	                        QVector<Frame> &frames);
+
+	/**
+	 * Returns the number of bytes of main data space in a range
+	 * of frames
+	 * @param frames list of frames
+	 * @param first index of the first frame
+	 * @param end index after the last frame
+	 */
+	static int mainDataSpace(const QVector<Frame> &frames,
+	                         int first, int end);
+
+	/**
+	 * Copies the last bytes of main data space before a frame
+	 * @param dst data that receives the bytes
+	 * @param dst_frames list of frames in dst
+	 * @param dst_index index of the frame in dst
+	 * @param src data with the source bytes
+	 * @param src_frames list of frames in src
+	 * @param src_index index of the frame in src
+	 * @param count number of bytes to copy
+	 */
+	static void copyMainData(QByteArray &dst,
+	                         const QVector<Frame> &dst_frames,
+	                         int dst_index,
+	                         const QByteArray &src,
+	                         const QVector<Frame> &src_frames,
+	                         int src_index, int count);
+
+    private:
+
+	/** number of output channels */
+	unsigned int m_channels;
+
+	/** sample rate */
+	unsigned int m_rate;
+
+	/** number of samples per MP3 frame */
+	unsigned int m_frame_size;
+
+	/**
+	 * true if the rate is supported by MP3 without resampling,
+	 * needed for cutting into segments
+	 */
+	bool m_rate_supported;
+
+	/** average bitrate [kbit/s] or zero */
+	int m_bitrate_nominal;
+
+	/** minimum bitrate [kbit/s] or zero */
+	int m_bitrate_lower;
+
+	/** maximum bitrate [kbit/s] or zero */
+	int m_bitrate_upper;
+
+	/** emphasis mode */
+	int m_emphasis;
+
+	/** copyright flag */
+	bool m_copyright;
+
+	/** original flag */
+	bool m_original;
+
+	/** CRC protection */
+	bool m_crc;
+
+	/** quality of the algorithm, -1 = default */
+	int m_quality;
+
+	/** strict ISO compliance */
+	bool m_strict_iso;
+
+	/** buffers for reading, one per input track */
+	QVector<Kwave::SampleArray> m_in;
+
+	/** buffers for mixing, one per output channel */
+	QVector<Kwave::SampleArray> m_out;
+
+	/** previous segment, frames after m_keep not written yet */
+	Segment *m_pending;
+
+    };
+}
+
+#endif /* MP3_LAME_ENGINE_H */
+
+//***************************************************************************
+//***************************************************************************
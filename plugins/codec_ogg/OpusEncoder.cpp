@@ -57,10 +57,15 @@
 #include <QApplication>
 #include <QBuffer>
 #include <QByteArray>
+#include <QFutureSynchronizer>
 #include <QList>
+#include <QMutexLocker>
 #include <QRandomGenerator>
 #include <QString>
+#include <QThread>
+#include <QThreadPool>
 #include <QTime>
+#include <QtConcurrentRun>
 #include <QtGlobal>
 #include <QtEndian>
 
@@ -72,6 +77,7 @@
 #include "libkwave/MultiTrackReader.h"
 #include "libkwave/Sample.h"
 #include "libkwave/SampleArray.h"
+#include "libkwave/SampleReader.h"
 #include "libkwave/Utils.h"
 #include "libkwave/modules/ChannelMixer.h"
 #include "libkwave/modules/RateConverter.h"
@@ -94,6 +100,18 @@
 /** default encoder complexity */
 #define DEFAULT_COMPLEXITY 10
 
+/** maximum delay of a packet in the Ogg stream [48kHz samples] */
+#define MAX_OGG_DELAY 48000
+
+/** length of the segments for parallel encoding [seconds] */
+#define SEGMENT_LENGTH 30
+
+/** pre-roll of each segment, for letting the encoder converge [ms] */
+#define SEGMENT_PREROLL 80
+
+/** interval for updating the progress during parallel encoding [ms] */
+#define SEGMENT_PROGRESS_INTERVAL 100
+
 /***************************************************************************/
 Kwave::OpusEncoder::OpusEncoder()
     :m_comments_map(),
@@ -112,7 +130,20 @@ Kwave::OpusEncoder::OpusEncoder()
      m_encoder(Q_NULLPTR),
      m_encoder_input(Q_NULLPTR),
      m_last_queue_element(Q_NULLPTR),
-     m_buffer(Q_NULLPTR)
+     m_buffer(Q_NULLPTR),
+     m_enc_granulepos(0),
+     m_last_granulepos(0),
+     m_last_segments(0),
+     m_packet_id(0),
+     m_segments(),
+     m_stripes(),
+     m_src_frame_size(0),
+     m_next_segment(0),
+     m_stop(0),
+     m_segment_progress(0),
+     m_lock(),
+     m_segment_done(),
+     m_failed(false)
 {
 
     memset(&m_opus_header, 0x00, sizeof(m_opus_header));
@@ -774,19 +805,21 @@ bool Kwave::OpusEncoder::writeOggPage(QIODevice &dst)
 }
 
 /***************************************************************************/
-unsigned int Kwave::OpusEncoder::fillInBuffer(Kwave::MultiTrackReader &src)
+unsigned int Kwave::OpusEncoder::fillInBuffer(Kwave::MultiTrackReader &src,
+    Kwave::MultiTrackSink<Kwave::SampleBuffer, true> &buffer,
+    float *input, unsigned int &extra_out) const
 {
     unsigned int min_count = m_frame_size + 1; // will be used as "invalid"
 
     for (unsigned int t = 0; t < m_encoder_channels; ++t) {
-	Kwave::SampleBuffer *buf = m_buffer->at(t);
+	Kwave::SampleBuffer *buf = buffer.at(t);
 	Q_ASSERT(buf);
 	if (!buf) return 0;
 
 	unsigned int count = 0;
 	unsigned int rest  = m_frame_size;
 	while (rest) {
-	    float *p = m_encoder_input + t;
+	    float *p = input + (count * m_encoder_channels) + t;
 
 	    // while buffer is empty and source is not at eof:
 	    // trigger the start of the chain to produce some data
@@ -818,50 +851,127 @@ unsigned int Kwave::OpusEncoder::fillInBuffer(Kwave::MultiTrackReader &src)
 
     // if we were not able to fill a complete frame, we probably are at eof
     // and have some space to pad with extra samples to compensate preskip
-    while ((n < m_frame_size) && m_extra_out) {
+    while ((n < m_frame_size) && extra_out) {
 	Q_ASSERT(src.eof());
 	for (unsigned int t = 0; t < m_encoder_channels; ++t) {
-	    m_encoder_input[(n + t) * m_encoder_channels] = 0.0;
+	    input[(n * m_encoder_channels) + t] = 0.0;
 	}
-	m_extra_out--;
+	extra_out--;
 	n++;
     }
 
     return n;
 }
 
+/***************************************************************************/
+bool Kwave::OpusEncoder::writePacket(QIODevice &dst, unsigned char *packet,
+                                     int bytes, bool last)
+{
+    const int size_segments = (bytes + 255) / 255;
+
+    m_packet_id++;
+    m_enc_granulepos += m_frame_size * 48000 / m_coding_rate;
+
+    // flush early if adding this packet would make us end up with a
+    // continued page which we wouldn't have otherwise
+    while (( ((size_segments <= 255) &&
+	    (m_last_segments + size_segments > 255)) ||
+	    (m_enc_granulepos - m_last_granulepos > MAX_OGG_DELAY)) &&
+#ifdef HAVE_OGG_STREAM_FLUSH_FILL
+	    ogg_stream_flush_fill(&m_os, &m_og, 255 * 255))
+#else /* HAVE_OGG_STREAM_FLUSH_FILL */
+	    ogg_stream_flush(&m_os, &m_og))
+#endif /* HAVE_OGG_STREAM_FLUSH_FILL */
+    {
+	if (ogg_page_packets(&m_og) != 0)
+	    m_last_granulepos = ogg_page_granulepos(&m_og);
+
+	m_last_segments -= m_og.header[26];
+
+	if (!writeOggPage(dst)) {
+	    qWarning("Opus encoder: I/O error");
+	    return false;
+	}
+    }
+
+    m_op.packet     = packet;
+    m_op.packetno   = m_packet_id;
+    m_op.bytes      = bytes;
+    m_op.b_o_s      = 0;
+    m_op.e_o_s      = (last) ? 1 : 0;
+    m_op.granulepos = m_enc_granulepos;
+    if (m_op.e_o_s) {
+	// compute the final GP as ceil(len*48k/input_rate). When a
+	// resampling decoder does the matching floor(len*input/48k)
+	// conversion the length will be exactly the same as the input.
+	sample_index_t length = m_info.length();
+	double         rate   = m_info.rate();
+	m_op.granulepos = static_cast<ogg_int64_t>(
+	    ceil((static_cast<double>(length) * 48000.0) / rate) +
+	    m_opus_header.preskip);
+    }
+    ogg_stream_packetin(&m_os, &m_op);
+    m_last_segments += size_segments;
+
+    // If the stream is over or we're sure that the delayed flush will
+    // fire, go ahead and flush now to avoid adding delay.
+    while ((m_op.e_o_s || (m_enc_granulepos +
+	    ((m_frame_size * 48000) / m_coding_rate ) -
+	     m_last_granulepos > MAX_OGG_DELAY) || (m_last_segments >= 255)) ?
+#ifdef HAVE_OGG_STREAM_FLUSH_FILL
+	    ogg_stream_flush_fill(&m_os, &m_og, 255 * 255) :
+	    ogg_stream_pageout_fill(&m_os, &m_og, 255 * 255))
+#else /* HAVE_OGG_STREAM_FLUSH_FILL */
+	    /*Libogg > 1.2.2 allows us to achieve lower overhead by
+	      producing larger pages. For 20ms frames this is only relevant
+	      above ~32kbit/sec.*/
+	    ogg_stream_flush(&m_os, &m_og) :
+	    ogg_stream_pageout(&m_os, &m_og))
+#endif /* HAVE_OGG_STREAM_FLUSH_FILL */
+    {
+	if (ogg_page_packets(&m_og) != 0)
+	    m_last_granulepos = ogg_page_granulepos(&m_og);
+
+	m_last_segments -= m_og.header[26];
+	if (!writeOggPage(dst)) {
+	    qWarning("Opus encoder: I/O error");
+	    return false;
+	}
+    }
+
+    return true;
+}
+
 /***************************************************************************/
 bool Kwave::OpusEncoder::encode(Kwave::MultiTrackReader &src,
                                 QIODevice &dst)
 {
-    long int     eos             =  0;
-    opus_int64   nb_encoded      =  0;
+    bool         last            = false;
+    bool         eos             = false;
     opus_int64   nb_samples      = -1;
-    opus_int64   total_bytes     =  0;
     opus_int64   total_samples   =  0;
-    ogg_int64_t  enc_granulepos  =  0;
-    ogg_int64_t  last_granulepos =  0;
-    ogg_int32_t  packet_id       =  1;
-    int          last_segments   =  0;
-    const int    max_ogg_delay   =  48000; /* 48kHz samples */
 
     Q_ASSERT(m_encoder);
     Q_ASSERT(m_encoder_input);
 
-    Q_UNUSED(dst)
+    m_enc_granulepos  = 0;
+    m_last_granulepos = 0;
+    m_last_segments   = 0;
+    m_packet_id       = 1;
 
-    /* Main encoding loop (one frame per iteration) */
-    while (!m_op.e_o_s && !src.isCanceled()) {
-	int size_segments = 0;
-
-	packet_id++;
+    // long sources are split into segments and encoded in parallel
+    if (prepareSegments(src))
+	return encodeSegments(src, dst);
 
+    /* Main encoding loop (one frame per iteration) */
+    while (!last && !src.isCanceled()) {
 	if (nb_samples < 0) {
-	    nb_samples = fillInBuffer(src);
+	    nb_samples = fillInBuffer(src, *m_buffer, m_encoder_input,
+	                              m_extra_out);
 	    total_samples += nb_samples;
-	    m_op.e_o_s = (nb_samples < m_frame_size) ? 1 : 0;
+	    last = (nb_samples < m_frame_size);
 	}
-	m_op.e_o_s |= eos; // eof from last pass
+	last |= eos; // eof from last pass
 
 	// pad the rest of the frame with zeroes if necessary
 	if (nb_samples < m_frame_size ) {
@@ -887,93 +997,399 @@ bool Kwave::OpusEncoder::encode(Kwave::MultiTrackReader &src,
 	    return false;
 	}
 
-	nb_encoded     += m_frame_size;
-	enc_granulepos += m_frame_size * 48000 / m_coding_rate;
-	total_bytes    += nbBytes;
-	size_segments   = (nbBytes + 255) / 255;
+	// the downside of early reading is if the input is an exact
+	// multiple of the frame_size you'll get an extra frame that needs
+	// to get cropped off. The downside of late reading is added delay.
+	// If your ogg_delay is 120ms or less we'll assume you want the
+	// low delay behavior.
+	if (!last && (MAX_OGG_DELAY > 5760)) {
+	    nb_samples = fillInBuffer(src, *m_buffer, m_encoder_input,
+	                              m_extra_out);
+	    total_samples += nb_samples;
+	    if (nb_samples < m_frame_size) eos = true;
+	    if (nb_samples == 0) last = true;
+	} else {
+	    nb_samples = -1;
+	}
 
-	// flush early if adding this packet would make us end up with a
-	// continued page which we wouldn't have otherwise
-	while (( ((size_segments <= 255) &&
-		(last_segments + size_segments > 255)) ||
-		(enc_granulepos - last_granulepos > max_ogg_delay)) &&
-#ifdef HAVE_OGG_STREAM_FLUSH_FILL
-		ogg_stream_flush_fill(&m_os, &m_og, 255 * 255))
-#else /* HAVE_OGG_STREAM_FLUSH_FILL */
-		ogg_stream_flush(&m_os, &m_og))
-#endif /* HAVE_OGG_STREAM_FLUSH_FILL */
-	{
-	    if (ogg_page_packets(&m_og) != 0)
-		last_granulepos = ogg_page_granulepos(&m_og);
+	if (!writePacket(dst, m_packet_buffer, nbBytes, last))
+	    return false;
+    }
 
-	    last_segments -= m_og.header[26];
+    return true;
+}
 
-	    if (!writeOggPage(dst)) {
-		qWarning("Opus encoder: I/O error");
-		return false;
+/***************************************************************************/
+/**
+ * Returns the number of threads of the global thread pool that are
+ * currently not in use, by QtConcurrent jobs of other parts of Kwave
+ */
+static int idleThreads()
+{
+    const QThreadPool *pool = QThreadPool::globalInstance();
+    return qMax(0, pool->maxThreadCount() - pool->activeThreadCount());
+}
+
+/***************************************************************************/
+bool Kwave::OpusEncoder::prepareSegments(Kwave::MultiTrackReader &src)
+{
+    m_segments.clear();
+    m_stripes.clear();
+
+    // called from a worker thread, e.g. by the parallel export of blocks,
+    // which already runs one encoder per CPU: more threads would only
+    // compete for the same CPUs
+    if (QThread::currentThread() != qApp->thread()) return false;
+    if (idleThreads() < 2) return false;
+
+    // a frame must consist of a whole number of source samples, otherwise
+    // the segments could not start exactly at a frame boundary
+    const double rate = m_info.rate();
+    if ((rate < 1.0) || (rate != floor(rate))) return false;
+    const quint64 scaled = static_cast<quint64>(m_frame_size) *
+                           static_cast<quint64>(rate);
+    if (!m_coding_rate || (scaled % m_coding_rate)) return false;
+    m_src_frame_size = scaled / m_coding_rate;
+
+    Kwave::SampleReader *reader = src[0];
+    if (!reader || reader->eof()) return false;
+    const sample_index_t first  = reader->pos();
+    const sample_index_t last   = reader->last();
+    const sample_index_t frames = (last - first + 1) / m_src_frame_size;
+
+    // segment length and pre-roll in frames
+    const sample_index_t segment_frames =
+	(static_cast<sample_index_t>(SEGMENT_LENGTH) * m_coding_rate) /
+	m_frame_size;
+    const unsigned int preroll = Kwave::toUint(
+	((SEGMENT_PREROLL * m_coding_rate / 1000) + m_frame_size - 1) /
+	m_frame_size);
+    if (!segment_frames) return false;
+    const sample_index_t count = frames / segment_frames;
+    if (count < 2) return false; // not worth the effort
+
+    for (sample_index_t index = 0; index < count; ++index) {
+	const sample_index_t start = index * segment_frames;
+	Segment segment;
+	segment.m_skip  = (index) ? preroll : 0;
+	segment.m_first = first + (start - segment.m_skip) * m_src_frame_size;
+	if (index < count - 1) {
+	    // a post-roll lets the rate converter deliver all samples
+	    segment.m_frames = Kwave::toUint(segment_frames);
+	    segment.m_last   = qMin(last, first +
+		(start + segment_frames + preroll) * m_src_frame_size - 1);
+	} else {
+	    // the last segment takes the rest, up to the end
+	    segment.m_frames = 0;
+	    segment.m_last   = last;
+	}
+	segment.m_done = false;
+	m_segments.append(segment);
+    }
+
+    // take the stripes of the whole range, the workers create their
+    // readers from them, independent from the source
+    m_stripes.resize(Kwave::toInt(src.tracks()));
+    for (unsigned int t = 0; t < src.tracks(); t++) {
+	Kwave::SampleReader *r = src[t];
+	m_stripes[t] = (r) ? r->stripes(first, last) :
+	                     Kwave::Stripe::List(first, last);
+    }
+
+    qDebug("    OpusEncoder: encoding %u segments in parallel",
+           Kwave::toUint(count));
+    return true;
+}
+
+/***************************************************************************/
+bool Kwave::OpusEncoder::encodeSegments(Kwave::MultiTrackReader &src,
+                                        QIODevice &dst)
+{
+    const int count = m_segments.count();
+    const sample_index_t length = m_segments.last().m_last -
+                                  m_segments.first().m_first + 1;
+
+    m_next_segment.storeRelease(0);
+    m_stop.storeRelease(0);
+    m_segment_progress.storeRelease(0);
+    m_failed = false;
+
+    // start the workers, one per CPU that is not busy otherwise
+    const int threads = qBound(1, idleThreads(), count);
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+    QFutureSynchronizer<void> synchronizer;
+    for (int i = 0; i < threads; i++) {
+	synchronizer.addFuture(QtConcurrent::run(&pool,
+	    this, &Kwave::OpusEncoder::segmentWorker));
+    }
+
+    // splice the packets of all segments into the Ogg stream, in order
+    bool ok = true;
+    sample_index_t skipped = 0;
+    for (int index = 0; ok && (index < count); index++) {
+	QList<QByteArray> packets;
+	for (bool waiting = true; waiting; ) {
+	    // forward the progress to the source and watch out for cancel
+	    const sample_index_t done = qMin<sample_index_t>(length,
+		m_segment_progress.loadAcquire());
+	    if (done > skipped) {
+		src.skip(done - skipped);
+		skipped = done;
+	    }
+	    if (src.isCanceled()) m_stop.storeRelease(1);
+
+	    QMutexLocker lock(&m_lock);
+	    if (m_segments[index].m_done) {
+		packets.swap(m_segments[index].m_packets);
+		waiting = false;
+	    } else if (m_failed || m_stop.loadAcquire()) {
+		break;
+	    } else {
+		m_segment_done.wait(&m_lock, SEGMENT_PROGRESS_INTERVAL);
+		lock.unlock();
+		QApplication::processEvents();
 	    }
 	}
+	if (packets.isEmpty()) break; // failed or canceled
+
+	const bool last_segment = (index == count - 1);
+	for (int i = 0; ok && (i < packets.count()); ++i) {
+	    const bool last = last_segment && (i == packets.count() - 1);
+	    QByteArray &packet = packets[i];
+	    ok = writePacket(dst,
+		reinterpret_cast<unsigned char *>(packet.data()),
+		packet.size(), last);
+	}
+    }
 
-        // the downside of early reading is if the input is an exact
-        // multiple of the frame_size you'll get an extra frame that needs
-        // to get cropped off. The downside of late reading is added delay.
-        // If your ogg_delay is 120ms or less we'll assume you want the
-        // low delay behavior.
-        if ((!m_op.e_o_s ) && (max_ogg_delay > 5760)) {
-            nb_samples = fillInBuffer(src);
-            total_samples += nb_samples;
-            if (nb_samples < m_frame_size) eos = 1;
-            if (nb_samples == 0) m_op.e_o_s = 1;
-        } else {
-            nb_samples = -1;
-        }
-
-        m_op.packet     = m_packet_buffer;
-        m_op.packetno   = packet_id;
-        m_op.bytes      = nbBytes;
-        m_op.b_o_s      = 0;
-        m_op.granulepos = enc_granulepos;
-        if (m_op.e_o_s) {
-            // compute the final GP as ceil(len*48k/input_rate). When a
-            // resampling decoder does the matching floor(len*input/48k)
-            // conversion the length will be exactly the same as the input.
-            sample_index_t length = m_info.length();
-	    double         rate   = m_info.rate();
-	    m_op.granulepos = static_cast<ogg_int64_t>(
-		ceil((static_cast<double>(length) * 48000.0) / rate) +
-		m_opus_header.preskip);
-        }
-        ogg_stream_packetin(&m_os, &m_op);
-        last_segments += size_segments;
-
-        // If the stream is over or we're sure that the delayed flush will
-        // fire, go ahead and flush now to avoid adding delay.
-        while ((m_op.e_o_s || (enc_granulepos +
-	        ((m_frame_size * 48000) / m_coding_rate ) -
-	         last_granulepos > max_ogg_delay) || (last_segments >= 255)) ?
-#ifdef HAVE_OGG_STREAM_FLUSH_FILL
-                ogg_stream_flush_fill(&m_os, &m_og, 255 * 255) :
-                ogg_stream_pageout_fill(&m_os, &m_og, 255 * 255))
-#else /* HAVE_OGG_STREAM_FLUSH_FILL */
-                /*Libogg > 1.2.2 allows us to achieve lower overhead by
-                  producing larger pages. For 20ms frames this is only relevant
-                  above ~32kbit/sec.*/
-                ogg_stream_flush(&m_os, &m_og) :
-                ogg_stream_pageout(&m_os, &m_og))
-#endif /* HAVE_OGG_STREAM_FLUSH_FILL */
+    m_stop.storeRelease(1);
+    synchronizer.waitForFinished();
+
+    m_segments.clear();
+    m_stripes.clear();
+    return ok && !m_failed;
+}
+
+/***************************************************************************/
+void Kwave::OpusEncoder::segmentWorker()
+{
+    for (;;) {
+	if (m_stop.loadAcquire()) break;
+	const int index = m_next_segment.fetchAndAddOrdered(1);
+
+	Segment segment;
 	{
-            if (ogg_page_packets(&m_og) != 0)
-                last_granulepos = ogg_page_granulepos(&m_og);
+	    QMutexLocker lock(&m_lock);
+	    if (index >= m_segments.count()) break;
+	    segment = m_segments.at(index);
+	}
 
-            last_segments -= m_og.header[26];
-	    if (!writeOggPage(dst)) {
-		qWarning("Opus encoder: I/O error");
-		return false;
-	    }
-        }
+	QList<QByteArray> packets;
+	const bool ok = encodeSegment(segment, packets);
+
+	QMutexLocker lock(&m_lock);
+	if (!ok) {
+	    m_failed = true;
+	    m_stop.storeRelease(1);
+	} else if (!m_stop.loadAcquire()) {
+	    m_segments[index].m_packets = packets;
+	    m_segments[index].m_done    = true;
+	}
+	m_segment_done.wakeAll();
     }
+}
 
-    return true;
+/***************************************************************************/
+bool Kwave::OpusEncoder::encodeSegment(
+    const Kwave::OpusEncoder::Segment &segment, QList<QByteArray> &packets)
+{
+    const unsigned int src_tracks = Kwave::toUint(m_stripes.count());
+    bool ok = true;
+
+    // one reader per track, on the stripes of this segment only
+    Kwave::MultiTrackReader src;
+    for (unsigned int t = 0; ok && (t < src_tracks); t++) {
+	Kwave::Stripe::List stripes(segment.m_first, segment.m_last);
+	foreach (const Kwave::Stripe &s, m_stripes[t]) {
+	    if (s.start() > segment.m_last) break;
+	    if (s.end() < segment.m_first) continue;
+	    stripes.append(s);
+	}
+	Kwave::SampleReader *reader = new(std::nothrow)
+	    Kwave::SampleReader(Kwave::SinglePassForward, stripes);
+	ok = (reader && src.insert(t, reader));
+    }
+
+    // the same queue as in open(): mixer, rate converter and buffer
+    Kwave::StreamObject *last_queue_element = &src;
+    Kwave::ChannelMixer *mixer = Q_NULLPTR;
+    if (ok && m_channel_mixer) {
+	mixer = new(std::nothrow)
+	    Kwave::ChannelMixer(src_tracks, m_encoder_channels);
+	ok = mixer && mixer->init() && Kwave::connect(
+	    *last_queue_element, SIGNAL(output(Kwave::SampleArray)),
+	    *mixer,              SLOT(input(Kwave::SampleArray)));
+	last_queue_element = mixer;
+    }
+
+    Kwave::StreamObject *converter = Q_NULLPTR;
+    if (ok && m_rate_converter) {
+	const double ratio = static_cast<double>(m_coding_rate) /
+	                     m_info.rate();
+	converter = new(std::nothrow)
+	    Kwave::MultiTrackSource<Kwave::RateConverter, true>(
+		m_encoder_channels);
+	if (converter) converter->setAttribute(
+	    SLOT(setRatio(QVariant)), QVariant(ratio));
+	ok = converter && Kwave::connect(
+	    *last_queue_element, SIGNAL(output(Kwave::SampleArray)),
+	    *converter,          SLOT(input(Kwave::SampleArray)));
+	last_queue_element = converter;
+    }
+
+    Kwave::MultiTrackSink<Kwave::SampleBuffer, true> *buffer = Q_NULLPTR;
+    if (ok) {
+	buffer = new(std::nothrow)
+	    Kwave::MultiTrackSink<Kwave::SampleBuffer, true>(
+		m_encoder_channels);
+	ok = buffer && Kwave::connect(
+	    *last_queue_element, SIGNAL(output(Kwave::SampleArray)),
+	    *buffer,             SLOT(input(Kwave::SampleArray)));
+    }
+
+    // an own encoder, with input and packet buffer
+    OpusMSEncoder *encoder = (ok) ? createSegmentEncoder() : Q_NULLPTR;
+    float *input = static_cast<float *>(
+	malloc(sizeof(float) * m_frame_size * m_encoder_channels));
+    unsigned char *packet = static_cast<unsigned char *>(
+	malloc(m_max_frame_bytes));
+    if (!encoder || !input || !packet) ok = false;
+
+    // only the last segment pads at the end, to compensate preskip
+    unsigned int extra_out = (segment.m_frames) ? 0 : m_extra_out;
+
+    for (unsigned int i = 0; ok &&
+         (!segment.m_frames || (i < segment.m_skip + segment.m_frames));
+         ++i)
+    {
+	if (m_stop.loadAcquire()) break;
+
+	const unsigned int n = fillInBuffer(src, *buffer, input, extra_out);
+	if (!n && i && !segment.m_frames) break; // multiple of frame size
+
+	// pad the rest of the frame with zeroes if necessary
+	for (unsigned int pos = n * m_encoder_channels;
+	     pos < m_frame_size * m_encoder_channels; pos++)
+	    input[pos] = 0;
+
+	const int bytes = opus_multistream_encode_float(
+	    encoder, input, m_frame_size, packet, m_max_frame_bytes);
+	if (bytes < 0) {
+	    qWarning("Opus encoder failed: '%s'",
+		     DBG(Kwave::opus_error(bytes)));
+	    ok = false;
+	    break;
+	}
+
+	// keep the packet if it is not part of the pre-roll
+	if (i >= segment.m_skip) {
+	    packets.append(QByteArray(reinterpret_cast<const char *>(packet),
+	                              bytes));
+	    m_segment_progress.fetchAndAddOrdered(m_src_frame_size);
+	}
+
+	if (!segment.m_frames && (n < m_frame_size)) break; // eof
+    }
+
+    if (encoder) opus_multistream_encoder_destroy(encoder);
+    free(packet);
+    free(input);
+    delete buffer;
+    delete converter;
+    delete mixer;
+    return ok;
+}
+
+/***************************************************************************/
+OpusMSEncoder *Kwave::OpusEncoder::createSegmentEncoder() const
+{
+    opus_int32 application = OPUS_APPLICATION_AUDIO;
+    opus_multistream_encoder_ctl(m_encoder,
+	OPUS_GET_APPLICATION(&application));
+
+    int err = OPUS_ALLOC_FAIL;
+    OpusMSEncoder *encoder = opus_multistream_encoder_create(
+	m_coding_rate,
+	m_encoder_channels,
+	m_opus_header.streams,
+	m_opus_header.coupled,
+	m_opus_header.map,
+	application,
+	&err
+    );
+    if (err != OPUS_OK) {
+	qWarning("OpusEncoder: creating encoder failed: '%s'",
+	         DBG(Kwave::opus_error(err)));
+	if (encoder) opus_multistream_encoder_destroy(encoder);
+	return Q_NULLPTR;
+    }
+
+    // the bitrate of the main encoder can not be queried before it has
+    // encoded the first frame, it is the sum over all streams
+    err = opus_multistream_encoder_ctl(encoder, OPUS_SET_BITRATE(
+	static_cast<opus_int32>(m_bitrate)));
+
+    // take over all other settings from the main encoder, get/set pairs
+    static const int settings[][2] = {
+	{ OPUS_GET_VBR_REQUEST,
+	  OPUS_SET_VBR_REQUEST              },
+	{ OPUS_GET_VBR_CONSTRAINT_REQUEST,
+	  OPUS_SET_VBR_CONSTRAINT_REQUEST   },
+	{ OPUS_GET_COMPLEXITY_REQUEST,
+	  OPUS_SET_COMPLEXITY_REQUEST       },
+	{ OPUS_GET_PACKET_LOSS_PERC_REQUEST,
+	  OPUS_SET_PACKET_LOSS_PERC_REQUEST },
+#ifdef OPUS_SET_LSB_DEPTH
+	{ OPUS_GET_LSB_DEPTH_REQUEST,
+	  OPUS_SET_LSB_DEPTH_REQUEST        },
+#endif /* OPUS_SET_LSB_DEPTH */
+    };
+    for (unsigned int i = 0;
+         (err == OPUS_OK) && (i < sizeof(settings) / sizeof(settings[0]));
+         ++i)
+    {
+	opus_int32 value = 0;
+	err = opus_multistream_encoder_ctl(m_encoder, settings[i][0],
+	                                   &value);
+	if (err == OPUS_OK)
+	    err = opus_multistream_encoder_ctl(encoder, settings[i][1],
+	                                       value);
+    }
+    if (err != OPUS_OK) {
+	qWarning("OpusEncoder: setting up the encoder failed: '%s'",
+	         DBG(Kwave::opus_error(err)));
+	opus_multistream_encoder_destroy(encoder);
+	return Q_NULLPTR;
+    }
+
+    // the bandwidth limits of the streams, for surround
+    for (unsigned int i = 0; i < m_opus_header.streams; i++) {
+	::OpusEncoder *from = Q_NULLPTR;
+	::OpusEncoder *to   = Q_NULLPTR;
+	opus_multistream_encoder_ctl(m_encoder,
+	    OPUS_MULTISTREAM_GET_ENCODER_STATE_REQUEST, i, &from);
+	opus_multistream_encoder_ctl(encoder,
+	    OPUS_MULTISTREAM_GET_ENCODER_STATE_REQUEST, i, &to);
+	if (!from || !to) continue;
+
+	opus_int32 bandwidth = OPUS_BANDWIDTH_FULLBAND;
+	if ((opus_encoder_ctl(from, OPUS_GET_MAX_BANDWIDTH(&bandwidth)) ==
+	     OPUS_OK) && (bandwidth != OPUS_BANDWIDTH_FULLBAND))
+	    opus_encoder_ctl(to, OPUS_SET_MAX_BANDWIDTH(bandwidth));
+    }
+
+    return encoder;
 }
 
 /***************************************************************************/
@@ -25,8 +25,18 @@
 #include <opus/opus.h>
 #include <opus/opus_multistream.h>
 
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include <QByteArray>
+#include <QList>
+#include <QMutex>
+#include <QVector>
+#include <QWaitCondition>
+
 #include "libkwave/FileInfo.h"
 #include "libkwave/MultiTrackSink.h"
+#include "libkwave/Sample.h"
+#include "libkwave/Stripe.h"
 #include "libkwave/VorbisCommentMap.h"
 #include "libkwave/modules/SampleBuffer.h"
 
@@ -156,9 +166,78 @@ namespace Kwave
 	/**
 	 * Fill the input buffer of the encoder with samples.
 	 * @param src MultiTrackReader used as source of the audio data
+	 * @param buffer the sample buffer at the end of the filter chain
+	 * @param input the input buffer of the encoder, one frame
+	 * @param extra_out number of samples that are still to be padded
+	 *                  at the end to compensate preskip, will be
+	 *                  decremented
 	 * @return number of samples read
 	 */
-	unsigned int fillInBuffer(Kwave::MultiTrackReader &src);
+	unsigned int fillInBuffer(Kwave::MultiTrackReader &src,
+	    Kwave::MultiTrackSink<Kwave::SampleBuffer, true> &buffer,
+	    float *input, unsigned int &extra_out) const;
+
+	/**
+	 * Puts one encoded packet into the Ogg stream and writes all pages
+	 * that are ready to the destination
+	 * @param dst a QIODevice that receives the raw data
+	 * @param packet pointer to the packet data
+	 * @param bytes size of the packet data
+	 * @param last true if this is the last packet of the stream
+	 * @return true if succeeded or false if failed
+	 */
+	bool writePacket(QIODevice &dst, unsigned char *packet, int bytes,
+	                 bool last);
+
+	/**
+	 * Checks if the source can be encoded in segments, in parallel,
+	 * and sets up the list of segments if so. Not used when called
+	 * from a worker thread or if no idle threads are left in the
+	 * global thread pool.
+	 * @param src MultiTrackReader used as source of the audio data
+	 * @return true if encoding in segments is possible
+	 */
+	bool prepareSegments(Kwave::MultiTrackReader &src);
+
+	/**
+	 * Encodes all segments in a pool of threads and splices their
+	 * packets into the Ogg stream, in the order of the segments
+	 * @param src MultiTrackReader used as source of the audio data,
+	 *            only used for progress and cancel
+	 * @param dst a QIODevice that receives the raw data
+	 * @return true if succeeded or false if failed
+	 */
+	bool encodeSegments(Kwave::MultiTrackReader &src, QIODevice &dst);
+
+	/** main loop of one worker thread, takes segments until done */
+	void segmentWorker();
+
+	/** a part of the source, which is encoded independently */
+	typedef struct {
+	    sample_index_t m_first;  /**< first sample, incl. pre-roll   */
+	    sample_index_t m_last;   /**< last sample, incl. post-roll   */
+	    unsigned int   m_skip;   /**< packets of the pre-roll        */
+	    unsigned int   m_frames; /**< frames to keep, 0 = up to eof  */
+	    bool           m_done;   /**< true if encoded completely     */
+	    QList<QByteArray> m_packets; /**< the encoded packets        */
+	} Segment;
+
+	/**
+	 * Encodes one segment with it's own readers, filter chain and
+	 * encoder, the packets of the pre-roll are discarded
+	 * @param segment the segment to encode
+	 * @param packets receives the encoded packets
+	 * @return true if succeeded or stopped, false if failed
+	 */
+	bool encodeSegment(const Kwave::OpusEncoder::Segment &segment,
+	                   QList<QByteArray> &packets);
+
+	/**
+	 * Creates a new encoder with the same settings as m_encoder,
+	 * for encoding a segment
+	 * @return a new encoder or null if failed
+	 */
+	OpusMSEncoder *createSegmentEncoder() const;
 
     private:
 
@@ -232,6 +311,45 @@ namespace Kwave
 
 	/** multi track buffer, for blockwise reading from the source device */
 	Kwave::MultiTrackSink<Kwave::SampleBuffer, true> *m_buffer;
+
+	/** granule position of the last packet in the Ogg stream */
+	ogg_int64_t m_enc_granulepos;
+
+	/** granule position of the last page that has been written */
+	ogg_int64_t m_last_granulepos;
+
+	/** number of lacing values in the Ogg stream, not yet written */
+	int m_last_segments;
+
+	/** number of the last packet in the Ogg stream */
+	ogg_int64_t m_packet_id;
+
+	/** segments for parallel encoding, empty in serial mode */
+	QVector<Kwave::OpusEncoder::Segment> m_segments;
+
+	/** stripes of the whole source, one list per track */
+	QVector<Kwave::Stripe::List> m_stripes;
+
+	/** number of source samples per encoded frame */
+	sample_index_t m_src_frame_size;
+
+	/** index of the next segment to be taken by a worker */
+	QAtomicInt m_next_segment;
+
+	/** set to stop all workers, after cancel or error */
+	QAtomicInt m_stop;
+
+	/** number of source samples that have been encoded */
+	QAtomicInteger<quint64> m_segment_progress;
+
+	/** lock for the state of the segments and m_failed */
+	QMutex m_lock;
+
+	/** signaled whenever a segment is done or failed */
+	QWaitCondition m_segment_done;
+
+	/** true if encoding a segment failed */
+	bool m_failed;
     };
 }
 
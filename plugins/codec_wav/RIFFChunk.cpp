@@ -26,8 +26,8 @@
 
 //***************************************************************************
 Kwave::RIFFChunk::RIFFChunk(RIFFChunk *parent, const QByteArray &name,
-                            const QByteArray &format, quint32 length,
-                            quint32 phys_offset, quint32 phys_length)
+                            const QByteArray &format, quint64 length,
+                            quint64 phys_offset, quint64 phys_length)
     :m_type(Sub), m_name(name), m_format(format), m_parent(parent),
      m_chunk_length(length), m_phys_offset(phys_offset),
      m_phys_length(phys_length), m_sub_chunks()
@@ -57,15 +57,15 @@ bool Kwave::RIFFChunk::isSane() const
     if (m_phys_length & 0x1) {
 	// size is not an even number: no criterium for insanity
 	// but worth a warning
-	qWarning("%s: physical length is not an even number: %u",
+	qWarning("%s: physical length is not an even number: %llu",
 	        path().data(), m_phys_length);
     }
 #endif /* DEBUG */
 
-    unsigned int datalen = dataLength();
+    quint64 datalen = dataLength();
     if (m_type == Main) datalen += 4;
     if (((datalen + 1) < m_phys_length) || (datalen > m_phys_length)) {
-	qWarning("%s: dataLength=%u, phys_length=%u",
+	qWarning("%s: dataLength=%llu, phys_length=%llu",
 	         path().data(), datalen, m_phys_length);
 	return false;
     }
@@ -76,9 +76,9 @@ bool Kwave::RIFFChunk::isSane() const
 }
 
 //***************************************************************************
-quint32 Kwave::RIFFChunk::physEnd() const
+quint64 Kwave::RIFFChunk::physEnd() const
 {
-    quint32 end = m_phys_offset + m_phys_length;
+    quint64 end = m_phys_offset + m_phys_length;
     if (m_phys_length) --end;
     if ((m_type != Root) && (m_type != Garbage)) end += 8;
     return end;
@@ -127,19 +127,19 @@ const QByteArray Kwave::RIFFChunk::path() const
 }
 
 //***************************************************************************
-quint32 Kwave::RIFFChunk::dataStart() const
+quint64 Kwave::RIFFChunk::dataStart() const
 {
     return m_phys_offset + ((m_type == Main) ? 12 : 8);
 }
 
 //***************************************************************************
-quint32 Kwave::RIFFChunk::dataLength() const
+quint64 Kwave::RIFFChunk::dataLength() const
 {
     return m_chunk_length - ((m_type == Main) ? 4 : 0);
 }
 
 //***************************************************************************
-void Kwave::RIFFChunk::setLength(quint32 length)
+void Kwave::RIFFChunk::setLength(quint64 length)
 {
     m_chunk_length = length;
     m_phys_length  = length;
@@ -163,17 +163,17 @@ void Kwave::RIFFChunk::fixSize()
 
     // pass two: sum up sub-chunks if type is main or root.
     if ((m_type == Main) || (m_type == Root)) {
-	quint32 old_length = m_phys_length;
+	quint64 old_length = m_phys_length;
 	m_phys_length = 0;
 	if (m_type == Main) m_phys_length += 4;
 
         foreach (Kwave::RIFFChunk *chunk, subChunks()) {
             if (!chunk) continue;
-	    quint32 len = chunk->physEnd() - chunk->physStart() + 1;
+	    quint64 len = chunk->physEnd() - chunk->physStart() + 1;
 	    m_phys_length += len;
 	}
 	if (m_phys_length != old_length) {
-	    qDebug("%s: setting size from %u to %u",
+	    qDebug("%s: setting size from %llu to %llu",
 	        path().data(), old_length, m_phys_length);
 	}
 	// chunk length is always equal to physical length for
@@ -183,14 +183,14 @@ void Kwave::RIFFChunk::fixSize()
 	// just round up if no main or root chunk
 	if (m_phys_length & 0x1) {
 	    m_phys_length++;
-	    qDebug("%s: rounding up size to %u", path().data(), m_phys_length);
+	    qDebug("%s: rounding up size to %llu", path().data(), m_phys_length);
 	}
 
 	// adjust chunk size to physical size if not long enough
 	if ((m_chunk_length+1 != m_phys_length) &&
 	    (m_chunk_length != m_phys_length))
 	{
-	    qDebug("%s: resizing chunk from %u to %u",
+	    qDebug("%s: resizing chunk from %llu to %llu",
 	        path().data(), m_chunk_length, m_phys_length);
 	    m_chunk_length = m_phys_length;
 	}
@@ -213,7 +213,7 @@ void Kwave::RIFFChunk::dumpStructure()
     }
 
     // dump this chunk
-    qDebug("[0x%08X-0x%08X] (%10u/%10u) %7s, '%s'",
+    qDebug("[0x%08llX-0x%08llX] (%10llu/%10llu) %7s, '%s'",
           m_phys_offset, physEnd(), physLength(), length(),
           t, path().data()
     );
@@ -66,8 +66,8 @@ namespace Kwave
 	 * @param phys_length length allocated in the source (file)
 	 */
 	RIFFChunk(Kwave::RIFFChunk *parent, const QByteArray &name,
-	          const QByteArray &format, quint32 length,
-	          quint32 phys_offset, quint32 phys_length);
+	          const QByteArray &format, quint64 length,
+	          quint64 phys_offset, quint64 phys_length);
 
 	/** Destructor */
 	virtual ~RIFFChunk();
@@ -111,39 +111,39 @@ namespace Kwave
 	const QByteArray path() const;
 
 	/** Returns the offset where the chunk's data starts. */
-	quint32 dataStart() const;
+	quint64 dataStart() const;
 
 	/** Returns the physical length of the chunk's data */
-	quint32 dataLength() const;
+	quint64 dataLength() const;
 
 	/**
 	 * Returns the length of the chunk in bytes, like stated in the
 	 * head of the chunk. Includes the format when it's a main chunk.
 	 */
-	inline quint32 length() const { return m_chunk_length; }
+	inline quint64 length() const { return m_chunk_length; }
 
 	/**
 	 * Sets the data and physical length of the chunk both to a
 	 * new value.
 	 */
-	void setLength(quint32 length);
+	void setLength(quint64 length);
 
 	/**
 	 * Returns the offset in the source (file) where the
 	 * chunk (name) starts.
 	 */
-	inline quint32 physStart() const { return m_phys_offset; }
+	inline quint64 physStart() const { return m_phys_offset; }
 
 	/**
 	 * Returns the offset in the source (file) where the chunk ends.
 	 */
-	quint32 physEnd() const;
+	quint64 physEnd() const;
 
 	/**
 	 * Returns the length of the chunk in the file. For some dubious
 	 * reason this seems always to be rounded up for even numbers!
 	 */
-	inline quint32 physLength() const { return m_phys_length; }
+	inline quint64 physLength() const { return m_phys_length; }
 
 	/**
 	 * Returns a reference to the list of sub-chunks (mutable).
@@ -189,13 +189,13 @@ namespace Kwave
 	Kwave::RIFFChunk *m_parent;
 
 	/** length of the chunk */
-	quint32 m_chunk_length;
+	quint64 m_chunk_length;
 
 	/** offset within the source (file) */
-	quint32 m_phys_offset;
+	quint64 m_phys_offset;
 
 	/** length used in the source (file) */
-	quint32 m_phys_length;
+	quint64 m_phys_length;
 
 	/** list of sub-chunks, empty if none known */
 	Kwave::RIFFChunkList m_sub_chunks;
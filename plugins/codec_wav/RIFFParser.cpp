@@ -20,8 +20,6 @@
 #include <math.h>
 #include <stdlib.h>
 
-#include <limits>
-
 #include <QIODevice>
 #include <QLatin1String>
 #include <QList>
@@ -37,6 +35,7 @@
 
 #include "RIFFChunk.h"
 #include "RIFFParser.h"
+#include "WavFileFormat.h"
 
 #if Q_BYTE_ORDER == Q_BIG_ENDIAN
 #define SYSTEM_ENDIANNES Kwave::BigEndian
@@ -44,25 +43,14 @@
 #define SYSTEM_ENDIANNES Kwave::LittleEndian
 #endif
 
-/**
- * saturated conversion of a quint64 into a quint32
- * @param x numeric value, 64 bit
- * @return the value of x clipped to 0xFFFFFFFF
- */
-static inline quint32 toUint32(quint64 x) {
-    const quint64 max = std::numeric_limits<quint32>::max();
-    return static_cast<quint32>(qMin(x, max));
-}
-
 //***************************************************************************
 Kwave::RIFFParser::RIFFParser(QIODevice &device,
                               const QStringList &main_chunks,
                               const QStringList &known_subchunks)
     :m_dev(device),
-     m_root(Q_NULLPTR, "", "", toUint32(device.size()), 0,
-            toUint32(device.size())),
+     m_root(Q_NULLPTR, "", "", device.size(), 0, device.size()),
      m_main_chunk_names(main_chunks), m_sub_chunk_names(known_subchunks),
-     m_endianness(Kwave::UnknownEndian), m_cancel(false)
+     m_endianness(Kwave::UnknownEndian), m_ds64_sizes(), m_cancel(false)
 {
     m_root.setType(Kwave::RIFFChunk::Root);
 }
@@ -108,7 +96,9 @@ void Kwave::RIFFParser::detectEndianness()
 {
     // first try the easy way, works if file is sane
     QString sane_name = QLatin1String(read4ByteString(0));
-    if (sane_name == _("RIFF")) {
+    if ((sane_name == _("RIFF")) || (sane_name == _("RF64")) ||
+        (sane_name == _("BW64")))
+    {
 	m_endianness = LittleEndian;
 	return;
     }
@@ -121,11 +111,11 @@ void Kwave::RIFFParser::detectEndianness()
     emit action(i18n("Detecting endianness (standard search)..."));
     emit progress(0);
 
-    QList<quint32> riff_offsets = scanForName("RIFF",
+    QList<quint64> riff_offsets = scanForName("RIFF",
 	m_root.physStart(), m_root.physLength(), 0, 2);
     if (m_cancel) return;
 
-    QList<quint32> rifx_offsets = scanForName("RIFX",
+    QList<quint64> rifx_offsets = scanForName("RIFX",
 	m_root.physStart(), m_root.physLength(), 1, 2);
     if (m_cancel) return;
 
@@ -164,13 +154,13 @@ void Kwave::RIFFParser::detectEndianness()
     foreach (QString chunk_name, names) {
 	// scan all offsets where the name matches
 	QByteArray name = chunk_name.toLatin1();
-	QList<quint32> offsets = scanForName(name,
+	QList<quint64> offsets = scanForName(name,
 	    m_root.physStart(), m_root.physLength(),
 	    index, count);
 	if (m_cancel) return;
 
 	// loop over all found offsets
-	foreach (quint32 ofs, offsets) {
+	foreach (quint64 ofs, offsets) {
 	    m_dev.seek(ofs + 4);
 
 	    // read length, assuming little endian
@@ -215,6 +205,60 @@ QByteArray Kwave::RIFFParser::read4ByteString(qint64 offset)
     return QByteArray(s);
 }
 
+//***************************************************************************
+/** reads a 64 bit little endian value from the current position */
+static quint64 readLE64(QIODevice &dev)
+{
+    quint64 value = 0;
+    dev.read(reinterpret_cast<char *>(&value), 8);
+    return qFromLittleEndian<quint64>(value);
+}
+
+//***************************************************************************
+void Kwave::RIFFParser::readDs64(quint64 offset)
+{
+    /*
+     * typedef struct {
+     *     char    ckID[4];       <- 'RF64' or 'BW64'
+     *     quint32 ckSize;        <- 0xFFFFFFFF
+     *     char    format[4];     <- 'WAVE'
+     *     char    ds64ID[4];     <- 'ds64'
+     *     quint32 ds64Size;      <- 28 + 12 * tableLength
+     *     quint64 riffSize;
+     *     quint64 dataSize;
+     *     quint64 sampleCount;
+     *     quint32 tableLength;
+     *     struct { char ckID[4]; quint64 ckSize; } table[];
+     * } rf64_header_t;
+     */
+    const QByteArray main_name = read4ByteString(offset);
+    if (read4ByteString(offset + 12) != "ds64") {
+	qWarning("RIFFParser: '%s' without 'ds64' chunk", main_name.data());
+	return;
+    }
+
+    quint32 ds64_len = 0;
+    m_dev.read(reinterpret_cast<char *>(&ds64_len), 4);
+    ds64_len = qFromLittleEndian<quint32>(ds64_len);
+    if (ds64_len < RF64_DS64_SIZE) {
+	qWarning("RIFFParser: 'ds64' chunk too short");
+	return;
+    }
+
+    m_ds64_sizes[main_name] = readLE64(m_dev); // riffSize
+    m_ds64_sizes["data"]    = readLE64(m_dev); // dataSize
+    readLE64(m_dev);                           // sampleCount (unused)
+
+    quint32 table_length = 0;
+    m_dev.read(reinterpret_cast<char *>(&table_length), 4);
+    table_length = qMin<quint32>(qFromLittleEndian<quint32>(table_length),
+                                 (ds64_len - RF64_DS64_SIZE) / 12);
+    for (quint32 i = 0; i < table_length; ++i) {
+	const QByteArray name = read4ByteString(m_dev.pos());
+	m_ds64_sizes[name] = readLE64(m_dev);
+    }
+}
+
 //***************************************************************************
 bool Kwave::RIFFParser::parse()
 {
@@ -228,14 +272,14 @@ bool Kwave::RIFFParser::parse()
     }
 
     // find all primary chunks
-    return parse(&m_root, 0, toUint32(m_dev.size()));
+    return parse(&m_root, 0, m_dev.size());
 }
 
 //***************************************************************************
 Kwave::RIFFChunk *Kwave::RIFFParser::addChunk(
     Kwave::RIFFChunk *parent, const QByteArray &name,
-    const QByteArray &format, quint32 length,
-    quint32 phys_offset, quint32 phys_length,
+    const QByteArray &format, quint64 length,
+    quint64 phys_offset, quint64 phys_length,
     Kwave::RIFFChunk::ChunkType type)
 {
     // do not add anything to garbage, use the garbage's parent instead
@@ -261,7 +305,7 @@ Kwave::RIFFChunk *Kwave::RIFFParser::addChunk(
     Kwave::RIFFChunkList &chunks = parent->subChunks();
     foreach (Kwave::RIFFChunk *c, chunks) {
 	if (!c) continue;
-	quint32 pos = c->physStart();
+	quint64 pos = c->physStart();
 	if (pos > phys_offset) {
 	    before = c;
 	    break;
@@ -276,14 +320,14 @@ Kwave::RIFFChunk *Kwave::RIFFParser::addChunk(
 
 //***************************************************************************
 bool Kwave::RIFFParser::addGarbageChunk(Kwave::RIFFChunk *parent,
-                                        quint32 offset,
-                                        quint32 length)
+                                        quint64 offset,
+                                        quint64 length)
 {
-    qDebug("adding garbage chunk at 0x%08X, length=%u",offset,length);
+    qDebug("adding garbage chunk at 0x%08llX, length=%llu",offset,length);
 
     // create the new chunk first
     QByteArray name(16, 0);
-    qsnprintf(name.data(), name.size(), "[0x%08X]", offset);
+    qsnprintf(name.data(), name.size(), "[0x%08llX]", offset);
     Kwave::RIFFChunk *chunk = addChunk(parent, name, "", length, offset,
 				length, Kwave::RIFFChunk::Garbage);
     return (chunk);
@@ -292,7 +336,7 @@ bool Kwave::RIFFParser::addGarbageChunk(Kwave::RIFFChunk *parent,
 //***************************************************************************
 bool Kwave::RIFFParser::addEmptyChunk(Kwave::RIFFChunk *parent,
                                       const QByteArray &name,
-                                      quint32 offset)
+                                      quint64 offset)
 {
     // create the new chunk first
     Kwave::RIFFChunk *chunk = addChunk(parent, name, "----", 0, offset,
@@ -302,7 +346,7 @@ bool Kwave::RIFFParser::addEmptyChunk(Kwave::RIFFChunk *parent,
 
 //***************************************************************************
 bool Kwave::RIFFParser::parse(Kwave::RIFFChunk *parent,
-                              quint32 offset, quint32 length)
+                              quint64 offset, quint64 length)
 {
     bool error = false;
     Kwave::RIFFChunkList found_chunks;
@@ -315,7 +359,7 @@ bool Kwave::RIFFParser::parse(Kwave::RIFFChunk *parent,
     if (length & 1) length++;
 
     do {
-// 	qDebug("RIFFParser::parse(offset=0x%08X, length=0x%08X)",
+// 	qDebug("RIFFParser::parse(offset=0x%08llX, length=0x%08llX)",
 // 	    offset, length);
 
 	// make sure that we are still in the source (file)
@@ -334,8 +378,8 @@ bool Kwave::RIFFParser::parse(Kwave::RIFFChunk *parent,
 
 	// chunks with less than 4 bytes are not possible
 	if (length < 4) {
-	    qWarning("chunk with less than 4 bytes at offset 0x%08X, "\
-		    "length=%u bytes!", offset, length);
+	    qWarning("chunk with less than 4 bytes at offset 0x%08llX, "\
+		    "length=%llu bytes!", offset, length);
 	    // too short stuff is "garbage"
 	    addGarbageChunk(parent, offset, length);
 	    error = true;
@@ -349,9 +393,9 @@ bool Kwave::RIFFParser::parse(Kwave::RIFFChunk *parent,
 
 	// check if the name really contains only ASCII characters
 	if (!isValidName(name)) {
-	    qWarning("invalid chunk name at offset 0x%08X", offset);
+	    qWarning("invalid chunk name at offset 0x%08llX", offset);
 	    // unreadable name -> make it a "garbage" chunk
-	    qDebug("addGarbageChunk(offset=0x%08X, length=0x%08X)",
+	    qDebug("addGarbageChunk(offset=0x%08llX, length=0x%08llX)",
 		    offset, length);
 	    addGarbageChunk(parent, offset, length);
 	    error = true;
@@ -359,16 +403,23 @@ bool Kwave::RIFFParser::parse(Kwave::RIFFChunk *parent,
 	}
 
 	// get the length stored in the chunk itself
-	quint32 len = 0;
+	quint64 len = 0;
 	if (length >= 8) {
 	    // length information present
-	    m_dev.read(reinterpret_cast<char *>(&len), 4);
-	    if (m_endianness != SYSTEM_ENDIANNES) len = qbswap<quint32>(len);
+	    quint32 len32 = 0;
+	    m_dev.read(reinterpret_cast<char *>(&len32), 4);
+	    if (m_endianness != SYSTEM_ENDIANNES) len32 = qbswap<quint32>(len32);
+	    len = len32;
 	}
+
+	// RF64/BW64: the real length is stored in the "ds64" chunk
+	if ((name == "RF64") || (name == "BW64")) readDs64(offset);
+	if ((len == RF64_SIZE_IN_DS64) && m_ds64_sizes.contains(name))
+	    len = m_ds64_sizes[name];
 	if (len == 0) {
 	    // valid name but no length information -> badly truncated
 	    // -> make it a zero-length chunk
-	    qDebug("empty chunk '%s' at 0x%08X", name.data(), offset);
+	    qDebug("empty chunk '%s' at 0x%08llX", name.data(), offset);
 	    addEmptyChunk(parent, name, offset);
 
 	    if (length > 8) {
@@ -381,15 +432,15 @@ bool Kwave::RIFFParser::parse(Kwave::RIFFChunk *parent,
 	}
 
 	// read the format if present
-	QByteArray format = read4ByteString(m_dev.pos());
+	QByteArray format = read4ByteString(offset + 8);
 
 	// calculate the physical length of the chunk
-	quint32 phys_len = (length - 8 < len) ? (length - 8) : len;
+	quint64 phys_len = (length - 8 < len) ? (length - 8) : len;
 	if (phys_len & 1) phys_len++;
 
 	// now create a new chunk, per default type is "sub-chunk"
-/*	qDebug("new chunk, name='%s', len=0x%08X, ofs=0x%08X, "\
-	    "phys_len=0x%08X (next=0x%08X)",
+/*	qDebug("new chunk, name='%s', len=0x%08llX, ofs=0x%08llX, "\
+	    "phys_len=0x%08llX (next=0x%08llX)",
 	    name.data(),
 	    len,offset,phys_len, offset+phys_len+8); */
 	Kwave::RIFFChunk *chunk = addChunk(parent, name, format, len, offset,
@@ -400,7 +451,7 @@ bool Kwave::RIFFParser::parse(Kwave::RIFFChunk *parent,
 	// if not at the end of the file, parse all further chunks
 	length -= chunk->physLength() + 8;
 	offset  = chunk->physEnd() + 1;
-// 	qDebug("   parse loop end: offset=0x%08X, length=0x%08X",offset,length);
+// 	qDebug("   parse loop end: offset=0x%08llX, length=0x%08llX",offset,length);
     } while (length && !m_cancel);
 
     // parse for sub-chunks in the chunks we newly found
@@ -414,7 +465,7 @@ bool Kwave::RIFFParser::parse(Kwave::RIFFChunk *parent,
 /* 	    QByteArray path = (parent ? parent->path() : QByteArray("")) +
 			    '/' + chunk->name();
 	    qDebug("scanning for chunks in '%s' (format='%s'), "\
-		"offset=0x%08X, length=0x%08X",
+		"offset=0x%08llX, length=0x%08llX",
 		path.data(), chunk->format().data(),
 		chunk->dataStart(), chunk->dataLength());*/
 	    if (!parse(chunk, chunk->dataStart(), chunk->dataLength())) {
@@ -481,23 +532,23 @@ unsigned int Kwave::RIFFParser::chunkCount(const QByteArray &path)
 }
 
 //***************************************************************************
-QList<quint32> Kwave::RIFFParser::scanForName(const QByteArray &name,
-    quint32 offset, quint32 length,
+QList<quint64> Kwave::RIFFParser::scanForName(const QByteArray &name,
+    quint64 offset, quint64 length,
     int progress_start, int progress_count)
 {
-    QList<quint32> matches;
+    QList<quint64> matches;
     if (length < 4) return matches;
-    quint32 end = offset + ((length > 4) ? (length - 4) : 0);
+    quint64 end = offset + ((length > 4) ? (length - 4) : 0);
     char buffer[5];
     memset(buffer, 0x00, sizeof(buffer));
 
     m_dev.seek(offset);
     m_dev.read(&buffer[0], 4);
 
-    qDebug("scannig for '%s' at [0x%08X...0x%08X] ...", name.data(),
+    qDebug("scannig for '%s' at [0x%08llX...0x%08llX] ...", name.data(),
 	offset, end);
-    quint32 pos;
-    int next = 1;
+    quint64 pos;
+    quint64 next = 1;
     for (pos = offset; (pos <= end) && !m_cancel; ++pos) {
 	if (name == buffer) {
 	    // found the name
@@ -511,8 +562,8 @@ QList<quint32> Kwave::RIFFParser::scanForName(const QByteArray &name,
 
 	// update progress bar
 	if (!--next && progress_count && (end > offset)) {
-	    int percent = (((100*progress_start + (100*(pos-offset)) /
-		    (end-offset))) / progress_count);
+	    int percent = static_cast<int>((100 * progress_start +
+		(100 * (pos - offset)) / (end - offset)) / progress_count);
 	    emit progress(percent);
 	    next = (end-offset)/100;
 	}
@@ -531,7 +582,7 @@ void Kwave::RIFFParser::listAllChunks(Kwave::RIFFChunk &parent,
 }
 
 //***************************************************************************
-Kwave::RIFFChunk *Kwave::RIFFParser::chunkAt(quint32 offset)
+Kwave::RIFFChunk *Kwave::RIFFParser::chunkAt(quint64 offset)
 {
     Kwave::RIFFChunkList list;
     listAllChunks(m_root, list);
@@ -560,18 +611,18 @@ Kwave::RIFFChunk *Kwave::RIFFParser::findMissingChunk(const QByteArray &name)
 	if (!chunk) continue;
 	if (chunk->type() == Kwave::RIFFChunk::Garbage) {
 	    // search for the name
-	    qDebug("searching in garbage at 0x%08X", chunk->physStart());
-	    QList<quint32> offsets = scanForName(name,
+	    qDebug("searching in garbage at 0x%08llX", chunk->physStart());
+	    QList<quint64> offsets = scanForName(name,
 		chunk->physStart(), chunk->physLength(),
 		index, count);
 	    if (offsets.count()) found_something = true;
 
 	    // process the results -> convert them into chunks
-	    quint32 end = chunk->physEnd();
-	    foreach (quint32 pos, offsets) {
+	    quint64 end = chunk->physEnd();
+	    foreach (quint64 pos, offsets) {
 		if (m_cancel) break;
-		quint32 len = end - pos + 1;
-		qDebug("found at [0x%08X...0x%08X] len=%u", pos, end, len);
+		quint64 len = end - pos + 1;
+		qDebug("found at [0x%08llX...0x%08llX] len=%llu", pos, end, len);
 		parse(chunk, pos, len);
 		qDebug("-------------------------------");
 	    }
@@ -581,16 +632,16 @@ Kwave::RIFFChunk *Kwave::RIFFParser::findMissingChunk(const QByteArray &name)
 
     // not found in garbage? search over the rest of the file"
     if (!found_something && !m_cancel) {
-	qDebug("brute-force search from 0x%08X to 0x%08X",
+	qDebug("brute-force search from 0x%08X to 0x%08llX",
 	    0, m_root.physEnd());
-	QList<quint32> offsets = scanForName(name, 0, m_root.physLength());
+	QList<quint64> offsets = scanForName(name, 0, m_root.physLength());
 
 	// process the results -> convert them into chunks
-	quint32 end = m_root.physEnd();
-	foreach (quint32 pos, offsets) {
+	quint64 end = m_root.physEnd();
+	foreach (quint64 pos, offsets) {
 	    if (m_cancel) break;
-	    quint32 len = end - pos + 1;
-	    qDebug("found at [0x%08X...0x%08X] len=%u", pos, end, len);
+	    quint64 len = end - pos + 1;
+	    qDebug("found at [0x%08llX...0x%08llX] len=%llu", pos, end, len);
 	    parse(&m_root, pos, len);
 	    qDebug("-------------------------------");
 	}
@@ -657,10 +708,10 @@ void Kwave::RIFFParser::collectGarbage()
 	    }
 
 	    if (subchunks.count() && contains_only_garbage) {
-		quint32 start = chunk->physStart();
-		quint32 end   = chunk->physEnd();
+		quint64 start = chunk->physStart();
+		quint64 end   = chunk->physEnd();
 
-		qDebug("chunk at 0x%08X contains only garbage!", start);
+		qDebug("chunk at 0x%08llX contains only garbage!", start);
 		// -> convert into a garbage chunk !
 		chunk->setType(Kwave::RIFFChunk::Garbage);
 		chunk->setLength(end - start + 4 + 1);
@@ -701,24 +752,24 @@ void Kwave::RIFFParser::fixGarbageEnds()
 	    if (c2->isChildOf(c1)) continue;
 
 	    // get ranges
-	    quint32 s1 = c1->physStart();
-	    quint32 e1 = c1->physEnd();
-	    quint32 s2 = c2->physStart();
-	    quint32 e2 = c2->physEnd();
+	    quint64 s1 = c1->physStart();
+	    quint64 e1 = c1->physEnd();
+	    quint64 s2 = c2->physStart();
+	    quint64 e2 = c2->physEnd();
 
 	    // check for overlaps
 	    if ((s2 <= e1) && (e2 >= s1)) {
 		qDebug("overlap detected:");
-		qDebug("    at 0x%08X...0x%08X '%s'",
+		qDebug("    at 0x%08llX...0x%08llX '%s'",
 		    s1, e1, c1->name().data());
-		qDebug("    at 0x%08X...0x%08X '%s'",
+		qDebug("    at 0x%08llX...0x%08llX '%s'",
 		    s2, e2, c2->name().data());
 
 		if ((c1->type() == Kwave::RIFFChunk::Garbage) && (s1 < s2)) {
 		    // shorten garbage
 		    e1 = s2 - 1;
-		    quint32 len = e1 - s1 + 1;
-		    qDebug("shortening garbage to %u bytes", len);
+		    quint64 len = e1 - s1 + 1;
+		    qDebug("shortening garbage to %llu bytes", len);
 		    c1->setLength(len);
 		}
 	    }
@@ -765,9 +816,9 @@ bool Kwave::RIFFParser::joinGarbageToEmpty()
 	    if ((next->type() == Kwave::RIFFChunk::Garbage) ||
 		(!isKnownName(next->name())) )
 	    {
-		quint32 len = next->physLength() + 4;
-		qDebug("joining garbage to empty chunk '%s' at 0x%08X, %u bytes",
-		    chunk->name().data(), chunk->physStart(), len);
+		quint64 len = next->physLength() + 4;
+		qDebug("joining garbage to empty chunk '%s' at 0x%08llX, "
+		       "%llu bytes", chunk->name().data(), chunk->physStart(), len);
 		chunk->setLength(len);
 		chunk->setType(guessType(chunk->name()));
 
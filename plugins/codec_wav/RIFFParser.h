@@ -22,6 +22,7 @@
 
 #include <QByteArray>
 #include <QList>
+#include <QMap>
 #include <QObject>
 #include <QStringList>
 
@@ -68,7 +69,7 @@ namespace Kwave
 	 * @return true if passed without any error
 	 */
 	bool parse(Kwave::RIFFChunk *parent,
-	           quint32 offset, quint32 length);
+	           quint64 offset, quint64 length);
 
 	/**
 	 * Returns true if the source contains no structural errors and
@@ -172,9 +173,9 @@ namespace Kwave
 	Kwave::RIFFChunk *addChunk(Kwave::RIFFChunk *parent,
 	                           const QByteArray &name,
 	                           const QByteArray &format,
-	                           quint32 length,
-	                           quint32 phys_offset,
-	                           quint32 phys_length,
+	                           quint64 length,
+	                           quint64 phys_offset,
+	                           quint64 phys_length,
 	                           Kwave::RIFFChunk::ChunkType type);
 
 	/**
@@ -186,8 +187,8 @@ namespace Kwave
 	 * @param length length of the garbage area in bytes
 	 * @return true if creation succeeded, false if out of memory
 	 */
-	bool addGarbageChunk(Kwave::RIFFChunk *parent, quint32 offset,
-	                     quint32 length);
+	bool addGarbageChunk(Kwave::RIFFChunk *parent, quint64 offset,
+	                     quint64 length);
 
 	/**
 	 * Adds a chunk with a valid name and no length information.
@@ -197,7 +198,7 @@ namespace Kwave
 	 * @return true if creation succeeded, false if out of memory
 	 */
 	bool addEmptyChunk(Kwave::RIFFChunk *parent, const QByteArray &name,
-	                   quint32 offset);
+	                   quint64 offset);
 
 	/**
 	 * Recursively creates a "flat" list of all chunks.
@@ -213,7 +214,7 @@ namespace Kwave
 	 * @param offset the start position (physical start)
 	 * @return pointer to the chunk or zero
 	 */
-	Kwave::RIFFChunk *chunkAt(quint32 offset);
+	Kwave::RIFFChunk *chunkAt(quint64 offset);
 
 	/**
 	 * Performs a scan for a 4-character chunk name over a range of the
@@ -226,11 +227,19 @@ namespace Kwave
 	 * @param progress_count number of progress sections
 	 * @return list of positions of where the name exists
 	 */
-	QList<quint32> scanForName(const QByteArray &name, quint32 offset,
-	                           quint32 length,
+	QList<quint64> scanForName(const QByteArray &name, quint64 offset,
+	                           quint64 length,
 	                           int progress_start = 0,
 	                           int progress_count = 1);
 
+	/**
+	 * Reads the "ds64" chunk of a RF64 or BW64 file, which contains
+	 * the 64 bit sizes of all chunks that have RF64_SIZE_IN_DS64 as
+	 * size, and stores them in m_ds64_sizes.
+	 * @param offset start of the "RF64" or "BW64" chunk
+	 */
+	void readDs64(quint64 offset);
+
     private:
 
 	/**
@@ -267,6 +276,9 @@ namespace Kwave
 	/** endianness of the RIFF file, auto-detected */
 	Kwave::byte_order_t m_endianness;
 
+	/** 64 bit chunk sizes from the "ds64" chunk, by chunk name */
+	QMap<QByteArray, quint64> m_ds64_sizes;
+
 	/** can be set to true in order to cancel a running operation */
 	bool m_cancel;
 
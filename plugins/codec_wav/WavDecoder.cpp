@@ -27,7 +27,10 @@
 #include <QtGlobal>
 
 #include <QApplication>
+#include <QFileDevice>
 #include <QProgressDialog>
+#include <QThread>
+#include <QtConcurrentMap>
 
 #include <KLocalizedString>
 
@@ -39,7 +42,10 @@
 #include "libkwave/MetaData.h"
 #include "libkwave/MetaDataList.h"
 #include "libkwave/MultiWriter.h"
+#include "libkwave/ReadAheadDevice.h"
 #include "libkwave/Sample.h"
+#include "libkwave/SampleArray.h"
+#include "libkwave/SampleConversion.h"
 #include "libkwave/SampleFormat.h"
 #include "libkwave/String.h"
 #include "libkwave/Utils.h"
@@ -58,13 +64,54 @@
 
 #define CHECK(cond) Q_ASSERT(cond); if (!(cond)) { src.close(); return false; }
 
+/** number of sample frames that are decoded per pass in decodeDirect() */
+#define DIRECT_DECODE_FRAMES (1024 * 1024)
+
+/** minimum number of sample frames per thread in decodeDirect() */
+#define DIRECT_DECODE_MIN_JOB (16 * 1024)
+
+namespace Kwave
+{
+    /** one range of sample frames, for parallel decoding of PCM data */
+    typedef struct {
+	const quint8       *in;     /**< interleaved raw PCM data        */
+	unsigned int        bits;   /**< number of bits per sample       */
+	QVector<sample_t *> out;    /**< destination, one per track      */
+	unsigned int        frames; /**< number of sample frames         */
+    } PcmDecodeJob;
+}
+
+//***************************************************************************
+static void decodePcmJob(Kwave::PcmDecodeJob &job)
+{
+    Kwave::pcm2samples(job.in, job.bits, Kwave::toUint(job.out.count()),
+                       job.out.constData(), job.frames);
+}
+
+//***************************************************************************
+/**
+ * Returns true if the format header describes uncompressed integer PCM
+ * with 8, 16, 24 or 32 bits, without padding
+ */
+static bool isPlainPCM(const Kwave::min_wav_header_t &header)
+{
+    const unsigned int bits = header.bitwidth;
+    if (header.format != Kwave::WAVE_FORMAT_PCM) return false;
+    if (!header.channels) return false;
+    if ((bits != 8) && (bits != 16) && (bits != 24) && (bits != 32))
+	return false;
+    return (header.blockalign == header.channels * (bits / 8));
+}
+
 //***************************************************************************
 Kwave::WavDecoder::WavDecoder()
     :Kwave::Decoder(),
      m_source(Q_NULLPTR),
      m_src_adapter(Q_NULLPTR),
      m_known_chunks(),
-     m_property_map()
+     m_property_map(),
+     m_data_offset(-1),
+     m_data_bits(0)
 {
     REGISTER_MIME_TYPES
     REGISTER_COMPRESSION_TYPES
@@ -72,6 +119,7 @@ Kwave::WavDecoder::WavDecoder()
     // native WAVE chunk names
     m_known_chunks.append(_("cue ")); /* Markers */
     m_known_chunks.append(_("data")); /* Sound Data */
+    m_known_chunks.append(_("ds64")); /* 64 bit sizes (RF64/BW64) */
     m_known_chunks.append(_("fact")); /* Fact (length in samples) */
     m_known_chunks.append(_("fmt ")); /* Format */
     m_known_chunks.append(_("inst")); /* Instrument */
@@ -129,6 +177,8 @@ bool Kwave::WavDecoder::open(QWidget *widget, QIODevice &src)
 
     QStringList main_chunks;
     main_chunks.append(_("RIFF")); /* RIFF, little-endian */
+    main_chunks.append(_("RF64")); /* RIFF with 64 bit sizes (EBU) */
+    main_chunks.append(_("BW64")); /* Broadcast Wave 64 (ITU-R BS.2088) */
     main_chunks.append(_("RIFX")); /* RIFF, big-endian */
     main_chunks.append(_("FORM")); /* used in AIFF, BE or IFF/.lbm */
     main_chunks.append(_("LIST")); /* additional information */
@@ -161,11 +211,17 @@ bool Kwave::WavDecoder::open(QWidget *widget, QIODevice &src)
 //     qDebug("--- RIFF file structure after first pass ---");
 //     parser.dumpStructure();
 
+    // RF64 and BW64 have the same structure as RIFF, with 64 bit sizes
+    QByteArray riff = "/RIFF:WAVE";
+    if (parser.findChunk("/RF64:WAVE"))      riff = "/RF64:WAVE";
+    else if (parser.findChunk("/BW64:WAVE")) riff = "/BW64:WAVE";
+    const bool rf64 = (riff != "/RIFF:WAVE");
+
     // check if there is a RIFF chunk at all...
-    Kwave::RIFFChunk *riff_chunk = parser.findChunk("/RIFF:WAVE");
-    Kwave::RIFFChunk *fact_chunk = parser.findChunk("/RIFF:WAVE/fact");
-    Kwave::RIFFChunk *fmt_chunk  = parser.findChunk("/RIFF:WAVE/fmt ");
-    Kwave::RIFFChunk *data_chunk = parser.findChunk("/RIFF:WAVE/data");
+    Kwave::RIFFChunk *riff_chunk = parser.findChunk(riff);
+    Kwave::RIFFChunk *fact_chunk = parser.findChunk(riff + "/fact");
+    Kwave::RIFFChunk *fmt_chunk  = parser.findChunk(riff + "/fmt ");
+    Kwave::RIFFChunk *data_chunk = parser.findChunk(riff + "/data");
 
     if (!riff_chunk || !fmt_chunk || !data_chunk || !parser.isSane()) {
 	if (Kwave::MessageBox::warningContinueCancel(widget,
@@ -188,7 +244,7 @@ bool Kwave::WavDecoder::open(QWidget *widget, QIODevice &src)
 
     if (!fmt_chunk) {
 	parser.findMissingChunk("fmt ");
-	fmt_chunk = parser.findChunk("/RIFF:WAVE/fmt ");
+	fmt_chunk = parser.findChunk(riff + "/fmt ");
 	if (progress.wasCanceled()) return false;
 	if (!fmt_chunk)  fmt_chunk  = parser.findChunk("fmt ");
 	need_repair = true;
@@ -196,7 +252,7 @@ bool Kwave::WavDecoder::open(QWidget *widget, QIODevice &src)
 
     if (!data_chunk) {
 	parser.findMissingChunk("data");
-	data_chunk = parser.findChunk("/RIFF:WAVE/data");
+	data_chunk = parser.findChunk(riff + "/data");
 	if (progress.wasCanceled()) return false;
 	if (!data_chunk) data_chunk = parser.findChunk("data");
 	need_repair = true;
@@ -210,21 +266,21 @@ bool Kwave::WavDecoder::open(QWidget *widget, QIODevice &src)
 	parser.dumpStructure();
 	if (progress.wasCanceled()) return false;
 
-	if (!fmt_chunk)  fmt_chunk  = parser.findChunk("/RIFF:WAVE/fmt ");
+	if (!fmt_chunk)  fmt_chunk  = parser.findChunk(riff + "/fmt ");
 	if (!fmt_chunk)  fmt_chunk  = parser.findChunk("/RIFF/fmt ");
 	if (!fmt_chunk)  fmt_chunk  = parser.findChunk("fmt ");
-	if (!data_chunk) data_chunk = parser.findChunk("/RIFF:WAVE/data");
+	if (!data_chunk) data_chunk = parser.findChunk(riff + "/data");
 	if (!data_chunk) data_chunk = parser.findChunk("/RIFF/data");
 	if (!data_chunk) data_chunk = parser.findChunk("data");
 	need_repair = true;
     }
 
-    quint32 fmt_offset = 0;
+    quint64 fmt_offset = 0;
     if (fmt_chunk) fmt_offset = fmt_chunk->dataStart();
 //     qDebug("fmt chunk starts at 0x%08X", fmt_offset);
 
-//     quint32 data_offset = 0;
-    quint32 data_size = 0;
+//     quint64 data_offset = 0;
+    quint64 data_size = 0;
     if (data_chunk) {
 // 	data_offset = data_chunk->dataStart();
 	data_size   = data_chunk->physLength();
@@ -247,7 +303,8 @@ bool Kwave::WavDecoder::open(QWidget *widget, QIODevice &src)
     // WORKAROUND: if there is a fact chunk, it must not contain zero
     //             for the moment the only workaround known is to open
     //             such broken files in repair mode
-    if (fact_chunk) {
+    //             (RF64 stores 0xFFFFFFFF here if the length is in "ds64")
+    if (fact_chunk && !rf64) {
 	qint64 offset = fact_chunk->dataStart();
 	union {
 	    quint32 len;
@@ -332,103 +389,142 @@ bool Kwave::WavDecoder::open(QWidget *widget, QIODevice &src)
 //     qDebug("bits/sample = %d", header.min.bitwidth);
 //     qDebug("-------------------------");
 
-    // open the file through libaudiofile :)
-    if (need_repair) {
-	QList<Kwave::RecoverySource *> *repair_list =
-	    new(std::nothrow) QList<Kwave::RecoverySource *>();
-	Q_ASSERT(repair_list);
-	if (!repair_list) return false;
-
-	Kwave::RIFFChunk *root = (riff_chunk) ? riff_chunk : parser.findChunk("");
-// 	parser.dumpStructure();
-//	qDebug("riff chunk = %p, parser.findChunk('')=%p", riff_chunk,
-//	    parser.findChunk(""));
-	repair(repair_list, root, fmt_chunk, data_chunk);
-	m_src_adapter = new(std::nothrow)
-	    Kwave::RepairVirtualAudioFile(*m_source, repair_list);
+    AFfilehandle fh = Q_NULLPTR;
+    AFframecount length = 0;
+    Kwave::SampleFormat::Format fmt = Kwave::SampleFormat::Unknown;
+    int af_compression = AF_COMPRESSION_NONE;
+
+    if (rf64 && !need_repair) {
+	// libaudiofile does not support RF64/BW64, only plain PCM can
+	// be decoded, directly from the file
+	if (!isPlainPCM(header.min) || !Kwave::ReadAheadDevice::fileOf(&src) ||
+	    !data_chunk)
+	{
+	    Kwave::MessageBox::sorry(widget,
+		i18n("RF64 files are only supported with uncompressed "
+		     "8, 16, 24 or 32 bit PCM data."));
+	    return false;
+	}
+	length = data_chunk->physLength() / header.min.blockalign;
+	fmt = (bits <= 8) ? Kwave::SampleFormat::Unsigned :
+	                    Kwave::SampleFormat::Signed;
     } else {
-	m_src_adapter = new(std::nothrow) Kwave::VirtualAudioFile(*m_source);
-    }
+	// open the file through libaudiofile :)
+	if (need_repair) {
+	    QList<Kwave::RecoverySource *> *repair_list =
+		new(std::nothrow) QList<Kwave::RecoverySource *>();
+	    Q_ASSERT(repair_list);
+	    if (!repair_list) return false;
+
+	    Kwave::RIFFChunk *root = (riff_chunk) ?
+		riff_chunk : parser.findChunk("");
+// 	    parser.dumpStructure();
+//	    qDebug("riff chunk = %p, parser.findChunk('')=%p", riff_chunk,
+//	        parser.findChunk(""));
+	    repair(repair_list, root, fmt_chunk, data_chunk);
+	    m_src_adapter = new(std::nothrow)
+		Kwave::RepairVirtualAudioFile(*m_source, repair_list);
+	} else {
+	    m_src_adapter = new(std::nothrow)
+		Kwave::VirtualAudioFile(*m_source);
+	}
 
-    Q_ASSERT(m_src_adapter);
-    if (!m_src_adapter) return false;
+	Q_ASSERT(m_src_adapter);
+	if (!m_src_adapter) return false;
+
+	m_src_adapter->open(m_src_adapter, Q_NULLPTR);
+
+	fh = m_src_adapter->handle();
+	if (!fh || (m_src_adapter->lastError() >= 0)) {
+	    QString reason;
+
+	    switch (m_src_adapter->lastError()) {
+		case AF_BAD_NOT_IMPLEMENTED:
+		    reason = i18n("Format or function is not implemented") +
+			     _("\n(") + format_name + _(")");
+		    break;
+		case AF_BAD_MALLOC:
+		    reason = i18n("Out of memory");
+		    break;
+		case AF_BAD_HEADER:
+		    reason = i18n("file header is damaged");
+		    break;
+		case AF_BAD_CODEC_TYPE:
+		    reason = i18n("Invalid codec type") +
+			     _("\n(") + format_name + _(")");
+		    break;
+		case AF_BAD_OPEN:
+		    reason = i18n("Opening the file failed");
+		    break;
+		case AF_BAD_READ:
+		    reason = i18n("Read access failed");
+		    break;
+		case AF_BAD_SAMPFMT:
+		    reason = i18n("Invalid sample format");
+		    break;
+		default:
+		    reason = i18n("internal libaudiofile error #%1: '%2'",
+			m_src_adapter->lastError(),
+			m_src_adapter->lastErrorText()
+		    );
+	    }
 
-    m_src_adapter->open(m_src_adapter, Q_NULLPTR);
+	    QString text= i18n("An error occurred while opening the file:\n'%1'",
+	                        reason);
+	    Kwave::MessageBox::error(widget, text);
 
-    AFfilehandle fh = m_src_adapter->handle();
-    if (!fh || (m_src_adapter->lastError() >= 0)) {
-	QString reason;
-
-	switch (m_src_adapter->lastError()) {
-	    case AF_BAD_NOT_IMPLEMENTED:
-	        reason = i18n("Format or function is not implemented") +
-		         _("\n(") + format_name + _(")");
-	        break;
-	    case AF_BAD_MALLOC:
-	        reason = i18n("Out of memory");
-	        break;
-	    case AF_BAD_HEADER:
-	        reason = i18n("file header is damaged");
-	        break;
-	    case AF_BAD_CODEC_TYPE:
-	        reason = i18n("Invalid codec type") +
-		         _("\n(") + format_name + _(")");
-	        break;
-	    case AF_BAD_OPEN:
-	        reason = i18n("Opening the file failed");
-	        break;
-	    case AF_BAD_READ:
-	        reason = i18n("Read access failed");
-	        break;
-	    case AF_BAD_SAMPFMT:
-	        reason = i18n("Invalid sample format");
-	        break;
-	    default:
-		reason = i18n("internal libaudiofile error #%1: '%2'",
-		    m_src_adapter->lastError(),
-		    m_src_adapter->lastErrorText()
-		);
+	    return false;
 	}
 
-	QString text= i18n("An error occurred while opening the file:\n'%1'",
-	                    reason);
-	Kwave::MessageBox::error(widget, text);
-
-	return false;
-    }
-
-    AFframecount length = afGetFrameCount(fh, AF_DEFAULT_TRACK);
-    tracks = afGetVirtualChannels(fh, AF_DEFAULT_TRACK);
+	length = afGetFrameCount(fh, AF_DEFAULT_TRACK);
+	tracks = afGetVirtualChannels(fh, AF_DEFAULT_TRACK);
 
-    int af_sample_format;
-    afGetVirtualSampleFormat(fh, AF_DEFAULT_TRACK, &af_sample_format,
-	reinterpret_cast<int *>(&bits));
-    if (static_cast<signed int>(bits) < 0) bits = 0;
-    Kwave::SampleFormat::Format fmt;
-    switch (af_sample_format)
-    {
-	case AF_SAMPFMT_TWOSCOMP:
-	    fmt = Kwave::SampleFormat::Signed;
-	    break;
-	case AF_SAMPFMT_UNSIGNED:
-	    fmt = Kwave::SampleFormat::Unsigned;
-	    break;
-	case AF_SAMPFMT_FLOAT:
-	    fmt = Kwave::SampleFormat::Float;
-	    break;
-	case AF_SAMPFMT_DOUBLE:
-	    fmt = Kwave::SampleFormat::Double;
-	    break;
-	default:
-	    fmt = Kwave::SampleFormat::Unknown;
-	    break;
+	int af_sample_format = AF_SAMPFMT_TWOSCOMP;
+	afGetVirtualSampleFormat(fh, AF_DEFAULT_TRACK, &af_sample_format,
+	    reinterpret_cast<int *>(&bits));
+	if (static_cast<signed int>(bits) < 0) bits = 0;
+	switch (af_sample_format)
+	{
+	    case AF_SAMPFMT_TWOSCOMP:
+		fmt = Kwave::SampleFormat::Signed;
+		break;
+	    case AF_SAMPFMT_UNSIGNED:
+		fmt = Kwave::SampleFormat::Unsigned;
+		break;
+	    case AF_SAMPFMT_FLOAT:
+		fmt = Kwave::SampleFormat::Float;
+		break;
+	    case AF_SAMPFMT_DOUBLE:
+		fmt = Kwave::SampleFormat::Double;
+		break;
+	    default:
+		fmt = Kwave::SampleFormat::Unknown;
+		break;
+	}
+	af_compression = afGetCompression(fh, AF_DEFAULT_TRACK);
     }
 
-    int af_compression = afGetCompression(fh, AF_DEFAULT_TRACK);
     const Kwave::Compression compression(
 	Kwave::Compression::fromAudiofile(af_compression)
     );
 
+    // plain integer PCM in a regular file can be decoded directly,
+    // without going through libaudiofile
+    m_data_offset = -1;
+    m_data_bits   = 0;
+    const unsigned int data_bits = header.min.bitwidth;
+    if (!need_repair && data_chunk && isPlainPCM(header.min) &&
+        (af_compression == AF_COMPRESSION_NONE) &&
+        (tracks == static_cast<unsigned int>(header.min.channels)) &&
+        (length > 0) &&
+        (static_cast<quint64>(length) * header.min.blockalign <=
+         data_chunk->physLength()) &&
+        Kwave::ReadAheadDevice::fileOf(m_source))
+    {
+	m_data_offset = static_cast<qint64>(data_chunk->dataStart());
+	m_data_bits   = data_bits;
+    }
+
     info.setRate(rate);
     info.setBits(bits);
     info.setTracks(tracks);
@@ -437,7 +533,7 @@ bool Kwave::WavDecoder::open(QWidget *widget, QIODevice &src)
     info.set(Kwave::INF_COMPRESSION, compression.toInt());
 
     // read in all info from the LIST (INFO) chunk
-    Kwave::RIFFChunk *info_chunk = parser.findChunk("/RIFF:WAVE/LIST:INFO");
+    Kwave::RIFFChunk *info_chunk = parser.findChunk(riff + "/LIST:INFO");
     if (info_chunk) {
 	// found info chunk !
 	Kwave::RIFFChunkList &list = info_chunk->subChunks();
@@ -447,8 +543,8 @@ bool Kwave::WavDecoder::open(QWidget *widget, QIODevice &src)
 
 	    // read the content into a QString
 	    Kwave::FileProperty prop = m_property_map.property(chunk->name());
-	    unsigned int ofs = chunk->dataStart();
-	    unsigned int len = chunk->dataLength();
+	    quint64      ofs = chunk->dataStart();
+	    unsigned int len = Kwave::toUint(chunk->dataLength());
 	    QByteArray buffer(len + 1, 0x00);
 	    src.seek(ofs);
 	    src.read(buffer.data(), len);
@@ -460,7 +556,7 @@ bool Kwave::WavDecoder::open(QWidget *widget, QIODevice &src)
     }
 
     // read in the Labels (cue list)
-    Kwave::RIFFChunk *cue_chunk = parser.findChunk("/RIFF:WAVE/cue ");
+    Kwave::RIFFChunk *cue_chunk = parser.findChunk(riff + "/cue ");
     if (cue_chunk) {
 	// found a cue list chunk !
 	quint32 count;
@@ -524,7 +620,7 @@ bool Kwave::WavDecoder::open(QWidget *widget, QIODevice &src)
 	    // as we now have index and position, find out the name
 	    QByteArray name = "";
 	    Kwave::RIFFChunk *adtl_chunk =
-		parser.findChunk("/RIFF:WAVE/LIST:adtl");
+		parser.findChunk(riff + "/LIST:adtl");
 	    if (adtl_chunk) {
                 Kwave::RIFFChunk *labl_chunk = Q_NULLPTR;
 		bool found = false;
@@ -553,7 +649,7 @@ bool Kwave::WavDecoder::open(QWidget *widget, QIODevice &src)
 		}
 		if (found) {
 		    Q_ASSERT(labl_chunk);
-		    unsigned int len = labl_chunk->length();
+		    unsigned int len = Kwave::toUint(labl_chunk->length());
 		    if (len > 4) {
 			len -= 4;
 			name.resize(len);
@@ -580,13 +676,15 @@ bool Kwave::WavDecoder::open(QWidget *widget, QIODevice &src)
     metaData().replace(labels.toMetaDataList());
 
     // set up libaudiofile to produce Kwave's internal sample format
+    if (fh) {
 #if Q_BYTE_ORDER == Q_BIG_ENDIAN
-    afSetVirtualByteOrder(fh, AF_DEFAULT_TRACK, AF_BYTEORDER_BIGENDIAN);
+	afSetVirtualByteOrder(fh, AF_DEFAULT_TRACK, AF_BYTEORDER_BIGENDIAN);
 #else
-    afSetVirtualByteOrder(fh, AF_DEFAULT_TRACK, AF_BYTEORDER_LITTLEENDIAN);
+	afSetVirtualByteOrder(fh, AF_DEFAULT_TRACK, AF_BYTEORDER_LITTLEENDIAN);
 #endif
-    afSetVirtualSampleFormat(fh, AF_DEFAULT_TRACK,
-	AF_SAMPFMT_TWOSCOMP, SAMPLE_STORAGE_BITS);
+	afSetVirtualSampleFormat(fh, AF_DEFAULT_TRACK,
+	    AF_SAMPFMT_TWOSCOMP, SAMPLE_STORAGE_BITS);
+    }
 
     return true;
 }
@@ -594,9 +692,16 @@ bool Kwave::WavDecoder::open(QWidget *widget, QIODevice &src)
 //***************************************************************************
 bool Kwave::WavDecoder::decode(QWidget */*widget*/, Kwave::MultiWriter &dst)
 {
-    Q_ASSERT(m_src_adapter);
     Q_ASSERT(m_source);
     if (!m_source) return false;
+
+    // fast path: plain PCM data, directly from the file
+    if (m_data_bits) {
+	decodeDirect(dst, Kwave::FileInfo(metaData()).length());
+	return true;
+    }
+
+    Q_ASSERT(m_src_adapter);
     if (!m_src_adapter) return false;
 
     AFfilehandle fh = m_src_adapter->handle();
@@ -664,10 +769,93 @@ bool Kwave::WavDecoder::decode(QWidget */*widget*/, Kwave::MultiWriter &dst)
     return true;
 }
 
+//***************************************************************************
+void Kwave::WavDecoder::decodeDirect(Kwave::MultiWriter &dst,
+                                     sample_index_t length)
+{
+    QFileDevice *file = Kwave::ReadAheadDevice::fileOf(m_source);
+    Q_ASSERT(file);
+    Q_ASSERT(m_data_offset >= 0);
+    if (!file || (m_data_offset < 0)) return;
+
+    const unsigned int tracks = dst.tracks();
+    const unsigned int frame_size = tracks * (m_data_bits / 8);
+
+    // one output block per track, which is handed over to the writers
+    QVector<Kwave::SampleArray> blocks(Kwave::toInt(tracks));
+    for (unsigned int t = 0; t < tracks; t++) {
+	if (!blocks[t].resize(DIRECT_DECODE_FRAMES))
+	    return; // out of memory
+    }
+
+    // split each pass into one range per CPU
+    const unsigned int cpus = qMax(1, QThread::idealThreadCount());
+    QVector<Kwave::PcmDecodeJob> jobs;
+    QByteArray buffer;
+
+    sample_index_t pos = 0;
+    while (pos < length) {
+	const unsigned int frames = Kwave::toUint(qMin<sample_index_t>(
+	    length - pos, DIRECT_DECODE_FRAMES));
+	const qint64 offset = m_data_offset +
+	    static_cast<qint64>(pos * frame_size);
+	const qint64 size   = static_cast<qint64>(frames) * frame_size;
+
+	// map the data, or read it if mapping is not possible
+	uchar *mapped = file->map(offset, size);
+	const quint8 *raw = mapped;
+	if (!mapped) {
+	    if (buffer.size() < size) buffer.resize(Kwave::toInt(size));
+	    if ((buffer.size() < size) || !file->seek(offset) ||
+	        (file->read(buffer.data(), size) != size))
+	    {
+		qWarning("WavDecoder: reading the data failed (%s)",
+		         DBG(file->errorString()));
+		break;
+	    }
+	    raw = reinterpret_cast<const quint8 *>(buffer.constData());
+	}
+
+	// the last pass might be shorter
+	if (frames < DIRECT_DECODE_FRAMES) {
+	    for (unsigned int t = 0; t < tracks; t++)
+		blocks[t].resize(frames);
+	}
+
+	const unsigned int per_job = qMax<unsigned int>(
+	    DIRECT_DECODE_MIN_JOB, (frames + cpus - 1) / cpus);
+	jobs.clear();
+	for (unsigned int first = 0; first < frames; first += per_job) {
+	    Kwave::PcmDecodeJob job;
+	    job.in     = raw + (static_cast<quint64>(first) * frame_size);
+	    job.bits   = m_data_bits;
+	    job.frames = qMin(per_job, frames - first);
+	    job.out.resize(Kwave::toInt(tracks));
+	    for (unsigned int t = 0; t < tracks; t++)
+		job.out[t] = blocks[t].data() + first;
+	    jobs.append(job);
+	}
+
+	// convert and de-interleave all ranges in parallel
+	QtConcurrent::blockingMap(jobs, decodePcmJob);
+	if (mapped) file->unmap(mapped);
+
+	// hand over whole blocks to the writers
+	for (unsigned int t = 0; t < tracks; t++) {
+	    Q_ASSERT(dst[t]);
+	    *(dst[t]) << blocks[t];
+	}
+	pos += frames;
+
+	// abort if the user pressed cancel
+	if (dst.isCanceled()) break;
+    }
+}
+
 //***************************************************************************
 bool Kwave::WavDecoder::repairChunk(
     QList<Kwave::RecoverySource *> *repair_list,
-    Kwave::RIFFChunk *chunk, quint32 &offset)
+    Kwave::RIFFChunk *chunk, quint64 &offset)
 {
     Q_ASSERT(chunk);
     Q_ASSERT(m_source);
@@ -682,8 +870,15 @@ bool Kwave::WavDecoder::repairChunk(
 
     // create buffer with header
     strncpy(buffer, chunk->name().data(), 4);
-    length = (chunk->type() == Kwave::RIFFChunk::Main) ? chunk->physLength() :
-                                                         chunk->dataLength();
+    const quint64 length64 = (chunk->type() == Kwave::RIFFChunk::Main) ?
+	chunk->physLength() : chunk->dataLength();
+
+    // the repaired file always is a classic RIFF with 32 bit sizes,
+    // chunks from a RF64 file might have to be truncated
+    length = static_cast<quint32>(qMin<quint64>(length64,
+                                                RF64_SIZE_IN_DS64 - 1));
+    if (length != length64)
+	qWarning("chunk '%s' truncated to 4GB", chunk->name().data());
     buffer[4] = (length      ) & 0xFF;
     buffer[5] = (length >>  8) & 0xFF;
     buffer[6] = (length >> 16) & 0xFF;
@@ -691,13 +886,13 @@ bool Kwave::WavDecoder::repairChunk(
     if (chunk->type() == Kwave::RIFFChunk::Main) {
 	strncpy(&(buffer[8]), chunk->format().data(), 4);
 	repair = new(std::nothrow) Kwave::RecoveryBuffer(offset, 12, buffer);
-	qDebug("[0x%08X-0x%08X] - main header '%s' (%s), len=%u",
+	qDebug("[0x%08llX-0x%08llX] - main header '%s' (%s), len=%u",
 	      offset, offset+11, chunk->name().data(),
 	      chunk->format().data(), length);
 	offset += 12;
     } else {
 	repair = new(std::nothrow) Kwave::RecoveryBuffer(offset, 8, buffer);
-	qDebug("[0x%08X-0x%08X] - sub header '%s', len=%u",
+	qDebug("[0x%08llX-0x%08llX] - sub header '%s', len=%u",
 	      offset, offset+7, chunk->name().data(), length);
 	offset += 8;
     }
@@ -713,7 +908,7 @@ bool Kwave::WavDecoder::repairChunk(
 	    offset, chunk->physLength(),
 	    *m_source, chunk->dataStart()
 	);
-	qDebug("[0x%08X-0x%08X] - restoring from offset 0x%08X (%u)",
+	qDebug("[0x%08llX-0x%08llX] - restoring from offset 0x%08llX (%llu)",
 	      offset, offset+chunk->physLength()-1, chunk->dataStart(),
 	      chunk->physLength());
 	Q_ASSERT(repair);
@@ -777,6 +972,7 @@ bool Kwave::WavDecoder::repair(QList<Kwave::RecoverySource *> *repair_list,
 	    if (chunk->name() == "fmt ") continue;
 	    if (chunk->name() == "data") continue;
 	    if (chunk->name() == "RIFF") continue;
+	    if (chunk->name() == "ds64") continue;
 	    if (chunk->type() == Kwave::RIFFChunk::Empty) continue;
 	    if (chunk->type() == Kwave::RIFFChunk::Garbage) continue;
 
@@ -794,7 +990,7 @@ bool Kwave::WavDecoder::repair(QList<Kwave::RecoverySource *> *repair_list,
     // --- set up the repair list ---
 
     // RIFF chunk length
-    quint32 offset = 0;
+    quint64 offset = 0;
     bool repaired = repairChunk(repair_list, &new_root, offset);
 
     // clean up...
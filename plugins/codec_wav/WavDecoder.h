@@ -91,7 +91,7 @@ namespace Kwave
 	 * @internal
 	 */
 	bool repairChunk(QList<Kwave::RecoverySource *> *repair_list,
-	                 Kwave::RIFFChunk *chunk, quint32 &offset);
+	                 Kwave::RIFFChunk *chunk, quint64 &offset);
 
     private:
 
@@ -99,6 +99,15 @@ namespace Kwave
 	void addPropertyChunk(const Kwave::FileProperty property,
 	                      const QByteArray &chunk_name);
 
+	/**
+	 * Decodes uncompressed integer PCM data directly from the file,
+	 * through a memory mapping and without libaudiofile. This is also
+	 * the only way to decode RF64/BW64 files.
+	 * @param dst MultiWriter that receives the audio data
+	 * @param length number of sample frames to decode
+	 */
+	void decodeDirect(Kwave::MultiWriter &dst, sample_index_t length);
+
     private:
 
 	/** source of the audio data */
@@ -113,6 +122,15 @@ namespace Kwave
 	/** map for translating chunk names to FileInfo properties */
 	Kwave::WavPropertyMap m_property_map;
 
+	/**
+	 * offset of the sample data within the source if it can be
+	 * decoded directly, see decodeDirect(), or -1 if not
+	 */
+	qint64 m_data_offset;
+
+	/** number of bits per sample, for decodeDirect() */
+	unsigned int m_data_bits;
+
     };
 }
 
@@ -26,6 +26,7 @@
 #include <KLocalizedString>
 
 #include <QByteArray>
+#include <QVector>
 #include <QtEndian>
 #include <QtGlobal>
 
@@ -34,7 +35,10 @@
 #include "libkwave/LabelList.h"
 #include "libkwave/MessageBox.h"
 #include "libkwave/MultiTrackReader.h"
+#include "libkwave/PcmSaveEngine.h"
 #include "libkwave/Sample.h"
+#include "libkwave/SampleArray.h"
+#include "libkwave/SampleConversion.h"
 #include "libkwave/SampleFormat.h"
 #include "libkwave/SampleReader.h"
 #include "libkwave/Utils.h"
@@ -43,6 +47,34 @@
 #include "WavEncoder.h"
 #include "WavFileFormat.h"
 
+/**
+ * maximum size of the sample data in a classic WAV file, leaves some
+ * room for the header, the INFO chunk and the labels
+ */
+#define WAV_MAX_DATA_SIZE (0xFFFFFFFFULL - (64ULL << 20))
+
+/** number of sample frames per block when writing RF64 */
+#define RF64_BLOCK_FRAMES (64 * 1024)
+
+/** offset of the RIFF size in the "ds64" chunk of a RF64 file */
+#define RF64_OFFSET_RIFF_SIZE 20
+
+/** offset of the data size in the "ds64" chunk of a RF64 file */
+#define RF64_OFFSET_DATA_SIZE 28
+
+/** offset of the sample count in the "ds64" chunk of a RF64 file */
+#define RF64_OFFSET_SAMPLE_COUNT 36
+
+/***************************************************************************/
+/** writes a little endian value with the given number of bytes */
+static void writeLE(QIODevice &dst, quint64 value, unsigned int bytes)
+{
+    char buffer[8];
+    for (unsigned int i = 0; i < bytes; ++i)
+	buffer[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    dst.write(buffer, bytes);
+}
+
 /***************************************************************************/
 Kwave::WavEncoder::WavEncoder()
     :Kwave::Encoder(), m_property_map()
@@ -146,14 +178,8 @@ void Kwave::WavEncoder::writeInfoChunk(QIODevice &dst, Kwave::FileInfo &info)
     if (!info_chunks.isEmpty()) {
 	quint32 size;
 
-	// enlarge the main RIFF chunk by the size of the LIST chunk
+	// the size of the main RIFF chunk is set in writeRiffSize()
 	info_size += 4 + 4 + 4; // add the size of LIST(INFO)
-	dst.seek(4);
-	dst.read(reinterpret_cast<char *>(&size), 4);
-	size = qToLittleEndian<quint32>(
-	    qFromLittleEndian<quint32>(size) + info_size);
-	dst.seek(4);
-	dst.write(reinterpret_cast<char *>(&size), 4);
 
 	// add the LIST(INFO) chunk itself
 	dst.seek(dst.size());
@@ -189,7 +215,7 @@ void Kwave::WavEncoder::writeLabels(QIODevice &dst,
                                     const Kwave::LabelList &labels)
 {
     const unsigned int labels_count = labels.count();
-    quint32 size, additional_size = 0, index, data;
+    quint32 size, index, data;
 
     // shortcut: nothing to do if no labels present
     if (!labels_count) return;
@@ -213,19 +239,9 @@ void Kwave::WavEncoder::writeLabels(QIODevice &dst,
     }
     if (size_of_labels) {
 	size_of_labels += 4; /* header entry: 'adtl' */
-	// enlarge the main RIFF chunk by the size of the LIST chunk
-	additional_size += 4 + 4 + size_of_labels; // add size of LIST(adtl)
     }
 
-    // enlarge the main RIFF chunk by the size of the cue chunks
-    additional_size += 4 + 4 + size_of_cue_list; // add size of 'cue '
-
-    dst.seek(4);
-    dst.read(reinterpret_cast<char *>(&size), 4);
-    size = qToLittleEndian<quint32>(
-	qFromLittleEndian<quint32>(size) + additional_size);
-    dst.seek(4);
-    dst.write(reinterpret_cast<char *>(&size), 4);
+    // the size of the main RIFF chunk is set in writeRiffSize()
 
     // seek to the end of the file
     dst.seek(dst.size());
@@ -260,7 +276,9 @@ void Kwave::WavEncoder::writeLabels(QIODevice &dst,
 	dst.write("data", 4);        // fccChunk
 	dst.write(reinterpret_cast<char *>(&data), 4); // dwChunkStart
 	dst.write(reinterpret_cast<char *>(&data), 4); // dwBlockStart
-	data = qToLittleEndian<quint32>(Kwave::toUint(label.pos()));
+	data = qToLittleEndian<quint32>(static_cast<quint32>(
+	    qMin<sample_index_t>(label.pos(),
+	                         std::numeric_limits<quint32>::max())));
 	dst.write(reinterpret_cast<char *>(&data), 4); // dwSampleOffset
 	index++;
     }
@@ -396,10 +414,45 @@ bool Kwave::WavEncoder::encode(QWidget *widget, Kwave::MultiTrackReader &src,
 	return false;
     }
 
-    // check for proper size: WAV supports only 32bit addressing
-    if (length * ((bits + 7) / 8) >= std::numeric_limits<quint32>::max()) {
-	Kwave::MessageBox::error(widget, i18n("File or selection too large"));
-	return false;
+    // check for proper size: WAV supports only 32bit addressing,
+    // bigger files are saved as RF64, with uncompressed PCM only
+    const bool rf64 = (static_cast<quint64>(length) * tracks *
+                       ((bits + 7) / 8) > WAV_MAX_DATA_SIZE);
+    if (rf64) {
+	if (compression != Kwave::Compression::NONE) {
+	    Kwave::MessageBox::error(widget,
+		i18n("File or selection too large"));
+	    return false;
+	}
+
+	// RF64 is written as integer PCM with 8, 16, 24 or 32 bits
+	bits = qBound(8U, ((bits + 7) / 8) * 8, 32U);
+	format.assign((bits == 8) ? Kwave::SampleFormat::Unsigned :
+	                            Kwave::SampleFormat::Signed);
+	info.setBits(bits);
+	info.set(Kwave::INF_SAMPLE_FORMAT, QVariant(format.toInt()));
+	qDebug("saving as RF64, %u bit PCM", bits);
+
+	if (!writeRF64(src, dst, info, bits)) {
+	    Kwave::MessageBox::error(widget,
+		i18n("An error occurred while saving the file"));
+	    return false;
+	}
+
+	// put the properties into the INFO chunk and write the labels
+	writeInfoChunk(dst, info);
+	writeLabels(dst, Kwave::LabelList(meta_data));
+	writeRiffSize(dst, true);
+
+	// bring everything to the disk, once at the end
+	if (Kwave::PcmSaveEngine::isSupported(dst) &&
+	    !Kwave::PcmSaveEngine::sync(dst))
+	{
+	    Kwave::MessageBox::error(widget,
+		i18n("An error occurred while saving the file"));
+	    return false;
+	}
+	return true;
     }
 
     int af_sample_format = AF_SAMPFMT_TWOSCOMP;
@@ -545,8 +598,127 @@ bool Kwave::WavEncoder::encode(QWidget *widget, Kwave::MultiTrackReader &src,
     // write the labels list
     writeLabels(dst, Kwave::LabelList(meta_data));
 
+    // finally set the size of the RIFF chunk
+    writeRiffSize(dst, false);
+
     return true;
 }
 
+/***************************************************************************/
+bool Kwave::WavEncoder::writeRF64(Kwave::MultiTrackReader &src,
+                                  QIODevice &dst,
+                                  const Kwave::FileInfo &info,
+                                  unsigned int bits)
+{
+    const unsigned int   tracks = info.tracks();
+    const sample_index_t length = info.length();
+    const unsigned int   bytes  = bits / 8;
+    const unsigned int   frame_size = tracks * bytes;
+    const quint32        rate = static_cast<quint32>(info.rate());
+
+    /*
+     * "RF64" header with "ds64" chunk, see EBU Tech 3306, the sizes
+     * in the "ds64" chunk are filled in after writing the data
+     */
+    dst.seek(0);
+    dst.write("RF64", 4);
+    writeLE(dst, RF64_SIZE_IN_DS64, 4);
+    dst.write("WAVE", 4);
+    dst.write("ds64", 4);
+    writeLE(dst, RF64_DS64_SIZE, 4);
+    writeLE(dst, 0, 8);                    // riffSize
+    writeLE(dst, 0, 8);                    // dataSize
+    writeLE(dst, 0, 8);                    // sampleCount
+    writeLE(dst, 0, 4);                    // tableLength
+
+    dst.write("fmt ", 4);
+    writeLE(dst, sizeof(Kwave::min_wav_header_t), 4);
+    writeLE(dst, Kwave::WAVE_FORMAT_PCM, 2);
+    writeLE(dst, tracks, 2);
+    writeLE(dst, rate, 4);
+    writeLE(dst, static_cast<quint64>(rate) * frame_size, 4);
+    writeLE(dst, frame_size, 2);
+    writeLE(dst, bits, 2);
+
+    dst.write("data", 4);
+    writeLE(dst, RF64_SIZE_IN_DS64, 4);
+
+    sample_index_t written = 0;
+    if (Kwave::PcmSaveEngine::isSupported(dst)) {
+	// encode and write in parallel, directly into the file
+	Kwave::PcmSaveEngine engine(bits);
+	const bool ok = engine.save(src, dst, length);
+	written = engine.written();
+	if (!ok) return false;
+    } else {
+	// buffers for one block of samples per track and the PCM data
+	QVector<Kwave::SampleArray> in(Kwave::toInt(tracks));
+	QVector<const sample_t *> in_ptr(Kwave::toInt(tracks));
+	QByteArray out;
+	out.resize(Kwave::toInt(RF64_BLOCK_FRAMES * frame_size));
+	if (out.size() != Kwave::toInt(RF64_BLOCK_FRAMES * frame_size))
+	    return false; // out of memory
+	for (unsigned int t = 0; t < tracks; t++) {
+	    if (!in[t].resize(RF64_BLOCK_FRAMES)) return false; // OOM
+	    in_ptr[t] = in[t].constData();
+	}
+
+	// stream the data in blocks
+	while (written < length) {
+	    const unsigned int count = Kwave::toUint(qMin<sample_index_t>(
+		length - written, RF64_BLOCK_FRAMES));
+	    for (unsigned int t = 0; t < tracks; t++) {
+		Kwave::SampleReader *reader = src[t];
+		const unsigned int got = (reader && !reader->eof()) ?
+		    reader->read(in[t], 0, count) : 0;
+		if (got < count) {
+		    memset(in[t].data() + got, 0x00,
+			   (count - got) * sizeof(sample_t));
+		}
+		in_ptr[t] = in[t].constData();
+	    }
+
+	    Kwave::samples2pcm(in_ptr.constData(), bits, tracks,
+		reinterpret_cast<quint8 *>(out.data()), count);
+	    const qint64 block_size = static_cast<qint64>(count) * frame_size;
+	    if (dst.write(out.constData(), block_size) != block_size) {
+		qWarning("WavEncoder: writing RF64 data failed");
+		return false;
+	    }
+	    written += count;
+
+	    // abort if the user pressed cancel
+	    // --> the sizes will match the data written so far
+	    if (src.isCanceled()) break;
+	}
+    }
+
+    // the data chunk is padded to an even length
+    const quint64 data_size = static_cast<quint64>(written) * frame_size;
+    if (data_size & 1) dst.write("\000", 1);
+
+    // fill in the sizes of the data
+    dst.seek(RF64_OFFSET_DATA_SIZE);
+    writeLE(dst, data_size, 8);
+    dst.seek(RF64_OFFSET_SAMPLE_COUNT);
+    writeLE(dst, written, 8);
+    dst.seek(dst.size());
+
+    return true;
+}
+
+/***************************************************************************/
+void Kwave::WavEncoder::writeRiffSize(QIODevice &dst, bool rf64)
+{
+    const quint64 riff_size = static_cast<quint64>(dst.size()) - 4 - 4;
+    if (rf64) {
+	dst.seek(RF64_OFFSET_RIFF_SIZE);
+	writeLE(dst, riff_size, 8);
+    } else {
+	dst.seek(4);
+	writeLE(dst, riff_size, 4);
+    }
+}
+
 /***************************************************************************/
 /***************************************************************************/
@@ -95,6 +95,30 @@ namespace Kwave
 	void fixAudiofileBrokenHeaderBug(QIODevice &dst, Kwave::FileInfo &info,
 	                                 unsigned int frame_size);
 
+	/**
+	 * Writes a RF64 file header and the sample data as uncompressed
+	 * integer PCM, without libaudiofile. The data is streamed in one
+	 * pass, the 64 bit sizes in the "ds64" chunk are filled in at the
+	 * end.
+	 *
+	 * @param src MultiTrackReader used as source of the audio data
+	 * @param dst file or other source to receive a stream of bytes
+	 * @param info information about the file to be saved
+	 * @param bits number of bits per sample, 8, 16, 24 or 32
+	 * @return true if succeeded, false on errors
+	 */
+	bool writeRF64(Kwave::MultiTrackReader &src, QIODevice &dst,
+	               const Kwave::FileInfo &info, unsigned int bits);
+
+	/**
+	 * Sets the size of the "RIFF" chunk to the current size of the
+	 * file, or the 64 bit size in the "ds64" chunk of a RF64 file
+	 *
+	 * @param dst file or other source to receive a stream of bytes
+	 * @param rf64 if true, the file is a RF64 file
+	 */
+	void writeRiffSize(QIODevice &dst, bool rf64);
+
     private:
 
 	/** map for translating chunk names to FileInfo properties */
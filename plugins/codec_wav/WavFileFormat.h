@@ -22,6 +22,15 @@
 
 #include "libkwave/Compression.h"
 
+/**
+ * chunk size in RF64/BW64 files that refers to a 64 bit size
+ * stored in the "ds64" chunk
+ */
+#define RF64_SIZE_IN_DS64 0xFFFFFFFFU
+
+/** size of the "ds64" chunk, without table entries */
+#define RF64_DS64_SIZE 28
+
 namespace Kwave
 {
 
@@ -31,6 +31,7 @@
 #include <QRect>
 #include <QScreen>
 #include <QStringList>
+#include <QVector>
 #include <QWindow>
 
 #include <QApplication>
@@ -47,15 +48,19 @@
 #include "libkwave/MultiTrackReader.h"
 #include "libkwave/MultiTrackWriter.h"
 #include "libkwave/PluginManager.h"
+#include "libkwave/Profiler.h"
+#include "libkwave/SampleConversion.h"
 #include "libkwave/SignalManager.h"
 #include "libkwave/String.h"
 #include "libkwave/Utils.h"
 #include "libkwave/Writer.h"
+#include "libkwave/modules/Oscillator.h"
 #include "libkwave/undo/UndoTransactionGuard.h"
 
 #include "libgui/SelectTimeWidget.h" // for selection mode
 
 #include "DebugPlugin.h"
+#include "ProfilerDialog.h"
 
 KWAVE_PLUGIN(debug, DebugPlugin)
 
@@ -91,6 +96,7 @@ void Kwave::DebugPlugin::load(QStringList &params)
     MENU_ENTRY("sawtooth",          _(I18N_NOOP("Generate Sawtooth Pattern")))
     MENU_ENTRY("sawtooth_verify",   _(I18N_NOOP("Verify Sawtooth Pattern")))
     MENU_ENTRY("fm_sweep",          _(I18N_NOOP("FM Sweep")))
+    MENU_ENTRY("multitone",         _(I18N_NOOP("Multi-Tone Signal")))
 //  MENU_ENTRY("stripe_index",      _(I18N_NOOP("Stripe Index")))
 //  MENU_ENTRY("hull_curve",        _(I18N_NOOP("Hull Curve")))
 //  MENU_ENTRY("offset_in_stripe",  _(I18N_NOOP("Offset in Stripe")))
@@ -99,6 +105,9 @@ void Kwave::DebugPlugin::load(QStringList &params)
 
     entry = _("menu(plugin:setup(debug,%1),Help/%2)");
     MENU_ENTRY("dump_windows",      _(I18N_NOOP("Dump Window Hierarchy")))
+    MENU_ENTRY("profile:start",     _(I18N_NOOP("Profiler/Start")))
+    MENU_ENTRY("profile:stop",      _(I18N_NOOP("Profiler/Stop")))
+    MENU_ENTRY("profile:statistics",_(I18N_NOOP("Profiler/Statistics...")))
 
     entry = _("menu(%1,Help/%2)");
     MENU_ENTRY("dump_metadata()",   _(I18N_NOOP("Dump Meta Data")))
@@ -205,6 +214,16 @@ QStringList *Kwave::DebugPlugin::setup(QStringList &params)
 	    QKeyEvent(QEvent::KeyRelease, key_code, key_modifiers);
 	QCoreApplication::postEvent(widget, release_event);
 
+    } else if (command == _("profile:start")) {
+	Kwave::Profiler::setEnabled(true);
+    } else if (command == _("profile:stop")) {
+	Kwave::Profiler::setEnabled(false);
+    } else if (command == _("profile:save")) {
+        if (params.count() != 2) return Q_NULLPTR;
+	if (!Kwave::Profiler::writeChromeTrace(params[1])) return Q_NULLPTR;
+    } else if (command == _("profile:statistics")) {
+	Kwave::ProfilerDialog dialog(parentWidget());
+	dialog.exec();
     }
 
     return new(std::nothrow) QStringList;
@@ -347,6 +366,39 @@ void Kwave::DebugPlugin::run(QStringList params)
     const sample_index_t right  = last;
     const sample_index_t length = right - left + 1;
     sample_index_t pos = first;
+
+    // set up the oscillators for the test signals
+    QVector<Kwave::Oscillator> oscillators;
+    QVector<float> float_buffer;
+    if (command == _("fm_sweep")) {
+	// linear sweep from 0.5Hz up to the Nyquist frequency
+	const double f_max = rate / 2.0;
+	const double f_min = 1;
+	Kwave::Oscillator osc(Kwave::Oscillator::Sine);
+	osc.setAmplitude(0.707);
+	osc.setFrequency(f_min / (2.0 * rate));
+	osc.sweepTo((2.0 * f_max - f_min) / (2.0 * rate), length);
+	oscillators.append(osc);
+    } else if (command == _("multitone")) {
+	// some reference tones at -20dB each
+	const double tones[] = { 100.0, 440.0, 1000.0, 3150.0, 10000.0 };
+	for (unsigned int i = 0; i < sizeof(tones) / sizeof(tones[0]); ++i) {
+	    if (tones[i] >= rate / 2.0) break;
+	    Kwave::Oscillator osc(Kwave::Oscillator::Sine);
+	    osc.setAmplitude(0.1);
+	    osc.setFrequency(tones[i] / rate);
+	    oscillators.append(osc);
+	}
+    }
+    if (!oscillators.isEmpty()) {
+	float_buffer.resize(BUFFER_SIZE);
+	Q_ASSERT(float_buffer.size() == BUFFER_SIZE);
+	if (float_buffer.size() != BUFFER_SIZE) {
+	    delete writers;
+	    return;
+	}
+    }
+
     while ((first <= last) && (!shouldStop())) {
 	sample_index_t rest = last - first + 1;
 	if (rest < m_buffer.size()) {
@@ -355,19 +407,16 @@ void Kwave::DebugPlugin::run(QStringList params)
 	    if (!ok) break;
 	}
 
-	// sawtooth pattern from min to max
-	if (command == _("fm_sweep")) {
-	    const double f_max = rate / 2.0;
-	    const double f_min = 1;
-	    for (unsigned int i = 0; i < m_buffer.size(); ++i, ++pos) {
-		double t = static_cast<double>(pos - left) / rate;
-		double f = f_min + (((f_max - f_min) *
-		    static_cast<double>(pos - left)) /
-		    static_cast<double>(length));
-		double y = 0.707 * sin(M_PI * f * t);
-		m_buffer[i] = double2sample(y);
-	    }
+	if (!oscillators.isEmpty()) {
+	    // test signals, sum of the output of all oscillators
+	    const unsigned int len = m_buffer.size();
+	    for (int i = 0; i < oscillators.count(); ++i)
+		oscillators[i].generate(float_buffer.data(), len, (i != 0));
+	    Kwave::floats2samples(float_buffer.constData(),
+	                          m_buffer.data(), len);
+	    pos += len;
 	} else if (command == _("sawtooth")) {
+	    // sawtooth pattern from min to max
 	    for (unsigned int i = 0; i < m_buffer.size(); ++i, ++pos) {
 		m_buffer[i] = SAMPLE_MIN +
 		    static_cast<sample_t>(pos % (SAMPLE_MAX - SAMPLE_MIN));
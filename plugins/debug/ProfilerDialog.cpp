@@ -0,0 +1,165 @@
+/*************************************************************************
+       ProfilerDialog.cpp  -  live statistics of the built-in profiler
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "config.h"
+
+#include <new>
+
+#include <QDialogButtonBox>
+#include <QHeaderView>
+#include <QPointer>
+#include <QPushButton>
+#include <QStringList>
+#include <QTreeWidget>
+#include <QTreeWidgetItem>
+#include <QUrl>
+#include <QVBoxLayout>
+
+#include <KLocalizedString>
+
+#include "libkwave/MessageBox.h"
+#include "libkwave/Profiler.h"
+#include "libkwave/String.h"
+
+#include "libgui/FileDialog.h"
+
+#include "ProfilerDialog.h"
+
+/** refresh interval of the statistics [ms] */
+#define REFRESH_INTERVAL 500
+
+//***************************************************************************
+Kwave::ProfilerDialog::ProfilerDialog(QWidget *parent)
+    :QDialog(parent), m_list(Q_NULLPTR), m_timer()
+{
+    setWindowTitle(i18n("Profiler"));
+
+    QVBoxLayout *layout = new(std::nothrow) QVBoxLayout(this);
+    Q_ASSERT(layout);
+    if (!layout) return;
+
+    m_list = new(std::nothrow) QTreeWidget(this);
+    Q_ASSERT(m_list);
+    if (!m_list) return;
+    m_list->setRootIsDecorated(false);
+    m_list->setSortingEnabled(true);
+    m_list->setHeaderLabels(QStringList()
+	<< i18n("Stage")
+	<< i18n("Kind")
+	<< i18n("Count")
+	<< i18n("Total [ms]")
+	<< i18n("Average [ms]")
+	<< i18n("Maximum [ms]")
+	<< i18n("Samples")
+	<< i18n("Samples/s")
+    );
+    m_list->sortByColumn(3, Qt::DescendingOrder);
+    layout->addWidget(m_list);
+
+    QDialogButtonBox *buttons = new(std::nothrow) QDialogButtonBox(
+	QDialogButtonBox::Close, this);
+    Q_ASSERT(buttons);
+    if (!buttons) return;
+    QPushButton *start = buttons->addButton(
+	(Kwave::Profiler::isEnabled()) ? i18n("Stop") : i18n("Start"),
+	QDialogButtonBox::ActionRole);
+    QPushButton *save = buttons->addButton(
+	i18n("Save Trace..."), QDialogButtonBox::ActionRole);
+    layout->addWidget(buttons);
+
+    connect(buttons, SIGNAL(rejected()), this, SLOT(reject()));
+    connect(start,   SIGNAL(clicked()),  this, SLOT(toggleEnabled()));
+    connect(save,    SIGNAL(clicked()),  this, SLOT(saveTrace()));
+    connect(&m_timer, SIGNAL(timeout()), this, SLOT(refresh()));
+
+    resize(800, 400);
+    refresh();
+    m_timer.start(REFRESH_INTERVAL);
+}
+
+//***************************************************************************
+Kwave::ProfilerDialog::~ProfilerDialog()
+{
+    m_timer.stop();
+}
+
+//***************************************************************************
+void Kwave::ProfilerDialog::refresh()
+{
+    if (!m_list) return;
+
+    m_list->setSortingEnabled(false);
+    m_list->clear();
+    foreach (const Kwave::Profiler::Statistics &s,
+             Kwave::Profiler::statistics())
+    {
+	const double total = static_cast<double>(s.m_time) / 1E6;
+	const double avg   = (s.m_count) ? (total / s.m_count) : 0.0;
+	const double max   = static_cast<double>(s.m_max) / 1E6;
+	const double rate  = (s.m_time > 0) ?
+	    (static_cast<double>(s.m_items) * 1E9 / s.m_time) : 0.0;
+
+	QTreeWidgetItem *item = new(std::nothrow) QTreeWidgetItem(m_list);
+	if (!item) break;
+	item->setText(0, s.m_name);
+	item->setText(1, (s.m_kind == Kwave::Profiler::Wait) ?
+	    i18n("lock wait") : i18n("work"));
+	item->setData(2, Qt::DisplayRole, s.m_count);
+	item->setData(3, Qt::DisplayRole, total);
+	item->setData(4, Qt::DisplayRole, avg);
+	item->setData(5, Qt::DisplayRole, max);
+	item->setData(6, Qt::DisplayRole, s.m_items);
+	item->setData(7, Qt::DisplayRole, qRound64(rate));
+    }
+    m_list->setSortingEnabled(true);
+}
+
+//***************************************************************************
+void Kwave::ProfilerDialog::toggleEnabled()
+{
+    const bool enable = !Kwave::Profiler::isEnabled();
+    Kwave::Profiler::setEnabled(enable);
+
+    QPushButton *button = qobject_cast<QPushButton *>(sender());
+    if (button) button->setText((enable) ? i18n("Stop") : i18n("Start"));
+    refresh();
+}
+
+//***************************************************************************
+void Kwave::ProfilerDialog::saveTrace()
+{
+    QPointer<Kwave::FileDialog> dlg = new(std::nothrow) Kwave::FileDialog(
+	_("kfiledialog:///kwave_profiler"),
+	Kwave::FileDialog::SaveFile, _("*.json|") + i18n("Chrome Trace"),
+	this, QUrl(), _("*.json")
+    );
+    if (!dlg) return;
+    dlg->setWindowTitle(i18n("Save Trace"));
+    if ((dlg->exec() == QDialog::Accepted) && dlg) {
+	QString filename = dlg->selectedUrl().toLocalFile();
+	if (!filename.isEmpty() &&
+	    !Kwave::Profiler::writeChromeTrace(filename))
+	{
+	    Kwave::MessageBox::error(this,
+		i18n("Unable to write the trace to '%1'.", filename));
+	}
+    }
+    delete dlg;
+}
+
+//***************************************************************************
+//***************************************************************************
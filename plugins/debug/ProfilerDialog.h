@@ -0,0 +1,74 @@
+/*************************************************************************
+         ProfilerDialog.h  -  live statistics of the built-in profiler
+                             -------------------
+    begin                : Mon Oct 19 2026
+    copyright            : (C) 2026 by Thomas Eschenbacher
+    email                : Thomas.Eschenbacher@gmx.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef PROFILER_DIALOG_H
+#define PROFILER_DIALOG_H
+
+#include "config.h"
+
+#include <QDialog>
+#include <QTimer>
+
+class QTreeWidget;
+
+namespace Kwave
+{
+    /**
+     * Shows the statistics of the stages that are instrumented with
+     * Kwave::ProfileScope: number of events, time, throughput and the
+     * time spent waiting for locks. The view is updated periodically.
+     */
+    class ProfilerDialog: public QDialog
+    {
+	Q_OBJECT
+    public:
+
+	/**
+	 * Constructor
+	 * @param parent the parent widget
+	 */
+	explicit ProfilerDialog(QWidget *parent);
+
+	/** Destructor */
+        virtual ~ProfilerDialog() Q_DECL_OVERRIDE;
+
+    private slots:
+
+	/** updates the list of statistics */
+	void refresh();
+
+	/** starts or stops the profiler */
+	void toggleEnabled();
+
+	/** asks for a file name and saves the events as Chrome trace */
+	void saveTrace();
+
+    private:
+
+	/** list with one entry per stage */
+	QTreeWidget *m_list;
+
+	/** timer for refreshing the list */
+	QTimer m_timer;
+
+    };
+}
+
+#endif /* PROFILER_DIALOG_H */
+
+//***************************************************************************
+//***************************************************************************
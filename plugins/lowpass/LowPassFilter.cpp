@@ -26,7 +26,7 @@
 
 //***************************************************************************
 Kwave::LowPassFilter::LowPassFilter()
-    :Kwave::SampleSource(Q_NULLPTR), m_buffer(blockSize()),
+    :Kwave::SampleSource(Q_NULLPTR), m_buffer(blockSize()), m_float_buffer(),
     m_f_cutoff(M_PI)
 {
     initFilter();
@@ -41,6 +41,7 @@ Kwave::LowPassFilter::~LowPassFilter()
 void Kwave::LowPassFilter::goOn()
 {
     emit output(m_buffer);
+    emit output(m_float_buffer);
 }
 
 //***************************************************************************
@@ -162,6 +163,34 @@ void Kwave::LowPassFilter::input(Kwave::SampleArray data)
     }
 }
 
+//***************************************************************************
+void Kwave::LowPassFilter::input(Kwave::FloatArray data)
+{
+    const Kwave::FloatArray &in = data;
+    bool ok = m_float_buffer.resize(in.size());
+    Q_ASSERT(ok);
+    Q_UNUSED(ok)
+
+    normed_setfilter_shelvelowpass(m_f_cutoff);
+
+    for (unsigned i = 0; i < in.size(); ++i)
+    {
+	// do the filtering, without clipping
+	m_filter.x = static_cast<double>(in[i]);
+	m_filter.y =
+	    m_filter.cx  * m_filter.x  +
+	    m_filter.cx1 * m_filter.x1 +
+	    m_filter.cx2 * m_filter.x2 +
+	    m_filter.cy1 * m_filter.y1 +
+	    m_filter.cy2 * m_filter.y2;
+	m_filter.x2 = m_filter.x1;
+	m_filter.x1 = m_filter.x;
+	m_filter.y2 = m_filter.y1;
+	m_filter.y1 = m_filter.y;
+	m_float_buffer[i] = static_cast<float>(0.95 * m_filter.y);
+    }
+}
+
 //***************************************************************************
 double Kwave::LowPassFilter::at(double f)
 {
@@ -20,9 +20,11 @@
 #include <math.h>
 
 #include <QColor>
+#include <QComboBox>
 #include <QPainter>
 #include <QPushButton>
 #include <QRadioButton>
+#include <QRandomGenerator>
 #include <QSlider>
 #include <QSpinBox>
 
@@ -31,6 +33,7 @@
 
 #include "libkwave/String.h"
 #include "libkwave/Utils.h"
+#include "libkwave/modules/NoiseEngine.h"
 
 #include "libgui/Colors.h"
 #include "libgui/CurveWidget.h"
@@ -46,7 +49,8 @@ Kwave::NoiseDialog::NoiseDialog(QWidget *parent,
                                   Kwave::OverViewCache *overview_cache)
     :QDialog(parent), Kwave::PluginSetupDialog(), Ui::NoiseDlg(),
      m_noise(0.1), m_mode(MODE_DECIBEL),
-     m_enable_updates(true), m_overview_cache(overview_cache)
+     m_enable_updates(true), m_overview_cache(overview_cache),
+     m_seed(QRandomGenerator::global()->generate64())
 {
     setupUi(this);
     setModal(true);
@@ -62,6 +66,9 @@ Kwave::NoiseDialog::NoiseDialog(QWidget *parent,
             this, SLOT(sliderChanged(int)));
     connect(spinbox, SIGNAL(valueChanged(int)),
             this, SLOT(spinboxChanged(int)));
+    // changes in the spectrum
+    connect(cbSpectrum, SIGNAL(currentIndexChanged(int)),
+            this, SIGNAL(spectrumChanged(int)));
     // click to the "Listen" button
     connect(btListen, SIGNAL(toggled(bool)),
             this, SLOT(listenToggled(bool)));
@@ -326,6 +333,9 @@ QStringList Kwave::NoiseDialog::params()
     QStringList list;
     list << QString::number(m_noise);
     list << QString::number(static_cast<int>(m_mode));
+    list << Kwave::NoiseEngine::spectrumName(
+	static_cast<Kwave::NoiseEngine::Spectrum>(cbSpectrum->currentIndex()));
+    list << QString::number(m_seed);
     return list;
 }
 
@@ -348,6 +358,14 @@ void Kwave::NoiseDialog::setParams(QStringList &params)
 
     // update factor
     updateDisplay(factor);
+
+    // optional: spectrum
+    if (params.count() > 2) {
+	bool ok = false;
+	Kwave::NoiseEngine::Spectrum spectrum =
+	    Kwave::NoiseEngine::spectrumFromName(params[2], &ok);
+	if (ok) cbSpectrum->setCurrentIndex(static_cast<int>(spectrum));
+    }
 }
 
 //***************************************************************************
@@ -23,6 +23,7 @@
 #include <QDialog>
 #include <QObject>
 #include <QString>
+#include <QtGlobal>
 
 #include "libkwave/PluginSetupDialog.h"
 #include "ui_NoiseDlg.h"
@@ -64,6 +65,13 @@ namespace Kwave
 	 */
 	void levelChanged(double level);
 
+	/**
+	 * Emitted whenever the spectrum changes
+	 * @param spectrum index of the spectrum,
+	 *        see Kwave::NoiseEngine::Spectrum
+	 */
+	void spectrumChanged(int spectrum);
+
 	/** Pre-listen mode has been started */
 	void startPreListen();
 
@@ -130,6 +138,13 @@ namespace Kwave
 	/** overview cache for calculating the preview image */
 	Kwave::OverViewCache *m_overview_cache;
 
+	/**
+	 * seed of the random numbers, drawn once per dialog and passed
+	 * with the parameters, so that repeating the command gives the
+	 * same noise
+	 */
+	quint64 m_seed;
+
     };
 }
 
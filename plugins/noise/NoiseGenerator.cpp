@@ -25,8 +25,10 @@
 //***************************************************************************
 Kwave::NoiseGenerator::NoiseGenerator(QObject *parent)
     :Kwave::SampleSource(parent),
-     m_random(),
+     m_engine(),
+     m_start(0),
      m_buffer(blockSize()),
+     m_noise(),
      m_noise_level(1.0)
 {
 }
@@ -42,24 +44,40 @@ void Kwave::NoiseGenerator::goOn()
     emit output(m_buffer);
 }
 
+//***************************************************************************
+void Kwave::NoiseGenerator::setStream(quint32 stream)
+{
+    m_engine.setStream(stream);
+}
+
+//***************************************************************************
+void Kwave::NoiseGenerator::seek(quint64 position)
+{
+    m_start = position;
+    m_engine.seek(position);
+}
+
 //***************************************************************************
 void Kwave::NoiseGenerator::input(Kwave::SampleArray data)
 {
-    bool ok = m_buffer.resize(data.size());
+    const unsigned int count = data.size();
+    bool ok = m_buffer.resize(count);
     Q_ASSERT(ok);
     Q_UNUSED(ok)
 
     m_buffer = data;
 
-    const quint32 max  = m_random.max();
-    const quint32 m_2  = max / 2;
+    if (static_cast<unsigned int>(m_noise.size()) < count)
+	m_noise.resize(count);
+    m_engine.generate(m_noise.data(), count);
+
     const double alpha = (1.0 - m_noise_level);
-    const double scale = (m_noise_level * 2.0) / static_cast<double>(max);
-    for (unsigned i = 0; i < data.size(); ++i) {
+    const double scale = m_noise_level;
+    const float *noise = m_noise.constData();
+    for (unsigned i = 0; i < count; ++i) {
 	const Kwave::SampleArray &in = data;
 	m_buffer[i] = double2sample(
-	    (sample2double(in[i]) * alpha) +
-	    (qint32(m_random.generate() - m_2) * scale)
+	    (sample2double(in[i]) * alpha) + (noise[i] * scale)
 	);
     }
 }
@@ -70,5 +88,20 @@ void Kwave::NoiseGenerator::setNoiseLevel(const QVariant fc)
     m_noise_level = QVariant(fc).toDouble();
 }
 
+//***************************************************************************
+void Kwave::NoiseGenerator::setSpectrum(const QVariant spectrum)
+{
+    m_engine.setSpectrum(static_cast<Kwave::NoiseEngine::Spectrum>(
+	QVariant(spectrum).toInt()));
+}
+
+//***************************************************************************
+void Kwave::NoiseGenerator::setSeed(const QVariant seed)
+{
+    // restart at the beginning, the same seed gives the same noise
+    m_engine.setSeed(QVariant(seed).toULongLong());
+    m_engine.seek(m_start);
+}
+
 //***************************************************************************
 //***************************************************************************
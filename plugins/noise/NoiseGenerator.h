@@ -21,11 +21,12 @@
 #include "config.h"
 
 #include <QObject>
-#include <QRandomGenerator>
 #include <QVariant>
+#include <QVector>
 
 #include "libkwave/SampleArray.h"
 #include "libkwave/SampleSource.h"
+#include "libkwave/modules/NoiseEngine.h"
 
 namespace Kwave
 {
@@ -46,6 +47,20 @@ namespace Kwave
 	 */
         virtual void goOn() Q_DECL_OVERRIDE;
 
+	/**
+	 * Sets the index of the random stream, should be the index of
+	 * the track, so that every track gets independent noise
+	 * @param stream index of the stream
+	 */
+	void setStream(quint32 stream);
+
+	/**
+	 * Sets the position of the next generated noise sample, normally
+	 * the index of the first sample of the selection
+	 * @param position index of the sample
+	 */
+	void seek(quint64 position);
+
     signals:
 
 	/** emits a block with noise */
@@ -61,14 +76,32 @@ namespace Kwave
 	 */
 	void setNoiseLevel(const QVariant fc);
 
+	/**
+	 * Sets the spectrum of the noise
+	 * @param spectrum see Kwave::NoiseEngine::Spectrum
+	 */
+	void setSpectrum(const QVariant spectrum);
+
+	/**
+	 * Sets the seed of the random numbers
+	 * @param seed the seed, as unsigned 64 bit integer
+	 */
+	void setSeed(const QVariant seed);
+
     private:
 
-	/** random generator for the noise */
-	QRandomGenerator m_random;
+	/** generator for the noise */
+	Kwave::NoiseEngine m_engine;
+
+	/** start position, for restarting in pre-listen mode */
+	quint64 m_start;
 
 	/** buffer for input */
 	Kwave::SampleArray m_buffer;
 
+	/** buffer for the generated noise */
+	QVector<float> m_noise;
+
 	/** noise level [0 .. 1.0] */
 	double m_noise_level;
 
@@ -21,6 +21,8 @@
 
 #include <errno.h>
 
+#include <QRandomGenerator>
+
 #include <KLocalizedString> // for the i18n macro
 
 #include "libkwave/Connect.h"
@@ -29,6 +31,8 @@
 #include "libkwave/PluginManager.h"
 #include "libkwave/SampleSink.h"
 #include "libkwave/SampleSource.h"
+#include "libkwave/Utils.h"
+#include "libkwave/modules/NoiseEngine.h"
 #include "libkwave/undo/UndoTransactionGuard.h"
 
 #include "libgui/OverViewCache.h"
@@ -41,7 +45,8 @@ KWAVE_PLUGIN(noise, NoisePlugin)
 
 //***************************************************************************
 Kwave::NoisePlugin::NoisePlugin(QObject *parent, const QVariantList &args)
-    :Kwave::FilterPlugin(parent, args), m_level(1.0), m_last_level(0.0)
+    :Kwave::FilterPlugin(parent, args), m_level(1.0), m_last_level(0.0),
+     m_spectrum(Kwave::NoiseEngine::White), m_last_spectrum(-1), m_seed(0)
 {
 }
 
@@ -57,7 +62,7 @@ int Kwave::NoisePlugin::interpreteParameters(QStringList &params)
     QString param;
 
     // evaluate the parameter list
-    if (params.count() != 2) return -EINVAL;
+    if ((params.count() < 2) || (params.count() > 4)) return -EINVAL;
 
     param = params[0];
     m_level = param.toDouble(&ok);
@@ -69,6 +74,26 @@ int Kwave::NoisePlugin::interpreteParameters(QStringList &params)
     Q_ASSERT(ok);
     if (!ok || (mode > 2)) return -EINVAL;
 
+    // optional: spectrum, white noise as default
+    m_spectrum = Kwave::NoiseEngine::White;
+    if (params.count() > 2) {
+	param = params[2];
+	m_spectrum = Kwave::NoiseEngine::spectrumFromName(param, &ok);
+	Q_ASSERT(ok);
+	if (!ok) return -EINVAL;
+    }
+
+    // optional: seed, the setup dialog always passes one. Without it
+    // (e.g. in old macros) every run gives different noise
+    if (params.count() > 3) {
+	param = params[3];
+	m_seed = param.toULongLong(&ok);
+	Q_ASSERT(ok);
+	if (!ok) return -EINVAL;
+    } else {
+	m_seed = QRandomGenerator::global()->generate64();
+    }
+
     // all parameters accepted
     return 0;
 }
@@ -99,6 +124,8 @@ Kwave::PluginSetupDialog *Kwave::NoisePlugin::createDialog(QWidget *parent)
     // connect the signals for detecting value changes in pre-listen mode
     connect(dialog, SIGNAL(levelChanged(double)),
             this,   SLOT(setNoiseLevel(double)));
+    connect(dialog, SIGNAL(spectrumChanged(int)),
+            this,   SLOT(setSpectrum(int)));
 
     return dialog;
 }
@@ -106,14 +133,33 @@ Kwave::PluginSetupDialog *Kwave::NoisePlugin::createDialog(QWidget *parent)
 //***************************************************************************
 Kwave::SampleSource *Kwave::NoisePlugin::createFilter(unsigned int tracks)
 {
-    return new(std::nothrow)
+    Kwave::MultiTrackSource<Kwave::NoiseGenerator, true> *filter =
+	new(std::nothrow)
 	Kwave::MultiTrackSource<Kwave::NoiseGenerator, true>(tracks);
+    if (!filter) return Q_NULLPTR;
+
+    // every track gets it's own stream of random numbers, that starts
+    // at the absolute position of the selection, so that the result
+    // only depends on seed, track and position
+    QVector<unsigned int> selected_tracks;
+    sample_index_t first = 0;
+    selection(&selected_tracks, &first, Q_NULLPTR, true);
+    for (unsigned int i = 0; i < tracks; i++) {
+	Kwave::NoiseGenerator *generator = (*filter)[i];
+	if (!generator) continue;
+	generator->setStream((i < Kwave::toUint(selected_tracks.count())) ?
+	    selected_tracks[i] : i);
+	generator->seek(first);
+    }
+
+    return filter;
 }
 
 //***************************************************************************
 bool Kwave::NoisePlugin::paramsChanged()
 {
-    return (!qFuzzyCompare(m_level, m_last_level));
+    return (!qFuzzyCompare(m_level, m_last_level) ||
+            (m_spectrum != m_last_spectrum));
 }
 
 //***************************************************************************
@@ -126,7 +172,16 @@ void Kwave::NoisePlugin::updateFilter(Kwave::SampleSource *filter,
 	filter->setAttribute(SLOT(setNoiseLevel(QVariant)),
 	                     QVariant(m_level));
 
-    m_last_level = m_level;
+    if ((m_spectrum != m_last_spectrum) || force)
+	filter->setAttribute(SLOT(setSpectrum(QVariant)),
+	                     QVariant(m_spectrum));
+
+    if (force)
+	filter->setAttribute(SLOT(setSeed(QVariant)),
+	                     QVariant(m_seed));
+
+    m_last_level    = m_level;
+    m_last_spectrum = m_spectrum;
 }
 
 //***************************************************************************
@@ -141,6 +196,12 @@ void Kwave::NoisePlugin::setNoiseLevel(double level)
     m_level = level;
 }
 
+//***************************************************************************
+void Kwave::NoisePlugin::setSpectrum(int spectrum)
+{
+    m_spectrum = spectrum;
+}
+
 //***************************************************************************
 #include "NoisePlugin.moc"
 //***************************************************************************
@@ -88,6 +88,13 @@ namespace Kwave
 	 */
 	void setNoiseLevel(double level);
 
+	/**
+	 * called when the spectrum setting changed during pre-listen
+	 * @param spectrum index of the spectrum,
+	 *        see Kwave::NoiseEngine::Spectrum
+	 */
+	void setSpectrum(int spectrum);
+
     private:
 
 	/** noise level, as linear factor ]0 ... 1.0] */
@@ -96,6 +103,15 @@ namespace Kwave
 	/** last value of m_level */
 	double m_last_level;
 
+	/** spectrum of the noise, see Kwave::NoiseEngine::Spectrum */
+	int m_spectrum;
+
+	/** last value of m_spectrum */
+	int m_last_spectrum;
+
+	/** seed of the random numbers */
+	quint64 m_seed;
+
     };
 }
 
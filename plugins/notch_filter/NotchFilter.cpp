@@ -27,7 +27,8 @@
 //***************************************************************************
 Kwave::NotchFilter::NotchFilter()
     :Kwave::SampleSource(Q_NULLPTR), Kwave::TransmissionFunction(),
-     m_buffer(blockSize()), m_f_cutoff(M_PI), m_f_bw(M_PI / 2)
+     m_buffer(blockSize()), m_float_buffer(), m_f_cutoff(M_PI),
+     m_f_bw(M_PI / 2)
 {
     initFilter();
 }
@@ -41,6 +42,7 @@ Kwave::NotchFilter::~NotchFilter()
 void Kwave::NotchFilter::goOn()
 {
     emit output(m_buffer);
+    emit output(m_float_buffer);
 }
 
 //***************************************************************************
@@ -144,6 +146,34 @@ void Kwave::NotchFilter::input(Kwave::SampleArray data)
     }
 }
 
+//***************************************************************************
+void Kwave::NotchFilter::input(Kwave::FloatArray data)
+{
+    const Kwave::FloatArray &in = data;
+    bool ok = m_float_buffer.resize(in.size());
+    Q_ASSERT(ok);
+    Q_UNUSED(ok)
+
+    setfilter_peaknotch2(m_f_cutoff, m_f_bw);
+
+    for (unsigned i = 0; i < in.size(); ++i)
+    {
+	// do the filtering, without clipping
+	m_filter.x = static_cast<double>(in[i]);
+	m_filter.y =
+	    m_filter.cx  * m_filter.x  +
+	    m_filter.cx1 * m_filter.x1 +
+	    m_filter.cx2 * m_filter.x2 +
+	    m_filter.cy1 * m_filter.y1 +
+	    m_filter.cy2 * m_filter.y2;
+	m_filter.x2 = m_filter.x1;
+	m_filter.x1 = m_filter.x;
+	m_filter.y2 = m_filter.y1;
+	m_filter.y1 = m_filter.y;
+	m_float_buffer[i] = static_cast<float>(0.95 * m_filter.y);
+    }
+}
+
 //***************************************************************************
 void Kwave::NotchFilter::setFrequency(const QVariant fc)
 {
@@ -26,6 +26,7 @@
 #include <QObject>
 #include <QVariant>
 
+#include "libkwave/FloatArray.h"
 #include "libkwave/SampleArray.h"
 #include "libkwave/SampleSource.h"
 #include "libkwave/TransmissionFunction.h"
@@ -55,11 +56,17 @@ namespace Kwave
 	/** emits a block with the filtered data */
 	void output(Kwave::SampleArray data);
 
+	/** emits a block with the filtered data, in float representation */
+	void output(Kwave::FloatArray data);
+
     public slots:
 
 	/** receives input data */
 	void input(Kwave::SampleArray data);
 
+	/** receives input data in float representation, without clipping */
+	void input(Kwave::FloatArray data);
+
 	/**
 	 * Sets the center frequency, normed to [0...2Pi]. The calculation is:
 	 * fc = frequency [Hz] * 2 * Pi / f_sample [Hz].
@@ -91,6 +98,9 @@ namespace Kwave
 	/** buffer for input */
 	Kwave::SampleArray m_buffer;
 
+	/** buffer for input in float representation */
+	Kwave::FloatArray m_float_buffer;
+
 	/** cutoff frequency [0...PI] */
 	double m_f_cutoff;
 
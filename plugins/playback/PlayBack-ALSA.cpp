@@ -37,6 +37,7 @@
 #include <KLocalizedString>
 
 #include "libkwave/Compression.h"
+#include "libkwave/Profiler.h"
 #include "libkwave/SampleEncoderLinear.h"
 #include "libkwave/SampleFormat.h"
 #include "libkwave/String.h"
@@ -648,6 +649,8 @@ int Kwave::PlayBackALSA::flush()
 
     if (m_handle) {
 	snd_pcm_uframes_t samples = m_buffer_used / m_bytes_per_sample;
+	Kwave::ProfileScope profile("playback:period");
+	profile.setItems(samples);
 	unsigned int buffer_samples = m_buffer_size / m_bytes_per_sample;
 	unsigned int timeout = (m_rate > 0) ?
 	    3 * ((1000 * buffer_samples) /
@@ -38,6 +38,7 @@
 
 #include "libkwave/ByteOrder.h"
 #include "libkwave/Compression.h"
+#include "libkwave/Profiler.h"
 #include "libkwave/SampleEncoderLinear.h"
 #include "libkwave/String.h"
 #include "libkwave/Utils.h"
@@ -296,6 +297,9 @@ void Kwave::PlayBackOSS::flush()
 {
     if (!m_buffer_used || !m_encoder) return; // nothing to do
 
+    Kwave::ProfileScope profile("playback:period");
+    profile.setItems(m_buffer_used);
+
     // convert into byte stream
     unsigned int bytes = m_buffer_used * m_encoder->rawBytesPerSample();
     m_encoder->encode(m_buffer, m_buffer_used, m_raw_buffer);
@@ -37,6 +37,7 @@
 #include <KUser>
 
 #include "libkwave/FileInfo.h"
+#include "libkwave/Profiler.h"
 #include "libkwave/String.h"
 #include "libkwave/Utils.h"
 #include "libkwave/memcpy.h"
@@ -640,6 +641,8 @@ int Kwave::PlayBackPulseAudio::flush()
     int samples_per_buffer = Kwave::toInt(
 	m_buffer_size / m_bytes_per_sample
     );
+    Kwave::ProfileScope profile("playback:period");
+    profile.setItems(samples_per_buffer);
     int ms = (!qFuzzyIsNull(m_rate)) ?
 	Kwave::toInt((samples_per_buffer * 1000.0) / m_rate) : 0;
     int timeout = (ms + 1) * 16;
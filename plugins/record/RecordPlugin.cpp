@@ -42,6 +42,7 @@
 #include "libkwave/InsertMode.h"
 #include "libkwave/MessageBox.h"
 #include "libkwave/PluginManager.h"
+#include "libkwave/Profiler.h"
 #include "libkwave/Sample.h"
 #include "libkwave/SampleFIFO.h"
 #include "libkwave/SampleFormat.h"
@@ -1492,6 +1493,9 @@ void Kwave::RecordPlugin::processBuffer()
     Q_ASSERT(samples);
     if (!samples) return;
 
+    Kwave::ProfileScope profile("record:buffer");
+    profile.setItems(samples * tracks);
+
     // check for reached recording time limit if enabled
     if (params.record_time_limited && m_writers) {
 	sample_index_t last = m_writers->last();
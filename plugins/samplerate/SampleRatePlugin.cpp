@@ -17,12 +17,17 @@
 
 #include "config.h"
 #include <errno.h>
+#include <math.h>
+#include <string.h>
 
 #include <KLocalizedString> // for the i18n macro
 
 #include <QList>
 #include <QListIterator>
 #include <QStringList>
+#include <QThread>
+#include <QVector>
+#include <QtConcurrentMap>
 
 #include "libkwave/Connect.h"
 #include "libkwave/FileInfo.h"
@@ -30,6 +35,7 @@
 #include "libkwave/MultiTrackReader.h"
 #include "libkwave/MultiTrackWriter.h"
 #include "libkwave/PluginManager.h"
+#include "libkwave/SampleConversion.h"
 #include "libkwave/SignalManager.h"
 #include "libkwave/Utils.h"
 #include "libkwave/Writer.h"
@@ -42,11 +48,46 @@
 
 KWAVE_PLUGIN(samplerate, SampleRatePlugin)
 
+/** length of a chunk for parallel processing [samples] */
+#define CHUNK_LENGTH (1024 * 1024)
+
+/**
+ * length of the pre-roll and post-roll around each chunk [samples],
+ * must be longer than the half filter length of all converters
+ */
+#define PREROLL_LENGTH 8192
+
+namespace Kwave
+{
+    /** one chunk of one track, for parallel conversion */
+    typedef struct {
+	Kwave::Resampler::Quality quality; /**< quality of the conversion  */
+	double          ratio;  /**< conversion ratio                      */
+	const sample_t *in;     /**< input, including pre- and post-roll   */
+	unsigned int    len;    /**< number of input samples               */
+	unsigned int    skip;   /**< output samples of the pre-roll        */
+	sample_t       *out;    /**< destination of the output             */
+	unsigned int    count;  /**< number of output samples              */
+    } ResampleJob;
+}
+
+//***************************************************************************
+static void convertJob(Kwave::ResampleJob &job)
+{
+    QVector<float> in(Kwave::toInt(job.len));
+    QVector<float> out(Kwave::toInt(job.count));
+
+    Kwave::samples2floats(job.in, in.data(), job.len);
+    Kwave::Resampler::convertChunk(job.quality, job.ratio,
+	in.constData(), job.len, job.skip, out.data(), job.count);
+    Kwave::floats2samples(out.constData(), job.out, job.count);
+}
+
 //***************************************************************************
 Kwave::SampleRatePlugin::SampleRatePlugin(QObject *parent,
                                           const QVariantList &args)
     :Kwave::Plugin(parent, args), m_params(), m_new_rate(0.0),
-     m_whole_signal(false)
+     m_whole_signal(false), m_quality(Kwave::Resampler::Medium)
 {
 }
 
@@ -64,19 +105,27 @@ int Kwave::SampleRatePlugin::interpreteParameters(QStringList &params)
     // set defaults
     m_new_rate     = 44100.0;
     m_whole_signal = false;
+    m_quality      = Kwave::Resampler::Medium;
 
     // evaluate the parameter list
-    if (params.count() < 1) return -EINVAL;
+    if ((params.count() < 1) || (params.count() > 3)) return -EINVAL;
 
     param = params[0];
     m_new_rate = param.toDouble(&ok);
     if (!ok) return -EINVAL;
 
     // check whether we should change the whole signal (optional)
-    if (params.count() == 2) {
-	if (params[1] != _("all"))
+    if (params.count() >= 2) {
+	if (params[1] == _("all"))
+	    m_whole_signal = true;
+	else if (params[1] != _("selection"))
 	    return -EINVAL;
-	m_whole_signal = true;
+    }
+
+    // quality of the conversion (optional)
+    if (params.count() >= 3) {
+	m_quality = Kwave::Resampler::qualityFromName(params[2], &ok);
+	if (!ok) return -EINVAL;
     }
 
     // all parameters accepted
@@ -162,29 +211,50 @@ void Kwave::SampleRatePlugin::run(QStringList params)
 	     (old_rate   / 1E3), (m_new_rate / 1E3))
     );
 
-    // create the converter
-    Kwave::MultiTrackSource<Kwave::RateConverter, true> converter(
-	tracks.count(), this);
-    converter.setAttribute(SLOT(setRatio(QVariant)), QVariant(ratio));
-
     // create the writer with the appropriate length
     Kwave::MultiTrackWriter sink(mgr, tracks, Kwave::Overwrite,
 	first, first + new_length - 1);
 
-    // connect the objects
-    bool ok = Kwave::connect(
-	source,    SIGNAL(output(Kwave::SampleArray)),
-	converter, SLOT(input(Kwave::SampleArray)));
-    if (ok) ok = Kwave::connect(
-	converter, SIGNAL(output(Kwave::SampleArray)),
-	sink,      SLOT(input(Kwave::SampleArray)));
-    if (!ok) {
-	return;
-    }
+    // long ranges with a rational ratio can be split into chunks and
+    // converted in parallel, but only with the polyphase filter: it's
+    // output depends only on the input within the filter length, while
+    // libsamplerate accumulates it's phase over the whole conversion
+    unsigned int up   = 1;
+    unsigned int down = 1;
+    if ((m_quality == Kwave::Resampler::Polyphase) &&
+        (length >= 2 * CHUNK_LENGTH) &&
+        (ratio >= (1.0 / 8.0)) && (ratio <= 8.0) &&
+        Kwave::Resampler::rational(ratio, up, down))
+    {
+	convertChunked(source, sink, up, down, length, new_length);
+    } else {
+	// create the converter
+	Kwave::MultiTrackSource<Kwave::RateConverter, true> converter(
+	    tracks.count(), this);
+	converter.setAttribute(SLOT(setRatio(QVariant)), QVariant(ratio));
+	converter.setAttribute(SLOT(setQuality(QVariant)),
+	                       QVariant(static_cast<int>(m_quality)));
+
+	// connect the objects, in float representation, which saves the
+	// conversion to and from sample_t within the converter
+	bool ok = Kwave::connect(
+	    source,    SIGNAL(output(Kwave::FloatArray)),
+	    converter, SLOT(input(Kwave::FloatArray)));
+	if (ok) ok = Kwave::connect(
+	    converter, SIGNAL(output(Kwave::FloatArray)),
+	    sink,      SLOT(input(Kwave::FloatArray)));
+	if (!ok) {
+	    return;
+	}
+
+	while (!shouldStop() && !source.eof()) {
+	    source.goOn();
+	    converter.goOn();
+	}
 
-    while (!shouldStop() && !source.eof()) {
-	source.goOn();
-	converter.goOn();
+	// flush the samples still held in the filters of the converters
+	for (unsigned int t = 0; t < converter.tracks(); ++t)
+	    if (converter[t]) converter[t]->finished();
     }
 
     sink.flush();
@@ -195,7 +265,7 @@ void Kwave::SampleRatePlugin::run(QStringList params)
 // 	    length, new_length, written);
     if (written < length) {
 	sample_index_t to_delete = length - written;
-	mgr.deleteRange(written, to_delete, tracks);
+	mgr.deleteRange(first + written, to_delete, tracks);
     }
 
     // adjust meta data locations
@@ -241,6 +311,108 @@ void Kwave::SampleRatePlugin::run(QStringList params)
 
 }
 
+//***************************************************************************
+void Kwave::SampleRatePlugin::convertChunked(Kwave::MultiTrackReader &source,
+                                             Kwave::MultiTrackWriter &sink,
+                                             unsigned int up,
+                                             unsigned int down,
+                                             sample_index_t length,
+                                             sample_index_t new_length)
+{
+    const double ratio = static_cast<double>(up) / static_cast<double>(down);
+    const unsigned int tracks = source.tracks();
+    if (!tracks) return;
+
+    // chunks and pre-roll must start at a multiple of the decimation
+    // factor, so that the output starts exactly at a sample
+    unsigned int chunk = CHUNK_LENGTH;
+    if (ratio > 1.0)
+	chunk = Kwave::toUint(static_cast<double>(chunk) / ratio);
+    chunk = Kwave::round_up<unsigned int>(chunk, down);
+    const unsigned int chunk_out = (chunk / down) * up;
+    unsigned int preroll = PREROLL_LENGTH;
+    if (ratio < 1.0) preroll *= Kwave::toUint(ceil(1.0 / ratio));
+    preroll = Kwave::round_up<unsigned int>(preroll, down);
+    const unsigned int preroll_out = (preroll / down) * up;
+
+    // give each CPU at least one chunk per pass
+    const unsigned int cpus = qMax(1, QThread::idealThreadCount());
+    const unsigned int chunks_per_pass =
+	qMax(1U, (cpus + tracks - 1) / tracks);
+
+    // per track: input with pre-roll and post-roll, and output
+    // input layout: [pre-roll | chunks_per_pass * chunk | post-roll]
+    const unsigned int in_size  = preroll + (chunks_per_pass * chunk) +
+	preroll;
+    const unsigned int out_size = chunks_per_pass * chunk_out;
+    QVector<Kwave::SampleArray> in(tracks);
+    QVector<Kwave::SampleArray> out(tracks);
+    for (unsigned int t = 0; t < tracks; ++t) {
+	// initially zero, which gives the pre-roll of the first chunk
+	if (!in[t].resize(in_size) || !out[t].resize(out_size))
+	    return; // out of memory
+    }
+
+    sample_index_t pos     = 0;       // start of the current pass
+    sample_index_t written = 0;       // number of samples written
+    unsigned int   filled  = preroll; // valid samples in the input
+    QVector<Kwave::ResampleJob> jobs;
+    while (!shouldStop() && (pos < length) && (written < new_length)) {
+	const sample_index_t remaining = length - pos;
+	const unsigned int chunks = qMin<unsigned int>(chunks_per_pass,
+	    Kwave::toUint((remaining + chunk - 1) / chunk));
+	const unsigned int needed = preroll + (chunks * chunk) + preroll;
+
+	jobs.clear();
+	for (unsigned int t = 0; t < tracks; ++t) {
+	    // read the input, pad with zeroes after the end
+	    Kwave::SampleReader *reader = source[t];
+	    unsigned int got = (reader && (needed > filled)) ?
+		reader->read(in[t], filled, needed - filled) : 0;
+	    if (filled + got < needed) {
+		memset(in[t].data() + filled + got, 0x00,
+		       (needed - filled - got) * sizeof(sample_t));
+	    }
+
+	    const sample_t *src = in[t].constData();
+	    sample_t       *dst = out[t].data();
+	    for (unsigned int c = 0; c < chunks; ++c) {
+		Kwave::ResampleJob job;
+		job.quality = m_quality;
+		job.ratio   = ratio;
+		job.in      = src + (c * chunk);
+		job.len     = preroll + chunk + preroll;
+		job.skip    = preroll_out;
+		job.out     = dst + (c * chunk_out);
+		job.count   = chunk_out;
+		jobs.append(job);
+	    }
+	}
+
+	// let all chunks of all tracks run in parallel
+	QtConcurrent::blockingMap(jobs, convertJob);
+
+	// write the output
+	sample_index_t count = qMin<sample_index_t>(
+	    chunks * chunk_out, new_length - written);
+	for (unsigned int t = 0; t < tracks; ++t) {
+	    Kwave::SampleArray block = out[t];
+	    if (count < block.size())
+		block.resize(Kwave::toUint(count));
+	    *(sink[t]) << block;
+	}
+	written += count;
+	pos     += chunks * chunk;
+
+	// keep the end of this pass as pre-roll of the next one
+	filled = preroll + preroll;
+	for (unsigned int t = 0; t < tracks; ++t) {
+	    sample_t *p = in[t].data();
+	    memmove(p, p + (chunks * chunk), filled * sizeof(sample_t));
+	}
+    }
+}
+
 //***************************************************************************
 #include "SampleRatePlugin.moc"
 //***************************************************************************
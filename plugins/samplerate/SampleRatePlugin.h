@@ -26,9 +26,14 @@
 #include "libkwave/Plugin.h"
 #include "libkwave/Sample.h"
 #include "libkwave/SampleArray.h"
+#include "libkwave/modules/Resampler.h"
 
 namespace Kwave
 {
+
+    class MultiTrackReader;
+    class MultiTrackWriter;
+
     /**
      * @class SampleRatePlugin
      * Change the sample rate of a signal
@@ -64,6 +69,26 @@ namespace Kwave
 	 */
 	int interpreteParameters(QStringList &params);
 
+    private:
+
+	/**
+	 * Converts the samples in overlapping chunks, which are processed
+	 * in parallel on all available CPUs. Only usable for conversion
+	 * ratios that can be expressed as fraction with small factors.
+	 *
+	 * @param source reader for the input samples
+	 * @param sink writer for the output samples
+	 * @param up interpolation factor
+	 * @param down decimation factor
+	 * @param length number of input samples
+	 * @param new_length number of output samples
+	 */
+	void convertChunked(Kwave::MultiTrackReader &source,
+	                    Kwave::MultiTrackWriter &sink,
+	                    unsigned int up, unsigned int down,
+	                    sample_index_t length,
+	                    sample_index_t new_length);
+
     private:
 
 	/** list of parameters */
@@ -75,6 +100,9 @@ namespace Kwave
 	/** if true, ignore selection and change whole signal */
 	bool m_whole_signal;
 
+	/** quality of the conversion */
+	Kwave::Resampler::Quality m_quality;
+
     };
 }
 
@@ -19,14 +19,22 @@
 
 #include <errno.h>
 
+#include <QDate>
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
+#include <QFutureSynchronizer>
+#include <QMutexLocker>
 #include <QPointer>
 #include <QRegExp>
 #include <QStringList>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrentRun>
 
+#include <KAboutData>
 #include <KLocalizedString>
+#include <kxmlgui_version.h>
 
 #include "libkwave/CodecManager.h"
 #include "libkwave/Encoder.h"
@@ -35,6 +43,7 @@
 #include "libkwave/LabelList.h"
 #include "libkwave/MessageBox.h"
 #include "libkwave/MetaDataList.h"
+#include "libkwave/MultiTrackReader.h"
 #include "libkwave/Parser.h"
 #include "libkwave/SignalManager.h"
 #include "libkwave/String.h"
@@ -49,8 +58,14 @@ Kwave::SaveBlocksPlugin::SaveBlocksPlugin(QObject *parent,
                                           const QVariantList &args)
     :Kwave::Plugin(parent, args),
      m_url(), m_pattern(), m_numbering_mode(CONTINUE),
-     m_selection_only(true), m_block_info()
+     m_selection_only(true), m_block_info(), m_export_jobs(),
+     m_export_meta(), m_export_mime_type(), m_export_tracks(),
+     m_export_lock(), m_export_progress(),
+     m_export_done(0.0), m_export_total(0.0)
 {
+    connect(this, SIGNAL(sigExportProgress(qreal)),
+	    this, SLOT(updateProgress(qreal)),
+	    Qt::QueuedConnection);
 }
 
 //***************************************************************************
@@ -224,20 +239,33 @@ int Kwave::SaveBlocksPlugin::start(QStringList &params)
 //     qDebug("selection_only   = %d", selection_only);
 //     qDebug("indices          = %u...%u (count=%u)", first, first+count-1,count);
 
-    // remember the original file info and determine the list of unsupported
-    // properties, we need that later to avoid that the signal manager
-    // complains on saving each and every block, again and again...
-    const Kwave::FileInfo orig_file_info(signalManager().metaData());
-    Kwave::FileInfo file_info(orig_file_info);
+    // determine the encoder and the list of unsupported properties,
+    // the user should be asked only once and not for each block. This
+    // also loads the codec module, which is not possible in the workers.
+    m_export_mime_type = Kwave::CodecManager::mimeTypeOf(m_url);
+    Kwave::FileInfo file_info(signalManager().metaData());
+    file_info.set(Kwave::INF_MIMETYPE, m_export_mime_type);
     QList<Kwave::FileProperty> unsupported_properties;
+    QList<Kwave::FileProperty> supported_properties;
     {
-	QString mimetype = Kwave::CodecManager::mimeTypeOf(m_url);
-	Kwave::Encoder *encoder = Kwave::CodecManager::encoder(mimetype);
-	if (encoder) {
-	    unsupported_properties = encoder->unsupportedProperties(
-		file_info.properties().keys());
-	    delete encoder;
+	Kwave::Encoder *encoder =
+	    Kwave::CodecManager::encoder(m_export_mime_type);
+	if (!encoder) {
+	    Kwave::MessageBox::error(parentWidget(),
+		i18n("Sorry, the file type is not supported."));
+	    return -EINVAL;
 	}
+	unsupported_properties = encoder->unsupportedProperties(
+	    file_info.properties().keys());
+	supported_properties = encoder->supportedProperties();
+	delete encoder;
+    }
+
+    m_export_tracks = selectedTracks();
+    if (m_export_tracks.isEmpty() || !count) {
+	Kwave::MessageBox::error(parentWidget(),
+	    i18n("Signal is empty, nothing to save."));
+	return -EINVAL;
     }
 
     // iterate over all blocks to check for overwritten files and missing dirs
@@ -314,18 +342,72 @@ int Kwave::SaveBlocksPlugin::start(QStringList &params)
 	}
     }
 
-    // save the current selection, we have to restore it afterwards!
-    sample_index_t saved_selection_left  = 0;
-    sample_index_t saved_selection_right = 0;
-    selection(Q_NULLPTR, &saved_selection_left, &saved_selection_right, false);
+    // check if we lose information and ask the user if this would
+    // be acceptable
+    if (!unsupported_properties.isEmpty()) {
+	QString list_of_lost_properties = _("\n");
+	foreach (const Kwave::FileProperty &p, unsupported_properties) {
+	    list_of_lost_properties +=
+		i18n(UTF8(file_info.name(p))) + _("\n");
+	}
+
+	if (Kwave::MessageBox::warningContinueCancel(parentWidget(),
+	    i18n("Saving in this format will lose the following "
+		 "additional file attribute(s):\n"
+		 "%1\n"
+		 "Do you still want to continue?",
+		 list_of_lost_properties),
+	    QString(),
+	    QString(),
+	    QString(),
+	    _("accept_lose_attributes_on_export")
+	    ) != KMessageBox::Continue)
+	{
+	    return -1;
+	}
+    }
+
+    // take a snapshot of the meta data, without the unsupported
+    // properties. The encoders only work on copies of it, neither the
+    // selection nor the meta data of the signal get modified.
+    const QString orig_title = file_info.get(INF_NAME).toString();
+    foreach (const Kwave::FileProperty &p, unsupported_properties)
+	file_info.set(p, QVariant());
+    file_info.setRate(signalRate());
+    file_info.setBits(signalManager().bits());
+    file_info.setTracks(m_export_tracks.count());
+
+    if (!file_info.contains(Kwave::INF_SOFTWARE) &&
+	supported_properties.contains(Kwave::INF_SOFTWARE))
+    {
+	// add our Kwave Software tag
+	const KAboutData about_data = KAboutData::applicationData();
+	QString software = about_data.displayName() + _("-") +
+	                   about_data.version() +
+	                   i18n("(built with KDE Frameworks %1)",
+	                        _(KXMLGUI_VERSION_STRING));
+	file_info.set(Kwave::INF_SOFTWARE, software);
+    }
+
+    if (!file_info.contains(Kwave::INF_CREATION_DATE) &&
+	supported_properties.contains(Kwave::INF_CREATION_DATE))
+    {
+	// add a date tag
+	QString date(QDate::currentDate().toString(_("yyyy-MM-dd")));
+	file_info.set(Kwave::INF_CREATION_DATE, date);
+    }
+
+    m_export_meta = signalManager().metaData();
+    m_export_meta.replace(Kwave::MetaDataList(file_info));
 
-    // now we can loop over all blocks and save them
+    // now we can loop over all blocks and collect them for run()
     sample_index_t block_start;
     sample_index_t block_end = 0;
     Kwave::LabelList labels(signalManager().metaData());
     Kwave::LabelListIterator it(labels);
     Kwave::Label label = it.hasNext() ? it.next() : Kwave::Label();
 
+    m_export_jobs.clear();
     for (unsigned int index = first;;) {
 	block_start = block_end;
 	block_end   = (label.isNull()) ? signalLength() : label.pos();
@@ -341,9 +423,6 @@ int Kwave::SaveBlocksPlugin::start(QStringList &params)
 	    Q_ASSERT(right > left);
 	    if (right <= left) break; // zero-length ?
 
-	    // select the range of samples
-	    selectRange(left, right - left + 1);
-
 	    // determine the filename
 	    QString name = createFileName(base, ext, m_pattern, index, count,
                                           first + count - 1);
@@ -353,39 +432,23 @@ int Kwave::SaveBlocksPlugin::start(QStringList &params)
 	    QUrl url = m_url.adjusted(QUrl::RemoveFilename);
 	    url.setPath(url.path(QUrl::FullyEncoded) + name, QUrl::StrictMode);
 
+	    ExportJob job;
+	    job.m_url   = url;
+	    job.m_first = left;
+	    job.m_last  = right;
+
 	    // enter the title of the block into the meta data if supported
 	    if (!unsupported_properties.contains(INF_NAME)) {
-		QString title = orig_file_info.get(INF_NAME).toString();
+		QString title = orig_title;
 		int idx = index - first;
 		if ((idx >= 0) && (idx < m_block_info.count())) {
 		    QString block_title = m_block_info[idx].m_title;
 		    if (block_title.length())
 			title = title + _(", ") + block_title;
 		}
-		file_info.set(INF_NAME, QVariant(title));
-		signalManager().metaData().replace(
-		    Kwave::MetaDataList(file_info));
-	    }
-
-	    qDebug("saving %9lu...%9lu -> '%s'",
-		   static_cast<unsigned long int>(left),
-		   static_cast<unsigned long int>(right),
-		   DBG(url.toDisplayString()));
-	    if (signalManager().save(url, true) < 0)
-		break;
-
-	    // if there were unsupported properties, the user might have been
-	    // asked whether it is ok to continue or not. If he answered with
-	    // "Cancel", we do not reach this point, otherwise we can continue
-	    // and prevent any further annoying questions by removing all
-	    // unsupported file info before the next run...
-	    if ((index == first) && !unsupported_properties.isEmpty()) {
-		foreach (const Kwave::FileProperty &p, unsupported_properties) {
-		    file_info.set(p, QVariant());
-		}
-		signalManager().metaData().replace(
-		    Kwave::MetaDataList(file_info));
+		job.m_title = title;
 	    }
+	    m_export_jobs.append(job);
 
 	    // increment the index for the next filename
 	    index++;
@@ -394,16 +457,130 @@ int Kwave::SaveBlocksPlugin::start(QStringList &params)
 	label = (it.hasNext()) ? it.next() : Kwave::Label();
     }
 
-    // restore the original file info
-    signalManager().metaData().replace(
-	Kwave::MetaDataList(orig_file_info));
+    // set up the progress dialog, the blocks are encoded in run()
+    return Kwave::Plugin::start(params);
+}
+
+//***************************************************************************
+QString Kwave::SaveBlocksPlugin::progressText()
+{
+    return i18n("Saving %1 blocks...", m_export_jobs.count());
+}
+
+//***************************************************************************
+void Kwave::SaveBlocksPlugin::run(QStringList params)
+{
+    Q_UNUSED(params)
+    if (m_export_jobs.isEmpty()) return;
+
+    // the progress is weighted by the length of the blocks
+    {
+	QMutexLocker lock(&m_export_lock);
+	m_export_progress.fill(0.0, m_export_jobs.count());
+	m_export_done  = 0.0;
+	m_export_total = 0.0;
+	foreach (const ExportJob &job, m_export_jobs)
+	    m_export_total += static_cast<double>(job.m_last - job.m_first + 1);
+    }
+
+    // encode several blocks at once, in a pool with one thread per CPU,
+    // each block has its own reader and encoder
+    QThreadPool pool;
+    pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+    QFutureSynchronizer<bool> synchronizer;
+    for (int index = 0; index < m_export_jobs.count(); index++) {
+	synchronizer.addFuture(QtConcurrent::run(&pool,
+	    this, &Kwave::SaveBlocksPlugin::exportBlock, index));
+    }
+    synchronizer.waitForFinished();
+
+    int failed = 0;
+    foreach (const QFuture<bool> &future, synchronizer.futures())
+	if (!future.result()) failed++;
+
+    if (failed) {
+	Kwave::MessageBox::error(parentWidget(),
+	    i18np("An error occurred while saving one block.",
+	          "An error occurred while saving %1 blocks.", failed));
+    } else if (shouldStop()) {
+	Kwave::MessageBox::error(parentWidget(),
+	    i18n("Saving has been canceled, some of the files might "
+	         "be truncated or missing."));
+    }
+}
+
+//***************************************************************************
+bool Kwave::SaveBlocksPlugin::exportBlock(int index)
+{
+    if (shouldStop()) return true;
+
+    const ExportJob &job = m_export_jobs.at(index);
+    const sample_index_t length = job.m_last - job.m_first + 1;
+
+    Kwave::Encoder *encoder =
+	Kwave::CodecManager::encoder(m_export_mime_type);
+    if (!encoder) return false;
+
+    // use a copy of the meta data snapshot, with all position aware
+    // meta data cropped to the range of the block
+    Kwave::MetaDataList meta(m_export_meta);
+    meta.cropByRange(job.m_first, job.m_last);
+    Kwave::FileInfo info(meta);
+    info.setLength(length);
+    info.set(Kwave::INF_FILENAME, job.m_url.path());
+    if (job.m_title.length())
+	info.set(INF_NAME, QVariant(job.m_title));
+    meta.replace(Kwave::MetaDataList(info));
+
+    qDebug("saving %9lu...%9lu -> '%s'",
+	   static_cast<unsigned long int>(job.m_first),
+	   static_cast<unsigned long int>(job.m_last),
+	   DBG(job.m_url.toDisplayString()));
+
+    // the reader only reads from the signal, several of them can
+    // run at the same time
+    Kwave::MultiTrackReader src(Kwave::SinglePassForward,
+	signalManager(), m_export_tracks, job.m_first, job.m_last);
+
+    // the progress is emitted from this worker thread, sender() would
+    // not be valid here, so each connection knows the index of it's block
+    connect(&src, &Kwave::MultiTrackReader::progress, this,
+	    [this, index](qreal percent) { blockProgress(index, percent); },
+	    Qt::DirectConnection);
+    connect(this, SIGNAL(sigCancel()),
+	    &src, SLOT(cancel()),
+	    Qt::DirectConnection);
+
+    QFile dst(job.m_url.path());
+    bool ok = encoder->encode(parentWidget(), src, dst, meta);
+    delete encoder;
+
+    {
+	QMutexLocker lock(&m_export_lock);
+	setBlockProgress(index, 100.0);
+    }
+
+    return ok;
+}
+
+//***************************************************************************
+void Kwave::SaveBlocksPlugin::blockProgress(int index, qreal percent)
+{
+    QMutexLocker lock(&m_export_lock);
+    setBlockProgress(index, percent);
+}
+
+//***************************************************************************
+void Kwave::SaveBlocksPlugin::setBlockProgress(int index, qreal percent)
+{
+    const ExportJob &job = m_export_jobs.at(index);
+    const double length = static_cast<double>(job.m_last - job.m_first + 1);
 
-    // restore the previous selection
-    selectRange(saved_selection_left,
-	(saved_selection_left != saved_selection_right) ?
-	(saved_selection_right - saved_selection_left + 1) : 0);
+    m_export_done += (percent - m_export_progress[index]) * length / 100.0;
+    m_export_progress[index] = percent;
 
-    return result;
+    if (m_export_total > 0.0)
+	emit sigExportProgress(100.0 * m_export_done / m_export_total);
 }
 
 //***************************************************************************
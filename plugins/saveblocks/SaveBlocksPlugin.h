@@ -20,10 +20,14 @@
 
 #include "config.h"
 
+#include <QList>
+#include <QMutex>
 #include <QObject>
 #include <QString>
 #include <QUrl>
+#include <QVector>
 
+#include "libkwave/MetaDataList.h"
 #include "libkwave/Plugin.h"
 
 class QStringList;
@@ -60,6 +64,16 @@ namespace Kwave
 	 */
         virtual int start(QStringList &params) Q_DECL_OVERRIDE;
 
+	/**
+	 * Encodes all blocks that have been prepared in start(), several
+	 * blocks at once in a bounded pool of worker threads.
+	 * @see Kwave::Plugin::run()
+	 */
+        virtual void run(QStringList params) Q_DECL_OVERRIDE;
+
+	/** @see Kwave::Plugin::progressText() */
+        virtual QString progressText() Q_DECL_OVERRIDE;
+
 	/** mode for numbering the output files */
 	typedef enum {
 	    CONTINUE      = 0,
@@ -138,6 +152,12 @@ namespace Kwave
 	/** emitted by updateExample to update the filename preview */
 	void sigNewExample(const QString &example);
 
+	/**
+	 * emitted from the worker threads with the progress over all
+	 * blocks, in percent [0...100]
+	 */
+	void sigExportProgress(qreal percent);
+
     private slots:
 
 	/**
@@ -162,6 +182,13 @@ namespace Kwave
 	    QString        m_title;  /**< title of the block */
 	} BlockInfo;
 
+	typedef struct {
+	    QUrl           m_url;    /**< destination file */
+	    sample_index_t m_first;  /**< first sample of the block */
+	    sample_index_t m_last;   /**< last sample of the block */
+	    QString        m_title;  /**< title (INF_NAME) or empty */
+	} ExportJob;
+
     private:
 
 	/**
@@ -174,6 +201,30 @@ namespace Kwave
 	QString createDisplayList(const QStringList &list,
                                   unsigned int max_entries) const;
 
+	/**
+	 * Encodes one block into its own file, through its own reader
+	 * and encoder. Called in the context of a worker thread.
+	 * @param index index of the block within m_export_jobs
+	 * @return true if successful or canceled, false on errors
+	 */
+	bool exportBlock(int index);
+
+	/**
+	 * Connected to the reader of each block, sums up the progress
+	 * of all blocks. Called in the context of the worker threads.
+	 * @param index index of the block within m_export_jobs
+	 * @param percent progress of the block [0...100]
+	 */
+	void blockProgress(int index, qreal percent);
+
+	/**
+	 * Sets the progress of one block and emits the progress over all
+	 * blocks. Must be called with m_export_lock held.
+	 * @param index index of the block within m_export_jobs
+	 * @param percent progress of the block [0...100]
+	 */
+	void setBlockProgress(int index, qreal percent);
+
     private:
 
 	/** the URL of the first file (user selection) */
@@ -191,6 +242,33 @@ namespace Kwave
 	/** list of all blocks to save */
 	QList<BlockInfo> m_block_info;
 
+	/** list of all blocks to encode in run() */
+	QList<ExportJob> m_export_jobs;
+
+	/**
+	 * snapshot of the meta data, taken in start(), without the
+	 * properties that are not supported by the encoder
+	 */
+	Kwave::MetaDataList m_export_meta;
+
+	/** mime type of the output files */
+	QString m_export_mime_type;
+
+	/** indices of the tracks to save */
+	QVector<unsigned int> m_export_tracks;
+
+	/** mutex for the progress */
+	QMutex m_export_lock;
+
+	/** progress of each block in percent */
+	QVector<qreal> m_export_progress;
+
+	/** number of samples that have already been encoded, all blocks */
+	double m_export_done;
+
+	/** number of samples to encode, all blocks */
+	double m_export_total;
+
     };
 }
 